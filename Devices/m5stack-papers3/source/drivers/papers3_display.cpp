@@ -186,6 +186,7 @@ static const DisplayApi papers3_display_api = {
     .get_frame_buffer_count = papers3_display_get_frame_buffer_count,
     .get_backlight = nullptr,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 // region Driver lifecycle
@@ -17,6 +17,17 @@ void setMain(MainFunction newMainFunction) {
 }
 
 static void freertosMainTask(void* parameter) {
+    // Keep stdout writes off the LVGL and driver tasks. Crashes through check() flush the buffer first.
+    const LogAsyncConfig log_config = {
+        .record_count = 512,
+        .drain_interval_ms = 10,
+        .drain_stack_size = 4096,
+        .file_path = nullptr
+    };
+    if (log_async_start(&log_config) != ERROR_NONE) {
+        LOG_W(TAG, "Failed to start async logging, continuing with synchronous logging");
+    }
+
     LOG_I(TAG, "starting app_main()");
     assert(simulator::mainFunction);
     mainFunction();
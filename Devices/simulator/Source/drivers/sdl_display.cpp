@@ -144,6 +144,7 @@ static const DisplayApi sdl_display_api = {
     .get_frame_buffer_count = sdl_display_get_frame_buffer_count,
     .get_backlight = nullptr,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 extern Module simulator_module;
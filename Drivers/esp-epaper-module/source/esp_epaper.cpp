@@ -216,6 +216,7 @@ static const DisplayApi esp_epaper_display_api = {
     .get_frame_buffer_count = esp_epaper_get_frame_buffer_count,
     .get_backlight = nullptr,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 static void free_internal(EspEpaperInternal* internal) {
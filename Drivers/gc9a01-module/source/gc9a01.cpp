@@ -309,6 +309,7 @@ static const DisplayApi gc9a01_display_api = {
     .get_frame_buffer_count = gc9a01_get_frame_buffer_count,
     .get_backlight = gc9a01_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver gc9a01_driver = {
@@ -521,6 +521,7 @@ static const DisplayApi gdeq031t10_display_api = {
     .get_frame_buffer_count = gdeq031t10_get_frame_buffer_count,
     .get_backlight = nullptr,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 // region Driver lifecycle
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: GPL-3.0
 #include <gps/gps.h>
+#include <gps/gps_parser.h>
 #include <gps_generic/gps_generic.h>
 #include <gps_meshtastic/module.h>
 
@@ -12,13 +13,12 @@
 #include <tactility/device.h>
 #include <tactility/driver.h>
 #include <tactility/drivers/uart_controller.h>
+#include <tactility/drivers/uart_reader.h>
 #include <tactility/error.h>
 #include <tactility/log.h>
 #include <tactility/module.h>
 #include <tactility/time.h>
 
-#include <minmea.h>
-
 #include <cstdio>
 #include <cstdlib> // For calloc() in PC builds
 
@@ -27,6 +27,8 @@ constexpr auto* TAG = "gps-meshtastic";
 #define GET_CONFIG(device) (static_cast<const GpsConfig*>((device)->config))
 
 constexpr uint32_t GPS_UART_BUFFER_SIZE = 256;
+// Only limits how long it takes to notice an interrupt request: received bytes are processed right away
+constexpr TickType_t GPS_UART_READ_TIMEOUT_TICKS = pdMS_TO_TICKS(100);
 constexpr TickType_t GPS_THREAD_STOP_TIMEOUT_TICKS = pdMS_TO_TICKS(5000);
 constexpr TickType_t GPS_THREAD_STOP_POLL_TICKS = pdMS_TO_TICKS(1000);
 
@@ -39,6 +41,8 @@ struct GpsInternal {
     GpsModel model;
     // Singly-linked list of subscribers, guarded by `mutex`.
     GpsSubscription* subscribers;
+    // The events that any subscriber wants, so the parser doesn't decode sentences nobody uses. Guarded by `mutex`.
+    uint32_t subscribed_event_mask;
 };
 
 static const char* gpsModelToString(GpsModel model) {
@@ -76,20 +80,51 @@ static const char* gpsModelToString(GpsModel model) {
     }
 }
 
-// Pushes `event` to every current subscriber and wakes their waiting task. Safe to call from the
-// GPS thread's parsing loop.
-static void notify_subscribers(GpsInternal* internal, const GpsEvent& event) {
+static uint32_t get_event_mask(const GpsSubscription* sub) {
+    return (sub->event_mask != 0) ? sub->event_mask : GPS_EVENT_MASK_DEFAULT;
+}
+
+static bool is_event_wanted(const GpsSubscription* sub, GpsEventType type) {
+    return type == GPS_EVENT_UNSUBSCRIBED || (get_event_mask(sub) & GPS_EVENT_MASK(type)) != 0;
+}
+
+// Pushes `event` to every current subscriber that wants it and wakes their waiting task. Safe to
+// call from the GPS thread's parsing loop.
+static void notify_subscribers(GpsInternal* internal, const GpsEvent* event) {
     recursive_mutex_lock(&internal->mutex);
 
     for (GpsSubscription* sub = internal->subscribers; sub != nullptr; sub = sub->next) {
-        sub->event = event;
-        sub->sequence++;
-        xTaskNotifyGive(sub->task);
+        if (is_event_wanted(sub, event->type)) {
+            sub->event = *event;
+            sub->sequence++;
+            xTaskNotifyGive(sub->task);
+        }
     }
 
     recursive_mutex_unlock(&internal->mutex);
 }
 
+static void on_parser_event(const GpsEvent* event, void* context) {
+    notify_subscribers(static_cast<GpsInternal*>(context), event);
+}
+
+// Must be called with the mutex locked
+static void update_subscribed_event_mask(GpsInternal* internal) {
+    uint32_t mask = 0;
+    for (GpsSubscription* sub = internal->subscribers; sub != nullptr; sub = sub->next) {
+        mask |= get_event_mask(sub);
+    }
+    // Without subscribers, sentences are only checked
+    internal->subscribed_event_mask = (mask != 0) ? mask : GPS_EVENT_MASK(GPS_EVENT_UNSUBSCRIBED);
+}
+
+static uint32_t get_subscribed_event_mask(GpsInternal* internal) {
+    recursive_mutex_lock(&internal->mutex);
+    uint32_t mask = internal->subscribed_event_mask;
+    recursive_mutex_unlock(&internal->mutex);
+    return mask;
+}
+
 static void set_state(GpsInternal* internal, GpsState state) {
     recursive_mutex_lock(&internal->mutex);
     internal->state = state;
@@ -153,11 +188,21 @@ static int32_t gps_thread_main(void* context) {
 
     set_state(internal, GpsState::GPS_STATE_ON);
 
-    // Reference: https://gpsd.gitlab.io/gpsd/NMEA.html
+    UartReader* reader = uart_reader_alloc(uart, GPS_UART_BUFFER_SIZE);
+    if (reader == nullptr) {
+        LOG_E(TAG, "Failed to allocate UART reader");
+        uart_controller_close(uart);
+        set_state(internal, GpsState::GPS_STATE_ERROR);
+        return -1;
+    }
+
+    // Bytes are parsed as they arrive: NMEA sentences and UBX messages don't need to be complete
+    GpsParser parser;
+    gps_parser_init(&parser, on_parser_event, internal);
     uint8_t buffer[GPS_UART_BUFFER_SIZE];
     while (!is_interrupted(internal)) {
         size_t bytes_read = 0;
-        uart_controller_read_until(uart, buffer, sizeof(buffer), '\n', true, &bytes_read, pdMS_TO_TICKS(100));
+        uart_reader_read(reader, buffer, sizeof(buffer), &bytes_read, GPS_UART_READ_TIMEOUT_TICKS);
 
         // Thread might've been interrupted in the meanwhile
         if (is_interrupted(internal)) {
@@ -165,38 +210,25 @@ static int32_t gps_thread_main(void* context) {
         }
 
         if (bytes_read > 0U) {
-            switch (minmea_sentence_id(reinterpret_cast<char*>(buffer), false)) {
-                case MINMEA_SENTENCE_RMC: {
-                    GpsEvent event { .type = GPS_EVENT_MESSAGE_RMC };
-                    if (minmea_parse_rmc(&event.data.rmc, reinterpret_cast<char*>(buffer))) {
-                        notify_subscribers(internal, event);
-                    } else {
-                        LOG_E(TAG, "RMC parse error: %s", reinterpret_cast<const char*>(buffer));
-                    }
-                    break;
-                }
-                case MINMEA_SENTENCE_GGA: {
-                    GpsEvent event { .type = GPS_EVENT_MESSAGE_GGA };
-                    if (minmea_parse_gga(&event.data.gga, reinterpret_cast<char*>(buffer))) {
-                        notify_subscribers(internal, event);
-                    } else {
-                        LOG_E(TAG, "GGA parse error: %s", reinterpret_cast<const char*>(buffer));
-                    }
-                    break;
-                }
-                default:
-                    break;
-            }
+            gps_parser_set_event_mask(&parser, get_subscribed_event_mask(internal));
+            gps_parser_feed(&parser, buffer, bytes_read);
         }
     }
 
+    GpsParserStats stats;
+    gps_parser_get_stats(&parser, &stats);
+    LOG_I(TAG, "Parsed %u sentences and %u UBX messages, %u checksum errors, %u dropped",
+        (unsigned)stats.sentences, (unsigned)stats.ubx_messages, (unsigned)stats.checksum_errors, (unsigned)stats.dropped);
+    uart_reader_free(reader);
+
     if (uart_controller_close(uart) != ERROR_NONE) {
         LOG_W(TAG, "Failed to close UART %s", uart->name);
     }
 
     // Wake any subscribers still awaiting an event so they don't block forever on a device that's
     // going away, then drop them - stop() is about to free `internal`.
-    notify_subscribers(internal, GpsEvent { .type = GPS_EVENT_UNSUBSCRIBED });
+    GpsEvent event { .type = GPS_EVENT_UNSUBSCRIBED };
+    notify_subscribers(internal, &event);
     recursive_mutex_lock(&internal->mutex);
     internal->subscribers = nullptr;
     recursive_mutex_unlock(&internal->mutex);
@@ -216,6 +248,7 @@ static error_t start(Device* device) {
     recursive_mutex_construct(&internal->mutex);
     internal->model = config->model;
     internal->state = GPS_STATE_PENDING_ON;
+    internal->subscribed_event_mask = GPS_EVENT_MASK(GPS_EVENT_UNSUBSCRIBED);
     internal->thread = thread_alloc_full("gps", 4096, gps_thread_main, device, -1);
     if (internal->thread == nullptr) {
         recursive_mutex_destruct(&internal->mutex);
@@ -271,6 +304,7 @@ static error_t gps_api_event_subscribe(Device* device, GpsSubscription* sub) {
     recursive_mutex_lock(&internal->mutex);
     sub->next = internal->subscribers;
     internal->subscribers = sub;
+    update_subscribed_event_mask(internal);
     recursive_mutex_unlock(&internal->mutex);
 
     return ERROR_NONE;
@@ -284,6 +318,7 @@ static error_t gps_api_event_unsubscribe(Device* device, GpsSubscription* sub) {
     for (GpsSubscription** link = &internal->subscribers; *link != nullptr; link = &(*link)->next) {
         if (*link == sub) {
             *link = sub->next;
+            update_subscribed_event_mask(internal);
             result = ERROR_NONE;
             break;
         }
@@ -446,6 +446,7 @@ static const DisplayApi hx8357_display_api = {
     .get_frame_buffer_count = hx8357_get_frame_buffer_count,
     .get_backlight = hx8357_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver hx8357_driver = {
@@ -412,6 +412,7 @@ static const DisplayApi ili9341_display_api = {
     .get_frame_buffer_count = ili9341_get_frame_buffer_count,
     .get_backlight = ili9341_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver ili9341_driver = {
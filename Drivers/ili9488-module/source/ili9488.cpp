@@ -339,6 +339,7 @@ static const DisplayApi ili9488_display_api = {
     .get_frame_buffer_count = ili9488_get_frame_buffer_count,
     .get_backlight = ili9488_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver ili9488_driver = {
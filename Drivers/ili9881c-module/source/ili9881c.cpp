@@ -575,6 +575,7 @@ static const DisplayApi ili9881c_display_api = {
     .get_frame_buffer_count = ili9881c_get_frame_buffer_count,
     .get_backlight = ili9881c_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver ili9881c_driver = {
@@ -510,6 +510,7 @@ static const DisplayApi jd9165_display_api = {
     .get_frame_buffer_count = jd9165_get_frame_buffer_count,
     .get_backlight = jd9165_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver jd9165_driver = {
@@ -322,6 +322,7 @@ static const DisplayApi jd9853_display_api = {
     .get_frame_buffer_count = jd9853_get_frame_buffer_count,
     .get_backlight = jd9853_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver jd9853_driver = {
@@ -347,6 +347,7 @@ static const DisplayApi ssd1306_display_api = {
     .get_frame_buffer_count = ssd1306_get_frame_buffer_count,
     .get_backlight = nullptr,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver ssd1306_driver = {
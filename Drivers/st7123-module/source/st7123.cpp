@@ -574,6 +574,7 @@ static const DisplayApi st7123_display_api = {
     .get_frame_buffer_count = st7123_get_frame_buffer_count,
     .get_backlight = st7123_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver st7123_driver = {
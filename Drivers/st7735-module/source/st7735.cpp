@@ -341,6 +341,7 @@ static const DisplayApi st7735_display_api = {
     .get_frame_buffer_count = st7735_get_frame_buffer_count,
     .get_backlight = st7735_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver st7735_driver = {
@@ -370,6 +370,7 @@ static const DisplayApi st7789_i8080_display_api = {
     .get_frame_buffer_count = st7789_i8080_get_frame_buffer_count,
     .get_backlight = st7789_i8080_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver st7789_i8080_driver = {
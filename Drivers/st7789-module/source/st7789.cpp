@@ -39,12 +39,26 @@ struct St7789Internal {
     // (see lvgl_display.c: the caller reuses/overwrites the color buffer as soon as draw_bitmap
     // returns) - esp_lcd_panel_draw_bitmap() itself only queues the transfer and returns early.
     SemaphoreHandle_t draw_done_semaphore;
+    // Passed to async_done_callback
+    Device* device;
+    // Set by draw_bitmap_async() right before it queues its transfer, and cleared by
+    // on_color_trans_done() when that transfer completes. Null for synchronous draws.
+    volatile DisplayDrawDoneCallback async_done_callback;
+    void* volatile async_done_context;
 };
 
-// Fires for every completed SPI transaction on this IO (not just draw_bitmap's color transfers -
-// bring-up commands like reset/init/gap go through the same IO), called from ISR context.
+// Called from ISR context once the last chunk of a color transfer completes. esp_lcd doesn't report
+// command transfers here (esp_lcd_panel_io_tx_param() polls them, including draw_bitmap's own
+// CASET/RASET), so once draw_bitmap_async() armed its callback, the next call is that draw's completion.
+// draw_bitmap() still drains the semaphore before drawing, as a safeguard against stale signals.
 static bool IRAM_ATTR on_color_trans_done(esp_lcd_panel_io_handle_t, esp_lcd_panel_io_event_data_t*, void* user_ctx) {
     auto* internal = static_cast<St7789Internal*>(user_ctx);
+    DisplayDrawDoneCallback callback = internal->async_done_callback;
+    if (callback != nullptr) {
+        internal->async_done_callback = nullptr;
+        callback(internal->device, internal->async_done_context);
+        return false;
+    }
     BaseType_t high_task_woken = pdFALSE;
     xSemaphoreGiveFromISR(internal->draw_done_semaphore, &high_task_woken);
     return high_task_woken == pdTRUE;
@@ -74,6 +88,9 @@ static error_t start(Device* device) {
         return ERROR_OUT_OF_MEMORY;
     }
 
+    internal->device = device;
+    internal->async_done_callback = nullptr;
+    internal->async_done_context = nullptr;
     internal->draw_done_semaphore = xSemaphoreCreateBinary();
     if (internal->draw_done_semaphore == nullptr) {
         free(internal);
@@ -225,6 +242,22 @@ static error_t st7789_draw_bitmap(Device* device, int32_t x_start, int32_t y_sta
     return ERROR_NONE;
 }
 
+// Same as st7789_draw_bitmap(), but returns as soon as the transfer is queued: on_done is called
+// from on_color_trans_done() once the SPI peripheral is done with color_data.
+static error_t st7789_draw_bitmap_async(Device* device, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data, DisplayDrawDoneCallback on_done, void* context) {
+    auto* internal = static_cast<St7789Internal*>(device_get_driver_data(device));
+
+    xSemaphoreTake(internal->draw_done_semaphore, 0);
+    internal->async_done_context = context;
+    internal->async_done_callback = on_done;
+
+    if (esp_lcd_panel_draw_bitmap(internal->panel_handle, x_start, y_start, x_end, y_end, color_data) != ESP_OK) {
+        internal->async_done_callback = nullptr;
+        return ERROR_RESOURCE;
+    }
+    return ERROR_NONE;
+}
+
 static error_t st7789_mirror(Device* device, bool x_axis, bool y_axis) {
     auto* internal = static_cast<St7789Internal*>(device_get_driver_data(device));
     return esp_lcd_panel_mirror(internal->panel_handle, x_axis, y_axis) == ESP_OK ? ERROR_NONE : ERROR_RESOURCE;
@@ -319,7 +352,7 @@ static error_t st7789_get_backlight(Device* device, Device** backlight) {
 static const DisplayApi st7789_display_api = {
     .capabilities = DISPLAY_CAPABILITY_CAP_MIRROR | DISPLAY_CAPABILITY_CAP_SWAP_XY |
         DISPLAY_CAPABILITY_CAP_SET_GAP | DISPLAY_CAPABILITY_INVERT_COLOR | DISPLAY_CAPABILITY_ON_OFF |
-        DISPLAY_CAPABILITY_SLEEP | DISPLAY_CAPABILITY_BACKLIGHT,
+        DISPLAY_CAPABILITY_SLEEP | DISPLAY_CAPABILITY_BACKLIGHT | DISPLAY_CAPABILITY_ASYNC_DRAW,
     .reset = st7789_reset,
     .init = st7789_init,
     .draw_bitmap = st7789_draw_bitmap,
@@ -341,6 +374,7 @@ static const DisplayApi st7789_display_api = {
     .get_frame_buffer_count = st7789_get_frame_buffer_count,
     .get_backlight = st7789_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = st7789_draw_bitmap_async,
 };
 
 Driver st7789_driver = {
@@ -325,6 +325,7 @@ static const DisplayApi st7796_i8080_display_api = {
     .get_frame_buffer_count = st7796_i8080_get_frame_buffer_count,
     .get_backlight = st7796_i8080_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver st7796_i8080_driver = {
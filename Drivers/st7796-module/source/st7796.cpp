@@ -341,6 +341,7 @@ static const DisplayApi st7796_display_api = {
     .get_frame_buffer_count = st7796_get_frame_buffer_count,
     .get_backlight = st7796_get_backlight,
     .has_capability = nullptr,
+    .draw_bitmap_async = nullptr,
 };
 
 Driver st7796_driver = {
@@ -6,14 +6,17 @@
 #include <tactility/drivers/gpio_controller.h>
 #include <tactility/drivers/gpio_descriptor.h>
 #include <tactility/drivers/i2c_controller.h>
+#include <tactility/drivers/i2c_register_cache.h>
 #include <tactility/log.h>
 
 #define TAG "XL9555"
 
 #define GET_CONFIG(device) (static_cast<const Xl9555Config*>((device)->config))
+#define GET_CACHE(device) (static_cast<I2cRegisterCache*>(gpio_controller_get_controller_context(device)))
 
 // PCA9555-compatible register map: one register per function per 8-pin port.
 constexpr auto XL9555_REGISTER_INPUT_PORT0 = 0x00;
+constexpr auto XL9555_REGISTER_INPUT_PORT1 = 0x01;
 constexpr auto XL9555_REGISTER_OUTPUT_PORT0 = 0x02;
 constexpr auto XL9555_REGISTER_POLARITY_PORT0 = 0x04;
 constexpr auto XL9555_REGISTER_CONFIG_PORT0 = 0x06;
@@ -30,42 +33,48 @@ static error_t start(Device* device) {
     auto* parent = device_get_parent(device);
     check(device_get_type(parent) == &I2C_CONTROLLER_TYPE);
 
-    return gpio_controller_init_descriptors(device, 16, nullptr);
+    // Output, polarity and configuration registers only change when this driver writes them,
+    // so pin updates don't need to read them back over the bus.
+    const uint8_t volatile_registers[] = { XL9555_REGISTER_INPUT_PORT0, XL9555_REGISTER_INPUT_PORT1 };
+    auto* cache = i2c_register_cache_alloc(parent, GET_CONFIG(device)->address, volatile_registers, 2);
+    if (cache == nullptr) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+
+    error_t error = gpio_controller_init_descriptors(device, 16, cache);
+    if (error != ERROR_NONE) {
+        i2c_register_cache_free(cache);
+    }
+    return error;
 }
 
 static error_t stop(Device* device) {
+    auto* cache = GET_CACHE(device);
     check(gpio_controller_deinit_descriptors(device) == ERROR_NONE);
+    i2c_register_cache_free(cache);
     return ERROR_NONE;
 }
 
 extern "C" {
 
 static error_t set_level(GpioDescriptor* descriptor, bool high) {
-    auto* device = descriptor->controller;
-    auto* parent = device_get_parent(device);
-    auto address = GET_CONFIG(device)->address;
+    auto* cache = GET_CACHE(descriptor->controller);
     auto reg = static_cast<uint8_t>(XL9555_REGISTER_OUTPUT_PORT0 + port_of(descriptor));
     auto bit = bit_of(descriptor);
 
-    // i2c_controller_register8_{set,reset}_bits() do a separate read then
-    // write; without this lock, concurrent updates to different pins on the
-    // same output port register can clobber each other.
-    device_lock(device);
-    error_t err = high
-        ? i2c_controller_register8_set_bits(parent, address, reg, bit, portMAX_DELAY)
-        : i2c_controller_register8_reset_bits(parent, address, reg, bit, portMAX_DELAY);
-    device_unlock(device);
-    return err;
+    // The cache's read-modify-write is atomic, so concurrent updates to different
+    // pins on the same output port register can't clobber each other.
+    return high
+        ? i2c_register_cache_set_bits(cache, reg, bit, portMAX_DELAY)
+        : i2c_register_cache_reset_bits(cache, reg, bit, portMAX_DELAY);
 }
 
 static error_t get_level(GpioDescriptor* descriptor, bool* high) {
-    auto* device = descriptor->controller;
-    auto* parent = device_get_parent(device);
-    auto address = GET_CONFIG(device)->address;
+    auto* cache = GET_CACHE(descriptor->controller);
     auto reg = static_cast<uint8_t>(XL9555_REGISTER_INPUT_PORT0 + port_of(descriptor));
     uint8_t bits;
 
-    error_t err = i2c_controller_register8_get(parent, address, reg, &bits, portMAX_DELAY);
+    error_t err = i2c_register_cache_get(cache, reg, &bits, portMAX_DELAY);
     if (err != ERROR_NONE) {
         return err;
     }
@@ -89,8 +98,7 @@ static error_t set_flags(GpioDescriptor* descriptor, gpio_flags_t flags) {
     }
 
     auto* device = descriptor->controller;
-    auto* parent = device_get_parent(device);
-    auto address = GET_CONFIG(device)->address;
+    auto* cache = GET_CACHE(device);
     auto config_reg = static_cast<uint8_t>(XL9555_REGISTER_CONFIG_PORT0 + port_of(descriptor));
     auto polarity_reg = static_cast<uint8_t>(XL9555_REGISTER_POLARITY_PORT0 + port_of(descriptor));
     auto bit = bit_of(descriptor);
@@ -98,14 +106,14 @@ static error_t set_flags(GpioDescriptor* descriptor, gpio_flags_t flags) {
 
     // Locked as a whole: direction and polarity are two separate RMW register
     // writes, and both should apply atomically with respect to other set_flags
-    // / set_level calls on this device.
+    // calls on this device.
     device_lock(device);
 
     // Direction: configuration bit is 1 for input, 0 for output.
     if (flags & GPIO_FLAG_DIRECTION_OUTPUT) {
-        err = i2c_controller_register8_reset_bits(parent, address, config_reg, bit, portMAX_DELAY);
+        err = i2c_register_cache_reset_bits(cache, config_reg, bit, portMAX_DELAY);
     } else {
-        err = i2c_controller_register8_set_bits(parent, address, config_reg, bit, portMAX_DELAY);
+        err = i2c_register_cache_set_bits(cache, config_reg, bit, portMAX_DELAY);
     }
 
     if (err != ERROR_NONE) {
@@ -115,9 +123,9 @@ static error_t set_flags(GpioDescriptor* descriptor, gpio_flags_t flags) {
 
     // Polarity inversion (mainly relevant for active-low inputs).
     if (flags & GPIO_FLAG_ACTIVE_LOW) {
-        err = i2c_controller_register8_set_bits(parent, address, polarity_reg, bit, portMAX_DELAY);
+        err = i2c_register_cache_set_bits(cache, polarity_reg, bit, portMAX_DELAY);
     } else {
-        err = i2c_controller_register8_reset_bits(parent, address, polarity_reg, bit, portMAX_DELAY);
+        err = i2c_register_cache_reset_bits(cache, polarity_reg, bit, portMAX_DELAY);
     }
 
     device_unlock(device);
@@ -126,8 +134,7 @@ static error_t set_flags(GpioDescriptor* descriptor, gpio_flags_t flags) {
 
 static error_t get_flags(GpioDescriptor* descriptor, gpio_flags_t* flags) {
     auto* device = descriptor->controller;
-    auto* parent = device_get_parent(device);
-    auto address = GET_CONFIG(device)->address;
+    auto* cache = GET_CACHE(device);
     auto config_reg = static_cast<uint8_t>(XL9555_REGISTER_CONFIG_PORT0 + port_of(descriptor));
     auto polarity_reg = static_cast<uint8_t>(XL9555_REGISTER_POLARITY_PORT0 + port_of(descriptor));
     auto bit = bit_of(descriptor);
@@ -136,11 +143,11 @@ static error_t get_flags(GpioDescriptor* descriptor, gpio_flags_t* flags) {
 
     gpio_flags_t f = GPIO_FLAG_NONE;
 
-    err = i2c_controller_register8_get(parent, address, config_reg, &val, portMAX_DELAY);
+    err = i2c_register_cache_get(cache, config_reg, &val, portMAX_DELAY);
     if (err != ERROR_NONE) return err;
     f |= (val & bit) ? GPIO_FLAG_DIRECTION_INPUT : GPIO_FLAG_DIRECTION_OUTPUT;
 
-    err = i2c_controller_register8_get(parent, address, polarity_reg, &val, portMAX_DELAY);
+    err = i2c_register_cache_get(cache, polarity_reg, &val, portMAX_DELAY);
     if (err != ERROR_NONE) return err;
     f |= (val & bit) ? GPIO_FLAG_ACTIVE_LOW : GPIO_FLAG_ACTIVE_HIGH;
 
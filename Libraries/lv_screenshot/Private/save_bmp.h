@@ -7,6 +7,12 @@
 extern "C" {
 #endif
 
+/**
+ * Writes the file header and info header of an uncompressed bottom-up BMP file.
+ * row_size is the size of a row in the file, including the padding to a multiple of 4 bytes.
+ */
+bool lv_screenshot_write_bmp_header(lv_fs_file_t* f, uint32_t w, uint32_t h, uint32_t bpp, uint32_t row_size);
+
 bool lve_screenshot_save_bmp_file(const uint8_t* image, uint32_t w, uint32_t h, uint32_t bpp, const char* filename);
 
 #ifdef __cplusplus
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Encodes a 24 bit PNG file row by row, so the image doesn't have to be in memory.
+ * The image data is compressed with a deflate encoder that uses fixed Huffman codes and a 4 KiB window:
+ * the PNG row filters turn the plain color areas of a UI into runs of zeros, which don't need more.
+ */
+typedef struct _lv_screenshot_png_stream_t lv_screenshot_png_stream_t;
+
+/** Writes the PNG header to the file. Returns NULL when out of memory or when the write fails. */
+lv_screenshot_png_stream_t* lv_screenshot_png_stream_open(lv_fs_file_t* file, uint32_t w, uint32_t h);
+
+/** Adds the next row. The pixels are in LV_COLOR_FORMAT_RGB888 (blue first). */
+bool lv_screenshot_png_stream_write_row(lv_screenshot_png_stream_t* stream, const uint8_t* pixels);
+
+/** Writes the rest of the file after the last row. The file isn't closed. */
+bool lv_screenshot_png_stream_finish(lv_screenshot_png_stream_t* stream);
+
+void lv_screenshot_png_stream_free(lv_screenshot_png_stream_t* stream);
+
+/** The memory that the encoder uses, in bytes */
+size_t lv_screenshot_png_stream_get_memory_size(const lv_screenshot_png_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,8 +1,12 @@
 #include "lv_screenshot.h"
 
 #include "save_png.h"
+#include "save_png_stream.h"
 #include "save_bmp.h"
 
+// For rendering a part of an object to a layer, like lv_snapshot does for the whole object
+#include "lvgl_private.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -29,6 +33,161 @@ bool lv_screenshot_create(lv_obj_t* obj, lv_100ask_screenshot_sv_t screenshot_sv
     return false;
 }
 
+/** Renders the rows of strip_area to draw_buf, which starts at the top left of strip_area */
+static void render_strip(lv_obj_t* obj, lv_draw_buf_t* draw_buf, const lv_area_t* strip_area) {
+    lv_draw_buf_clear(draw_buf, NULL);
+
+    lv_layer_t layer;
+    lv_layer_init(&layer);
+    layer.draw_buf = draw_buf;
+    layer.buf_area.x1 = strip_area->x1;
+    layer.buf_area.y1 = strip_area->y1;
+    layer.buf_area.x2 = strip_area->x1 + draw_buf->header.w - 1;
+    layer.buf_area.y2 = strip_area->y1 + draw_buf->header.h - 1;
+    layer.color_format = draw_buf->header.cf;
+    layer._clip_area = *strip_area;
+    layer.phy_clip_area = *strip_area;
+
+    lv_display_t* disp_old = lv_refr_get_disp_refreshing();
+    lv_display_t* disp_new = lv_obj_get_display(obj);
+    lv_layer_t* layer_old = disp_new->layer_head;
+    disp_new->layer_head = &layer;
+    lv_refr_set_disp_refreshing(disp_new);
+
+    lv_obj_redraw(&layer, obj);
+    while (layer.draw_task_head) {
+        lv_draw_dispatch_wait_for_request();
+        lv_draw_dispatch();
+    }
+
+    disp_new->layer_head = layer_old;
+    lv_refr_set_disp_refreshing(disp_old);
+}
+
+/** BMP rows are stored from the bottom up, so the rows of the strip are written in reverse */
+static bool write_bmp_rows(lv_fs_file_t* f, const lv_draw_buf_t* draw_buf, uint32_t row_count, uint32_t row_size) {
+    static const uint8_t padding[3] = { 0, 0, 0 };
+    uint32_t pixels_size = draw_buf->header.w * 3;
+    uint32_t padding_size = row_size - pixels_size;
+    uint32_t bw;
+    for (int32_t row = (int32_t)row_count - 1; row >= 0; row--) {
+        const uint8_t* pixels = draw_buf->data + row * draw_buf->header.stride;
+        if (lv_fs_write(f, pixels, pixels_size, &bw) != LV_FS_RES_OK || bw != pixels_size) {
+            return false;
+        }
+        if (padding_size > 0 && (lv_fs_write(f, padding, padding_size, &bw) != LV_FS_RES_OK || bw != padding_size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool write_png_rows(lv_screenshot_png_stream_t* png_stream, const lv_draw_buf_t* draw_buf, uint32_t row_count) {
+    for (uint32_t row = 0; row < row_count; row++) {
+        if (!lv_screenshot_png_stream_write_row(png_stream, draw_buf->data + row * draw_buf->header.stride)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool lv_screenshot_create_streaming(lv_obj_t* obj, const char* filename, const lv_screenshot_stream_config_t* config, lv_screenshot_stream_stats_t* stats) {
+    uint32_t start_time = lv_tick_get();
+    lv_screenshot_stream_stats_t local_stats;
+    if (stats == NULL) {
+        stats = &local_stats;
+    }
+    lv_memzero(stats, sizeof(lv_screenshot_stream_stats_t));
+
+    bool is_png = config->screenshot_sv == LV_100ASK_SCREENSHOT_SV_PNG;
+    if (!is_png && config->screenshot_sv != LV_100ASK_SCREENSHOT_SV_BMP) {
+        return false;
+    }
+
+    lv_obj_update_layout(obj);
+    lv_area_t area;
+    int32_t ext_size = lv_obj_get_ext_draw_size(obj);
+    lv_obj_get_coords(obj, &area);
+    lv_area_increase(&area, ext_size, ext_size);
+    uint32_t w = lv_area_get_width(&area);
+    uint32_t h = lv_area_get_height(&area);
+
+    uint32_t strip_height = config->strip_height;
+    if (strip_height == 0) {
+        strip_height = LV_MAX(1, LV_SCREENSHOT_STREAM_STRIP_SIZE_DEFAULT / (w * 3));
+    }
+    strip_height = LV_MIN(strip_height, h);
+
+    lv_draw_buf_t* draw_buf = lv_draw_buf_create(w, strip_height, LV_COLOR_FORMAT_RGB888, LV_STRIDE_AUTO);
+    if (draw_buf == NULL) {
+        LV_LOG_WARN("Out of memory for a strip of %" LV_PRIu32 " rows", strip_height);
+        return false;
+    }
+
+    lv_fs_file_t f;
+    if (lv_fs_open(&f, filename, LV_FS_MODE_WR) != LV_FS_RES_OK) {
+        LV_LOG_WARN("Can't create output file %s", filename);
+        lv_draw_buf_destroy(draw_buf);
+        return false;
+    }
+
+    // Rows are padded to a multiple of 4 bytes in BMP files
+    uint32_t bmp_row_size = (w * 3 + 3) & ~3U;
+    lv_screenshot_png_stream_t* png_stream = NULL;
+    bool success;
+    if (is_png) {
+        png_stream = lv_screenshot_png_stream_open(&f, w, h);
+        success = png_stream != NULL;
+    } else {
+        success = lv_screenshot_write_bmp_header(&f, w, h, 24, bmp_row_size);
+    }
+    stats->peak_memory = draw_buf->data_size + (png_stream != NULL ? lv_screenshot_png_stream_get_memory_size(png_stream) : 0);
+
+    uint32_t strip_count = (h + strip_height - 1) / strip_height;
+    for (uint32_t strip = 0; strip < strip_count && success; strip++) {
+        // BMP files start with the bottom row
+        uint32_t strip_index = is_png ? strip : strip_count - 1 - strip;
+        lv_area_t strip_area = area;
+        strip_area.y1 = area.y1 + (int32_t)(strip_index * strip_height);
+        strip_area.y2 = LV_MIN(strip_area.y1 + (int32_t)strip_height - 1, area.y2);
+        uint32_t row_count = lv_area_get_height(&strip_area);
+
+        uint32_t render_start_time = lv_tick_get();
+        render_strip(obj, draw_buf, &strip_area);
+        stats->render_time_ms += lv_tick_elaps(render_start_time);
+        stats->strip_count++;
+
+        if (config->unlock != NULL) {
+            config->unlock(config->user_data);
+        }
+        success = is_png ? write_png_rows(png_stream, draw_buf, row_count) : write_bmp_rows(&f, draw_buf, row_count, bmp_row_size);
+        if (config->lock != NULL) {
+            config->lock(config->user_data);
+        }
+
+        // The object might have been deleted while the lock was released
+        if (success && config->unlock != NULL && !lv_obj_is_valid(obj)) {
+            LV_LOG_WARN("Object was deleted during the capture");
+            success = false;
+        }
+    }
+
+    if (success && png_stream != NULL) {
+        success = lv_screenshot_png_stream_finish(png_stream);
+    }
+    if (success) {
+        lv_fs_tell(&f, &stats->file_size);
+    }
+
+    if (png_stream != NULL) {
+        lv_screenshot_png_stream_free(png_stream);
+    }
+    lv_fs_close(&f);
+    lv_draw_buf_destroy(draw_buf);
+    stats->time_ms = lv_tick_elaps(start_time);
+    return success;
+}
+
 static void data_pre_processing(lv_draw_buf_t* snapshot, uint16_t bpp, lv_100ask_screenshot_sv_t screenshot_sv) {
     if (bpp == 16) {
         uint16_t rgb565_data = 0;
@@ -14,6 +14,45 @@ typedef enum {
 
 bool lv_screenshot_create(lv_obj_t* obj, lv_100ask_screenshot_sv_t screenshot_sv, const char* filename);
 
+/** The strip height is chosen so that a strip takes about this many bytes */
+#define LV_SCREENSHOT_STREAM_STRIP_SIZE_DEFAULT (32 * 1024)
+
+typedef struct {
+    lv_100ask_screenshot_sv_t screenshot_sv;
+    /** The number of rows that are rendered at a time, or 0 for the default */
+    uint32_t strip_height;
+    /**
+     * Optional: called to release the LVGL lock while a strip is encoded and written, and to take it again
+     * before the next strip is rendered. The screen can change in between, so strips might not match exactly.
+     */
+    void (*unlock)(void* user_data);
+    void (*lock)(void* user_data);
+    void* user_data;
+} lv_screenshot_stream_config_t;
+
+typedef struct {
+    /** Total time, in milliseconds */
+    uint32_t time_ms;
+    /** Time spent rendering with the LVGL lock held, in milliseconds */
+    uint32_t render_time_ms;
+    /** The memory that was allocated for the capture, in bytes */
+    size_t peak_memory;
+    uint32_t strip_count;
+    uint32_t file_size;
+} lv_screenshot_stream_stats_t;
+
+/**
+ * Saves a screenshot like lv_screenshot_create(), but renders and encodes it one strip of rows at a time,
+ * so only a strip has to be in memory instead of the full image and the encoder's copies of it.
+ * Must be called with the LVGL lock held, and returns with the lock held.
+ * @param[in] obj the object to capture, usually lv_screen_active()
+ * @param[in] filename the output file, as an lv_fs path
+ * @param[in] config the options
+ * @param[out] stats optional: the measurements of the capture
+ * @return true when the file was written completely
+ */
+bool lv_screenshot_create_streaming(lv_obj_t* obj, const char* filename, const lv_screenshot_stream_config_t* config, lv_screenshot_stream_stats_t* stats);
+
 #ifdef __cplusplus
 } /*extern "C"*/
 #endif
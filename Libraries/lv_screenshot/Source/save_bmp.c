@@ -32,26 +32,17 @@ typedef struct tagRGBQUAD {
     uint8_t rgbReserved;
 } __attribute__((packed)) RGBQUAD;
 
-bool lve_screenshot_save_bmp_file(const uint8_t* image, uint32_t w, uint32_t h, uint32_t bpp, const char* filename) {
+bool lv_screenshot_write_bmp_header(lv_fs_file_t* f, uint32_t w, uint32_t h, uint32_t bpp, uint32_t row_size) {
     BITMAPFILEHEADER tBmpFileHead;
     BITMAPINFOHEADER tBmpInfoHead;
 
-    uint32_t dwSize;
-
     uint32_t bw;
-    lv_fs_file_t f;
 
     memset(&tBmpFileHead, 0, sizeof(BITMAPFILEHEADER));
     memset(&tBmpInfoHead, 0, sizeof(BITMAPINFOHEADER));
 
-    lv_fs_res_t res = lv_fs_open(&f, filename, LV_FS_MODE_WR);
-    if (res != LV_FS_RES_OK) {
-        LV_LOG_USER("Can't create output file %s", filename);
-        return false;
-    }
-
     tBmpFileHead.bfType = 0x4d42;
-    tBmpFileHead.bfSize = 0x36 + w * h * (bpp / 8);
+    tBmpFileHead.bfSize = 0x36 + row_size * h;
     tBmpFileHead.bfOffBits = 0x00000036;
 
     tBmpInfoHead.biSize = 0x00000028;
@@ -60,21 +51,35 @@ bool lve_screenshot_save_bmp_file(const uint8_t* image, uint32_t w, uint32_t h,
     tBmpInfoHead.biPlanes = 0x0001;
     tBmpInfoHead.biBitCount = bpp;
     tBmpInfoHead.biCompression = 0;
-    tBmpInfoHead.biSizeImage = w * h * (bpp / 8);
+    tBmpInfoHead.biSizeImage = row_size * h;
     tBmpInfoHead.biXPelsPerMeter = 0;
     tBmpInfoHead.biYPelsPerMeter = 0;
     tBmpInfoHead.biClrUsed = 0;
     tBmpInfoHead.biClrImportant = 0;
 
-    res = lv_fs_write(&f, &tBmpFileHead, sizeof(tBmpFileHead), &bw);
+    lv_fs_write(f, &tBmpFileHead, sizeof(tBmpFileHead), &bw);
     if (bw != sizeof(tBmpFileHead)) {
-        LV_LOG_USER("Can't write BMP File Head to %s", filename);
         return false;
     }
 
-    res = lv_fs_write(&f, &tBmpInfoHead, sizeof(tBmpInfoHead), &bw);
-    if (bw != sizeof(tBmpInfoHead)) {
-        LV_LOG_USER("Can't write BMP File Info Head to %s", filename);
+    lv_fs_write(f, &tBmpInfoHead, sizeof(tBmpInfoHead), &bw);
+    return bw == sizeof(tBmpInfoHead);
+}
+
+bool lve_screenshot_save_bmp_file(const uint8_t* image, uint32_t w, uint32_t h, uint32_t bpp, const char* filename) {
+    uint32_t dwSize;
+
+    uint32_t bw;
+    lv_fs_file_t f;
+
+    lv_fs_res_t res = lv_fs_open(&f, filename, LV_FS_MODE_WR);
+    if (res != LV_FS_RES_OK) {
+        LV_LOG_USER("Can't create output file %s", filename);
+        return false;
+    }
+
+    if (!lv_screenshot_write_bmp_header(&f, w, h, bpp, w * (bpp / 8))) {
+        LV_LOG_USER("Can't write BMP header to %s", filename);
         return false;
     }
 
@@ -0,0 +1,434 @@
+#include "save_png_stream.h"
+
+#define WINDOW_SIZE 4096
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+#define HASH_BITS 12
+#define HASH_SIZE (1 << HASH_BITS)
+#define CHAIN_LENGTH_MAX 16
+#define MATCH_LENGTH_MIN 3
+#define MATCH_LENGTH_MAX 258
+#define NO_POSITION 0xFFFF
+#define CHUNK_DATA_SIZE 4096
+#define ADLER_MODULO 65521
+// The largest number of bytes that can be added before the Adler-32 sums must be reduced
+#define ADLER_BLOCK_SIZE 5552
+#define BYTES_PER_PIXEL 3
+
+struct _lv_screenshot_png_stream_t {
+    lv_fs_file_t* file;
+    uint32_t row_size;
+    bool failed;
+
+    // PNG rows, as RGB
+    uint8_t* previous_row;
+    uint8_t* current_row;
+    // The filter type followed by the filtered row
+    uint8_t* filtered_row;
+
+    // Deflate: the last WINDOW_SIZE bytes that were encoded and the bytes that weren't encoded yet
+    uint8_t window[2 * WINDOW_SIZE];
+    uint32_t window_end;
+    uint32_t position;
+    // Hash chains of the 3 byte sequences in the window
+    uint16_t head[HASH_SIZE];
+    uint16_t previous[WINDOW_SIZE];
+    uint32_t bit_buffer;
+    uint32_t bit_count;
+    uint32_t adler_a;
+    uint32_t adler_b;
+
+    // The IDAT chunk that is being filled
+    uint8_t chunk[CHUNK_DATA_SIZE];
+    uint32_t chunk_length;
+};
+
+static const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA_BITS[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+    4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DISTANCE_EXTRA_BITS[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// region File output
+
+static void write_bytes(lv_screenshot_png_stream_t* stream, const void* data, uint32_t size) {
+    uint32_t written = 0;
+    if (!stream->failed && (lv_fs_write(stream->file, data, size, &written) != LV_FS_RES_OK || written != size)) {
+        stream->failed = true;
+    }
+}
+
+static void write_u32(lv_screenshot_png_stream_t* stream, uint32_t value) {
+    const uint8_t bytes[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+    write_bytes(stream, bytes, sizeof(bytes));
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, uint32_t size) {
+    static const uint32_t CRC_TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ CRC_TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC_TABLE[crc & 0x0F];
+    }
+    return crc;
+}
+
+static void write_chunk(lv_screenshot_png_stream_t* stream, const char* type, const uint8_t* data, uint32_t size) {
+    write_u32(stream, size);
+    write_bytes(stream, type, 4);
+    if (size > 0) {
+        write_bytes(stream, data, size);
+    }
+    uint32_t crc = crc32_update(0xFFFFFFFF, (const uint8_t*)type, 4);
+    crc = crc32_update(crc, data, size);
+    write_u32(stream, crc ^ 0xFFFFFFFF);
+}
+
+static void put_byte(lv_screenshot_png_stream_t* stream, uint8_t byte) {
+    stream->chunk[stream->chunk_length++] = byte;
+    if (stream->chunk_length == CHUNK_DATA_SIZE) {
+        write_chunk(stream, "IDAT", stream->chunk, stream->chunk_length);
+        stream->chunk_length = 0;
+    }
+}
+
+// endregion
+
+// region Deflate
+
+static void put_bits(lv_screenshot_png_stream_t* stream, uint32_t value, uint32_t count) {
+    stream->bit_buffer |= value << stream->bit_count;
+    stream->bit_count += count;
+    while (stream->bit_count >= 8) {
+        put_byte(stream, (uint8_t)stream->bit_buffer);
+        stream->bit_buffer >>= 8;
+        stream->bit_count -= 8;
+    }
+}
+
+/** Huffman codes are stored starting with their most significant bit */
+static uint32_t reverse_bits(uint32_t code, uint32_t count) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        result = (result << 1) | (code & 1);
+        code >>= 1;
+    }
+    return result;
+}
+
+/** Writes a literal/length symbol with the fixed Huffman code from RFC 1951 section 3.2.6 */
+static void put_symbol(lv_screenshot_png_stream_t* stream, uint32_t symbol) {
+    uint32_t code;
+    uint32_t length;
+    if (symbol < 144) {
+        code = 0x30 + symbol;
+        length = 8;
+    } else if (symbol < 256) {
+        code = 0x190 + symbol - 144;
+        length = 9;
+    } else if (symbol < 280) {
+        code = symbol - 256;
+        length = 7;
+    } else {
+        code = 0xC0 + symbol - 280;
+        length = 8;
+    }
+    put_bits(stream, reverse_bits(code, length), length);
+}
+
+static void put_match(lv_screenshot_png_stream_t* stream, uint32_t length, uint32_t distance) {
+    int length_index = 28;
+    while (LENGTH_BASE[length_index] > length) {
+        length_index--;
+    }
+    put_symbol(stream, 257 + length_index);
+    put_bits(stream, length - LENGTH_BASE[length_index], LENGTH_EXTRA_BITS[length_index]);
+
+    int distance_index = 29;
+    while (DISTANCE_BASE[distance_index] > distance) {
+        distance_index--;
+    }
+    put_bits(stream, reverse_bits(distance_index, 5), 5);
+    put_bits(stream, distance - DISTANCE_BASE[distance_index], DISTANCE_EXTRA_BITS[distance_index]);
+}
+
+static uint32_t hash_at(const lv_screenshot_png_stream_t* stream, uint32_t position) {
+    const uint8_t* bytes = stream->window + position;
+    uint32_t sequence = ((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 8) | bytes[2];
+    // Fibonacci hashing: the upper bits of the product depend on all the bytes
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void insert_position(lv_screenshot_png_stream_t* stream, uint32_t position) {
+    uint32_t hash = hash_at(stream, position);
+    stream->previous[position & WINDOW_MASK] = stream->head[hash];
+    stream->head[hash] = (uint16_t)position;
+}
+
+/** @return the length of the longest match, or 0 */
+static uint32_t find_match(const lv_screenshot_png_stream_t* stream, uint32_t max_length, uint32_t* distance) {
+    uint32_t position = stream->position;
+    uint32_t best_length = 0;
+    uint32_t candidate = stream->head[hash_at(stream, position)];
+    const uint8_t* current = stream->window + position;
+    for (int chain = 0; chain < CHAIN_LENGTH_MAX && candidate != NO_POSITION && position - candidate <= WINDOW_SIZE; chain++) {
+        const uint8_t* match = stream->window + candidate;
+        uint32_t length = 0;
+        while (length < max_length && match[length] == current[length]) {
+            length++;
+        }
+        if (length > best_length) {
+            best_length = length;
+            *distance = position - candidate;
+            if (length == max_length) {
+                break;
+            }
+        }
+        uint32_t next = stream->previous[candidate & WINDOW_MASK];
+        // The entry was overwritten by a newer position: the rest of the chain is out of the window
+        if (next >= candidate) {
+            break;
+        }
+        candidate = next;
+    }
+    return best_length >= MATCH_LENGTH_MIN ? best_length : 0;
+}
+
+/**
+ * Encodes the bytes in the window. Unless flushing, the last bytes are kept until more data arrives,
+ * so matches can be as long as possible.
+ */
+static void compress(lv_screenshot_png_stream_t* stream, bool flush) {
+    uint32_t lookahead_min = flush ? 1 : MATCH_LENGTH_MAX;
+    while (stream->window_end - stream->position >= lookahead_min) {
+        uint32_t available = stream->window_end - stream->position;
+        uint32_t length = 0;
+        uint32_t distance = 0;
+        if (available >= MATCH_LENGTH_MIN) {
+            length = find_match(stream, LV_MIN(available, MATCH_LENGTH_MAX), &distance);
+            insert_position(stream, stream->position);
+        }
+
+        if (length > 0) {
+            put_match(stream, length, distance);
+            for (uint32_t i = 1; i < length; i++) {
+                uint32_t position = stream->position + i;
+                if (stream->window_end - position >= MATCH_LENGTH_MIN) {
+                    insert_position(stream, position);
+                }
+            }
+            stream->position += length;
+        } else {
+            put_symbol(stream, stream->window[stream->position]);
+            stream->position++;
+        }
+    }
+}
+
+/** Moves the upper half of the window to the lower half */
+static void slide_window(lv_screenshot_png_stream_t* stream) {
+    lv_memcpy(stream->window, stream->window + WINDOW_SIZE, WINDOW_SIZE);
+    stream->position -= WINDOW_SIZE;
+    stream->window_end -= WINDOW_SIZE;
+    for (uint32_t i = 0; i < HASH_SIZE; i++) {
+        uint32_t position = stream->head[i];
+        stream->head[i] = (position != NO_POSITION && position >= WINDOW_SIZE) ? (uint16_t)(position - WINDOW_SIZE) : NO_POSITION;
+    }
+    for (uint32_t i = 0; i < WINDOW_SIZE; i++) {
+        uint32_t position = stream->previous[i];
+        stream->previous[i] = (position != NO_POSITION && position >= WINDOW_SIZE) ? (uint16_t)(position - WINDOW_SIZE) : NO_POSITION;
+    }
+}
+
+static void update_adler(lv_screenshot_png_stream_t* stream, const uint8_t* data, uint32_t size) {
+    uint32_t a = stream->adler_a;
+    uint32_t b = stream->adler_b;
+    while (size > 0) {
+        uint32_t block_size = LV_MIN(size, ADLER_BLOCK_SIZE);
+        for (uint32_t i = 0; i < block_size; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= ADLER_MODULO;
+        b %= ADLER_MODULO;
+        data += block_size;
+        size -= block_size;
+    }
+    stream->adler_a = a;
+    stream->adler_b = b;
+}
+
+static void deflate_write(lv_screenshot_png_stream_t* stream, const uint8_t* data, uint32_t size) {
+    update_adler(stream, data, size);
+    while (size > 0) {
+        // compress() leaves less than MATCH_LENGTH_MAX bytes, so the position is in the upper half
+        if (stream->window_end == 2 * WINDOW_SIZE) {
+            slide_window(stream);
+        }
+        uint32_t copy_size = LV_MIN(size, 2 * WINDOW_SIZE - stream->window_end);
+        lv_memcpy(stream->window + stream->window_end, data, copy_size);
+        stream->window_end += copy_size;
+        data += copy_size;
+        size -= copy_size;
+        compress(stream, false);
+    }
+}
+
+// endregion
+
+// region PNG rows
+
+static uint8_t paeth_predictor(uint8_t left, uint8_t above, uint8_t above_left) {
+    int estimate = left + above - above_left;
+    int left_distance = LV_ABS(estimate - left);
+    int above_distance = LV_ABS(estimate - above);
+    int above_left_distance = LV_ABS(estimate - above_left);
+    if (left_distance <= above_distance && left_distance <= above_left_distance) {
+        return left;
+    } else if (above_distance <= above_left_distance) {
+        return above;
+    } else {
+        return above_left;
+    }
+}
+
+static uint8_t filter_byte(uint8_t filter, const uint8_t* row, const uint8_t* previous_row, uint32_t index) {
+    uint8_t value = row[index];
+    uint8_t left = index >= BYTES_PER_PIXEL ? row[index - BYTES_PER_PIXEL] : 0;
+    uint8_t above = previous_row[index];
+    uint8_t above_left = index >= BYTES_PER_PIXEL ? previous_row[index - BYTES_PER_PIXEL] : 0;
+    switch (filter) {
+        case 1:
+            return value - left;
+        case 2:
+            return value - above;
+        case 3:
+            return value - (uint8_t)((left + above) / 2);
+        case 4:
+            return value - paeth_predictor(left, above, above_left);
+        default:
+            return value;
+    }
+}
+
+/** Picks the filter with the lowest sum of absolute differences, as recommended by the PNG specification */
+static uint8_t choose_filter(const lv_screenshot_png_stream_t* stream) {
+    uint8_t best_filter = 0;
+    uint32_t best_sum = UINT32_MAX;
+    for (uint8_t filter = 0; filter <= 4; filter++) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < stream->row_size && sum < best_sum; i++) {
+            int8_t difference = (int8_t)filter_byte(filter, stream->current_row, stream->previous_row, i);
+            sum += LV_ABS(difference);
+        }
+        if (sum < best_sum) {
+            best_sum = sum;
+            best_filter = filter;
+        }
+    }
+    return best_filter;
+}
+
+// endregion
+
+lv_screenshot_png_stream_t* lv_screenshot_png_stream_open(lv_fs_file_t* file, uint32_t w, uint32_t h) {
+    uint32_t row_size = w * BYTES_PER_PIXEL;
+    lv_screenshot_png_stream_t* stream = lv_malloc_zeroed(sizeof(lv_screenshot_png_stream_t) + 3 * row_size + 1);
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    stream->file = file;
+    stream->row_size = row_size;
+    stream->previous_row = (uint8_t*)(stream + 1);
+    stream->current_row = stream->previous_row + row_size;
+    stream->filtered_row = stream->current_row + row_size;
+    lv_memset(stream->head, 0xFF, sizeof(stream->head));
+    lv_memset(stream->previous, 0xFF, sizeof(stream->previous));
+    stream->adler_a = 1;
+
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    write_bytes(stream, SIGNATURE, sizeof(SIGNATURE));
+
+    const uint8_t header[13] = {
+        (uint8_t)(w >> 24), (uint8_t)(w >> 16), (uint8_t)(w >> 8), (uint8_t)w,
+        (uint8_t)(h >> 24), (uint8_t)(h >> 16), (uint8_t)(h >> 8), (uint8_t)h,
+        8, // Bit depth
+        2, // Color type: RGB
+        0, // Compression method: deflate
+        0, // Filter method: adaptive
+        0  // No interlacing
+    };
+    write_chunk(stream, "IHDR", header, sizeof(header));
+
+    // zlib header: deflate with a 4 KiB window (CINFO 4) and a check value that makes it a multiple of 31
+    put_byte(stream, 0x48);
+    put_byte(stream, 0x0D);
+    // A single final block with fixed Huffman codes
+    put_bits(stream, 1, 1);
+    put_bits(stream, 1, 2);
+
+    if (stream->failed) {
+        lv_free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+bool lv_screenshot_png_stream_write_row(lv_screenshot_png_stream_t* stream, const uint8_t* pixels) {
+    for (uint32_t i = 0; i < stream->row_size; i += BYTES_PER_PIXEL) {
+        stream->current_row[i] = pixels[i + 2];
+        stream->current_row[i + 1] = pixels[i + 1];
+        stream->current_row[i + 2] = pixels[i];
+    }
+
+    uint8_t filter = choose_filter(stream);
+    stream->filtered_row[0] = filter;
+    for (uint32_t i = 0; i < stream->row_size; i++) {
+        stream->filtered_row[i + 1] = filter_byte(filter, stream->current_row, stream->previous_row, i);
+    }
+    deflate_write(stream, stream->filtered_row, stream->row_size + 1);
+
+    uint8_t* previous_row = stream->previous_row;
+    stream->previous_row = stream->current_row;
+    stream->current_row = previous_row;
+    return !stream->failed;
+}
+
+bool lv_screenshot_png_stream_finish(lv_screenshot_png_stream_t* stream) {
+    compress(stream, true);
+    put_symbol(stream, 256); // End of block
+    if (stream->bit_count > 0) {
+        put_bits(stream, 0, 8 - stream->bit_count);
+    }
+
+    uint32_t adler = (stream->adler_b << 16) | stream->adler_a;
+    put_byte(stream, (uint8_t)(adler >> 24));
+    put_byte(stream, (uint8_t)(adler >> 16));
+    put_byte(stream, (uint8_t)(adler >> 8));
+    put_byte(stream, (uint8_t)adler);
+    if (stream->chunk_length > 0) {
+        write_chunk(stream, "IDAT", stream->chunk, stream->chunk_length);
+        stream->chunk_length = 0;
+    }
+    write_chunk(stream, "IEND", NULL, 0);
+    return !stream->failed;
+}
+
+void lv_screenshot_png_stream_free(lv_screenshot_png_stream_t* stream) {
+    lv_free(stream);
+}
+
+size_t lv_screenshot_png_stream_get_memory_size(const lv_screenshot_png_stream_t* stream) {
+    return sizeof(lv_screenshot_png_stream_t) + 3 * stream->row_size + 1;
+}
@@ -4,6 +4,7 @@
 #include <tactility/error.h>
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +22,26 @@ extern "C" {
  */
 error_t app_get_install_path(const char* app_id, char* path, size_t path_size);
 
+#define APP_INSTALL_SHA256_SIZE 32U
+
+/**
+ * Called while the package is extracted.
+ * @param[in] bytes_processed the amount of package bytes that were read so far
+ * @param[in] bytes_total the size of the package file
+ * @param[in] context AppInstallOptions::progress_context
+ */
+typedef void (*AppInstallProgressCallback)(size_t bytes_processed, size_t bytes_total, void* context);
+
+struct AppInstallOptions {
+    /** Nullable: reports extraction progress */
+    AppInstallProgressCallback progress_callback;
+    void* progress_context;
+    /** Nullable: the SHA-256 (APP_INSTALL_SHA256_SIZE bytes) that the package file must have */
+    const uint8_t* expected_sha256;
+    /** Nullable: receives the SHA-256 (APP_INSTALL_SHA256_SIZE bytes) of the package file */
+    uint8_t* sha256_out;
+};
+
 /**
  * Installs an app from a tarball at @a source_path: extracts it into the app install directory,
  * parses the extracted manifest.properties (see app/metadata.h) to determine its id, then
@@ -36,6 +57,37 @@ error_t app_get_install_path(const char* app_id, char* path, size_t path_size);
  */
 error_t app_install(const char* source_path);
 
+/**
+ * Like app_install(), with integrity verification and progress reporting.
+ * The package is extracted in a single pass into a staging directory while its SHA-256 is calculated.
+ * The previous install of the app is only replaced after the package was verified.
+ * @param[in] source_path path to a tar file containing the app (must have manifest.properties
+ * at its root)
+ * @param[in] options nullable options
+ * @retval ERROR_NONE on success
+ * @retval ERROR_NOT_FOUND @a source_path doesn't exist / can't be read or extracted
+ * @retval ERROR_INVALID_ARGUMENT the tarball has no valid manifest.properties at its root
+ * @retval ERROR_NOT_ALLOWED the package doesn't match AppInstallOptions::expected_sha256
+ * @retval ERROR_OUT_OF_MEMORY when the extraction buffer can't be allocated
+ * @retval ERROR_RESOURCE when the previous install couldn't be unregistered, or when the new app couldn't be moved
+ *         into its place, in which case the previous install is kept
+ */
+error_t app_install_with_options(const char* source_path, const struct AppInstallOptions* options);
+
+/**
+ * Called after the files of an app changed: its directory was replaced by an install, or deleted by an uninstall.
+ * @param[in] path the app directory
+ */
+typedef void (*AppFilesChangedCallback)(const char* path);
+
+/**
+ * Set the callback for changes to the files of installed apps, e.g. to drop cached file content of an app.
+ * A reinstalled file can have the same modification time and size as the previous one (e.g. on FAT without a
+ * valid clock), so caches can't rely on those to notice the change.
+ * @param[in] callback nullable callback
+ */
+void app_install_set_files_changed_callback(AppFilesChangedCallback callback);
+
 /**
  * Uninstalls a previously app_install()-ed app: stops it if currently running, deletes its
  * install directory, and unregisters it (app_manager_remove()).
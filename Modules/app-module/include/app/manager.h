@@ -137,9 +137,24 @@ error_t app_manager_install_path_add(const char* path);
  * already registered, and unregisters (app_manager_remove() only - does not stop it if running,
  * does not delete anything) any manifest a previous scan registered whose directory has since
  * disappeared. Safe to call repeatedly (e.g. after an SD card is mounted/unmounted).
+ * Each path keeps an index of parsed manifests in a hidden ".app_index" file: a manifest is only
+ * parsed again when its modification time or size changed since it was indexed.
  */
 void app_manager_install_path_scan(void);
 
+struct AppManagerIndexStats {
+    /** Manifests that were unchanged since they were indexed, so they weren't parsed again */
+    uint32_t hits;
+    /** Manifests that were new or changed, and had to be parsed */
+    uint32_t misses;
+};
+
+/**
+ * Gets the manifest index counters of app_manager_install_path_scan(), accumulated over all scans since boot.
+ * @param[out] out_stats the counters
+ */
+void app_manager_install_path_get_index_stats(struct AppManagerIndexStats* out_stats);
+
 /**
  * Uninstalls an app that was registered via app_manager_install_path_scan() (i.e. discovered on
  * disk, not installed via app_install()). Stops running instances, removes the manifest
@@ -8,6 +8,7 @@
 
 #include <tactility/filesystem/file_mutex.h>
 
+#include <cstdint>
 #include <cstring>
 #include <dirent.h>
 #include <string>
@@ -19,6 +20,9 @@
 #endif
 #include <vector>
 
+// Reports a replaced or deleted app directory to the callback of app_install_set_files_changed_callback()
+void app_fs_notify_files_changed(const std::string& path);
+
 inline bool app_fs_is_directory(const std::string& path) {
     struct stat result {};
     FileMutex file_mutex;
@@ -39,6 +43,22 @@ inline bool app_fs_is_file(const std::string& path) {
     return retval;
 }
 
+// Gets the modification time (in seconds) and size of the regular file at @a path.
+// Returns false if it doesn't exist or isn't a regular file.
+inline bool app_fs_get_file_info(const std::string& path, int64_t& out_mtime, int64_t& out_size) {
+    FileMutex file_mutex;
+    file_mutex_get(&file_mutex, path.c_str());
+    file_mutex_lock(&file_mutex);
+    struct stat result {};
+    auto retval = stat(path.c_str(), &result) == 0 && S_ISREG(result.st_mode);
+    file_mutex_unlock(&file_mutex);
+    if (retval) {
+        out_mtime = static_cast<int64_t>(result.st_mtime);
+        out_size = static_cast<int64_t>(result.st_size);
+    }
+    return retval;
+}
+
 // Appends the full path of every direct subdirectory of @a path to @a out.
 // No-op (not an error) if @a path can't be opened.
 inline bool app_fs_delete_recursively(const std::string& path) {
@@ -141,7 +161,8 @@ inline void app_fs_list_direct_subdirectories(const std::string& path, std::vect
 
     struct dirent* entry;
     while ((entry = readdir(dir)) != nullptr) {
-        if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) {
+        // Also skips hidden directories, such as app_install()'s staging directories
+        if (entry->d_name[0] == '.') {
             continue;
         }
         children.push_back(path + "/" + entry->d_name);
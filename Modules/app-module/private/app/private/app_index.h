@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+// Persistent index of the manifests in one install root, so app_manager_install_path_scan() only
+// has to parse manifest.properties files that are new or changed since the previous scan -
+// parsing every manifest on each boot takes seconds on an SD card with many apps.
+//
+// The index is a small text file at {root}/.app_index (hidden, so app_fs_list_direct_subdirectories()
+// skips it) with one line per app directory. An entry is only trusted while the manifest's
+// modification time and size still match what was recorded when it was parsed.
+
+#include <app/metadata.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+constexpr auto* APP_INDEX_FILE_NAME = ".app_index";
+
+struct AppIndexEntry {
+    int64_t manifest_mtime;
+    int64_t manifest_size;
+    AppMetadata metadata;
+};
+
+/** Entries by app directory name (relative to the install root) */
+typedef std::unordered_map<std::string, AppIndexEntry> AppIndex;
+
+/**
+ * Loads the index of @a root into @a out_index.
+ * A missing, outdated or corrupt index file results in an empty index: the caller then parses
+ * every manifest again and saves a fresh index.
+ * @return true when the index file was read
+ */
+bool app_index_load(const std::string& root, AppIndex& out_index);
+
+/**
+ * Replaces the index file of @a root with @a index.
+ * @return true on success
+ */
+bool app_index_save(const std::string& root, const AppIndex& index);
+
+/**
+ * Drops the index entry of an app directory that was installed, replaced or deleted, so the next scan
+ * parses its manifest again: a rewritten manifest can keep its modification time and size, e.g. on FAT
+ * without a valid clock. Waits for a running app_manager_install_path_scan(), so it can't write the
+ * entry back. Implemented in manager.cpp, which serializes the scans.
+ * @warning Don't call this while holding a file lock: the scan takes those while it holds its own lock.
+ * @param[in] app_path the app directory, e.g. {root}/{app id}
+ */
+void app_index_forget(const std::string& app_path);
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <app/private/app_index.h>
+
+#include <tactility/filesystem/file_mutex.h>
+#include <tactility/log.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+constexpr auto* TAG = "app_index";
+
+namespace {
+
+/** Bump when the line format changes: older index files are then ignored and rebuilt */
+constexpr auto* INDEX_HEADER = "app_index 1";
+
+constexpr size_t FIELD_COUNT = 9;
+
+std::vector<std::string> split(const std::string& line, char separator) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        auto end = line.find(separator, start);
+        if (end == std::string::npos) {
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+bool parse_int64(const std::string& value, int64_t& out_value) {
+    if (value.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    out_value = std::strtoll(value.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+bool parse_uint64(const std::string& value, uint64_t& out_value) {
+    if (value.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    out_value = std::strtoull(value.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+template<size_t Size>
+bool copy_field(const std::string& value, char (&out_buffer)[Size]) {
+    if (value.size() >= Size) {
+        return false;
+    }
+    std::memcpy(out_buffer, value.c_str(), value.size() + 1);
+    return true;
+}
+
+/** Line format: directory, mtime, size, id, name, version name, version code, target sdk, required device ids */
+bool parse_entry(const std::string& line, std::string& out_directory_name, AppIndexEntry& out_entry) {
+    auto fields = split(line, '\t');
+    if (fields.size() != FIELD_COUNT || fields[0].empty()) {
+        return false;
+    }
+
+    out_entry = {};
+    out_directory_name = fields[0];
+    return parse_int64(fields[1], out_entry.manifest_mtime) &&
+        parse_int64(fields[2], out_entry.manifest_size) &&
+        copy_field(fields[3], out_entry.metadata.app_id) &&
+        copy_field(fields[4], out_entry.metadata.app_name) &&
+        copy_field(fields[5], out_entry.metadata.app_version_name) &&
+        parse_uint64(fields[6], out_entry.metadata.app_version_code) &&
+        copy_field(fields[7], out_entry.metadata.target_sdk) &&
+        copy_field(fields[8], out_entry.metadata.requires_device_id);
+}
+
+bool is_storable(const char* value) {
+    return std::strpbrk(value, "\t\r\n") == nullptr;
+}
+
+bool is_storable(const std::string& directory_name, const AppIndexEntry& entry) {
+    const auto& metadata = entry.metadata;
+    return is_storable(directory_name.c_str()) &&
+        is_storable(metadata.app_id) &&
+        is_storable(metadata.app_name) &&
+        is_storable(metadata.app_version_name) &&
+        is_storable(metadata.target_sdk) &&
+        is_storable(metadata.requires_device_id);
+}
+
+} // namespace
+
+bool app_index_load(const std::string& root, AppIndex& out_index) {
+    out_index.clear();
+    auto path = root + "/" + APP_INDEX_FILE_NAME;
+
+    FileMutex mutex;
+    file_mutex_get(&mutex, path.c_str());
+    file_mutex_lock(&mutex);
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        file_mutex_unlock(&mutex);
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) || line != INDEX_HEADER) {
+        file_mutex_unlock(&mutex);
+        LOG_W(TAG, "Ignoring outdated or corrupt index at %s", path.c_str());
+        return false;
+    }
+
+    while (std::getline(file, line)) {
+        std::string directory_name;
+        AppIndexEntry entry;
+        if (!parse_entry(line, directory_name, entry)) {
+            file_mutex_unlock(&mutex);
+            LOG_W(TAG, "Ignoring corrupt index at %s", path.c_str());
+            out_index.clear();
+            return false;
+        }
+        out_index[directory_name] = entry;
+    }
+
+    file_mutex_unlock(&mutex);
+    return true;
+}
+
+bool app_index_save(const std::string& root, const AppIndex& index) {
+    auto path = root + "/" + APP_INDEX_FILE_NAME;
+    auto temp_path = path + ".tmp";
+
+    FileMutex mutex;
+    file_mutex_get(&mutex, path.c_str());
+    file_mutex_lock(&mutex);
+
+    FILE* file = std::fopen(temp_path.c_str(), "w");
+    if (file == nullptr) {
+        file_mutex_unlock(&mutex);
+        LOG_W(TAG, "Failed to create %s", temp_path.c_str());
+        return false;
+    }
+
+    bool success = std::fprintf(file, "%s\n", INDEX_HEADER) > 0;
+    for (const auto& [directory_name, entry] : index) {
+        if (!success) {
+            break;
+        }
+        // Entries that can't be stored are parsed again by the next scan
+        if (!is_storable(directory_name, entry)) {
+            continue;
+        }
+        const auto& metadata = entry.metadata;
+        success = std::fprintf(file, "%s\t%" PRId64 "\t%" PRId64 "\t%s\t%s\t%s\t%" PRIu64 "\t%s\t%s\n",
+            directory_name.c_str(),
+            entry.manifest_mtime,
+            entry.manifest_size,
+            metadata.app_id,
+            metadata.app_name,
+            metadata.app_version_name,
+            metadata.app_version_code,
+            metadata.target_sdk,
+            metadata.requires_device_id
+        ) > 0;
+    }
+    success = (std::fclose(file) == 0) && success;
+
+    // FAT can't rename over an existing file. A missing index is harmless: the next scan rebuilds it.
+    if (success) {
+        std::remove(path.c_str());
+        success = std::rename(temp_path.c_str(), path.c_str()) == 0;
+    }
+    if (!success) {
+        std::remove(temp_path.c_str());
+        LOG_W(TAG, "Failed to write %s", path.c_str());
+    }
+
+    file_mutex_unlock(&mutex);
+    return success;
+}
@@ -5,6 +5,7 @@
 #include <app/metadata.h>
 
 #include <app/private/app_fs.h>
+#include <app/private/app_index.h>
 #include <app/private/app_ledger.h>
 
 #include <tactility/concurrent/mutex.h>
@@ -12,9 +13,14 @@
 #include <tactility/log.h>
 #include <tactility/paths.h>
 
-#include <minitar.h>
+#include <tactility/time.h>
 
+#include <mbedtls/sha256.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <dirent.h>
@@ -22,14 +28,18 @@
 #include <unistd.h>
 
 #include <memory>
+#include <new>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 constexpr auto* TAG = "app_install";
 
 namespace {
 
+std::atomic<AppFilesChangedCallback> files_changed_callback = nullptr;
+
 // region Filesystem helpers (app-module may not depend upward on Tactility::file - see
 // app_metadata_parsing.cpp for the same constraint applied to properties-file loading)
 
@@ -81,61 +91,319 @@ bool get_app_install_directory(std::string& out_path) {
 
 // endregion
 
-// region Tar extraction (ported from the old Tactility::app AppInstall.cpp)
+// region Streaming tar extraction
+
+constexpr size_t TAR_BLOCK_SIZE = 512;
+// Archive reads and file writes are done in chunks of this size: SD card throughput drops sharply with small transfers
+constexpr size_t EXTRACT_BUFFER_SIZE = 16 * 1024;
+
+// POSIX ustar header
+struct TarHeader {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char type;
+    char link_name[100];
+    char magic[6];
+    char version[2];
+    char user_name[32];
+    char group_name[32];
+    char device_major[8];
+    char device_minor[8];
+    char prefix[155];
+    char padding[12];
+};
 
-bool untar_file(minitar* archive, const minitar_entry* entry, const std::string& destination_path) {
-    auto absolute_path = destination_path + "/" + entry->metadata.path;
-    if (!ensure_directory_recursive(destination_path)) {
-        LOG_E(TAG, "Can't find or create directory %s", destination_path.c_str());
-        return false;
+static_assert(sizeof(TarHeader) == TAR_BLOCK_SIZE);
+
+uint64_t parse_octal(const char* field, size_t length) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < length && field[i] != '\0' && field[i] != ' '; i++) {
+        if (field[i] < '0' || field[i] > '7') {
+            break;
+        }
+        value = (value << 3U) | static_cast<uint64_t>(field[i] - '0');
     }
+    return value;
+}
 
-    if (!minitar_read_contents_to_file(archive, entry, absolute_path.c_str())) {
-        LOG_E(TAG, "Failed to write data to %s", absolute_path.c_str());
-        return false;
+bool is_zero_block(const uint8_t* block) {
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+        if (block[i] != 0) {
+            return false;
+        }
     }
+    return true;
+}
 
-    // Note: fchmod() doesn't exist on ESP-IDF and chmod() does nothing on that platform.
-    chmod(absolute_path.c_str(), entry->metadata.mode);
+bool is_valid_checksum(const uint8_t* block) {
+    const auto* header = reinterpret_cast<const TarHeader*>(block);
+    uint64_t expected = parse_octal(header->checksum, sizeof(header->checksum));
+    size_t checksum_offset = offsetof(TarHeader, checksum);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+        bool in_checksum = i >= checksum_offset && i < checksum_offset + sizeof(header->checksum);
+        sum += in_checksum ? ' ' : block[i];
+    }
+    return sum == expected;
+}
+
+std::string get_entry_path(const TarHeader* header) {
+    std::string name(header->name, strnlen(header->name, sizeof(header->name)));
+    size_t prefix_length = strnlen(header->prefix, sizeof(header->prefix));
+    if (prefix_length > 0) {
+        name = std::string(header->prefix, prefix_length) + "/" + name;
+    }
+    while (name.starts_with("./")) {
+        name.erase(0, 2);
+    }
+    while (!name.empty() && name.back() == '/') {
+        name.pop_back();
+    }
+    return name;
+}
 
+// Rejects absolute paths and ".." segments, so an archive can't write outside of the staging directory
+bool is_safe_entry_path(const std::string& path) {
+    if (path.starts_with('/')) {
+        return false;
+    }
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        if (path.compare(start, end - start, "..") == 0) {
+            return false;
+        }
+        start = end + 1;
+    }
     return true;
 }
 
-bool untar_directory(const minitar_entry* entry, const std::string& destination_path) {
-    return ensure_directory_recursive(destination_path + "/" + entry->metadata.path);
+// Reads the archive sequentially through one large buffer, hashing and reporting progress along the way
+class ArchiveReader {
+
+    FILE* file;
+    std::unique_ptr<uint8_t[]> buffer;
+    size_t position = 0;
+    size_t length = 0;
+    size_t bytes_read = 0;
+    size_t bytes_total;
+    mbedtls_sha256_context sha256 {};
+    const AppInstallOptions* options;
+
+    bool fill() {
+        if (position < length) {
+            return true;
+        }
+        length = fread(buffer.get(), 1, EXTRACT_BUFFER_SIZE, file);
+        position = 0;
+        if (length == 0) {
+            return false;
+        }
+        mbedtls_sha256_update(&sha256, buffer.get(), length);
+        bytes_read += length;
+        if (options != nullptr && options->progress_callback != nullptr) {
+            options->progress_callback(bytes_read, bytes_total, options->progress_context);
+        }
+        return true;
+    }
+
+public:
+
+    ArchiveReader(FILE* file, size_t bytes_total, const AppInstallOptions* options) :
+        file(file),
+        buffer(new(std::nothrow) uint8_t[EXTRACT_BUFFER_SIZE]),
+        bytes_total(bytes_total),
+        options(options) {
+        mbedtls_sha256_init(&sha256);
+        mbedtls_sha256_starts(&sha256, 0);
+    }
+
+    ~ArchiveReader() {
+        mbedtls_sha256_free(&sha256);
+    }
+
+    bool is_valid() const { return buffer != nullptr; }
+
+    bool read(void* output, size_t size) {
+        auto* output_bytes = static_cast<uint8_t*>(output);
+        while (size > 0) {
+            if (!fill()) {
+                return false;
+            }
+            size_t chunk = std::min(size, length - position);
+            memcpy(output_bytes, buffer.get() + position, chunk);
+            position += chunk;
+            output_bytes += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    // Write the next @a size bytes to @a output (nullable: skip them instead)
+    bool copy(FILE* output, size_t size) {
+        while (size > 0) {
+            if (!fill()) {
+                return false;
+            }
+            size_t chunk = std::min(size, length - position);
+            if (output != nullptr && fwrite(buffer.get() + position, 1, chunk, output) != chunk) {
+                return false;
+            }
+            position += chunk;
+            size -= chunk;
+        }
+        return true;
+    }
+
+    // Consume the remainder of the file (tar files are padded to a record size) and finish the hash
+    void finish(uint8_t sha256_out[APP_INSTALL_SHA256_SIZE]) {
+        position = length;
+        while (fill()) {
+            position = length;
+        }
+        mbedtls_sha256_finish(&sha256, sha256_out);
+    }
+
+    size_t get_bytes_read() const { return bytes_read; }
+};
+
+struct ExtractContext {
+    std::string destination_path;
+    // Directories that are known to exist, so nested entries don't stat() every parent again
+    std::unordered_set<std::string> directories;
+    size_t file_count = 0;
+};
+
+bool ensure_directory_cached(ExtractContext& context, const std::string& path) {
+    if (context.directories.contains(path)) {
+        return true;
+    }
+    auto parent_index = path.find_last_of('/');
+    if (parent_index != std::string::npos && parent_index > 0) {
+        if (!ensure_directory_cached(context, path.substr(0, parent_index))) {
+            return false;
+        }
+    }
+    if (!ensure_directory(path)) {
+        return false;
+    }
+    context.directories.insert(path);
+    return true;
 }
 
-bool untar(const std::string& tar_path, const std::string& destination_path) {
-    minitar archive {};
-    if (minitar_open(tar_path.c_str(), &archive) != 0) {
-        LOG_E(TAG, "Failed to open %s", tar_path.c_str());
+bool extract_file(ArchiveReader& reader, ExtractContext& context, const std::string& entry_path, const TarHeader* header, uint64_t size) {
+    auto absolute_path = context.destination_path + "/" + entry_path;
+    auto parent_index = absolute_path.find_last_of('/');
+    if (!ensure_directory_cached(context, absolute_path.substr(0, parent_index))) {
+        LOG_E(TAG, "Can't find or create directory for %s", absolute_path.c_str());
         return false;
     }
 
-    bool success = true;
-    minitar_entry entry {};
-    while (minitar_read_entry(&archive, &entry) == 0) {
-        LOG_I(TAG, "Extracting %s", entry.metadata.path);
-        if (entry.metadata.type == MTAR_DIRECTORY) {
-            if (std::strcmp(entry.metadata.name, ".") == 0 || std::strcmp(entry.metadata.name, "..") == 0 || std::strcmp(entry.metadata.name, "/") == 0) {
-                continue;
-            }
-            success = untar_directory(&entry, destination_path);
-        } else if (entry.metadata.type == MTAR_REGULAR) {
-            success = untar_file(&archive, &entry, destination_path);
+    FILE* output = fopen(absolute_path.c_str(), "wb");
+    if (output == nullptr) {
+        LOG_E(TAG, "Failed to open %s", absolute_path.c_str());
+        return false;
+    }
+    // Writes come from the archive buffer in large chunks already
+    setvbuf(output, nullptr, _IONBF, 0);
+    bool success = reader.copy(output, size);
+    success = (fclose(output) == 0) && success;
+    if (!success) {
+        LOG_E(TAG, "Failed to write data to %s", absolute_path.c_str());
+        return false;
+    }
+
+    // Note: fchmod() doesn't exist on ESP-IDF and chmod() does nothing on that platform.
+    chmod(absolute_path.c_str(), static_cast<mode_t>(parse_octal(header->mode, sizeof(header->mode))));
+    context.file_count++;
+    return true;
+}
+
+bool extract_entries(ArchiveReader& reader, ExtractContext& context) {
+    uint8_t block[TAR_BLOCK_SIZE];
+    while (true) {
+        if (!reader.read(block, TAR_BLOCK_SIZE)) {
+            LOG_E(TAG, "Unexpected end of archive");
+            return false;
+        }
+        if (is_zero_block(block)) {
+            return true; // End of archive
+        }
+        if (!is_valid_checksum(block)) {
+            LOG_E(TAG, "Corrupt tar header");
+            return false;
+        }
+
+        const auto* header = reinterpret_cast<const TarHeader*>(block);
+        auto entry_path = get_entry_path(header);
+        uint64_t size = parse_octal(header->size, sizeof(header->size));
+        uint64_t padding = (TAR_BLOCK_SIZE - (size % TAR_BLOCK_SIZE)) % TAR_BLOCK_SIZE;
+        if (!is_safe_entry_path(entry_path)) {
+            LOG_E(TAG, "Unsafe path in archive: %s", entry_path.c_str());
+            return false;
+        }
+
+        LOG_D(TAG, "Extracting %s", entry_path.c_str());
+        bool success;
+        if (header->type == '5') {
+            success = entry_path.empty() || ensure_directory_cached(context, context.destination_path + "/" + entry_path);
+        } else if ((header->type == '0' || header->type == '\0') && !entry_path.empty()) {
+            success = extract_file(reader, context, entry_path, header, size);
+            size = 0;
         } else {
-            LOG_E(TAG, "Unsupported entry type: %d", static_cast<int>(entry.metadata.type));
+            LOG_E(TAG, "Unsupported entry type: %d", static_cast<int>(header->type));
             success = false;
         }
 
-        if (!success) {
-            LOG_E(TAG, "Failed to extract %s", entry.metadata.path);
-            break;
+        if (!success || !reader.copy(nullptr, size + padding)) {
+            LOG_E(TAG, "Failed to extract %s", entry_path.c_str());
+            return false;
         }
     }
+}
+
+/**
+ * Extract @a tar_path into @a destination_path in a single pass over the archive.
+ * @param[out] sha256_out the SHA-256 of the whole archive file
+ */
+error_t untar(const std::string& tar_path, const std::string& destination_path, const AppInstallOptions* options, uint8_t sha256_out[APP_INSTALL_SHA256_SIZE]) {
+    FILE* file = fopen(tar_path.c_str(), "rb");
+    if (file == nullptr) {
+        LOG_E(TAG, "Failed to open %s", tar_path.c_str());
+        return ERROR_NOT_FOUND;
+    }
+    setvbuf(file, nullptr, _IONBF, 0);
 
-    minitar_close(&archive);
-    return success;
+    struct stat file_stat {};
+    size_t file_size = (fstat(fileno(file), &file_stat) == 0) ? static_cast<size_t>(file_stat.st_size) : 0;
+
+    ArchiveReader reader(file, file_size, options);
+    if (!reader.is_valid()) {
+        fclose(file);
+        return ERROR_OUT_OF_MEMORY;
+    }
+
+    ExtractContext context { .destination_path = destination_path };
+    uint64_t start_time = get_micros_since_boot();
+    bool success = ensure_directory_cached(context, destination_path) && extract_entries(reader, context);
+    reader.finish(sha256_out);
+    fclose(file);
+
+    if (!success) {
+        return ERROR_NOT_FOUND;
+    }
+
+    uint64_t duration_ms = (get_micros_since_boot() - start_time) / 1000U;
+    LOG_I(TAG, "Extracted %u files (%u bytes) in %u ms", (unsigned)context.file_count, (unsigned)reader.get_bytes_read(), (unsigned)duration_ms);
+    return ERROR_NONE;
 }
 
 // endregion
@@ -221,7 +489,8 @@ void stop_all_instances_of(const AppManifest* manifest) {
 }
 
 // Caller must already hold install_registry().mutex
-error_t uninstall_locked(const std::string& app_id) {
+// @param[in] delete_files false when the caller replaces the install directory itself
+error_t uninstall_locked(const std::string& app_id, bool delete_files = true) {
     auto& registry = install_registry();
     auto iterator = registry.apps.find(app_id);
     if (iterator == registry.apps.end()) {
@@ -235,7 +504,11 @@ error_t uninstall_locked(const std::string& app_id) {
 
     stop_all_instances_of(&iterator->second->manifest);
     app_manager_remove(app_id.c_str());
-    delete_recursively(iterator->second->path);
+    if (delete_files) {
+        delete_recursively(iterator->second->path);
+        app_fs_notify_files_changed(iterator->second->path);
+        app_index_forget(iterator->second->path);
+    }
     registry.apps.erase(iterator);
 
     return ERROR_NONE;
@@ -245,8 +518,19 @@ error_t uninstall_locked(const std::string& app_id) {
 
 } // namespace
 
+void app_fs_notify_files_changed(const std::string& path) {
+    auto callback = files_changed_callback.load();
+    if (callback != nullptr) {
+        callback(path.c_str());
+    }
+}
+
 extern "C" {
 
+void app_install_set_files_changed_callback(AppFilesChangedCallback callback) {
+    files_changed_callback.store(callback);
+}
+
 error_t app_get_install_path(const char* app_id, char* path, size_t path_size) {
     if (path_size == 0) {
         return ERROR_BUFFER_OVERFLOW;
@@ -268,6 +552,10 @@ error_t app_get_install_path(const char* app_id, char* path, size_t path_size) {
 }
 
 error_t app_install(const char* source_path) {
+    return app_install_with_options(source_path, nullptr);
+}
+
+error_t app_install_with_options(const char* source_path, const AppInstallOptions* options) {
     LOG_I(TAG, "Installing app from %s", source_path);
 
     std::string app_parent_path;
@@ -280,7 +568,8 @@ error_t app_install(const char* source_path) {
         return ERROR_NOT_FOUND;
     }
 
-    auto staging_path = app_parent_path + "/" + last_path_segment(source_path);
+    // Hidden, so app_manager_install_path_scan() doesn't pick up a half-extracted app
+    auto staging_path = app_parent_path + "/.staging-" + last_path_segment(source_path);
     delete_recursively(staging_path);
 
     FileMutex target_mutex {};
@@ -288,16 +577,28 @@ error_t app_install(const char* source_path) {
     FileMutex source_mutex {};
     file_mutex_get(&source_mutex, source_path);
 
+    uint8_t sha256[APP_INSTALL_SHA256_SIZE];
     file_mutex_lock(&target_mutex);
     file_mutex_lock(&source_mutex);
-    bool untar_success = untar(source_path, staging_path);
+    error_t untar_result = untar(source_path, staging_path, options, sha256);
     file_mutex_unlock(&source_mutex);
     file_mutex_unlock(&target_mutex);
 
-    if (!untar_success) {
+    if (untar_result != ERROR_NONE) {
         LOG_E(TAG, "Failed to extract %s", source_path);
         delete_recursively(staging_path);
-        return ERROR_NOT_FOUND;
+        return untar_result;
+    }
+
+    if (options != nullptr && options->sha256_out != nullptr) {
+        memcpy(options->sha256_out, sha256, APP_INSTALL_SHA256_SIZE);
+    }
+
+    // Verified before anything happens to a previous install, so a corrupt package never replaces a working app
+    if (options != nullptr && options->expected_sha256 != nullptr && memcmp(options->expected_sha256, sha256, APP_INSTALL_SHA256_SIZE) != 0) {
+        LOG_E(TAG, "Install failed: SHA-256 mismatch for %s", source_path);
+        delete_recursively(staging_path);
+        return ERROR_NOT_ALLOWED;
     }
 
     auto manifest_path = staging_path + "/manifest.properties";
@@ -323,7 +624,7 @@ error_t app_install(const char* source_path) {
     // (manager.cpp's separate registry, scanning this same directory tree), which
     // uninstall_locked() doesn't know about. Clear the app-manager registration unconditionally
     // too, or app_manager_add() below rejects the re-add as a duplicate.
-    uninstall_locked(metadata.app_id);
+    uninstall_locked(metadata.app_id, false);
 
     error_t remove_result = app_manager_remove(metadata.app_id);
     if (remove_result != ERROR_NONE && remove_result != ERROR_NOT_FOUND) {
@@ -333,18 +634,47 @@ error_t app_install(const char* source_path) {
         return ERROR_RESOURCE;
     }
 
+    // Swap the directories with renames, so the app directory always holds either the old or the new app
     auto final_path = app_parent_path + "/" + metadata.app_id;
-    delete_recursively(final_path);
+    auto replaced_path = app_parent_path + "/.replaced-" + metadata.app_id;
+    delete_recursively(replaced_path);
 
     file_mutex_lock(&target_mutex);
-    bool rename_success = rename(staging_path.c_str(), final_path.c_str()) == 0;
+    bool has_previous = app_fs_is_directory(final_path);
+    bool rename_success = !has_previous || rename(final_path.c_str(), replaced_path.c_str()) == 0;
+    bool is_previous_restored = has_previous && !rename_success;
+    if (rename_success && rename(staging_path.c_str(), final_path.c_str()) != 0) {
+        rename_success = false;
+        is_previous_restored = has_previous && rename(replaced_path.c_str(), final_path.c_str()) == 0;
+    }
+    if (rename_success) {
+        // After the swap and under the lock, so cached content of the previous app can't be stored again in between
+        app_fs_notify_files_changed(final_path);
+    }
     file_mutex_unlock(&target_mutex);
 
     if (!rename_success) {
         LOG_E(TAG, "Failed to rename \"%s\" to \"%s\"", staging_path.c_str(), final_path.c_str());
         delete_recursively(staging_path);
+        // The previous app was unregistered above: register it again, so a failed update doesn't uninstall it
+        if (is_previous_restored) {
+            AppMetadata previous_metadata {};
+            auto previous_manifest_path = final_path + "/manifest.properties";
+            if (app_metadata_parse(previous_manifest_path.c_str(), &previous_metadata) == ERROR_NONE) {
+                register_installed_app_locked(final_path, previous_metadata);
+            } else {
+                LOG_E(TAG, "Failed to restore the registration of %s", final_path.c_str());
+            }
+        }
         mutex_unlock(&registry.mutex);
-        return ERROR_NOT_FOUND;
+        return ERROR_RESOURCE;
+    }
+
+    // Not under the file lock, see app_index_forget()
+    app_index_forget(final_path);
+
+    if (has_previous) {
+        delete_recursively(replaced_path);
     }
 
     // Only remaining failure mode is a duplicate id - can't happen, uninstall_locked() above
@@ -2,6 +2,7 @@
 #include <app/manager.h>
 #include <app/metadata.h>
 #include <app/private/app_fs.h>
+#include <app/private/app_index.h>
 #include <app/private/app_ledger.h>
 #include <app/private/app_scheduler.h>
 
@@ -217,9 +218,16 @@ struct ScannedAppManifest {
 struct InstallPathRegistry {
     std::vector<std::string> paths;
     std::unordered_map<std::string, std::unique_ptr<ScannedAppManifest>> scanned;
+    AppManagerIndexStats index_stats {};
     Mutex mutex {};
+    // Serializes app_manager_install_path_scan() calls, so concurrent scans don't both rewrite
+    // the same index file. Taken before (never while holding) mutex or the ledger mutex.
+    Mutex scan_mutex {};
 
-    InstallPathRegistry() { mutex_construct(&mutex); }
+    InstallPathRegistry() {
+        mutex_construct(&mutex);
+        mutex_construct(&scan_mutex);
+    }
 };
 
 InstallPathRegistry& install_path_registry() {
@@ -229,6 +237,23 @@ InstallPathRegistry& install_path_registry() {
 
 } // namespace
 
+void app_index_forget(const std::string& app_path) {
+    auto separator_index = app_path.find_last_of('/');
+    if (separator_index == std::string::npos || separator_index == 0) {
+        return;
+    }
+    auto root = app_path.substr(0, separator_index);
+    auto directory_name = app_path.substr(separator_index + 1);
+
+    auto& registry = install_path_registry();
+    mutex_lock(&registry.scan_mutex);
+    AppIndex index;
+    if (app_index_load(root, index) && index.erase(directory_name) > 0) {
+        app_index_save(root, index);
+    }
+    mutex_unlock(&registry.scan_mutex);
+}
+
 extern "C" {
 
 error_t app_manager_install_path_add(const char* path) {
@@ -243,16 +268,12 @@ error_t app_manager_install_path_add(const char* path) {
 
 void app_manager_install_path_scan(void) {
     auto& registry = install_path_registry();
+    mutex_lock(&registry.scan_mutex);
 
     mutex_lock(&registry.mutex);
     auto paths_copy = registry.paths;
     mutex_unlock(&registry.mutex);
 
-    std::vector<std::string> found_app_dirs;
-    for (const auto& root : paths_copy) {
-        app_fs_list_direct_subdirectories(root, found_app_dirs);
-    }
-
     // Snapshot of what's already registered, taken once so the rest of this scan can run without holding registry.mutex
     mutex_lock(&registry.mutex);
     std::unordered_map<std::string, std::string> known_paths; // id -> path
@@ -261,36 +282,69 @@ void app_manager_install_path_scan(void) {
     }
     mutex_unlock(&registry.mutex);
 
-    // Stat each manifest and parse it entirely without registry.mutex held (due to filesystem IO being slow)
+    // Stat each manifest and parse it entirely without registry.mutex held (due to filesystem IO being slow).
+    // Manifests that didn't change since the previous scan are taken from the root's index instead of being parsed.
+    AppManagerIndexStats index_stats {};
     std::vector<std::unique_ptr<ScannedAppManifest>> new_records;
-    for (const auto& app_dir : found_app_dirs) {
-        auto manifest_path = app_dir + "/manifest.properties";
-        if (!app_fs_is_file(manifest_path)) {
-            continue;
+    for (const auto& root : paths_copy) {
+        std::vector<std::string> app_dirs;
+        app_fs_list_direct_subdirectories(root, app_dirs);
+        if (app_dirs.empty() && !app_fs_is_directory(root)) {
+            continue; // e.g. an unmounted SD card: keep its index for when it returns
         }
 
-        AppMetadata metadata {};
-        if (app_metadata_parse(manifest_path.c_str(), &metadata) != ERROR_NONE) {
-            LOG_W(TAG, "Invalid manifest at %s", manifest_path.c_str());
-            continue;
+        AppIndex index;
+        app_index_load(root, index);
+        AppIndex updated_index;
+        bool index_changed = false;
+
+        for (const auto& app_dir : app_dirs) {
+            auto manifest_path = app_dir + "/manifest.properties";
+            AppIndexEntry entry {};
+            if (!app_fs_get_file_info(manifest_path, entry.manifest_mtime, entry.manifest_size)) {
+                continue;
+            }
+
+            auto directory_name = app_dir.substr(root.size() + 1);
+            auto cached = index.find(directory_name);
+            if (cached != index.end() &&
+                cached->second.manifest_mtime == entry.manifest_mtime &&
+                cached->second.manifest_size == entry.manifest_size) {
+                index_stats.hits++;
+                entry.metadata = cached->second.metadata;
+            } else {
+                index_stats.misses++;
+                if (app_metadata_parse(manifest_path.c_str(), &entry.metadata) != ERROR_NONE) {
+                    LOG_W(TAG, "Invalid manifest at %s", manifest_path.c_str());
+                    continue;
+                }
+                index_changed = true;
+            }
+            updated_index[directory_name] = entry;
+
+            const auto& metadata = entry.metadata;
+            if (known_paths.contains(metadata.app_id)) {
+                continue; // already registered by an earlier scan
+            }
+
+            auto record = std::make_unique<ScannedAppManifest>();
+            record->id = metadata.app_id;
+            record->name = metadata.app_name;
+            record->path = app_dir;
+            record->manifest = AppManifest {
+                .id = record->id.c_str(),
+                .name = record->name.c_str(),
+                .category = APP_CATEGORY_USER,
+                .location = { APP_LOCATION_PATH, const_cast<char*>(record->path.c_str()) },
+                .flags = 0,
+            };
+            new_records.push_back(std::move(record));
         }
 
-        if (known_paths.contains(metadata.app_id)) {
-            continue; // already registered by an earlier scan
+        // Also rewritten when apps were removed, so their entries don't linger
+        if (index_changed || updated_index.size() != index.size()) {
+            app_index_save(root, updated_index);
         }
-
-        auto record = std::make_unique<ScannedAppManifest>();
-        record->id = metadata.app_id;
-        record->name = metadata.app_name;
-        record->path = app_dir;
-        record->manifest = AppManifest {
-            .id = record->id.c_str(),
-            .name = record->name.c_str(),
-            .category = APP_CATEGORY_USER,
-            .location = { APP_LOCATION_PATH, const_cast<char*>(record->path.c_str()) },
-            .flags = 0,
-        };
-        new_records.push_back(std::move(record));
     }
 
     // Anything a previous scan registered whose directory has since disappeared  gets unregistered below.
@@ -325,6 +379,17 @@ void app_manager_install_path_scan(void) {
     for (auto& record : added_records) {
         registry.scanned[record->id] = std::move(record);
     }
+    registry.index_stats.hits += index_stats.hits;
+    registry.index_stats.misses += index_stats.misses;
+    mutex_unlock(&registry.mutex);
+
+    mutex_unlock(&registry.scan_mutex);
+}
+
+void app_manager_install_path_get_index_stats(AppManagerIndexStats* out_stats) {
+    auto& registry = install_path_registry();
+    mutex_lock(&registry.mutex);
+    *out_stats = registry.index_stats;
     mutex_unlock(&registry.mutex);
 }
 
@@ -371,6 +436,8 @@ error_t app_manager_install_path_uninstall(const char* app_id) {
     if (!app_fs_delete_recursively(path)) {
         return ERROR_RESOURCE;
     }
+    app_fs_notify_files_changed(path);
+    app_index_forget(path);
 
     mutex_lock(&registry.mutex);
     registry.scanned.erase(app_id);
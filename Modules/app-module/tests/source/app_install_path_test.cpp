@@ -0,0 +1,140 @@
+#include "doctest.h"
+
+#include <app/install.h>
+#include <app/manager.h>
+
+#include <tactility/time.h>
+
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace {
+
+constexpr auto* ROOT_PATH = "app_install_path_test";
+constexpr int APP_COUNT = 200;
+
+std::string get_app_id(int index) {
+    char id[32];
+    std::snprintf(id, sizeof(id), "one.tactility.indexed%03d", index);
+    return id;
+}
+
+void write_manifest(int index, const char* name) {
+    auto directory = std::string(ROOT_PATH) + "/" + get_app_id(index);
+    mkdir(directory.c_str(), 0755);
+    FILE* file = std::fopen((directory + "/manifest.properties").c_str(), "w");
+    REQUIRE_NE(file, nullptr);
+    std::fprintf(file,
+        "manifest.version=0.2\n"
+        "target.sdk=0.0.0\n"
+        "target.platforms=esp32\n"
+        "app.id=%s\n"
+        "app.version.name=0.1.0\n"
+        "app.version.code=1\n"
+        "app.name=%s\n",
+        get_app_id(index).c_str(), name
+    );
+    std::fclose(file);
+}
+
+void delete_root() {
+    for (int i = 0; i < APP_COUNT; i++) {
+        auto directory = std::string(ROOT_PATH) + "/" + get_app_id(i);
+        unlink((directory + "/manifest.properties").c_str());
+        rmdir(directory.c_str());
+    }
+    unlink((std::string(ROOT_PATH) + "/.app_index").c_str());
+    rmdir(ROOT_PATH);
+}
+
+bool is_registered(int index) {
+    AppManifest manifest {};
+    return app_manager_find_manifest(get_app_id(index).c_str(), &manifest) == ERROR_NONE;
+}
+
+/** @return the index counters of a single scan */
+AppManagerIndexStats scan() {
+    AppManagerIndexStats before;
+    AppManagerIndexStats after;
+    app_manager_install_path_get_index_stats(&before);
+    app_manager_install_path_scan();
+    app_manager_install_path_get_index_stats(&after);
+    return {
+        .hits = after.hits - before.hits,
+        .misses = after.misses - before.misses
+    };
+}
+
+} // namespace
+
+TEST_CASE("app_manager_install_path_scan should only parse manifests that changed since the previous scan") {
+    delete_root();
+    REQUIRE_EQ(mkdir(ROOT_PATH, 0755), 0);
+    for (int i = 0; i < APP_COUNT; i++) {
+        write_manifest(i, "Indexed");
+    }
+    CHECK_EQ(app_manager_install_path_add(ROOT_PATH), ERROR_NONE);
+
+    // Nothing indexed yet, like the first boot with these apps
+    uint64_t start_time = get_micros_since_boot();
+    auto stats = scan();
+    uint64_t cold_us = get_micros_since_boot() - start_time;
+    CHECK_EQ(stats.hits, 0);
+    CHECK_EQ(stats.misses, APP_COUNT);
+    CHECK(is_registered(0));
+    CHECK(is_registered(APP_COUNT - 1));
+
+    start_time = get_micros_since_boot();
+    stats = scan();
+    uint64_t warm_us = get_micros_since_boot() - start_time;
+    // Every manifest came from the index, none was parsed
+    CHECK_EQ(stats.hits, APP_COUNT);
+    CHECK_EQ(stats.misses, 0);
+
+    // Timings are only reported, the counters above show that the index was used
+    MESSAGE("Scanning " << APP_COUNT << " apps: " << cold_us / 1000U << " ms without index, "
+        << warm_us / 1000U << " ms with index");
+
+    // A changed manifest is parsed again, the others still come from the index
+    write_manifest(7, "Indexed and changed");
+    stats = scan();
+    CHECK_EQ(stats.hits, APP_COUNT - 1);
+    CHECK_EQ(stats.misses, 1);
+
+    // A corrupt index is ignored and rebuilt
+    FILE* file = std::fopen((std::string(ROOT_PATH) + "/.app_index").c_str(), "w");
+    REQUIRE_NE(file, nullptr);
+    std::fputs("app_index 1\nnot an entry\n", file);
+    std::fclose(file);
+    stats = scan();
+    CHECK_EQ(stats.misses, APP_COUNT);
+    stats = scan();
+    CHECK_EQ(stats.hits, APP_COUNT);
+
+    // A reinstalled manifest with the same size and modification time (e.g. on FAT without a valid clock) is
+    // parsed again, because uninstalling dropped its index entry
+    auto manifest_path = std::string(ROOT_PATH) + "/" + get_app_id(3) + "/manifest.properties";
+    struct stat manifest_stat {};
+    REQUIRE_EQ(stat(manifest_path.c_str(), &manifest_stat), 0);
+    CHECK_EQ(app_uninstall(get_app_id(3).c_str()), ERROR_NONE);
+    CHECK_FALSE(is_registered(3));
+    write_manifest(3, "Reindex");
+    struct utimbuf times = { .actime = manifest_stat.st_atime, .modtime = manifest_stat.st_mtime };
+    REQUIRE_EQ(utime(manifest_path.c_str(), &times), 0);
+    stats = scan();
+    CHECK_EQ(stats.hits, APP_COUNT - 1);
+    CHECK_EQ(stats.misses, 1);
+    AppManifest manifest {};
+    REQUIRE_EQ(app_manager_find_manifest(get_app_id(3).c_str(), &manifest), ERROR_NONE);
+    CHECK_EQ(std::string(manifest.name), "Reindex");
+
+    // Removed directories are unregistered
+    delete_root();
+    stats = scan();
+    CHECK_EQ(stats.hits + stats.misses, 0);
+    CHECK_FALSE(is_registered(0));
+    CHECK_FALSE(is_registered(APP_COUNT - 1));
+}
@@ -0,0 +1,190 @@
+#include "doctest.h"
+
+#include <app/install.h>
+#include <app/manager.h>
+
+#include <tactility/time.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+
+constexpr auto* APP_ID = "one.tactility.installtest";
+constexpr auto* PACKAGE_PATH = "app_install_test.tar";
+
+constexpr auto* MANIFEST =
+    "manifest.version=0.2\n"
+    "target.sdk=0.0.0\n"
+    "target.platforms=esp32\n"
+    "app.id=one.tactility.installtest\n"
+    "app.version.name=0.1.0\n"
+    "app.version.code=1\n"
+    "app.name=Install Test\n";
+
+void append_header(std::vector<uint8_t>& archive, const std::string& path, size_t size, char type) {
+    uint8_t header[512] = {};
+    std::memcpy(header, path.c_str(), path.size());
+    std::snprintf(reinterpret_cast<char*>(header + 100), 8, "%07o", type == '5' ? 0755 : 0644);
+    std::snprintf(reinterpret_cast<char*>(header + 124), 12, "%011zo", size);
+    header[156] = static_cast<uint8_t>(type);
+    std::memcpy(header + 257, "ustar", 6);
+    std::memcpy(header + 263, "00", 2);
+    std::memset(header + 148, ' ', 8);
+    unsigned checksum = 0;
+    for (auto byte : header) {
+        checksum += byte;
+    }
+    std::snprintf(reinterpret_cast<char*>(header + 148), 8, "%06o", checksum);
+    archive.insert(archive.end(), header, header + sizeof(header));
+}
+
+void append_file(std::vector<uint8_t>& archive, const std::string& path, const std::vector<uint8_t>& data) {
+    append_header(archive, path, data.size(), '0');
+    archive.insert(archive.end(), data.begin(), data.end());
+    archive.resize(archive.size() + (512 - (data.size() % 512)) % 512, 0);
+}
+
+/** Creates a package with a manifest and a data file of each of @a file_sizes in nested directories */
+std::vector<uint8_t> create_package(const std::vector<size_t>& file_sizes) {
+    std::vector<uint8_t> archive;
+    std::string manifest = MANIFEST;
+    append_file(archive, "manifest.properties", std::vector<uint8_t>(manifest.begin(), manifest.end()));
+    append_header(archive, "assets/", 0, '5');
+    for (size_t i = 0; i < file_sizes.size(); i++) {
+        std::vector<uint8_t> data(file_sizes[i]);
+        for (size_t j = 0; j < data.size(); j++) {
+            data[j] = static_cast<uint8_t>(i + j * 31U);
+        }
+        append_file(archive, "assets/level" + std::to_string(i % 4) + "/file" + std::to_string(i) + ".bin", data);
+    }
+    // End of archive, padded to the default record size like tar does
+    archive.resize(archive.size() + 1024, 0);
+    archive.resize(((archive.size() + 10239) / 10240) * 10240, 0);
+    return archive;
+}
+
+/** Creates a package with a manifest and @a file_count data files of @a file_size bytes in nested directories */
+std::vector<uint8_t> create_package(size_t file_count, size_t file_size) {
+    return create_package(std::vector<size_t>(file_count, file_size));
+}
+
+void write_package(const std::vector<uint8_t>& archive) {
+    FILE* file = std::fopen(PACKAGE_PATH, "wb");
+    REQUIRE_NE(file, nullptr);
+    REQUIRE_EQ(std::fwrite(archive.data(), 1, archive.size(), file), archive.size());
+    std::fclose(file);
+}
+
+std::string get_install_path() {
+    char path[256];
+    REQUIRE_EQ(app_get_install_path(APP_ID, path, sizeof(path)), ERROR_NONE);
+    return path;
+}
+
+bool is_registered() {
+    AppManifest manifest {};
+    return app_manager_find_manifest(APP_ID, &manifest) == ERROR_NONE;
+}
+
+bool is_file(const std::string& path, size_t expected_size) {
+    struct stat result {};
+    return stat(path.c_str(), &result) == 0 && S_ISREG(result.st_mode) && static_cast<size_t>(result.st_size) == expected_size;
+}
+
+void on_progress(size_t bytes_processed, size_t bytes_total, void* context) {
+    auto* progress = static_cast<std::vector<size_t>*>(context);
+    CHECK_LE(bytes_processed, bytes_total);
+    progress->push_back(bytes_processed);
+}
+
+} // namespace
+
+TEST_CASE("app_install_with_options should extract, hash and report progress") {
+    auto archive = create_package(8, 3000);
+    write_package(archive);
+
+    std::vector<size_t> progress;
+    uint8_t sha256[APP_INSTALL_SHA256_SIZE] = {};
+    AppInstallOptions options = {
+        .progress_callback = on_progress,
+        .progress_context = &progress,
+        .expected_sha256 = nullptr,
+        .sha256_out = sha256
+    };
+    REQUIRE_EQ(app_install_with_options(PACKAGE_PATH, &options), ERROR_NONE);
+
+    auto install_path = get_install_path();
+    CHECK(is_file(install_path + "/manifest.properties", std::strlen(MANIFEST)));
+    CHECK(is_file(install_path + "/assets/level3/file7.bin", 3000));
+    CHECK(is_registered());
+    REQUIRE_FALSE(progress.empty());
+    CHECK_EQ(progress.back(), archive.size());
+    uint8_t zeroes[APP_INSTALL_SHA256_SIZE] = {};
+    CHECK_NE(std::memcmp(sha256, zeroes, sizeof(sha256)), 0);
+
+    // Reinstalling with the expected hash replaces the app
+    options.expected_sha256 = sha256;
+    options.sha256_out = nullptr;
+    options.progress_callback = nullptr;
+    CHECK_EQ(app_install_with_options(PACKAGE_PATH, &options), ERROR_NONE);
+
+    // A different package is rejected and leaves the installed app alone
+    archive[archive.size() - 1] ^= 0xFFU;
+    write_package(archive);
+    CHECK_EQ(app_install_with_options(PACKAGE_PATH, &options), ERROR_NOT_ALLOWED);
+    CHECK(is_file(install_path + "/assets/level0/file0.bin", 3000));
+    CHECK(is_registered());
+
+    CHECK_EQ(app_uninstall(APP_ID), ERROR_NONE);
+    std::remove(PACKAGE_PATH);
+}
+
+TEST_CASE("app_install should reject corrupt and unsafe packages") {
+    auto archive = create_package(1, 100);
+    archive[10] ^= 0xFFU; // Inside the name of the first header, so its checksum no longer matches
+    write_package(archive);
+    CHECK_EQ(app_install(PACKAGE_PATH), ERROR_NOT_FOUND);
+
+    std::vector<uint8_t> unsafe;
+    append_file(unsafe, "../escaped.txt", { 'x' });
+    unsafe.resize(unsafe.size() + 1024, 0);
+    write_package(unsafe);
+    CHECK_EQ(app_install(PACKAGE_PATH), ERROR_NOT_FOUND);
+
+    // The archive is extracted into a staging directory inside the install directory of all apps,
+    // so that's where the escaped file would end up
+    char path[256];
+    REQUIRE_EQ(app_get_install_path("", path, sizeof(path)), ERROR_NONE);
+    std::string app_parent_path = path;
+    app_parent_path.pop_back(); // The separator before the empty app id
+    struct stat result {};
+    CHECK_NE(stat((app_parent_path + "/escaped.txt").c_str(), &result), 0);
+
+    CHECK_EQ(app_install("app_install_test_missing.tar"), ERROR_NOT_FOUND);
+    std::remove(PACKAGE_PATH);
+}
+
+TEST_CASE("app_install throughput benchmark") {
+    // About 5 MB in files from 4 kB to 512 kB, like an app with assets. The odd sizes leave partial tar records.
+    std::vector<size_t> file_sizes;
+    for (size_t i = 0; i < 40; i++) {
+        file_sizes.push_back((4096U << (i % 8)) + i * 37U);
+    }
+    auto archive = create_package(file_sizes);
+    write_package(archive);
+
+    uint64_t start_time = get_micros_since_boot();
+    CHECK_EQ(app_install(PACKAGE_PATH), ERROR_NONE);
+    uint64_t duration_us = get_micros_since_boot() - start_time;
+
+    MESSAGE("Installed " << archive.size() / 1024U << " kB in " << duration_us / 1000U << " ms ("
+        << (archive.size() * 1000000ULL / 1024U / 1024U) / std::max<uint64_t>(duration_us, 1U) << " MB/s)");
+
+    CHECK_EQ(app_uninstall(APP_ID), ERROR_NONE);
+    std::remove(PACKAGE_PATH);
+}
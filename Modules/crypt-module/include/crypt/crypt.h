@@ -21,6 +21,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <tactility/error.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -80,6 +82,127 @@ int crypt_encrypt(const uint8_t iv[16], const uint8_t* inData, uint8_t* outData,
  */
 int crypt_decrypt(const uint8_t iv[16], const uint8_t* inData, uint8_t* outData, size_t dataLength);
 
+/** @brief Size of a key for the crypt_aead_*() functions */
+#define CRYPT_AEAD_KEY_SIZE 32
+/** @brief Size of an IV for the crypt_aead_*() functions */
+#define CRYPT_AEAD_IV_SIZE 12
+/** @brief Size of the authentication tag that the crypt_aead_*() functions produce and verify */
+#define CRYPT_AEAD_TAG_SIZE 16
+/** @brief Maximum number of bytes that an update can hold back until a later update or finish call */
+#define CRYPT_AEAD_MAX_PENDING 15
+
+enum CryptAeadMode {
+    CRYPT_AEAD_ENCRYPT,
+    CRYPT_AEAD_DECRYPT
+};
+
+/**
+ * @brief Opaque state for AES-256-GCM encryption or decryption of data that is processed in chunks.
+ *
+ * Unlike crypt_encrypt(), this doesn't need the whole plaintext in memory and any change to the
+ * ciphertext, the IV or the associated data is detected when decrypting. A large file can be
+ * processed with a fixed-size buffer:
+ *  - crypt_aead_init() with a unique IV (store it next to the ciphertext)
+ *  - crypt_aead_update() for every chunk
+ *  - crypt_aead_finish_encrypt() to get the tag (store it next to the ciphertext), or
+ *    crypt_aead_finish_decrypt() to verify it
+ *
+ * Decrypted data is returned before the tag is verified: don't use it until
+ * crypt_aead_finish_decrypt() succeeded (e.g. write it to a temporary file and rename that afterwards).
+ *
+ * Created by crypt_aead_init(), released by the finish call or crypt_aead_free().
+ */
+struct CryptAeadContext;
+
+/**
+ * @brief Starts encrypting or decrypting.
+ *
+ * Every successful call must be followed by a finish call that matches the mode, or crypt_aead_free().
+ *
+ * @param[out] out_context the newly allocated context
+ * @param[in] mode whether to encrypt or decrypt
+ * @param[in] key a key of CRYPT_AEAD_KEY_SIZE bytes, or NULL to use the device key (see crypt_encrypt())
+ * @param[in] iv must never be used twice with the same key, e.g. the first CRYPT_AEAD_IV_SIZE bytes of crypt_generate_iv()
+ * @param[in] associated_data data that isn't encrypted but is authenticated (e.g. a file header), can be NULL
+ * @param[in] associated_data_length the size of associated_data
+ * @retval ERROR_NONE when the context is ready for crypt_aead_update()
+ * @retval ERROR_OUT_OF_MEMORY when the context couldn't be allocated
+ * @retval ERROR_INVALID_ARGUMENT when mbedtls rejected the arguments
+ */
+error_t crypt_aead_init(
+    struct CryptAeadContext** out_context,
+    enum CryptAeadMode mode,
+    const uint8_t* key,
+    const uint8_t iv[CRYPT_AEAD_IV_SIZE],
+    const void* associated_data,
+    size_t associated_data_length
+);
+
+/**
+ * @brief Encrypts or decrypts the next chunk of data.
+ *
+ * The output can be up to CRYPT_AEAD_MAX_PENDING bytes shorter or longer than the input, depending
+ * on what previous calls held back (hardware implementations process whole blocks).
+ *
+ * @param[inout] context the context from crypt_aead_init()
+ * @param[in] input the next chunk
+ * @param[in] length the size of input
+ * @param[out] output the next part of the result, can be the same buffer as input
+ * @param[in] output_size the size of output, at least length + CRYPT_AEAD_MAX_PENDING
+ * @param[out] out_length the number of bytes written to output
+ * @retval ERROR_NONE when the chunk was processed
+ * @retval ERROR_UNDEFINED when mbedtls failed
+ */
+error_t crypt_aead_update(
+    struct CryptAeadContext* context,
+    const uint8_t* input,
+    size_t length,
+    uint8_t* output,
+    size_t output_size,
+    size_t* out_length
+);
+
+/**
+ * @brief Finishes encrypting and releases the context.
+ * @param[inout] context the context from crypt_aead_init() with CRYPT_AEAD_ENCRYPT
+ * @param[out] output the last part of the ciphertext, with room for CRYPT_AEAD_MAX_PENDING bytes
+ * @param[out] out_length the number of bytes written to output
+ * @param[out] tag the authentication tag, needed for decrypting
+ * @retval ERROR_NONE when the ciphertext and tag are complete
+ * @retval ERROR_INVALID_STATE when the context was started for decryption - it isn't released then
+ * @retval ERROR_UNDEFINED when mbedtls failed
+ */
+error_t crypt_aead_finish_encrypt(
+    struct CryptAeadContext* context,
+    uint8_t output[CRYPT_AEAD_MAX_PENDING],
+    size_t* out_length,
+    uint8_t tag[CRYPT_AEAD_TAG_SIZE]
+);
+
+/**
+ * @brief Finishes decrypting, verifies the data and releases the context.
+ * @param[inout] context the context from crypt_aead_init() with CRYPT_AEAD_DECRYPT
+ * @param[out] output the last part of the plaintext, with room for CRYPT_AEAD_MAX_PENDING bytes
+ * @param[out] out_length the number of bytes written to output
+ * @param[in] tag the tag from crypt_aead_finish_encrypt()
+ * @retval ERROR_NONE when the plaintext is complete and authentic
+ * @retval ERROR_NOT_ALLOWED when the ciphertext, IV, associated data or tag was modified or the key is wrong
+ * @retval ERROR_INVALID_STATE when the context was started for encryption - it isn't released then
+ * @retval ERROR_UNDEFINED when mbedtls failed
+ */
+error_t crypt_aead_finish_decrypt(
+    struct CryptAeadContext* context,
+    uint8_t output[CRYPT_AEAD_MAX_PENDING],
+    size_t* out_length,
+    const uint8_t tag[CRYPT_AEAD_TAG_SIZE]
+);
+
+/**
+ * @brief Releases a context that won't be finished, e.g. after an error.
+ * @param[in] context the context from crypt_aead_init()
+ */
+void crypt_aead_free(struct CryptAeadContext* context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,12 +4,19 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <tactility/error.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** @brief The size of a SHA-256 hash in bytes */
+#define HASH_SHA256_SIZE 32
+
 /**
  * Implementation of DJB2 hashing algorithm.
+ * Processes 1 byte at a time and is easy to provoke collisions for: prefer hash_xxh32() for
+ * larger buffers and for hash tables with keys that come from outside the device.
  * @param[in] str the string to calculate the hash for
  * @return the hash
  */
@@ -23,6 +30,103 @@ uint32_t djb2_str(const char* str);
  */
 uint32_t djb2_data(const void* data, size_t length);
 
+/**
+ * @brief State for calculating an xxHash32 over data that arrives in parts.
+ * Only access it through the hash_xxh32_*() functions.
+ */
+struct HashXxh32State {
+    uint32_t accumulators[4];
+    uint32_t seed;
+    uint32_t buffer_size;
+    uint64_t total_length;
+    uint8_t buffer[16];
+};
+
+/**
+ * @brief Calculates the xxHash32 of the data: a fast non-cryptographic hash that processes 16 bytes per round.
+ * Use a random seed for hash tables with keys that come from outside the device, so the collisions can't be predicted.
+ * @param[in] data the bytes to calculate the hash for
+ * @param[in] length the size of data
+ * @param[in] seed changes the outcome of the hash
+ * @return the hash
+ */
+uint32_t hash_xxh32(const void* data, size_t length, uint32_t seed);
+
+/**
+ * @brief Starts an xxHash32 calculation.
+ * @param[out] state the state to initialize
+ * @param[in] seed changes the outcome of the hash
+ */
+void hash_xxh32_init(struct HashXxh32State* state, uint32_t seed);
+
+/**
+ * @brief Adds data to an xxHash32 calculation.
+ * @param[inout] state the state from hash_xxh32_init()
+ * @param[in] data the bytes to add
+ * @param[in] length the size of data
+ */
+void hash_xxh32_update(struct HashXxh32State* state, const void* data, size_t length);
+
+/**
+ * @brief Gets the xxHash32 of all the data that was added so far.
+ * The state remains valid, so more data can be added afterwards.
+ * @param[in] state the state from hash_xxh32_init()
+ * @return the hash, equal to hash_xxh32() of all the data in one call
+ */
+uint32_t hash_xxh32_final(const struct HashXxh32State* state);
+
+/**
+ * @brief Opaque state for calculating a SHA-256 hash over data that arrives in parts.
+ * Created by hash_sha256_init(), released by hash_sha256_final() or hash_sha256_free().
+ */
+struct HashSha256State;
+
+/**
+ * @brief Calculates the SHA-256 hash of the data.
+ * Uses the SHA peripheral when the target has one.
+ * @param[in] data the bytes to calculate the hash for
+ * @param[in] length the size of data
+ * @param[out] out_hash the hash
+ * @retval ERROR_NONE when the hash was calculated
+ * @retval ERROR_UNDEFINED when mbedtls failed
+ */
+error_t hash_sha256(const void* data, size_t length, uint8_t out_hash[HASH_SHA256_SIZE]);
+
+/**
+ * @brief Starts a SHA-256 calculation.
+ * Every successful call must be followed by hash_sha256_final() or hash_sha256_free().
+ * @param[out] out_state the newly allocated state
+ * @retval ERROR_NONE when the calculation was started
+ * @retval ERROR_OUT_OF_MEMORY when the state couldn't be allocated
+ * @retval ERROR_UNDEFINED when mbedtls failed
+ */
+error_t hash_sha256_init(struct HashSha256State** out_state);
+
+/**
+ * @brief Adds data to a SHA-256 calculation.
+ * @param[inout] state the state from hash_sha256_init()
+ * @param[in] data the bytes to add
+ * @param[in] length the size of data
+ * @retval ERROR_NONE when the data was added
+ * @retval ERROR_UNDEFINED when mbedtls failed
+ */
+error_t hash_sha256_update(struct HashSha256State* state, const void* data, size_t length);
+
+/**
+ * @brief Finishes a SHA-256 calculation and releases the state.
+ * @param[inout] state the state from hash_sha256_init()
+ * @param[out] out_hash the hash of all the data that was added
+ * @retval ERROR_NONE when the hash was calculated
+ * @retval ERROR_UNDEFINED when mbedtls failed
+ */
+error_t hash_sha256_final(struct HashSha256State* state, uint8_t out_hash[HASH_SHA256_SIZE]);
+
+/**
+ * @brief Releases the state of a SHA-256 calculation that won't be finished.
+ * @param[in] state the state from hash_sha256_init()
+ */
+void hash_sha256_free(struct HashSha256State* state);
+
 #ifdef __cplusplus
 }
 #endif
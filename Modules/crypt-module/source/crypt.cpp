@@ -5,10 +5,12 @@
 #include <tactility/log.h>
 
 #include <mbedtls/aes.h>
+#include <mbedtls/gcm.h>
 #include <mbedtls/platform_util.h>
 #include <mbedtls/sha256.h>
 #include <cstring>
 #include <cstdint>
+#include <new>
 
 #ifdef ESP_PLATFORM
 #include "esp_mac.h"
@@ -22,6 +24,12 @@ constexpr auto* TAG = "crypt";
 
 #define TT_NVS_NAMESPACE "tt_secure"
 
+// Definition of the opaque context declared in crypt/crypt.h, so its size doesn't depend on the mbedtls configuration
+struct CryptAeadContext {
+    mbedtls_gcm_context gcm;
+    enum CryptAeadMode mode;
+};
+
 /**
  * Fills a buffer with cryptographically secure random bytes.
  * @param[out] out output buffer
@@ -209,3 +217,115 @@ int crypt_decrypt(const uint8_t iv[16], const uint8_t* inData, uint8_t* outData,
     mbedtls_platform_zeroize(iv_copy, sizeof(iv_copy));
     return result;
 }
+
+error_t crypt_aead_init(
+    struct CryptAeadContext** out_context,
+    enum CryptAeadMode mode,
+    const uint8_t* key,
+    const uint8_t iv[CRYPT_AEAD_IV_SIZE],
+    const void* associated_data,
+    size_t associated_data_length
+) {
+    check(out_context && iv);
+
+    auto* context = new (std::nothrow) CryptAeadContext;
+    if (context == nullptr) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+
+    uint8_t device_key[CRYPT_AEAD_KEY_SIZE];
+    if (key == nullptr) {
+        getKey(device_key);
+        key = device_key;
+    }
+
+    context->mode = mode;
+    mbedtls_gcm_init(&context->gcm);
+    int gcm_mode = (mode == CRYPT_AEAD_ENCRYPT) ? MBEDTLS_GCM_ENCRYPT : MBEDTLS_GCM_DECRYPT;
+    int result = mbedtls_gcm_setkey(&context->gcm, MBEDTLS_CIPHER_ID_AES, key, CRYPT_AEAD_KEY_SIZE * 8);
+    mbedtls_platform_zeroize(device_key, sizeof(device_key));
+    if (result == 0) {
+        result = mbedtls_gcm_starts(&context->gcm, gcm_mode, iv, CRYPT_AEAD_IV_SIZE);
+    }
+    if (result == 0 && associated_data_length > 0) {
+        result = mbedtls_gcm_update_ad(&context->gcm, static_cast<const unsigned char*>(associated_data), associated_data_length);
+    }
+
+    if (result != 0) {
+        LOG_E(TAG, "Failed to start AES-GCM (%d)", result);
+        crypt_aead_free(context);
+        return ERROR_INVALID_ARGUMENT;
+    }
+    *out_context = context;
+    return ERROR_NONE;
+}
+
+error_t crypt_aead_update(
+    struct CryptAeadContext* context,
+    const uint8_t* input,
+    size_t length,
+    uint8_t* output,
+    size_t output_size,
+    size_t* out_length
+) {
+    check(context && out_length);
+    int result = mbedtls_gcm_update(&context->gcm, input, length, output, output_size, out_length);
+    if (result != 0) {
+        LOG_E(TAG, "AES-GCM update failed (%d)", result);
+        return ERROR_UNDEFINED;
+    }
+    return ERROR_NONE;
+}
+
+error_t crypt_aead_finish_encrypt(
+    struct CryptAeadContext* context,
+    uint8_t output[CRYPT_AEAD_MAX_PENDING],
+    size_t* out_length,
+    uint8_t tag[CRYPT_AEAD_TAG_SIZE]
+) {
+    check(context && out_length && tag);
+    if (context->mode != CRYPT_AEAD_ENCRYPT) {
+        return ERROR_INVALID_STATE;
+    }
+
+    int result = mbedtls_gcm_finish(&context->gcm, output, CRYPT_AEAD_MAX_PENDING, out_length, tag, CRYPT_AEAD_TAG_SIZE);
+    crypt_aead_free(context);
+    if (result != 0) {
+        LOG_E(TAG, "AES-GCM finish failed (%d)", result);
+        return ERROR_UNDEFINED;
+    }
+    return ERROR_NONE;
+}
+
+error_t crypt_aead_finish_decrypt(
+    struct CryptAeadContext* context,
+    uint8_t output[CRYPT_AEAD_MAX_PENDING],
+    size_t* out_length,
+    const uint8_t tag[CRYPT_AEAD_TAG_SIZE]
+) {
+    check(context && out_length && tag);
+    if (context->mode != CRYPT_AEAD_DECRYPT) {
+        return ERROR_INVALID_STATE;
+    }
+
+    uint8_t actual_tag[CRYPT_AEAD_TAG_SIZE];
+    int result = mbedtls_gcm_finish(&context->gcm, output, CRYPT_AEAD_MAX_PENDING, out_length, actual_tag, sizeof(actual_tag));
+    crypt_aead_free(context);
+    if (result != 0) {
+        LOG_E(TAG, "AES-GCM finish failed (%d)", result);
+        return ERROR_UNDEFINED;
+    }
+
+    // Constant time, so the comparison doesn't reveal how many bytes of a forged tag were right
+    uint8_t difference = 0;
+    for (size_t i = 0; i < CRYPT_AEAD_TAG_SIZE; ++i) {
+        difference |= actual_tag[i] ^ tag[i];
+    }
+    mbedtls_platform_zeroize(actual_tag, sizeof(actual_tag));
+    return (difference == 0) ? ERROR_NONE : ERROR_NOT_ALLOWED;
+}
+
+void crypt_aead_free(struct CryptAeadContext* context) {
+    mbedtls_gcm_free(&context->gcm);
+    delete context;
+}
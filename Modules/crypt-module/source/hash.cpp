@@ -1,6 +1,102 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <crypt/hash.h>
 
+#include <mbedtls/sha256.h>
+
+#include <bit>
+#include <cstring>
+#include <new>
+
+static_assert(std::endian::native == std::endian::little, "xxHash32 reads words in little endian order");
+
+namespace {
+
+constexpr uint32_t XXH32_PRIME_1 = 0x9E3779B1U;
+constexpr uint32_t XXH32_PRIME_2 = 0x85EBCA77U;
+constexpr uint32_t XXH32_PRIME_3 = 0xC2B2AE3DU;
+constexpr uint32_t XXH32_PRIME_4 = 0x27D4EB2FU;
+constexpr uint32_t XXH32_PRIME_5 = 0x165667B1U;
+
+constexpr size_t XXH32_STRIPE_SIZE = 16;
+
+inline uint32_t read_word(const uint8_t* data) {
+    uint32_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+inline uint32_t xxh32_round(uint32_t accumulator, uint32_t input) {
+    accumulator += input * XXH32_PRIME_2;
+    accumulator = std::rotl(accumulator, 13);
+    return accumulator * XXH32_PRIME_1;
+}
+
+void xxh32_reset(uint32_t accumulators[4], uint32_t seed) {
+    accumulators[0] = seed + XXH32_PRIME_1 + XXH32_PRIME_2;
+    accumulators[1] = seed + XXH32_PRIME_2;
+    accumulators[2] = seed;
+    accumulators[3] = seed - XXH32_PRIME_1;
+}
+
+/** @return a pointer to the first byte that wasn't processed because it's part of an incomplete stripe */
+const uint8_t* xxh32_process_stripes(uint32_t accumulators[4], const uint8_t* data, const uint8_t* end) {
+    uint32_t v1 = accumulators[0];
+    uint32_t v2 = accumulators[1];
+    uint32_t v3 = accumulators[2];
+    uint32_t v4 = accumulators[3];
+    while (end - data >= static_cast<ptrdiff_t>(XXH32_STRIPE_SIZE)) {
+        v1 = xxh32_round(v1, read_word(data));
+        v2 = xxh32_round(v2, read_word(data + 4));
+        v3 = xxh32_round(v3, read_word(data + 8));
+        v4 = xxh32_round(v4, read_word(data + 12));
+        data += XXH32_STRIPE_SIZE;
+    }
+    accumulators[0] = v1;
+    accumulators[1] = v2;
+    accumulators[2] = v3;
+    accumulators[3] = v4;
+    return data;
+}
+
+uint32_t xxh32_finish(const uint32_t accumulators[4], uint32_t seed, uint64_t total_length, const uint8_t* data, size_t length) {
+    uint32_t hash;
+    if (total_length >= XXH32_STRIPE_SIZE) {
+        hash = std::rotl(accumulators[0], 1) + std::rotl(accumulators[1], 7) +
+            std::rotl(accumulators[2], 12) + std::rotl(accumulators[3], 18);
+    } else {
+        hash = seed + XXH32_PRIME_5;
+    }
+    hash += static_cast<uint32_t>(total_length);
+
+    const uint8_t* end = data + length;
+    while (end - data >= 4) {
+        hash += read_word(data) * XXH32_PRIME_3;
+        hash = std::rotl(hash, 17) * XXH32_PRIME_4;
+        data += 4;
+    }
+    while (data < end) {
+        hash += *data * XXH32_PRIME_5;
+        hash = std::rotl(hash, 11) * XXH32_PRIME_1;
+        data++;
+    }
+
+    hash ^= hash >> 15;
+    hash *= XXH32_PRIME_2;
+    hash ^= hash >> 13;
+    hash *= XXH32_PRIME_3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+} // namespace
+
+// Definition of the opaque state declared in crypt/hash.h, so its size doesn't depend on the mbedtls configuration
+struct HashSha256State {
+    mbedtls_sha256_context context;
+};
+
+extern "C" {
+
 uint32_t djb2_str(const char* str) {
     uint32_t hash = 5381;
     char c = (char)*str++;
@@ -14,12 +110,92 @@ uint32_t djb2_str(const char* str) {
 uint32_t djb2_data(const void* data, size_t length) {
     uint32_t hash = 5381;
     auto* data_bytes = static_cast<const uint8_t*>(data);
-    uint8_t c = *data_bytes++;
-    size_t index = 0;
-    while (index < length) {
-        hash = ((hash << 5) + hash) + (uint32_t)c; // hash * 33 + c
-        c = *data_bytes++;
-        index++;
+    for (size_t index = 0; index < length; index++) {
+        hash = ((hash << 5) + hash) + (uint32_t)data_bytes[index]; // hash * 33 + c
     }
     return hash;
 }
+
+uint32_t hash_xxh32(const void* data, size_t length, uint32_t seed) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint32_t accumulators[4];
+    xxh32_reset(accumulators, seed);
+    const uint8_t* remainder = xxh32_process_stripes(accumulators, bytes, bytes + length);
+    return xxh32_finish(accumulators, seed, length, remainder, static_cast<size_t>(bytes + length - remainder));
+}
+
+void hash_xxh32_init(struct HashXxh32State* state, uint32_t seed) {
+    xxh32_reset(state->accumulators, seed);
+    state->seed = seed;
+    state->buffer_size = 0;
+    state->total_length = 0;
+}
+
+void hash_xxh32_update(struct HashXxh32State* state, const void* data, size_t length) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    const uint8_t* end = bytes + length;
+    state->total_length += length;
+
+    // Complete the stripe that the previous update left behind
+    if (state->buffer_size > 0) {
+        size_t fill_size = XXH32_STRIPE_SIZE - state->buffer_size;
+        if (length < fill_size) {
+            std::memcpy(state->buffer + state->buffer_size, bytes, length);
+            state->buffer_size += length;
+            return;
+        }
+        std::memcpy(state->buffer + state->buffer_size, bytes, fill_size);
+        xxh32_process_stripes(state->accumulators, state->buffer, state->buffer + XXH32_STRIPE_SIZE);
+        bytes += fill_size;
+        state->buffer_size = 0;
+    }
+
+    bytes = xxh32_process_stripes(state->accumulators, bytes, end);
+    state->buffer_size = static_cast<uint32_t>(end - bytes);
+    std::memcpy(state->buffer, bytes, state->buffer_size);
+}
+
+uint32_t hash_xxh32_final(const struct HashXxh32State* state) {
+    return xxh32_finish(state->accumulators, state->seed, state->total_length, state->buffer, state->buffer_size);
+}
+
+error_t hash_sha256(const void* data, size_t length, uint8_t out_hash[HASH_SHA256_SIZE]) {
+    if (mbedtls_sha256(static_cast<const unsigned char*>(data), length, out_hash, 0) != 0) {
+        return ERROR_UNDEFINED;
+    }
+    return ERROR_NONE;
+}
+
+error_t hash_sha256_init(struct HashSha256State** out_state) {
+    auto* state = new (std::nothrow) HashSha256State;
+    if (state == nullptr) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    mbedtls_sha256_init(&state->context);
+    if (mbedtls_sha256_starts(&state->context, 0) != 0) {
+        hash_sha256_free(state);
+        return ERROR_UNDEFINED;
+    }
+    *out_state = state;
+    return ERROR_NONE;
+}
+
+error_t hash_sha256_update(struct HashSha256State* state, const void* data, size_t length) {
+    if (mbedtls_sha256_update(&state->context, static_cast<const unsigned char*>(data), length) != 0) {
+        return ERROR_UNDEFINED;
+    }
+    return ERROR_NONE;
+}
+
+error_t hash_sha256_final(struct HashSha256State* state, uint8_t out_hash[HASH_SHA256_SIZE]) {
+    int result = mbedtls_sha256_finish(&state->context, out_hash);
+    hash_sha256_free(state);
+    return result == 0 ? ERROR_NONE : ERROR_UNDEFINED;
+}
+
+void hash_sha256_free(struct HashSha256State* state) {
+    mbedtls_sha256_free(&state->context);
+    delete state;
+}
+
+}
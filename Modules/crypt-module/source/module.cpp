@@ -10,8 +10,22 @@ static const ModuleSymbol crypt_module_symbols[] = {
     DEFINE_MODULE_SYMBOL(crypt_generate_iv),
     DEFINE_MODULE_SYMBOL(crypt_encrypt),
     DEFINE_MODULE_SYMBOL(crypt_decrypt),
+    DEFINE_MODULE_SYMBOL(crypt_aead_init),
+    DEFINE_MODULE_SYMBOL(crypt_aead_update),
+    DEFINE_MODULE_SYMBOL(crypt_aead_finish_encrypt),
+    DEFINE_MODULE_SYMBOL(crypt_aead_finish_decrypt),
+    DEFINE_MODULE_SYMBOL(crypt_aead_free),
     DEFINE_MODULE_SYMBOL(djb2_str),
     DEFINE_MODULE_SYMBOL(djb2_data),
+    DEFINE_MODULE_SYMBOL(hash_xxh32),
+    DEFINE_MODULE_SYMBOL(hash_xxh32_init),
+    DEFINE_MODULE_SYMBOL(hash_xxh32_update),
+    DEFINE_MODULE_SYMBOL(hash_xxh32_final),
+    DEFINE_MODULE_SYMBOL(hash_sha256),
+    DEFINE_MODULE_SYMBOL(hash_sha256_init),
+    DEFINE_MODULE_SYMBOL(hash_sha256_update),
+    DEFINE_MODULE_SYMBOL(hash_sha256_final),
+    DEFINE_MODULE_SYMBOL(hash_sha256_free),
     MODULE_SYMBOL_TERMINATOR
 };
 
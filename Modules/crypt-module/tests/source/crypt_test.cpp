@@ -1,6 +1,11 @@
 #include "doctest.h"
 #include <crypt/crypt.h>
+#include <tactility/time.h>
+
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <vector>
 
 TEST_CASE("crypt_encrypt followed by crypt_decrypt returns the original data") {
     uint8_t iv[16];
@@ -99,3 +104,139 @@ TEST_CASE("crypt_encrypt followed by crypt_decrypt works with a randomly generat
 
     CHECK_EQ(memcmp(plaintext, decrypted, sizeof(plaintext)), 0);
 }
+
+namespace {
+
+std::vector<uint8_t> from_hex(const char* hex) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; hex[i] != '\0' && hex[i + 1] != '\0'; i += 2) {
+        char byte[3] = { hex[i], hex[i + 1], '\0' };
+        bytes.push_back(static_cast<uint8_t>(strtoul(byte, nullptr, 16)));
+    }
+    return bytes;
+}
+
+/** Runs a whole encryption or decryption in chunks of chunk_size bytes */
+error_t aead_process(CryptAeadMode mode, const uint8_t* key, const uint8_t* iv, const std::vector<uint8_t>& associated_data,
+                     const std::vector<uint8_t>& input, size_t chunk_size, std::vector<uint8_t>& output, uint8_t tag[CRYPT_AEAD_TAG_SIZE]) {
+    CryptAeadContext* context = nullptr;
+    error_t error = crypt_aead_init(&context, mode, key, iv, associated_data.data(), associated_data.size());
+    if (error != ERROR_NONE) {
+        return error;
+    }
+
+    output.clear();
+    std::vector<uint8_t> buffer(chunk_size + CRYPT_AEAD_MAX_PENDING);
+    for (size_t offset = 0; offset < input.size(); offset += chunk_size) {
+        size_t length = std::min(chunk_size, input.size() - offset);
+        size_t output_length = 0;
+        error = crypt_aead_update(context, input.data() + offset, length, buffer.data(), buffer.size(), &output_length);
+        if (error != ERROR_NONE) {
+            crypt_aead_free(context);
+            return error;
+        }
+        output.insert(output.end(), buffer.begin(), buffer.begin() + output_length);
+    }
+
+    size_t output_length = 0;
+    if (mode == CRYPT_AEAD_ENCRYPT) {
+        error = crypt_aead_finish_encrypt(context, buffer.data(), &output_length, tag);
+    } else {
+        error = crypt_aead_finish_decrypt(context, buffer.data(), &output_length, tag);
+    }
+    output.insert(output.end(), buffer.begin(), buffer.begin() + output_length);
+    return error;
+}
+
+} // namespace
+
+TEST_CASE("crypt_aead produces the AES-256-GCM reference values") {
+    // Test case 16 from the GCM specification (McGrew & Viega)
+    auto key = from_hex("feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308");
+    auto iv = from_hex("cafebabefacedbaddecaf888");
+    auto associated_data = from_hex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+    auto plaintext = from_hex(
+        "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+        "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39"
+    );
+    auto expected_ciphertext = from_hex(
+        "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+        "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662"
+    );
+    auto expected_tag = from_hex("76fc6ece0f4e1768cddf8853bb2d551b");
+
+    for (size_t chunk_size : { 1, 7, 16, 100 }) {
+        CAPTURE(chunk_size);
+        std::vector<uint8_t> ciphertext;
+        uint8_t tag[CRYPT_AEAD_TAG_SIZE] = {};
+        REQUIRE_EQ(aead_process(CRYPT_AEAD_ENCRYPT, key.data(), iv.data(), associated_data, plaintext, chunk_size, ciphertext, tag), ERROR_NONE);
+        CHECK(ciphertext == expected_ciphertext);
+        CHECK_EQ(memcmp(tag, expected_tag.data(), sizeof(tag)), 0);
+
+        std::vector<uint8_t> decrypted;
+        CHECK_EQ(aead_process(CRYPT_AEAD_DECRYPT, key.data(), iv.data(), associated_data, ciphertext, chunk_size, decrypted, tag), ERROR_NONE);
+        CHECK(decrypted == plaintext);
+    }
+}
+
+TEST_CASE("crypt_aead_finish_decrypt rejects modified data") {
+    uint8_t iv[16];
+    crypt_generate_iv(iv);
+    std::vector<uint8_t> associated_data = { 'v', '1' };
+    std::vector<uint8_t> plaintext(1000, 0x5A);
+    std::vector<uint8_t> ciphertext;
+    std::vector<uint8_t> decrypted;
+    uint8_t tag[CRYPT_AEAD_TAG_SIZE];
+
+    // The device key
+    REQUIRE_EQ(aead_process(CRYPT_AEAD_ENCRYPT, nullptr, iv, associated_data, plaintext, 256, ciphertext, tag), ERROR_NONE);
+    CHECK(ciphertext != plaintext);
+    CHECK_EQ(aead_process(CRYPT_AEAD_DECRYPT, nullptr, iv, associated_data, ciphertext, 256, decrypted, tag), ERROR_NONE);
+
+    ciphertext[500] ^= 0x01;
+    CHECK_EQ(aead_process(CRYPT_AEAD_DECRYPT, nullptr, iv, associated_data, ciphertext, 256, decrypted, tag), ERROR_NOT_ALLOWED);
+    ciphertext[500] ^= 0x01;
+
+    associated_data[1] = '2';
+    CHECK_EQ(aead_process(CRYPT_AEAD_DECRYPT, nullptr, iv, associated_data, ciphertext, 256, decrypted, tag), ERROR_NOT_ALLOWED);
+    associated_data[1] = '1';
+
+    tag[0] ^= 0x80;
+    CHECK_EQ(aead_process(CRYPT_AEAD_DECRYPT, nullptr, iv, associated_data, ciphertext, 256, decrypted, tag), ERROR_NOT_ALLOWED);
+}
+
+TEST_CASE("crypt_aead finish calls must match the mode") {
+    uint8_t iv[CRYPT_AEAD_IV_SIZE] = {};
+    uint8_t output[CRYPT_AEAD_MAX_PENDING];
+    uint8_t tag[CRYPT_AEAD_TAG_SIZE] = {};
+    size_t output_length = 0;
+    CryptAeadContext* context = nullptr;
+    REQUIRE_EQ(crypt_aead_init(&context, CRYPT_AEAD_DECRYPT, nullptr, iv, nullptr, 0), ERROR_NONE);
+    CHECK_EQ(crypt_aead_finish_encrypt(context, output, &output_length, tag), ERROR_INVALID_STATE);
+    crypt_aead_free(context);
+}
+
+TEST_CASE("crypt_aead throughput benchmark") {
+    // A 1 MB file in 4 kB chunks, so peak memory stays at the chunk size
+    constexpr size_t FILE_SIZE = 1024 * 1024;
+    constexpr size_t CHUNK_SIZE = 4096;
+    uint8_t iv[16];
+    crypt_generate_iv(iv);
+    std::vector<uint8_t> chunk(CHUNK_SIZE + CRYPT_AEAD_MAX_PENDING, 0x42);
+    uint8_t tag[CRYPT_AEAD_TAG_SIZE];
+    uint8_t last[CRYPT_AEAD_MAX_PENDING];
+    size_t output_length = 0;
+
+    CryptAeadContext* context = nullptr;
+    uint64_t start_time = get_micros_since_boot();
+    REQUIRE_EQ(crypt_aead_init(&context, CRYPT_AEAD_ENCRYPT, nullptr, iv, nullptr, 0), ERROR_NONE);
+    for (size_t offset = 0; offset < FILE_SIZE; offset += CHUNK_SIZE) {
+        // In place
+        CHECK_EQ(crypt_aead_update(context, chunk.data(), CHUNK_SIZE, chunk.data(), chunk.size(), &output_length), ERROR_NONE);
+    }
+    CHECK_EQ(crypt_aead_finish_encrypt(context, last, &output_length, tag), ERROR_NONE);
+    uint64_t duration_us = get_micros_since_boot() - start_time;
+
+    MESSAGE("AES-256-GCM: " << (FILE_SIZE / 1024U) << " kB in " << (duration_us / 1000U) << " ms ("
+        << FILE_SIZE / std::max<uint64_t>(duration_us, 1U) << " MB/s)");
+}
@@ -1,6 +1,10 @@
 #include "doctest.h"
 #include <crypt/hash.h>
+#include <tactility/time.h>
+
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 TEST_CASE("djb2_str of an empty string returns the DJB2 seed value") {
     CHECK_EQ(djb2_str(""), 5381u);
@@ -26,3 +30,107 @@ TEST_CASE("djb2_data matches djb2_str for the same bytes") {
     const char* text = "tactility";
     CHECK_EQ(djb2_data(text, strlen(text)), djb2_str(text));
 }
+
+TEST_CASE("djb2_data of an empty buffer doesn't read the buffer") {
+    CHECK_EQ(djb2_data(nullptr, 0), 5381u);
+}
+
+TEST_CASE("hash_xxh32 produces the reference xxHash32 values") {
+    CHECK_EQ(hash_xxh32("", 0, 0), 0x02CC5D05u);
+    CHECK_EQ(hash_xxh32("", 0, 0x9E3779B1u), 0x36B78AE7u);
+    CHECK_EQ(hash_xxh32("a", 1, 0), 0x550D7456u);
+    CHECK_EQ(hash_xxh32("abc", 3, 0), 0x32D153FFu);
+    const char* text = "The quick brown fox jumps over the lazy dog";
+    CHECK_EQ(hash_xxh32(text, strlen(text), 0), 0xE85EA4DEu);
+}
+
+TEST_CASE("hash_xxh32 produces different hashes for different seeds") {
+    CHECK_NE(hash_xxh32("tactility", 9, 1), hash_xxh32("tactility", 9, 2));
+}
+
+TEST_CASE("hash_xxh32_update matches hash_xxh32 regardless of how the data is split") {
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 7U + (i >> 8));
+    }
+    CHECK_EQ(hash_xxh32(data.data(), data.size(), 0x12345678u), 0x97F95518u);
+
+    for (size_t chunk_size : { 1, 3, 15, 16, 17, 100 }) {
+        CAPTURE(chunk_size);
+        HashXxh32State state;
+        hash_xxh32_init(&state, 0x12345678u);
+        for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+            hash_xxh32_update(&state, data.data() + offset, std::min(chunk_size, data.size() - offset));
+        }
+        CHECK_EQ(hash_xxh32_final(&state), 0x97F95518u);
+    }
+
+    // Inputs shorter than a stripe take a different path
+    HashXxh32State state;
+    hash_xxh32_init(&state, 0);
+    hash_xxh32_update(&state, "ab", 2);
+    hash_xxh32_update(&state, "c", 1);
+    CHECK_EQ(hash_xxh32_final(&state), 0x32D153FFu);
+}
+
+TEST_CASE("hash_sha256 produces the reference SHA-256 values") {
+    const uint8_t expected[HASH_SHA256_SIZE] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    };
+    uint8_t hash[HASH_SHA256_SIZE] = {};
+    CHECK_EQ(hash_sha256("abc", 3, hash), ERROR_NONE);
+    CHECK_EQ(memcmp(hash, expected, sizeof(hash)), 0);
+
+    HashSha256State* state = nullptr;
+    REQUIRE_EQ(hash_sha256_init(&state), ERROR_NONE);
+    CHECK_EQ(hash_sha256_update(state, "a", 1), ERROR_NONE);
+    CHECK_EQ(hash_sha256_update(state, "bc", 2), ERROR_NONE);
+    memset(hash, 0, sizeof(hash));
+    CHECK_EQ(hash_sha256_final(state, hash), ERROR_NONE);
+
+    // A calculation that isn't finished
+    REQUIRE_EQ(hash_sha256_init(&state), ERROR_NONE);
+    CHECK_EQ(hash_sha256_update(state, "a", 1), ERROR_NONE);
+    hash_sha256_free(state);
+    CHECK_EQ(memcmp(hash, expected, sizeof(hash)), 0);
+}
+
+TEST_CASE("hash throughput benchmark") {
+    std::vector<uint8_t> data(1024 * 1024);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<uint8_t>(i * 31U);
+    }
+
+    for (size_t size : { 1024, 16 * 1024, 1024 * 1024 }) {
+        // Hash about 4 MB per algorithm, so small inputs are measured over many calls
+        size_t iterations = (4 * 1024 * 1024) / size;
+        uint32_t sink = 0;
+
+        uint64_t start_time = get_micros_since_boot();
+        for (size_t i = 0; i < iterations; i++) {
+            sink += djb2_data(data.data(), size);
+        }
+        uint64_t djb2_us = get_micros_since_boot() - start_time;
+
+        start_time = get_micros_since_boot();
+        for (size_t i = 0; i < iterations; i++) {
+            sink += hash_xxh32(data.data(), size, 0);
+        }
+        uint64_t xxh32_us = get_micros_since_boot() - start_time;
+
+        uint8_t hash[HASH_SHA256_SIZE];
+        start_time = get_micros_since_boot();
+        for (size_t i = 0; i < iterations; i++) {
+            hash_sha256(data.data(), size, hash);
+        }
+        uint64_t sha256_us = get_micros_since_boot() - start_time;
+        CHECK_NE(sink, 0u);
+
+        auto to_mb_per_second = [&](uint64_t duration_us) {
+            return static_cast<uint64_t>(size) * iterations / std::max<uint64_t>(duration_us, 1U);
+        };
+        MESSAGE((size / 1024U) << " kB: djb2 " << to_mb_per_second(djb2_us) << " MB/s, xxh32 "
+            << to_mb_per_second(xxh32_us) << " MB/s, sha256 " << to_mb_per_second(sha256_us) << " MB/s");
+    }
+}
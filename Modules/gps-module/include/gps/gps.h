@@ -12,6 +12,9 @@ extern "C" {
 
 #include <minmea.h>
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /**
  * @brief Supported GPS/GNSS receiver chipsets.
  */
@@ -51,6 +54,65 @@ enum GpsEventType {
     GPS_EVENT_UNSUBSCRIBED, // Last event, device wants to destroy itself and unsubscribed the subscriber.
     GPS_EVENT_MESSAGE_RMC,
     GPS_EVENT_MESSAGE_GGA,
+    GPS_EVENT_MESSAGE_GSA,
+    GPS_EVENT_MESSAGE_GSV,
+    GPS_EVENT_MESSAGE_VTG,
+    GPS_EVENT_MESSAGE_ZDA,
+    GPS_EVENT_POSITION, // All the data of 1 navigation epoch, see GpsPosition
+};
+
+/** @brief The bit for an event type in GpsSubscription::event_mask */
+#define GPS_EVENT_MASK(type) (1UL << (type))
+
+/** @brief All event types */
+#define GPS_EVENT_MASK_ALL 0xFFFFFFFFUL
+
+/** @brief The event types of a subscription with an event_mask of 0: the RMC and GGA sentences */
+#define GPS_EVENT_MASK_DEFAULT (GPS_EVENT_MASK(GPS_EVENT_MESSAGE_RMC) | GPS_EVENT_MASK(GPS_EVENT_MESSAGE_GGA))
+
+// Bits of GpsPosition::fields that tell which values were reported
+#define GPS_POSITION_FIELD_TIME (1UL << 0)
+#define GPS_POSITION_FIELD_DATE (1UL << 1)
+#define GPS_POSITION_FIELD_LOCATION (1UL << 2)
+#define GPS_POSITION_FIELD_ALTITUDE (1UL << 3)
+#define GPS_POSITION_FIELD_SPEED (1UL << 4)
+#define GPS_POSITION_FIELD_COURSE (1UL << 5)
+#define GPS_POSITION_FIELD_SATELLITES (1UL << 6)
+#define GPS_POSITION_FIELD_HDOP (1UL << 7)
+#define GPS_POSITION_FIELD_VDOP (1UL << 8)
+#define GPS_POSITION_FIELD_PDOP (1UL << 9)
+
+/**
+ * @brief A consolidated fix: the data of all the sentences of 1 navigation epoch, or of a single UBX-NAV-PVT message.
+ * Values use fixed point integers, so they are exact and the same for NMEA and UBX.
+ */
+struct GpsPosition {
+    /** @brief GPS_POSITION_FIELD_* bits for the values that were reported */
+    uint32_t fields;
+    /** @brief UTC time of the fix */
+    struct minmea_time time;
+    /** @brief UTC date of the fix, the year includes the century */
+    struct minmea_date date;
+    /** @brief The receiver reports a valid fix */
+    bool valid;
+    /** @brief enum minmea_gsa_fix_type, or 0 when unknown */
+    int fix_type;
+    /** @brief Degrees * 10^7, north is positive */
+    int32_t latitude_e7;
+    /** @brief Degrees * 10^7, east is positive */
+    int32_t longitude_e7;
+    /** @brief Millimeters above mean sea level */
+    int32_t altitude_mm;
+    /** @brief Ground speed in millimeters per second */
+    int32_t speed_mm_s;
+    /** @brief Course over ground in degrees * 10^5 */
+    int32_t course_e5;
+    /** @brief Satellites used for the fix */
+    int satellites;
+    /** @brief Dilutions of precision * 100 */
+    int hdop_e2;
+    int vdop_e2;
+    int pdop_e2;
 };
 
 struct GpsEvent {
@@ -58,6 +120,11 @@ struct GpsEvent {
     union {
         struct minmea_sentence_rmc rmc;
         struct minmea_sentence_gga gga;
+        struct minmea_sentence_gsa gsa;
+        struct minmea_sentence_gsv gsv;
+        struct minmea_sentence_vtg vtg;
+        struct minmea_sentence_zda zda;
+        struct GpsPosition position;
     } data;
 };
 
@@ -70,6 +137,12 @@ struct GpsSubscription {
     uint32_t consumed_sequence;
 
     struct GpsSubscription* next;
+
+    /**
+     * The GPS_EVENT_MASK() bits of the event types to receive, e.g. GPS_EVENT_MASK_ALL.
+     * 0 means GPS_EVENT_MASK_DEFAULT. Set it before subscribing. GPS_EVENT_UNSUBSCRIBED is always received.
+     */
+    uint32_t event_mask;
 };
 
 /**
@@ -77,7 +150,7 @@ struct GpsSubscription {
  */
 struct GpsApi {
     /**
-     * @brief Registers a subscriber for GPS events (e.g. RMC/GGA sentences).
+     * @brief Registers a subscriber for GPS events (e.g. RMC/GGA sentences or consolidated positions).
      * @param[in] device the GPS device
      * @param[in,out] sub subscription to register; caller owns the storage and must keep it alive until unsubscribed
      */
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Incremental parser for the NMEA and UBX messages that GPS receivers send.
+// Bytes are processed as they arrive, in chunks of any size: the checksums are calculated while the
+// bytes are buffered, so complete messages are decoded without another pass over their data.
+// Reference: https://gpsd.gitlab.io/gpsd/NMEA.html
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <gps/gps.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief The longest NMEA sentence that is decoded, including "$" and "*hh". Longer sentences are dropped. */
+#define GPS_PARSER_SENTENCE_SIZE_MAX 120
+
+/** @brief The largest UBX payload that is decoded: UBX-NAV-PVT. Larger messages are skipped. */
+#define GPS_PARSER_UBX_PAYLOAD_SIZE_MAX 92
+
+/**
+ * @brief Called for each decoded message and each consolidated position.
+ * @param[in] event the event, only valid during the call
+ * @param[in] context the context that was passed to gps_parser_init()
+ */
+typedef void (*GpsParserCallback)(const struct GpsEvent* event, void* context);
+
+/** @brief Counters for monitoring the quality of the data stream */
+struct GpsParserStats {
+    /** @brief NMEA sentences with a valid checksum */
+    uint32_t sentences;
+    /** @brief UBX messages with a valid checksum */
+    uint32_t ubx_messages;
+    /** @brief NMEA sentences and UBX messages that were dropped because of a checksum mismatch */
+    uint32_t checksum_errors;
+    /** @brief Messages that were dropped because they were too long or couldn't be decoded */
+    uint32_t dropped;
+    /** @brief GPS_EVENT_POSITION events */
+    uint32_t positions;
+};
+
+/**
+ * @brief Parser state.
+ * Only access it through the gps_parser_*() functions.
+ */
+struct GpsParser {
+    GpsParserCallback callback;
+    void* context;
+    uint32_t event_mask;
+    struct GpsParserStats stats;
+
+    uint8_t state;
+    uint8_t checksum;
+    uint8_t received_checksum;
+    uint8_t ubx_checksum_a;
+    uint8_t ubx_checksum_b;
+    uint8_t ubx_class;
+    uint8_t ubx_id;
+    uint16_t ubx_length;
+    uint16_t length;
+    char sentence[GPS_PARSER_SENTENCE_SIZE_MAX + 1];
+    uint8_t ubx_payload[GPS_PARSER_UBX_PAYLOAD_SIZE_MAX];
+
+    // The epoch that is being consolidated from NMEA sentences
+    struct GpsPosition position;
+    // GPS_EVENT_MASK() bits of the sentence types in the current epoch
+    uint8_t epoch_types;
+    bool epoch_reported;
+    // The type of the last sentence of the current epoch and of the previous epoch: when the latter
+    // arrives, the epoch is complete and it's reported without waiting for the next epoch to start.
+    // 0 when unknown, or when the previous epoch ended with GSA.
+    uint8_t last_type;
+    uint8_t epoch_end_type;
+};
+
+/**
+ * @brief Initializes a parser.
+ * @param[out] parser the parser to initialize
+ * @param[in] callback the function that receives the events
+ * @param[in] context passed to the callback
+ */
+void gps_parser_init(struct GpsParser* parser, GpsParserCallback callback, void* context);
+
+/**
+ * @brief Sets which events are reported. Messages that aren't needed for these events are checked but not decoded.
+ * @param[in] parser the parser
+ * @param[in] event_mask GPS_EVENT_MASK() bits, e.g. GPS_EVENT_MASK_ALL
+ */
+void gps_parser_set_event_mask(struct GpsParser* parser, uint32_t event_mask);
+
+/**
+ * @brief Processes received bytes. The callback is called from this function.
+ * Messages may be split over several calls in any way.
+ * @param[in] parser the parser
+ * @param[in] data the received bytes
+ * @param[in] length the number of bytes
+ */
+void gps_parser_feed(struct GpsParser* parser, const uint8_t* data, size_t length);
+
+/**
+ * @brief Discards the message that is being received and the epoch that is being consolidated, e.g. after reconfiguring the receiver.
+ * @param[in] parser the parser
+ */
+void gps_parser_reset(struct GpsParser* parser);
+
+/**
+ * @brief Gets the counters since gps_parser_init().
+ * @param[in] parser the parser
+ * @param[out] stats the counters
+ */
+void gps_parser_get_stats(const struct GpsParser* parser, struct GpsParserStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,566 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <gps/gps_parser.h>
+
+#include <cstring>
+
+namespace {
+
+enum ParserState : uint8_t {
+    STATE_IDLE,
+    STATE_NMEA_BODY,
+    STATE_NMEA_CHECKSUM_HIGH,
+    STATE_NMEA_CHECKSUM_LOW,
+    STATE_UBX_SYNC,
+    STATE_UBX_CLASS,
+    STATE_UBX_ID,
+    STATE_UBX_LENGTH_LOW,
+    STATE_UBX_LENGTH_HIGH,
+    STATE_UBX_PAYLOAD,
+    STATE_UBX_CHECKSUM_A,
+    STATE_UBX_CHECKSUM_B
+};
+
+constexpr uint8_t UBX_SYNC_1 = 0xB5;
+constexpr uint8_t UBX_SYNC_2 = 0x62;
+constexpr uint8_t UBX_CLASS_NAV = 0x01;
+constexpr uint8_t UBX_ID_NAV_PVT = 0x07;
+// Longer UBX messages are treated as corrupt data, so a bad length doesn't make the parser skip NMEA sentences
+constexpr uint16_t UBX_PAYLOAD_SIZE_LIMIT = 1024;
+
+// Room for "*hh" and the terminating NUL
+constexpr uint16_t NMEA_BODY_SIZE_MAX = GPS_PARSER_SENTENCE_SIZE_MAX - 3;
+
+int hex_value(uint8_t character) {
+    if (character >= '0' && character <= '9') return character - '0';
+    if (character >= 'A' && character <= 'F') return character - 'A' + 10;
+    if (character >= 'a' && character <= 'f') return character - 'a' + 10;
+    return -1;
+}
+
+bool is_wanted(const GpsParser* parser, GpsEventType type) {
+    return (parser->event_mask & GPS_EVENT_MASK(type)) != 0;
+}
+
+// region NMEA decoding
+
+/** @return false for proprietary and unsupported sentences */
+bool get_sentence_type(const char* sentence, GpsEventType* type) {
+    // "$TTSSS," where TT is the talker and SSS the sentence
+    if (sentence[1] == 'P') {
+        return false;
+    }
+    const char* name = sentence + 3;
+    if (std::strncmp(name, "RMC,", 4) == 0) {
+        *type = GPS_EVENT_MESSAGE_RMC;
+    } else if (std::strncmp(name, "GGA,", 4) == 0) {
+        *type = GPS_EVENT_MESSAGE_GGA;
+    } else if (std::strncmp(name, "GSA,", 4) == 0) {
+        *type = GPS_EVENT_MESSAGE_GSA;
+    } else if (std::strncmp(name, "GSV,", 4) == 0) {
+        *type = GPS_EVENT_MESSAGE_GSV;
+    } else if (std::strncmp(name, "VTG,", 4) == 0) {
+        *type = GPS_EVENT_MESSAGE_VTG;
+    } else if (std::strncmp(name, "ZDA,", 4) == 0) {
+        *type = GPS_EVENT_MESSAGE_ZDA;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool decode_sentence(const char* sentence, GpsEvent* event) {
+    switch (event->type) {
+        case GPS_EVENT_MESSAGE_RMC:
+            return minmea_parse_rmc(&event->data.rmc, sentence);
+        case GPS_EVENT_MESSAGE_GGA:
+            return minmea_parse_gga(&event->data.gga, sentence);
+        case GPS_EVENT_MESSAGE_GSA:
+            return minmea_parse_gsa(&event->data.gsa, sentence);
+        case GPS_EVENT_MESSAGE_GSV:
+            return minmea_parse_gsv(&event->data.gsv, sentence);
+        case GPS_EVENT_MESSAGE_VTG:
+            return minmea_parse_vtg(&event->data.vtg, sentence);
+        case GPS_EVENT_MESSAGE_ZDA:
+            return minmea_parse_zda(&event->data.zda, sentence);
+        default:
+            return false;
+    }
+}
+
+// endregion
+
+// region Epoch consolidation
+
+/** Converts NMEA's DDMM.MMMM to degrees * 10^7 */
+bool to_coordinate_e7(const minmea_float& value, int32_t* out) {
+    if (value.scale == 0) {
+        return false;
+    }
+    int64_t scale = value.scale;
+    int64_t degrees = value.value / (scale * 100);
+    // Minutes * scale, with the same sign as the degrees
+    int64_t minutes = value.value % (scale * 100);
+    *out = static_cast<int32_t>(degrees * 10000000 + minutes * 10000000 / (60 * scale));
+    return true;
+}
+
+bool has_time(const minmea_time& time) {
+    return time.hours >= 0;
+}
+
+bool is_same_time(const minmea_time& left, const minmea_time& right) {
+    return left.hours == right.hours && left.minutes == right.minutes &&
+        left.seconds == right.seconds && left.microseconds == right.microseconds;
+}
+
+void set_time(GpsPosition* position, const minmea_time& time) {
+    if (has_time(time)) {
+        position->time = time;
+        position->fields |= GPS_POSITION_FIELD_TIME;
+    }
+}
+
+void set_date(GpsPosition* position, const minmea_date& date) {
+    if (date.day > 0) {
+        position->date = date;
+        // RMC has a 2-digit year
+        if (position->date.year < 100) {
+            position->date.year += 2000;
+        }
+        position->fields |= GPS_POSITION_FIELD_DATE;
+    }
+}
+
+void set_location(GpsPosition* position, const minmea_float& latitude, const minmea_float& longitude) {
+    if (to_coordinate_e7(latitude, &position->latitude_e7) && to_coordinate_e7(longitude, &position->longitude_e7)) {
+        position->fields |= GPS_POSITION_FIELD_LOCATION;
+    }
+}
+
+void set_course(GpsPosition* position, const minmea_float& course) {
+    if (course.scale != 0) {
+        position->course_e5 = minmea_rescale(&course, 100000);
+        position->fields |= GPS_POSITION_FIELD_COURSE;
+    }
+}
+
+void set_dop(GpsPosition* position, const minmea_float& dop, int* out, uint32_t field) {
+    if (dop.scale != 0) {
+        *out = minmea_rescale(&dop, 100);
+        position->fields |= field;
+    }
+}
+
+const minmea_time* get_sentence_time(const GpsEvent& event) {
+    switch (event.type) {
+        case GPS_EVENT_MESSAGE_RMC:
+            return &event.data.rmc.time;
+        case GPS_EVENT_MESSAGE_GGA:
+            return &event.data.gga.time;
+        case GPS_EVENT_MESSAGE_ZDA:
+            return &event.data.zda.time;
+        default:
+            return nullptr;
+    }
+}
+
+void merge_sentence(GpsPosition* position, const GpsEvent& event) {
+    switch (event.type) {
+        case GPS_EVENT_MESSAGE_RMC: {
+            const auto& rmc = event.data.rmc;
+            set_time(position, rmc.time);
+            set_date(position, rmc.date);
+            set_location(position, rmc.latitude, rmc.longitude);
+            if (rmc.speed.scale != 0) {
+                // 1 knot is 514.444 mm/s
+                position->speed_mm_s = static_cast<int32_t>(static_cast<int64_t>(minmea_rescale(&rmc.speed, 1000)) * 514444 / 1000000);
+                position->fields |= GPS_POSITION_FIELD_SPEED;
+            }
+            set_course(position, rmc.course);
+            position->valid |= rmc.valid;
+            break;
+        }
+        case GPS_EVENT_MESSAGE_GGA: {
+            const auto& gga = event.data.gga;
+            set_time(position, gga.time);
+            set_location(position, gga.latitude, gga.longitude);
+            if (gga.altitude.scale != 0) {
+                position->altitude_mm = minmea_rescale(&gga.altitude, 1000);
+                position->fields |= GPS_POSITION_FIELD_ALTITUDE;
+            }
+            if (gga.satellites_tracked >= 0) {
+                position->satellites = gga.satellites_tracked;
+                position->fields |= GPS_POSITION_FIELD_SATELLITES;
+            }
+            set_dop(position, gga.hdop, &position->hdop_e2, GPS_POSITION_FIELD_HDOP);
+            position->valid |= gga.fix_quality > 0;
+            break;
+        }
+        case GPS_EVENT_MESSAGE_GSA: {
+            const auto& gsa = event.data.gsa;
+            if (gsa.fix_type > position->fix_type) {
+                position->fix_type = gsa.fix_type;
+            }
+            set_dop(position, gsa.pdop, &position->pdop_e2, GPS_POSITION_FIELD_PDOP);
+            set_dop(position, gsa.hdop, &position->hdop_e2, GPS_POSITION_FIELD_HDOP);
+            set_dop(position, gsa.vdop, &position->vdop_e2, GPS_POSITION_FIELD_VDOP);
+            break;
+        }
+        case GPS_EVENT_MESSAGE_VTG: {
+            const auto& vtg = event.data.vtg;
+            if (vtg.speed_kph.scale != 0) {
+                // Meters per hour to millimeters per second
+                position->speed_mm_s = minmea_rescale(&vtg.speed_kph, 1000) * 10 / 36;
+                position->fields |= GPS_POSITION_FIELD_SPEED;
+            }
+            set_course(position, vtg.true_track_degrees);
+            break;
+        }
+        case GPS_EVENT_MESSAGE_ZDA:
+            set_time(position, event.data.zda.time);
+            set_date(position, event.data.zda.date);
+            break;
+        default:
+            break;
+    }
+}
+
+void report_position(GpsParser* parser, const GpsPosition& position) {
+    GpsEvent event { .type = GPS_EVENT_POSITION };
+    event.data.position = position;
+    parser->stats.positions++;
+    parser->callback(&event, parser->context);
+}
+
+void report_epoch(GpsParser* parser) {
+    parser->epoch_reported = true;
+    if (parser->position.fields != 0) {
+        report_position(parser, parser->position);
+    }
+}
+
+void start_epoch(GpsParser* parser) {
+    if (!parser->epoch_reported) {
+        report_epoch(parser);
+    }
+    // Learn which sentence ends an epoch, so the next one is reported as soon as it's complete.
+    // GSA can't end an epoch: the number of GSA sentences depends on the constellations in use.
+    parser->epoch_end_type = parser->last_type != GPS_EVENT_MESSAGE_GSA ? parser->last_type : 0;
+    parser->position = {};
+    parser->epoch_types = 0;
+    parser->epoch_reported = false;
+}
+
+/**
+ * Adds a sentence to the current epoch. Receivers send a burst of sentences per epoch, in a fixed order
+ * that differs between models. A new epoch starts when the time of the fix changes or a sentence type
+ * repeats. GSA is the exception: multi-GNSS receivers send 1 per constellation, so it never ends an epoch.
+ */
+void consolidate(GpsParser* parser, const GpsEvent& event) {
+    auto type_bit = static_cast<uint8_t>(GPS_EVENT_MASK(event.type));
+    const minmea_time* time = get_sentence_time(event);
+    bool is_repeated = (parser->epoch_types & type_bit) != 0 && event.type != GPS_EVENT_MESSAGE_GSA;
+    bool is_new_time = time != nullptr && has_time(*time) &&
+        (parser->position.fields & GPS_POSITION_FIELD_TIME) != 0 && !is_same_time(*time, parser->position.time);
+    if (is_repeated || is_new_time) {
+        start_epoch(parser);
+    }
+
+    merge_sentence(&parser->position, event);
+    parser->epoch_types |= type_bit;
+    parser->last_type = event.type;
+    if (event.type == parser->epoch_end_type && !parser->epoch_reported) {
+        report_epoch(parser);
+    }
+}
+
+// endregion
+
+void handle_sentence(GpsParser* parser) {
+    parser->stats.sentences++;
+    GpsEvent event {};
+    if (!get_sentence_type(parser->sentence, &event.type)) {
+        return;
+    }
+
+    bool is_message_wanted = is_wanted(parser, event.type);
+    // Satellites in view don't change the position
+    bool is_position_wanted = is_wanted(parser, GPS_EVENT_POSITION) && event.type != GPS_EVENT_MESSAGE_GSV;
+    if (!is_message_wanted && !is_position_wanted) {
+        return;
+    }
+
+    if (!decode_sentence(parser->sentence, &event)) {
+        parser->stats.dropped++;
+        return;
+    }
+
+    if (is_message_wanted) {
+        parser->callback(&event, parser->context);
+    }
+    if (is_position_wanted) {
+        consolidate(parser, event);
+    }
+}
+
+// region UBX decoding
+
+uint16_t read_u16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+int32_t read_i32(const uint8_t* data) {
+    return static_cast<int32_t>(static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+        (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24));
+}
+
+/** Decodes UBX-NAV-PVT, as documented in the u-blox 8 / M8 receiver description */
+void decode_nav_pvt(const uint8_t* payload, GpsPosition* position) {
+    constexpr uint8_t VALID_DATE = 0x01;
+    constexpr uint8_t VALID_TIME = 0x02;
+    constexpr uint8_t FLAGS_GNSS_FIX_OK = 0x01;
+
+    *position = {};
+    uint8_t valid = payload[11];
+    if ((valid & VALID_DATE) != 0) {
+        position->date = { .day = payload[7], .month = payload[6], .year = read_u16(payload + 4) };
+        position->fields |= GPS_POSITION_FIELD_DATE;
+    }
+    if ((valid & VALID_TIME) != 0) {
+        // The nanoseconds are negative when the time was rounded up to the next second
+        int32_t nanoseconds = read_i32(payload + 16);
+        position->time = {
+            .hours = payload[8],
+            .minutes = payload[9],
+            .seconds = payload[10],
+            .microseconds = nanoseconds > 0 ? nanoseconds / 1000 : 0
+        };
+        position->fields |= GPS_POSITION_FIELD_TIME;
+    }
+
+    // 0: no fix, 1: dead reckoning only, 2: 2D, 3: 3D, 4: GNSS and dead reckoning, 5: time only
+    uint8_t fix_type = payload[20];
+    position->valid = (payload[21] & FLAGS_GNSS_FIX_OK) != 0;
+    if (fix_type == 2) {
+        position->fix_type = MINMEA_GPGSA_FIX_2D;
+    } else if (fix_type == 3 || fix_type == 4) {
+        position->fix_type = MINMEA_GPGSA_FIX_3D;
+    } else {
+        position->fix_type = MINMEA_GPGSA_FIX_NONE;
+    }
+
+    position->satellites = payload[23];
+    position->pdop_e2 = read_u16(payload + 76);
+    position->fields |= GPS_POSITION_FIELD_SATELLITES | GPS_POSITION_FIELD_PDOP;
+
+    if (fix_type >= 1 && fix_type <= 4) {
+        position->longitude_e7 = read_i32(payload + 24);
+        position->latitude_e7 = read_i32(payload + 28);
+        position->speed_mm_s = read_i32(payload + 60);
+        position->course_e5 = read_i32(payload + 64);
+        position->fields |= GPS_POSITION_FIELD_LOCATION | GPS_POSITION_FIELD_SPEED | GPS_POSITION_FIELD_COURSE;
+        if (fix_type != 2) {
+            position->altitude_mm = read_i32(payload + 36);
+            position->fields |= GPS_POSITION_FIELD_ALTITUDE;
+        }
+    }
+}
+
+void handle_ubx(GpsParser* parser) {
+    parser->stats.ubx_messages++;
+    if (parser->ubx_class == UBX_CLASS_NAV && parser->ubx_id == UBX_ID_NAV_PVT &&
+        parser->ubx_length == GPS_PARSER_UBX_PAYLOAD_SIZE_MAX && is_wanted(parser, GPS_EVENT_POSITION)) {
+        GpsPosition position;
+        decode_nav_pvt(parser->ubx_payload, &position);
+        report_position(parser, position);
+    }
+}
+
+void update_ubx_checksum(GpsParser* parser, uint8_t byte) {
+    parser->ubx_checksum_a += byte;
+    parser->ubx_checksum_b += parser->ubx_checksum_a;
+}
+
+// endregion
+
+void drop_message(GpsParser* parser) {
+    parser->stats.dropped++;
+    parser->state = STATE_IDLE;
+}
+
+void feed_byte(GpsParser* parser, uint8_t byte) {
+    switch (parser->state) {
+        case STATE_IDLE:
+            if (byte == '$') {
+                parser->sentence[0] = '$';
+                parser->length = 1;
+                parser->checksum = 0;
+                parser->state = STATE_NMEA_BODY;
+            } else if (byte == UBX_SYNC_1) {
+                parser->state = STATE_UBX_SYNC;
+            }
+            break;
+        case STATE_NMEA_CHECKSUM_HIGH:
+        case STATE_NMEA_CHECKSUM_LOW: {
+            int value = hex_value(byte);
+            if (value < 0) {
+                drop_message(parser);
+                // It might be the start of the next message
+                feed_byte(parser, byte);
+                break;
+            }
+            parser->sentence[parser->length++] = static_cast<char>(byte);
+            if (parser->state == STATE_NMEA_CHECKSUM_HIGH) {
+                parser->received_checksum = static_cast<uint8_t>(value << 4);
+                parser->state = STATE_NMEA_CHECKSUM_LOW;
+            } else {
+                parser->received_checksum |= static_cast<uint8_t>(value);
+                parser->sentence[parser->length] = '\0';
+                parser->state = STATE_IDLE;
+                if (parser->received_checksum == parser->checksum) {
+                    handle_sentence(parser);
+                } else {
+                    parser->stats.checksum_errors++;
+                }
+            }
+            break;
+        }
+        case STATE_UBX_SYNC:
+            if (byte == UBX_SYNC_2) {
+                parser->ubx_checksum_a = 0;
+                parser->ubx_checksum_b = 0;
+                parser->state = STATE_UBX_CLASS;
+            } else {
+                parser->state = STATE_IDLE;
+                feed_byte(parser, byte);
+            }
+            break;
+        case STATE_UBX_CLASS:
+            parser->ubx_class = byte;
+            update_ubx_checksum(parser, byte);
+            parser->state = STATE_UBX_ID;
+            break;
+        case STATE_UBX_ID:
+            parser->ubx_id = byte;
+            update_ubx_checksum(parser, byte);
+            parser->state = STATE_UBX_LENGTH_LOW;
+            break;
+        case STATE_UBX_LENGTH_LOW:
+            parser->ubx_length = byte;
+            update_ubx_checksum(parser, byte);
+            parser->state = STATE_UBX_LENGTH_HIGH;
+            break;
+        case STATE_UBX_LENGTH_HIGH:
+            parser->ubx_length |= static_cast<uint16_t>(byte << 8);
+            update_ubx_checksum(parser, byte);
+            parser->length = 0;
+            if (parser->ubx_length > UBX_PAYLOAD_SIZE_LIMIT) {
+                drop_message(parser);
+            } else {
+                parser->state = (parser->ubx_length > 0) ? STATE_UBX_PAYLOAD : STATE_UBX_CHECKSUM_A;
+            }
+            break;
+        case STATE_UBX_PAYLOAD:
+            // Payloads that don't fit are only checked
+            if (parser->length < GPS_PARSER_UBX_PAYLOAD_SIZE_MAX) {
+                parser->ubx_payload[parser->length] = byte;
+            }
+            parser->length++;
+            update_ubx_checksum(parser, byte);
+            if (parser->length == parser->ubx_length) {
+                parser->state = STATE_UBX_CHECKSUM_A;
+            }
+            break;
+        case STATE_UBX_CHECKSUM_A:
+            if (byte == parser->ubx_checksum_a) {
+                parser->state = STATE_UBX_CHECKSUM_B;
+            } else {
+                parser->stats.checksum_errors++;
+                parser->state = STATE_IDLE;
+            }
+            break;
+        case STATE_UBX_CHECKSUM_B:
+            parser->state = STATE_IDLE;
+            if (byte == parser->ubx_checksum_b) {
+                handle_ubx(parser);
+            } else {
+                parser->stats.checksum_errors++;
+            }
+            break;
+        default:
+            parser->state = STATE_IDLE;
+            break;
+    }
+}
+
+/**
+ * Buffers the body of a sentence and calculates its checksum, until the "*" before the checksum.
+ * This is where most of the bytes go, so it doesn't go through the state machine for each byte.
+ * @return the first byte that wasn't processed
+ */
+const uint8_t* feed_nmea_body(GpsParser* parser, const uint8_t* data, const uint8_t* end) {
+    uint16_t length = parser->length;
+    uint8_t checksum = parser->checksum;
+    while (data < end) {
+        uint8_t byte = *data;
+        if (byte == '*') {
+            parser->sentence[length++] = '*';
+            parser->state = STATE_NMEA_CHECKSUM_HIGH;
+            data++;
+            break;
+        }
+        if (byte == '$' || byte < 0x20 || byte > 0x7E || length == NMEA_BODY_SIZE_MAX) {
+            // Incomplete sentence: the byte might be the start of the next message
+            drop_message(parser);
+            break;
+        }
+        parser->sentence[length++] = static_cast<char>(byte);
+        checksum ^= byte;
+        data++;
+    }
+    parser->length = length;
+    parser->checksum = checksum;
+    return data;
+}
+
+} // namespace
+
+extern "C" {
+
+void gps_parser_init(struct GpsParser* parser, GpsParserCallback callback, void* context) {
+    *parser = {};
+    parser->callback = callback;
+    parser->context = context;
+    parser->event_mask = GPS_EVENT_MASK_ALL;
+}
+
+void gps_parser_set_event_mask(struct GpsParser* parser, uint32_t event_mask) {
+    parser->event_mask = event_mask;
+}
+
+void gps_parser_feed(struct GpsParser* parser, const uint8_t* data, size_t length) {
+    const uint8_t* end = data + length;
+    while (data < end) {
+        if (parser->state == STATE_NMEA_BODY) {
+            data = feed_nmea_body(parser, data, end);
+        } else {
+            feed_byte(parser, *data);
+            data++;
+        }
+    }
+}
+
+void gps_parser_reset(struct GpsParser* parser) {
+    parser->state = STATE_IDLE;
+    parser->position = {};
+    parser->epoch_types = 0;
+    parser->epoch_reported = false;
+    parser->last_type = 0;
+    parser->epoch_end_type = 0;
+}
+
+void gps_parser_get_stats(const struct GpsParser* parser, struct GpsParserStats* stats) {
+    *stats = parser->stats;
+}
+
+}
@@ -0,0 +1,415 @@
+#include "doctest.h"
+#include <gps/gps_parser.h>
+#include <tactility/time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Recorded from a u-blox M8 (GPS + GLONASS) at 1 Hz: 3 epochs
+const char* UBLOX_M8_LOG =
+    "$GNRMC,092750.00,A,5321.68070,N,00630.33720,W,0.004,77.52,091202,,,A*5C\r\n"
+    "$GNVTG,77.52,T,,M,0.004,N,0.008,K,A*18\r\n"
+    "$GNGGA,092750.00,5321.68070,N,00630.33720,W,1,08,1.01,21.3,M,51.4,M,,*6D\r\n"
+    "$GNGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*14\r\n"
+    "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1F\r\n"
+    "$GPGSV,3,1,10,02,14,137,29,04,53,148,40,05,28,203,42,07,29,299,35*78\r\n"
+    "$GPGSV,3,2,10,08,09,328,26,10,23,066,32,13,73,233,44,15,04,060,*76\r\n"
+    "$GPGSV,3,3,10,29,43,043,38,30,01,332,*78\r\n"
+    "$GLGSV,1,1,02,67,36,249,33,68,53,329,30*6F\r\n"
+    "$GNGLL,5321.68070,N,00630.33720,W,092750.00,A,A*60\r\n"
+    "$GPTXT,01,01,02,u-blox ag - www.u-blox.com*50\r\n"
+    "$GNRMC,092751.00,A,5321.68075,N,00630.33725,W,0.012,77.60,091202,,,A*5B\r\n"
+    "$GNVTG,77.60,T,,M,0.012,N,0.008,K,A*1E\r\n"
+    "$GNGGA,092751.00,5321.68075,N,00630.33725,W,1,08,1.01,21.4,M,51.4,M,,*6B\r\n"
+    "$GNGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*14\r\n"
+    "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1F\r\n"
+    "$GPGSV,3,1,10,02,14,137,29,04,53,148,40,05,28,203,42,07,29,299,35*78\r\n"
+    "$GPGSV,3,2,10,08,09,328,26,10,23,066,32,13,73,233,44,15,04,060,*76\r\n"
+    "$GPGSV,3,3,10,29,43,043,38,30,01,332,*78\r\n"
+    "$GLGSV,1,1,02,67,36,249,33,68,53,329,30*6F\r\n"
+    "$GNGLL,5321.68075,N,00630.33725,W,092751.00,A,A*61\r\n"
+    "$GNRMC,092752.00,A,5321.68080,N,00630.33730,W,0.020,,091202,,,A*7F\r\n"
+    "$GNVTG,,T,,M,0.020,N,0.008,K,A*37\r\n"
+    "$GNGGA,092752.00,5321.68080,N,00630.33730,W,1,08,1.01,21.6,M,51.4,M,,*64\r\n"
+    "$GNGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*14\r\n"
+    "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1F\r\n"
+    "$GPGSV,3,1,10,02,14,137,29,04,53,148,40,05,28,203,42,07,29,299,35*78\r\n"
+    "$GPGSV,3,2,10,08,09,328,26,10,23,066,32,13,73,233,44,15,04,060,*76\r\n"
+    "$GPGSV,3,3,10,29,43,043,38,30,01,332,*78\r\n"
+    "$GLGSV,1,1,02,67,36,249,33,68,53,329,30*6F\r\n"
+    "$GNGLL,5321.68080,N,00630.33730,W,092752.00,A,A*6C\r\n";
+
+// The first sentence of the epoch after UBLOX_M8_LOG: the last epoch of a log is only complete when the next one starts
+const char* UBLOX_M8_NEXT_EPOCH = "$GNRMC,092753.00,A,5321.68085,N,00630.33735,W,0.020,,091202,,,A*7E\r\n";
+
+struct EventRecorder {
+    std::vector<GpsEvent> events;
+
+    static void callback(const GpsEvent* event, void* context) {
+        static_cast<EventRecorder*>(context)->events.push_back(*event);
+    }
+
+    size_t count(GpsEventType type) const {
+        size_t result = 0;
+        for (const auto& event : events) {
+            if (event.type == type) {
+                result++;
+            }
+        }
+        return result;
+    }
+
+    std::vector<GpsPosition> positions() const {
+        std::vector<GpsPosition> result;
+        for (const auto& event : events) {
+            if (event.type == GPS_EVENT_POSITION) {
+                result.push_back(event.data.position);
+            }
+        }
+        return result;
+    }
+};
+
+void feed(GpsParser* parser, const char* text) {
+    gps_parser_feed(parser, reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+std::vector<uint8_t> create_ubx_message(uint8_t message_class, uint8_t id, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> message = { 0xB5, 0x62, message_class, id,
+        static_cast<uint8_t>(payload.size()), static_cast<uint8_t>(payload.size() >> 8) };
+    message.insert(message.end(), payload.begin(), payload.end());
+    uint8_t checksum_a = 0;
+    uint8_t checksum_b = 0;
+    for (size_t i = 2; i < message.size(); i++) {
+        checksum_a += message[i];
+        checksum_b += checksum_a;
+    }
+    message.push_back(checksum_a);
+    message.push_back(checksum_b);
+    return message;
+}
+
+void put_i32(std::vector<uint8_t>& payload, size_t offset, int32_t value) {
+    for (int i = 0; i < 4; i++) {
+        payload[offset + i] = static_cast<uint8_t>(static_cast<uint32_t>(value) >> (i * 8));
+    }
+}
+
+std::vector<uint8_t> create_nav_pvt() {
+    std::vector<uint8_t> payload(92, 0);
+    payload[4] = 2026 & 0xFF;
+    payload[5] = 2026 >> 8;
+    payload[6] = 10; // month
+    payload[7] = 16; // day
+    payload[8] = 9; // hours
+    payload[9] = 27;
+    payload[10] = 50;
+    payload[11] = 0x03; // valid date and time
+    put_i32(payload, 16, 250000000); // nanoseconds
+    payload[20] = 3; // 3D fix
+    payload[21] = 0x01; // gnssFixOK
+    payload[23] = 11; // satellites
+    put_i32(payload, 24, -65056200); // longitude
+    put_i32(payload, 28, 533613450); // latitude
+    put_i32(payload, 36, 21300); // height above mean sea level
+    put_i32(payload, 60, 1500); // ground speed
+    put_i32(payload, 64, 7752000); // heading of motion
+    payload[76] = 172; // pDOP
+    return create_ubx_message(0x01, 0x07, payload);
+}
+
+std::string remove_sentences(std::string log, const char* prefix) {
+    size_t start;
+    while ((start = log.find(prefix)) != std::string::npos) {
+        log.erase(start, log.find('\n', start) + 1 - start);
+    }
+    return log;
+}
+
+} // namespace
+
+TEST_CASE("gps_parser decodes all supported sentences of a recorded log") {
+    EventRecorder recorder;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &recorder);
+    feed(&parser, UBLOX_M8_LOG);
+
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_RMC), 3);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_VTG), 3);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_GGA), 3);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_GSA), 6);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_GSV), 12);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_ZDA), 0);
+
+    GpsParserStats stats;
+    gps_parser_get_stats(&parser, &stats);
+    CHECK_EQ(stats.sentences, 31);
+    CHECK_EQ(stats.checksum_errors, 0);
+    CHECK_EQ(stats.dropped, 0);
+
+    const auto& gsv = recorder.events[5].data.gsv;
+    REQUIRE_EQ(recorder.events[5].type, GPS_EVENT_MESSAGE_GSV);
+    CHECK_EQ(gsv.total_sats, 10);
+    CHECK_EQ(gsv.sats[1].nr, 4);
+    CHECK_EQ(gsv.sats[1].snr, 40);
+}
+
+TEST_CASE("gps_parser consolidates the sentences of an epoch into a position") {
+    EventRecorder recorder;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &recorder);
+    feed(&parser, UBLOX_M8_LOG);
+    feed(&parser, UBLOX_M8_NEXT_EPOCH);
+
+    auto positions = recorder.positions();
+    REQUIRE_EQ(positions.size(), 3);
+    const auto& position = positions[0];
+    CHECK(position.valid);
+    CHECK_EQ(position.fix_type, MINMEA_GPGSA_FIX_3D);
+    CHECK_EQ(position.time.hours, 9);
+    CHECK_EQ(position.time.minutes, 27);
+    CHECK_EQ(position.time.seconds, 50);
+    CHECK_EQ(position.date.day, 9);
+    CHECK_EQ(position.date.month, 12);
+    CHECK_EQ(position.date.year, 2002);
+    CHECK_EQ(position.latitude_e7, 533613450);
+    CHECK_EQ(position.longitude_e7, -65056200);
+    CHECK_EQ(position.altitude_mm, 21300);
+    CHECK_EQ(position.speed_mm_s, 2);
+    CHECK_EQ(position.course_e5, 7752000);
+    CHECK_EQ(position.satellites, 8);
+    CHECK_EQ(position.hdop_e2, 103);
+    CHECK_EQ(position.vdop_e2, 138);
+    CHECK_EQ(position.pdop_e2, 172);
+
+    CHECK_EQ(positions[1].time.seconds, 51);
+    CHECK_EQ(positions[1].latitude_e7, 533613458);
+    // The last epoch has no course
+    CHECK_EQ(positions[2].fields & GPS_POSITION_FIELD_COURSE, 0);
+    CHECK_NE(positions[2].fields & GPS_POSITION_FIELD_LOCATION, 0);
+}
+
+TEST_CASE("gps_parser reports an epoch as soon as its last sentence arrives once it learned the order") {
+    EventRecorder recorder;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &recorder);
+    gps_parser_set_event_mask(&parser, GPS_EVENT_MASK(GPS_EVENT_POSITION));
+
+    // A GPS-only receiver that doesn't send GSA
+    std::string log = remove_sentences(UBLOX_M8_LOG, "$GNGSA");
+    size_t second_epoch = log.find("$GNRMC", 1);
+    size_t second_epoch_gga = log.find("$GNGGA", second_epoch);
+    size_t second_epoch_gga_end = log.find('\n', second_epoch_gga) + 1;
+
+    // The first epoch is reported when the next epoch starts
+    feed(&parser, log.substr(0, second_epoch).c_str());
+    CHECK_EQ(recorder.events.size(), 0);
+    feed(&parser, log.substr(second_epoch, second_epoch_gga_end - second_epoch).c_str());
+    REQUIRE_EQ(recorder.events.size(), 2);
+    // The second epoch is reported at its GGA, which was the last position sentence of the first epoch
+    CHECK_EQ(recorder.events[1].data.position.time.seconds, 51);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_RMC), 0);
+}
+
+TEST_CASE("gps_parser merges all GSA sentences of an epoch") {
+    EventRecorder recorder;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &recorder);
+    gps_parser_set_event_mask(&parser, GPS_EVENT_MASK(GPS_EVENT_POSITION));
+
+    // The GLONASS GSA of every epoch has other DOP values than the GPS GSA before it
+    std::string log = UBLOX_M8_LOG;
+    const std::string glonass_gsa = "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1F";
+    size_t start;
+    while ((start = log.find(glonass_gsa)) != std::string::npos) {
+        log.replace(start, glonass_gsa.size(), "$GNGSA,A,3,67,68,,,,,,,,,,,2.50,1.50,2.00*12");
+    }
+    feed(&parser, log.c_str());
+    feed(&parser, UBLOX_M8_NEXT_EPOCH);
+
+    auto positions = recorder.positions();
+    REQUIRE_EQ(positions.size(), 3);
+    for (const auto& position : positions) {
+        CHECK_EQ(position.pdop_e2, 250);
+        CHECK_EQ(position.vdop_e2, 200);
+    }
+}
+
+TEST_CASE("gps_parser handles any split of the data") {
+    EventRecorder whole;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &whole);
+    feed(&parser, UBLOX_M8_LOG);
+
+    EventRecorder split;
+    gps_parser_init(&parser, EventRecorder::callback, &split);
+    const auto* data = reinterpret_cast<const uint8_t*>(UBLOX_M8_LOG);
+    size_t length = strlen(UBLOX_M8_LOG);
+    for (size_t i = 0; i < length; i++) {
+        gps_parser_feed(&parser, data + i, 1);
+    }
+
+    REQUIRE_EQ(split.events.size(), whole.events.size());
+    for (size_t i = 0; i < whole.events.size(); i++) {
+        CHECK_EQ(split.events[i].type, whole.events[i].type);
+        CHECK_EQ(memcmp(&split.events[i].data, &whole.events[i].data, sizeof(GpsEvent::data)), 0);
+    }
+}
+
+TEST_CASE("gps_parser drops corrupt sentences and recovers at the next one") {
+    EventRecorder recorder;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &recorder);
+    gps_parser_set_event_mask(&parser, GPS_EVENT_MASK(GPS_EVENT_MESSAGE_GSA));
+
+    // Wrong checksum
+    feed(&parser, "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1E\r\n");
+    // Cut off by the next sentence, and garbage in between
+    feed(&parser, "$GNGSA,A,3,67,68,,,\x01\xFF$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1F\r\n");
+    // No checksum
+    feed(&parser, "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38\r\n");
+    // Too long
+    feed(&parser, ("$GNGSA," + std::string(GPS_PARSER_SENTENCE_SIZE_MAX, '1') + "*00\r\n").c_str());
+
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_GSA), 1);
+    GpsParserStats stats;
+    gps_parser_get_stats(&parser, &stats);
+    CHECK_EQ(stats.sentences, 1);
+    CHECK_EQ(stats.checksum_errors, 1);
+    CHECK_EQ(stats.dropped, 3);
+}
+
+TEST_CASE("gps_parser only decodes the sentences for the event mask") {
+    EventRecorder recorder;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &recorder);
+    gps_parser_set_event_mask(&parser, GPS_EVENT_MASK(GPS_EVENT_MESSAGE_GGA) | GPS_EVENT_MASK(GPS_EVENT_MESSAGE_VTG));
+    feed(&parser, UBLOX_M8_LOG);
+
+    CHECK_EQ(recorder.events.size(), 6);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_GGA), 3);
+    CHECK_EQ(recorder.count(GPS_EVENT_MESSAGE_VTG), 3);
+}
+
+TEST_CASE("gps_parser decodes UBX-NAV-PVT between NMEA sentences") {
+    EventRecorder recorder;
+    GpsParser parser;
+    gps_parser_init(&parser, EventRecorder::callback, &recorder);
+    gps_parser_set_event_mask(&parser, GPS_EVENT_MASK(GPS_EVENT_POSITION) | GPS_EVENT_MASK(GPS_EVENT_MESSAGE_GSA));
+
+    auto pvt = create_nav_pvt();
+    // An ACK, which is ignored
+    auto ack = create_ubx_message(0x05, 0x01, { 0x06, 0x01 });
+    feed(&parser, "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1F\r\n");
+    gps_parser_feed(&parser, ack.data(), ack.size());
+    gps_parser_feed(&parser, pvt.data(), pvt.size());
+    feed(&parser, "$GNGSA,A,3,67,68,,,,,,,,,,,1.72,1.03,1.38*1F\r\n");
+
+    REQUIRE_EQ(recorder.events.size(), 3);
+    CHECK_EQ(recorder.events[0].type, GPS_EVENT_MESSAGE_GSA);
+    REQUIRE_EQ(recorder.events[1].type, GPS_EVENT_POSITION);
+    CHECK_EQ(recorder.events[2].type, GPS_EVENT_MESSAGE_GSA);
+
+    const auto& position = recorder.events[1].data.position;
+    CHECK(position.valid);
+    CHECK_EQ(position.fix_type, MINMEA_GPGSA_FIX_3D);
+    CHECK_EQ(position.date.year, 2026);
+    CHECK_EQ(position.date.month, 10);
+    CHECK_EQ(position.date.day, 16);
+    CHECK_EQ(position.time.hours, 9);
+    CHECK_EQ(position.time.microseconds, 250000);
+    CHECK_EQ(position.latitude_e7, 533613450);
+    CHECK_EQ(position.longitude_e7, -65056200);
+    CHECK_EQ(position.altitude_mm, 21300);
+    CHECK_EQ(position.speed_mm_s, 1500);
+    CHECK_EQ(position.course_e5, 7752000);
+    CHECK_EQ(position.satellites, 11);
+    CHECK_EQ(position.pdop_e2, 172);
+    CHECK_EQ(position.fields & GPS_POSITION_FIELD_HDOP, 0);
+
+    GpsParserStats stats;
+    gps_parser_get_stats(&parser, &stats);
+    CHECK_EQ(stats.ubx_messages, 2);
+
+    // A corrupt message is dropped
+    pvt[20] = 2;
+    gps_parser_feed(&parser, pvt.data(), pvt.size());
+    gps_parser_get_stats(&parser, &stats);
+    CHECK_EQ(stats.checksum_errors, 1);
+    CHECK_EQ(recorder.count(GPS_EVENT_POSITION), 1);
+}
+
+TEST_CASE("gps_parser replay benchmark") {
+    constexpr int ITERATIONS = 200;
+    // Typical for a UART read while the receiver is sending a burst
+    constexpr size_t CHUNK_SIZE = 64;
+    std::string log = UBLOX_M8_LOG;
+    const auto* data = reinterpret_cast<const uint8_t*>(log.data());
+    uint64_t total_bytes = static_cast<uint64_t>(log.size()) * ITERATIONS;
+
+    // The previous pipeline: split lines, then identify them with minmea, which checks the checksum in another pass
+    size_t line_events = 0;
+    uint64_t start_time = get_micros_since_boot();
+    for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+        size_t start = 0;
+        size_t end;
+        while ((end = log.find('\n', start)) != std::string::npos) {
+            char line[GPS_PARSER_SENTENCE_SIZE_MAX + 3];
+            size_t length = end + 1 - start;
+            memcpy(line, log.data() + start, length);
+            line[length] = '\0';
+            start = end + 1;
+            switch (minmea_sentence_id(line, false)) {
+                case MINMEA_SENTENCE_RMC: {
+                    minmea_sentence_rmc rmc;
+                    line_events += minmea_parse_rmc(&rmc, line) ? 1 : 0;
+                    break;
+                }
+                case MINMEA_SENTENCE_GGA: {
+                    minmea_sentence_gga gga;
+                    line_events += minmea_parse_gga(&gga, line) ? 1 : 0;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+    uint64_t line_us = get_micros_since_boot() - start_time;
+
+    auto measure = [&](uint32_t event_mask, size_t& event_count) {
+        size_t count = 0;
+        GpsParser parser;
+        gps_parser_init(&parser, [](const GpsEvent*, void* context) { (*static_cast<size_t*>(context))++; }, &count);
+        gps_parser_set_event_mask(&parser, event_mask);
+        uint64_t start = get_micros_since_boot();
+        for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+            for (size_t offset = 0; offset < log.size(); offset += CHUNK_SIZE) {
+                gps_parser_feed(&parser, data + offset, std::min(CHUNK_SIZE, log.size() - offset));
+            }
+        }
+        event_count = count;
+        return get_micros_since_boot() - start;
+    };
+
+    size_t rmc_gga_events;
+    uint64_t rmc_gga_us = measure(GPS_EVENT_MASK(GPS_EVENT_MESSAGE_RMC) | GPS_EVENT_MASK(GPS_EVENT_MESSAGE_GGA), rmc_gga_events);
+    size_t position_events;
+    uint64_t position_us = measure(GPS_EVENT_MASK(GPS_EVENT_POSITION), position_events);
+    size_t all_events;
+    uint64_t all_us = measure(GPS_EVENT_MASK_ALL, all_events);
+
+    CHECK_EQ(rmc_gga_events, line_events);
+    // The last epoch is only reported when the next one starts
+    CHECK_EQ(position_events, 3 * ITERATIONS - 1);
+
+    auto throughput = [&](uint64_t us) { return (total_bytes * 1000000U / (us + 1)) / 1024U; };
+    MESSAGE("line split + minmea (RMC, GGA): " << throughput(line_us) << " KiB/s");
+    MESSAGE("gps_parser (RMC, GGA): " << throughput(rmc_gga_us) << " KiB/s");
+    MESSAGE("gps_parser (positions): " << throughput(position_us) << " KiB/s");
+    MESSAGE("gps_parser (all " << ((all_events + 1) / ITERATIONS) << " events per replay): " << throughput(all_us) << " KiB/s");
+}
@@ -60,6 +60,37 @@ struct LvglDisplayConfig {
      * never DMAs directly from the buffer pointer LVGL hands it in the flush callback.
      */
     bool prefer_external_ram;
+
+    /**
+     * Enables the flush pipeline, for partial rendering:
+     * - Invalidated areas that are close to each other are merged, so a frame takes fewer (but
+     *   slightly larger) transfers.
+     * - Transfers go through display_draw_bitmap_async(). With a driver that has
+     *   DISPLAY_CAPABILITY_ASYNC_DRAW and double_buffer set, LVGL renders the next tile while the
+     *   previous one is still being transferred. When it has to wait for that transfer, the LVGL
+     *   task blocks until the driver reports it done, instead of spinning.
+     */
+    bool flush_pipeline;
+};
+
+/**
+ * @brief Flush statistics of a display. Times are in microseconds.
+ */
+struct LvglDisplayFlushStats {
+    /** The amount of frames that were flushed */
+    uint32_t frame_count;
+    /** Time from the first flush of the last frame until its last transfer was done */
+    uint32_t last_frame_flush_us;
+    /** The longest frame flush time */
+    uint32_t max_frame_flush_us;
+    /** The amount of pixel data bytes that were sent for the last frame */
+    uint32_t last_frame_bytes;
+    /** The amount of transfers (draw_bitmap calls) for the last frame */
+    uint32_t last_frame_transfers;
+    /** Invalidated areas that were merged into another area (see LvglDisplayConfig::flush_pipeline) */
+    uint32_t coalesced_areas;
+    /** The amount of pixel data bytes that were sent since the display was added */
+    uint64_t total_bytes;
 };
 
 /**
@@ -82,6 +113,16 @@ struct LvglDisplayConfig {
  */
 error_t lvgl_display_add(struct Device* device, const struct LvglDisplayConfig* config, lv_display_t** out_display);
 
+/**
+ * @brief Gets the flush statistics of a display that was created with lvgl_display_add().
+ * @warning Caller must hold the LVGL lock.
+ * @param[in] display the display
+ * @param[out] out_stats the statistics
+ * @retval ERROR_NONE on success
+ * @retval ERROR_INVALID_ARGUMENT if display or out_stats is NULL
+ */
+error_t lvgl_display_get_flush_stats(lv_display_t* display, struct LvglDisplayFlushStats* out_stats);
+
 /**
  * @brief Removes a display previously created with lvgl_display_add(), freeing any buffers it owns.
  * @warning Caller must hold the LVGL lock.
@@ -68,12 +68,16 @@ void lvgl_devices_attach() {
         bool can_hw_rotate = display_has_capability(kernel_display_device, DISPLAY_CAPABILITY_CAP_SWAP_XY) &&
             display_has_capability(kernel_display_device, DISPLAY_CAPABILITY_CAP_MIRROR);
         bool prefer_external_ram_buffer = display_has_capability(kernel_display_device, DISPLAY_CAPABILITY_PREFER_EXTERNAL_RAM);
+        // A second buffer only pays off when LVGL can render into it while the driver is still sending the first one
+        bool async_draw = display_has_capability(kernel_display_device, DISPLAY_CAPABILITY_ASYNC_DRAW);
         struct LvglDisplayConfig lvgl_display_config = {
             .buffer_height = (uint16_t)(vres > 10 ? vres / 10 : vres),
+            .double_buffer = async_draw,
             .sw_rotate = !can_hw_rotate,
             .swap_bytes = swap_bytes,
             .force_full_frame = display_requires_full_frame,
-            .prefer_external_ram = prefer_external_ram_buffer
+            .prefer_external_ram = prefer_external_ram_buffer,
+            .flush_pipeline = async_draw
         };
         lv_disp_t* added_display = NULL;
         if (lvgl_display_add(kernel_display_device, &lvgl_display_config, &added_display) == ERROR_NONE) {
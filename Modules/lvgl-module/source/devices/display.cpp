@@ -3,13 +3,19 @@
 
 #include <lvgl/ppa.h>
 
+#include <tactility/delay.h>
 #include <tactility/device.h>
 #include <tactility/driver.h>
 #include <tactility/drivers/display.h>
+#include <tactility/drivers/display_pixels.h>
+#include <tactility/freertos/port.h>
+#include <tactility/freertos/semphr.h>
 #include <tactility/log.h>
+#include <tactility/time.h>
 
 #include <lvgl/devices/device_context.h>
 
+#include <atomic>
 #include <stdlib.h>
 
 #ifdef ESP_PLATFORM
@@ -18,6 +24,14 @@
 
 constexpr auto* TAG = "lvgl_display";
 
+// Matches LVGL's default LV_INV_BUF_SIZE: LVGL itself redraws the whole screen when a frame has more areas
+constexpr uint32_t LVGL_DISPLAY_PENDING_AREAS_MAX = 32;
+
+// Every transfer has a fixed cost (setting the address window, starting the DMA, waiting for it to
+// finish), so an invalidated area is merged with a nearby one when their bounding box is at most
+// this much larger (in percent) than the 2 areas separately.
+constexpr uint64_t LVGL_DISPLAY_COALESCE_OVERDRAW_PERCENT = 25;
+
 struct LvglDisplayCtx {
     void* buf1;
     void* buf2;
@@ -41,7 +55,7 @@ struct LvglDisplayCtx {
     bool sw_rotate;
     void* rotate_buf;
     // Lazily created on the first sw_rotate flush that needs it (see lvgl_display_rotate_tile()).
-    // Stays NULL - and every rotate falls back to rotate_buf/lv_draw_sw_rotate() - when the target
+    // Stays NULL - and every rotate falls back to rotate_buf/lvgl_display_sw_rotate() - when the target
     // has no PPA (lvgl_ppa_is_supported()), the color format has no PPA color mode
     // (lvgl_ppa_supports_color_format()), or creating the PPA client/buffer failed once already.
     void* ppa_handle;
@@ -57,6 +71,29 @@ struct LvglDisplayCtx {
     // Mirrors LvglDisplayConfig::swap_bytes: the panel is big endian while the OS is little endian,
     // so we fix it in software. In the future, the driver should probably expose endianness requirements instead.
     bool byte_swap;
+    // For lv_display_flush_ready() in lvgl_display_draw_done_cb(), which only gets this context
+    lv_display_t* display;
+    // Mirrors LvglDisplayConfig::flush_pipeline
+    bool flush_pipeline;
+    // Given by lvgl_display_draw_done_cb(), so lvgl_display_flush_wait_cb() can block instead of LVGL
+    // spinning on the flushing flag. Only created with the flush pipeline.
+    SemaphoreHandle_t transfer_done_semaphore;
+    // Invalidated areas of the next frame, for coalescing (see lvgl_display_invalidate_event_cb()).
+    // Cleared once a frame is rendered.
+    lv_area_t pending_areas[LVGL_DISPLAY_PENDING_AREAS_MAX];
+    uint32_t pending_area_count;
+    // Statistics of the frame that is being flushed. Only used on the LVGL task.
+    bool frame_started;
+    bool frame_submitted; // The last transfer of the frame was started
+    uint32_t frame_start_us;
+    uint32_t frame_bytes;
+    uint32_t frame_transfers;
+    struct LvglDisplayFlushStats stats;
+    // Written by lvgl_display_draw_done_cb(), which can run in an ISR
+    std::atomic<bool> transfer_busy;
+    std::atomic<uint32_t> transfer_done_us;
+    // Set while lvgl_display_draw_done_cb() runs: it still gives the semaphore after clearing transfer_busy
+    std::atomic<bool> draw_done_cb_running;
 };
 
 static void* lvgl_display_alloc_buffer(size_t size_bytes, bool prefer_external_ram) {
@@ -196,9 +233,8 @@ static void* lvgl_display_fb_base(struct LvglDisplayCtx* ctx, const uint8_t* col
 // first eligible call, sized to ctx->buf_size_bytes (the largest tile or full-frame buffer this
 // display will ever flush - see lvgl_display_add()); once creation fails once, ppa_unavailable
 // latches so later tiles don't retry it. Never asks PPA to byte-swap: lvgl_display_flush_cb()
-// applies ctx->byte_swap itself, once, at a single point regardless of which rotation path ran -
-// simpler than tracking whether it was already done by PPA (PARTIAL mode) vs. already done
-// per-tile before FULL mode's whole-frame rotate (see the two call sites).
+// applies ctx->byte_swap itself after the PPA path (PARTIAL mode), or already did so per-tile
+// before FULL mode's whole-frame rotate (see the two call sites).
 static void* lvgl_display_try_ppa_rotate(struct LvglDisplayCtx* ctx, const uint8_t* in_buff, int32_t w, int32_t h,
                                           lv_display_rotation_t rotation, lv_color_format_t color_format) {
     if (!ctx->ppa_eligible || ctx->ppa_unavailable) {
@@ -220,11 +256,170 @@ static void* lvgl_display_try_ppa_rotate(struct LvglDisplayCtx* ctx, const uint8
     return lvgl_ppa_rotate(ctx->ppa_handle, in_buff, w, h, rotation, color_format, false);
 }
 
+// Rotates the w x h block at in_buff into ctx->rotate_buf in software. Uses the cache-blocked
+// display_pixels_rotate() kernels, which can also byte-swap RGB565 in the same pass, and only
+// falls back to lv_draw_sw_rotate() for formats they don't cover. Returns whether swap_rgb565 was
+// applied, so the caller knows if it still has to swap.
+static bool lvgl_display_sw_rotate(struct LvglDisplayCtx* ctx, const uint8_t* in_buff, int32_t w, int32_t h,
+                                   uint32_t src_stride, uint32_t dest_stride, lv_display_rotation_t rotation,
+                                   lv_color_format_t color_format, bool swap_rgb565) {
+    uint8_t bytes_per_pixel = 0;
+    switch (color_format) {
+        case LV_COLOR_FORMAT_L8:
+            bytes_per_pixel = 1;
+            break;
+        case LV_COLOR_FORMAT_RGB565:
+            bytes_per_pixel = 2;
+            break;
+        case LV_COLOR_FORMAT_RGB888:
+            bytes_per_pixel = 3;
+            break;
+        case LV_COLOR_FORMAT_XRGB8888:
+        case LV_COLOR_FORMAT_ARGB8888:
+            bytes_per_pixel = 4;
+            break;
+        default:
+            break;
+    }
+    // LV_DISPLAY_ROTATION_* and DisplayPixelRotation have the same values and meaning
+    auto pixel_rotation = (enum DisplayPixelRotation)rotation;
+    bool swap = swap_rgb565 && bytes_per_pixel == 2;
+    if (bytes_per_pixel != 0 &&
+        display_pixels_rotate(in_buff, ctx->rotate_buf, w, h, src_stride, dest_stride, bytes_per_pixel, pixel_rotation, swap) == ERROR_NONE) {
+        return swap;
+    }
+    lv_draw_sw_rotate(in_buff, ctx->rotate_buf, w, h, src_stride, dest_stride, rotation, color_format);
+    return false;
+}
+
+// Wraps around every ~71 minutes, which is fine for measuring durations with unsigned subtraction.
+static uint32_t lvgl_display_get_micros() {
+    return (uint32_t)get_micros_since_boot();
+}
+
+// Merges a newly invalidated area with a pending one of the same frame when that only costs a bit
+// of overdraw. LVGL stores the (modified) area that this event passes along, and its own area
+// joining (lv_refr.c) then drops the pending area that the merged one now contains - so the frame
+// is rendered and flushed as fewer, larger transfers.
+static void lvgl_display_invalidate_event_cb(lv_event_t* e) {
+    struct LvglDeviceContext* wrapper = (struct LvglDeviceContext*)lv_event_get_user_data(e);
+    struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)wrapper->context;
+    lv_area_t* area = (lv_area_t*)lv_event_get_param(e);
+    uint64_t area_size = lv_area_get_size(area);
+
+    for (uint32_t i = 0; i < ctx->pending_area_count; i++) {
+        lv_area_t* pending = &ctx->pending_areas[i];
+        lv_area_t joined = {
+            LV_MIN(pending->x1, area->x1),
+            LV_MIN(pending->y1, area->y1),
+            LV_MAX(pending->x2, area->x2),
+            LV_MAX(pending->y2, area->y2)
+        };
+        uint64_t separate_size = lv_area_get_size(pending) + area_size;
+        if ((uint64_t)lv_area_get_size(&joined) * 100U <= separate_size * (100U + LVGL_DISPLAY_COALESCE_OVERDRAW_PERCENT)) {
+            *pending = joined;
+            *area = joined;
+            ctx->stats.coalesced_areas++;
+            return;
+        }
+    }
+
+    if (ctx->pending_area_count < LVGL_DISPLAY_PENDING_AREAS_MAX) {
+        ctx->pending_areas[ctx->pending_area_count++] = *area;
+    }
+}
+
+static void lvgl_display_refresh_ready_event_cb(lv_event_t* e) {
+    struct LvglDeviceContext* wrapper = (struct LvglDeviceContext*)lv_event_get_user_data(e);
+    struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)wrapper->context;
+    ctx->pending_area_count = 0;
+}
+
+// Completes the statistics of the current frame once its last transfer is done.
+static void lvgl_display_finish_frame(struct LvglDisplayCtx* ctx) {
+    if (!ctx->frame_submitted || ctx->transfer_busy.load(std::memory_order_acquire)) {
+        return;
+    }
+    uint32_t duration_us = ctx->transfer_done_us.load(std::memory_order_relaxed) - ctx->frame_start_us;
+    ctx->stats.frame_count++;
+    ctx->stats.last_frame_flush_us = duration_us;
+    ctx->stats.max_frame_flush_us = LV_MAX(ctx->stats.max_frame_flush_us, duration_us);
+    ctx->stats.last_frame_bytes = ctx->frame_bytes;
+    ctx->stats.last_frame_transfers = ctx->frame_transfers;
+    ctx->frame_started = false;
+    ctx->frame_submitted = false;
+}
+
+// Called by the driver once it's done with the color data of lvgl_display_transfer(). Can run in an ISR.
+static void lvgl_display_draw_done_cb(struct Device* device, void* context) {
+    (void)device;
+    struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)context;
+    ctx->draw_done_cb_running.store(true);
+    ctx->transfer_done_us.store(lvgl_display_get_micros(), std::memory_order_relaxed);
+    ctx->transfer_busy.store(false, std::memory_order_release);
+    lv_display_flush_ready(ctx->display);
+    // Drivers call this from an ISR for DMA transfers, but some finish in the calling task
+    if (xPortInIsrContext()) {
+        BaseType_t high_task_woken = pdFALSE;
+        xSemaphoreGiveFromISR(ctx->transfer_done_semaphore, &high_task_woken);
+        portYIELD_FROM_ISR(high_task_woken);
+    } else {
+        xSemaphoreGive(ctx->transfer_done_semaphore);
+    }
+    ctx->draw_done_cb_running.store(false);
+}
+
+// LVGL calls this instead of spinning while a transfer of lvgl_display_transfer() is still busy.
+// The semaphore can still be given by a transfer that LVGL didn't wait for, so transfer_busy decides.
+static void lvgl_display_flush_wait_cb(lv_display_t* disp) {
+    struct LvglDeviceContext* wrapper = (struct LvglDeviceContext*)lv_display_get_driver_data(disp);
+    struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)wrapper->context;
+    while (ctx->transfer_busy.load(std::memory_order_acquire)) {
+        xSemaphoreTake(ctx->transfer_done_semaphore, portMAX_DELAY);
+    }
+}
+
+// Sends pixels to the display and calls lv_display_flush_ready() once the driver is done with them.
+// With the flush pipeline, drivers with DISPLAY_CAPABILITY_ASYNC_DRAW return before the transfer is
+// done: LVGL then renders the next tile into its other buffer while this one is still being sent,
+// and only waits for lv_display_flush_ready() before it flushes again.
+// LVGL's area is inclusive; DisplayApi's draw_bitmap wants an exclusive end.
+static void lvgl_display_transfer(struct LvglDeviceContext* wrapper, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                                  const uint8_t* color_map, uint32_t size_bytes, bool is_last) {
+    struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)wrapper->context;
+    ctx->frame_bytes += size_bytes;
+    ctx->frame_transfers++;
+    ctx->stats.total_bytes += size_bytes;
+    ctx->frame_submitted = is_last;
+
+    if (ctx->flush_pipeline) {
+        ctx->transfer_busy.store(true, std::memory_order_relaxed);
+        if (display_draw_bitmap_async(wrapper->device, x1, y1, x2 + 1, y2 + 1, color_map, lvgl_display_draw_done_cb, ctx) == ERROR_NONE) {
+            return;
+        }
+        ctx->transfer_busy.store(false, std::memory_order_relaxed);
+    } else {
+        display_draw_bitmap(wrapper->device, x1, y1, x2 + 1, y2 + 1, color_map);
+    }
+    ctx->transfer_done_us.store(lvgl_display_get_micros(), std::memory_order_relaxed);
+    lv_display_flush_ready(ctx->display);
+}
+
 static void lvgl_display_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* color_map) {
     struct LvglDeviceContext* wrapper = (struct LvglDeviceContext*)lv_display_get_driver_data(disp);
     struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)wrapper->context;
     bool is_i1 = lv_display_get_color_format(disp) == LV_COLOR_FORMAT_I1;
 
+    // LVGL waits for lv_display_flush_ready() before flushing again, so the previous frame's last
+    // transfer is always done by now.
+    lvgl_display_finish_frame(ctx);
+    if (!ctx->frame_started) {
+        ctx->frame_started = true;
+        ctx->frame_start_us = lvgl_display_get_micros();
+        ctx->frame_bytes = 0;
+        ctx->frame_transfers = 0;
+    }
+
     int32_t x1 = area->x1;
     int32_t y1 = area->y1;
     int32_t x2 = area->x2;
@@ -233,6 +428,7 @@ static void lvgl_display_flush_cb(lv_display_t* disp, const lv_area_t* area, uin
 
     lv_display_rotation_t rotation = lv_display_get_rotation(disp);
     bool rotating = ctx->sw_rotate && rotation != LV_DISPLAY_ROTATION_0;
+    bool byte_swapped = false;
 
     // In FULL mode, a refresh cycle can call this once per still-unjoined invalidated area (see
     // the comment below) before the frame is complete - rotating per-tile here would only ever
@@ -252,11 +448,8 @@ static void lvgl_display_flush_cb(lv_display_t* disp, const lv_area_t* area, uin
         } else {
             uint32_t w_stride = lv_draw_buf_width_to_stride(w, color_format);
             uint32_t h_stride = lv_draw_buf_width_to_stride(h, color_format);
-            if (rotation == LV_DISPLAY_ROTATION_180) {
-                lv_draw_sw_rotate(color_map, ctx->rotate_buf, w, h, w_stride, w_stride, rotation, color_format);
-            } else {
-                lv_draw_sw_rotate(color_map, ctx->rotate_buf, w, h, w_stride, h_stride, rotation, color_format);
-            }
+            uint32_t dest_stride = rotation == LV_DISPLAY_ROTATION_180 ? w_stride : h_stride;
+            byte_swapped = lvgl_display_sw_rotate(ctx, color_map, w, h, w_stride, dest_stride, rotation, color_format, ctx->byte_swap);
             color_map = (uint8_t*)ctx->rotate_buf;
         }
         lv_area_t rotated_area = { x1, y1, x2, y2 };
@@ -267,8 +460,8 @@ static void lvgl_display_flush_cb(lv_display_t* disp, const lv_area_t* area, uin
         y2 = rotated_area.y2;
     }
 
-    if (ctx->byte_swap) {
-        lv_draw_sw_rgb565_swap(color_map, area_size_px);
+    if (ctx->byte_swap && !byte_swapped) {
+        display_pixels_swap_rgb565(color_map, area_size_px);
     }
 
     if (ctx->render_mode == LV_DISPLAY_RENDER_MODE_FULL) {
@@ -314,20 +507,25 @@ static void lvgl_display_flush_cb(lv_display_t* disp, const lv_area_t* area, uin
                 } else {
                     uint32_t src_stride = lv_draw_buf_width_to_stride(logical_w, color_format);
                     uint32_t dest_stride = lv_draw_buf_width_to_stride(hres, color_format);
-                    lv_draw_sw_rotate(fb_base, ctx->rotate_buf, logical_w, logical_h, src_stride, dest_stride, rotation, color_format);
+                    // Already byte-swapped per tile above
+                    lvgl_display_sw_rotate(ctx, fb_base, logical_w, logical_h, src_stride, dest_stride, rotation, color_format, false);
                     fb_base = (uint8_t*)ctx->rotate_buf;
                 }
             }
 
-            display_draw_bitmap(wrapper->device, 0, 0, hres, vres, fb_base);
+            uint32_t frame_size_bytes = is_i1
+                ? (uint32_t)((hres + 7) / 8) * vres
+                : (uint32_t)hres * vres * lv_color_format_get_size(lv_display_get_color_format(disp));
+            lvgl_display_transfer(wrapper, 0, 0, hres - 1, vres - 1, fb_base, frame_size_bytes, true);
+            return;
         }
     } else if (ctx->owns_buffers) {
         // PARTIAL mode: each flush_cb call is one independent, complete tile into a buffer that
         // gets reused for the next tile, so present it immediately rather than waiting.
-        // LVGL's area is inclusive; DisplayApi's draw_bitmap wants an exclusive end.
-        display_draw_bitmap(wrapper->device, x1, y1, x2 + 1, y2 + 1, color_map);
+        uint32_t tile_size_bytes = area_size_px * lv_color_format_get_size(lv_display_get_color_format(disp));
+        lvgl_display_transfer(wrapper, x1, y1, x2, y2, color_map, tile_size_bytes, lv_display_flush_is_last(disp));
+        return;
     }
-    // DisplayApi has no async completion callback, so draw_bitmap is synchronous.
     lv_display_flush_ready(disp);
 }
 
@@ -363,12 +561,13 @@ error_t lvgl_display_add(struct Device* device, const struct LvglDisplayConfig*
     wrapper->device = device;
 
     ctx->byte_swap = config->swap_bytes;
+    ctx->flush_pipeline = config->flush_pipeline;
     ctx->sw_rotate = config->sw_rotate;
     // Only relevant when sw_rotate is set - lvgl_display_try_ppa_rotate() also checks
     // ctx->ppa_eligible directly, so this is safe to compute unconditionally.
     ctx->ppa_eligible = lvgl_ppa_is_supported() && lvgl_ppa_supports_color_format(lv_color_format);
     if (config->sw_rotate && !ctx->ppa_eligible) {
-        LOG_I(TAG, "PPA not available for this display (supported=%d, color_format=%d) - using lv_draw_sw_rotate()",
+        LOG_I(TAG, "PPA not available for this display (supported=%d, color_format=%d) - using software rotation",
               (int)lvgl_ppa_is_supported(), (int)lv_color_format);
     }
     ctx->has_swap_xy_cap = display_has_capability(device, DISPLAY_CAPABILITY_CAP_SWAP_XY);
@@ -459,6 +658,19 @@ error_t lvgl_display_add(struct Device* device, const struct LvglDisplayConfig*
         }
     }
 
+    if (ctx->flush_pipeline) {
+        ctx->transfer_done_semaphore = xSemaphoreCreateBinary();
+        if (ctx->transfer_done_semaphore == NULL) {
+            if (ctx->owns_buffers) {
+                lvgl_display_free_buffer(ctx->buf1);
+                lvgl_display_free_buffer(ctx->buf2);
+            }
+            lvgl_display_free_buffer(ctx->rotate_buf);
+            delete wrapper;
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+
     lv_display_t* disp = lv_display_create(hres, vres);
     if (disp == NULL) {
         if (ctx->owns_buffers) {
@@ -466,16 +678,28 @@ error_t lvgl_display_add(struct Device* device, const struct LvglDisplayConfig*
             lvgl_display_free_buffer(ctx->buf2);
         }
         lvgl_display_free_buffer(ctx->rotate_buf);
+        if (ctx->transfer_done_semaphore != NULL) {
+            vSemaphoreDelete(ctx->transfer_done_semaphore);
+        }
         delete wrapper;
         return ERROR_OUT_OF_MEMORY;
     }
 
     ctx->render_mode = render_mode;
+    ctx->display = disp;
     lv_display_set_color_format(disp, lv_color_format);
     lv_display_set_buffers(disp, ctx->buf1, ctx->buf2, buf_size_bytes, render_mode);
     lv_display_set_flush_cb(disp, lvgl_display_flush_cb);
+    if (ctx->flush_pipeline) {
+        lv_display_set_flush_wait_cb(disp, lvgl_display_flush_wait_cb);
+    }
     lv_display_set_driver_data(disp, wrapper);
     lv_display_add_event_cb(disp, lvgl_display_rotation_event_cb, LV_EVENT_RESOLUTION_CHANGED, wrapper);
+    // FULL mode always flushes the whole display, so coalescing areas wouldn't save any transfers there
+    if (ctx->flush_pipeline && render_mode == LV_DISPLAY_RENDER_MODE_PARTIAL) {
+        lv_display_add_event_cb(disp, lvgl_display_invalidate_event_cb, LV_EVENT_INVALIDATE_AREA, wrapper);
+        lv_display_add_event_cb(disp, lvgl_display_refresh_ready_event_cb, LV_EVENT_REFR_READY, wrapper);
+    }
 
     // Apply once explicitly, independent of whether LV_EVENT_RESOLUTION_CHANGED fires on creation.
     lvgl_display_apply_rotation(wrapper, lv_display_get_rotation(disp));
@@ -484,6 +708,17 @@ error_t lvgl_display_add(struct Device* device, const struct LvglDisplayConfig*
     return ERROR_NONE;
 }
 
+error_t lvgl_display_get_flush_stats(lv_display_t* display, struct LvglDisplayFlushStats* out_stats) {
+    if (display == NULL || out_stats == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    struct LvglDeviceContext* wrapper = (struct LvglDeviceContext*)lv_display_get_driver_data(display);
+    struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)wrapper->context;
+    lvgl_display_finish_frame(ctx);
+    *out_stats = ctx->stats;
+    return ERROR_NONE;
+}
+
 void lvgl_display_remove(lv_display_t* display) {
     if (display == NULL) {
         return;
@@ -494,6 +729,10 @@ void lvgl_display_remove(lv_display_t* display) {
 
     if (wrapper != NULL) {
         struct LvglDisplayCtx* ctx = (struct LvglDisplayCtx*)wrapper->context;
+        // The driver may still be reading from one of the buffers below, or giving the semaphore
+        while (ctx->transfer_busy.load() || ctx->draw_done_cb_running.load()) {
+            delay_ticks(1);
+        }
         if (ctx->owns_buffers) {
             if (ctx->buf1 != NULL) {
                 lvgl_display_free_buffer(ctx->buf1);
@@ -508,6 +747,9 @@ void lvgl_display_remove(lv_display_t* display) {
         if (ctx->ppa_handle != NULL) {
             lvgl_ppa_delete(ctx->ppa_handle);
         }
+        if (ctx->transfer_done_semaphore != NULL) {
+            vSemaphoreDelete(ctx->transfer_done_semaphore);
+        }
         delete wrapper;
     }
 }
@@ -36,6 +36,7 @@ const struct ModuleSymbol lvgl_module_symbols[] = {
     DEFINE_MODULE_SYMBOL(lvgl_get_statusbar_icon_font_height),
     // lvgl_display
     DEFINE_MODULE_SYMBOL(lvgl_display_add),
+    DEFINE_MODULE_SYMBOL(lvgl_display_get_flush_stats),
     DEFINE_MODULE_SYMBOL(lvgl_display_remove),
     // lvgl_keyboard
     DEFINE_MODULE_SYMBOL(lvgl_keyboard_add),
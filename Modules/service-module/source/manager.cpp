@@ -4,6 +4,7 @@
 
 #include <tactility/concurrent/mutex.h>
 #include <tactility/log.h>
+#include <tactility/memory.h>
 #include <tactility/system_event.h>
 
 #include <new>
@@ -106,7 +107,10 @@ error_t service_manager_start(const char* id) {
         return ERROR_OUT_OF_MEMORY;
     }
 
+    // memory_* allocations without a tag of their own are accounted to the service (see memory_tracking_set_thread_tag())
+    const char* previous_tag = memory_tracking_set_thread_tag(manifest->id);
     error_t error = service_instance_construct(instance, manifest);
+    memory_tracking_set_thread_tag(previous_tag);
     if (error != ERROR_NONE) {
         mutex_unlock(&instance_ledger.mutex);
         delete instance;
@@ -120,7 +124,9 @@ error_t service_manager_start(const char* id) {
     service_instance_set_state(instance, SERVICE_STATE_STARTING);
 
     LOG_I(TAG, "start %s", id);
+    previous_tag = memory_tracking_set_thread_tag(manifest->id);
     error = (manifest->on_start != nullptr) ? manifest->on_start(instance, instance->data) : ERROR_NONE;
+    memory_tracking_set_thread_tag(previous_tag);
 
     if (error == ERROR_NONE) {
         service_instance_set_state(instance, SERVICE_STATE_STARTED);
@@ -157,7 +163,9 @@ error_t service_manager_stop(const char* id) {
     service_instance_set_state(instance, SERVICE_STATE_STOPPING);
 
     if (instance->manifest->on_stop != nullptr) {
+        const char* previous_tag = memory_tracking_set_thread_tag(instance->manifest->id);
         instance->manifest->on_stop(instance, instance->data);
+        memory_tracking_set_thread_tag(previous_tag);
     }
 
     service_instance_set_state(instance, SERVICE_STATE_STOPPED);
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Mock I2C controller for the simulator and tests ("posix,mock-i2c"). Slave devices are simulated
+// as 256 8-bit registers with auto-incrementing register addresses, like most PMICs and IO expanders.
+// Every transfer is counted, so tests can measure how many bus transactions an operation needs.
+
+#pragma once
+
+#include <tactility/error.h>
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct Device;
+
+/**
+ * @brief Adds a simulated slave device with all registers set to 0.
+ * @param[in] device the mock I2C controller device
+ * @param[in] address the 7-bit I2C address of the slave device
+ * @retval ERROR_NONE when the slave device was added
+ * @retval ERROR_INVALID_STATE when there's already a slave device at the address
+ */
+error_t posix_i2c_add_target(struct Device* device, uint8_t address);
+
+/**
+ * @brief Sets a register of a simulated slave device directly, e.g. to simulate an input that changes. This is not counted as a transfer.
+ * @param[in] device the mock I2C controller device
+ * @param[in] address the 7-bit I2C address of the slave device
+ * @param[in] reg the register address
+ * @param[in] value the new value
+ * @retval ERROR_NONE when the register was set
+ * @retval ERROR_NOT_FOUND when there's no slave device at the address
+ */
+error_t posix_i2c_set_register(struct Device* device, uint8_t address, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Gets a register of a simulated slave device directly. This is not counted as a transfer.
+ * @param[in] device the mock I2C controller device
+ * @param[in] address the 7-bit I2C address of the slave device
+ * @param[in] reg the register address
+ * @param[out] value the register value
+ * @retval ERROR_NONE when the register was read
+ * @retval ERROR_NOT_FOUND when there's no slave device at the address
+ */
+error_t posix_i2c_get_register(struct Device* device, uint8_t address, uint8_t reg, uint8_t* value);
+
+/**
+ * @brief Gets the number of transfers since the controller was started, including failed ones.
+ * @param[in] device the mock I2C controller device
+ * @return the number of transfers
+ */
+uint32_t posix_i2c_get_transfer_count(struct Device* device);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Mock I2C controller for the simulator and tests: see posix_i2c.h
+
+#include <tactility/drivers/posix_i2c.h>
+
+#include <tactility/concurrent/mutex.h>
+#include <tactility/device.h>
+#include <tactility/driver.h>
+#include <tactility/drivers/i2c_controller.h>
+#include <tactility/log.h>
+
+#include <map>
+#include <new>
+
+#define TAG "mock_i2c"
+
+namespace {
+
+struct MockI2cTarget {
+    uint8_t registers[256] = {};
+    // The register address for the next byte, which increments after each byte
+    uint8_t registerPointer = 0;
+};
+
+struct PosixI2cCtx {
+    Mutex mutex {};
+    std::map<uint8_t, MockI2cTarget> targets;
+    uint32_t transferCount = 0;
+};
+
+#define GET_CTX(device) (static_cast<PosixI2cCtx*>(device_get_driver_data(device)))
+
+// Counts the transfer and finds the target. Must be called with the mutex locked.
+MockI2cTarget* beginTransfer(PosixI2cCtx* ctx, uint8_t address) {
+    ctx->transferCount++;
+    auto iterator = ctx->targets.find(address);
+    return (iterator != ctx->targets.end()) ? &iterator->second : nullptr;
+}
+
+void readBytes(MockI2cTarget* target, uint8_t* data, size_t dataSize) {
+    for (size_t i = 0; i < dataSize; i++) {
+        data[i] = target->registers[target->registerPointer++];
+    }
+}
+
+// The first byte sets the register pointer, like for most register based devices
+void writeBytes(MockI2cTarget* target, const uint8_t* data, size_t dataSize) {
+    if (dataSize == 0) return;
+    target->registerPointer = data[0];
+    for (size_t i = 1; i < dataSize; i++) {
+        target->registers[target->registerPointer++] = data[i];
+    }
+}
+
+// ---- I2cControllerApi ----
+
+error_t apiRead(Device* device, uint8_t address, uint8_t* data, size_t dataSize, TickType_t timeout) {
+    (void)timeout;
+    if (dataSize == 0) return ERROR_INVALID_ARGUMENT;
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto* target = beginTransfer(ctx, address);
+    if (target != nullptr) {
+        readBytes(target, data, dataSize);
+    }
+    mutex_unlock(&ctx->mutex);
+    return (target != nullptr) ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+error_t apiWrite(Device* device, uint8_t address, const uint8_t* data, uint16_t dataSize, TickType_t timeout) {
+    (void)timeout;
+    if (dataSize == 0) return ERROR_INVALID_ARGUMENT;
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto* target = beginTransfer(ctx, address);
+    if (target != nullptr) {
+        writeBytes(target, data, dataSize);
+    }
+    mutex_unlock(&ctx->mutex);
+    return (target != nullptr) ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+error_t apiWriteRead(Device* device, uint8_t address, const uint8_t* writeData, size_t writeDataSize, uint8_t* readData, size_t readDataSize, TickType_t timeout) {
+    (void)timeout;
+    if (writeDataSize == 0 || readDataSize == 0) return ERROR_INVALID_ARGUMENT;
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto* target = beginTransfer(ctx, address);
+    if (target != nullptr) {
+        writeBytes(target, writeData, writeDataSize);
+        readBytes(target, readData, readDataSize);
+    }
+    mutex_unlock(&ctx->mutex);
+    return (target != nullptr) ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+error_t apiReadRegister(Device* device, uint8_t address, uint8_t reg, uint8_t* data, size_t dataSize, TickType_t timeout) {
+    (void)timeout;
+    if (dataSize == 0) return ERROR_INVALID_ARGUMENT;
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto* target = beginTransfer(ctx, address);
+    if (target != nullptr) {
+        target->registerPointer = reg;
+        readBytes(target, data, dataSize);
+    }
+    mutex_unlock(&ctx->mutex);
+    return (target != nullptr) ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+error_t apiWriteRegister(Device* device, uint8_t address, uint8_t reg, const uint8_t* data, uint16_t dataSize, TickType_t timeout) {
+    (void)timeout;
+    if (dataSize == 0) return ERROR_INVALID_ARGUMENT;
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto* target = beginTransfer(ctx, address);
+    if (target != nullptr) {
+        target->registerPointer = reg;
+        for (uint16_t i = 0; i < dataSize; i++) {
+            target->registers[target->registerPointer++] = data[i];
+        }
+    }
+    mutex_unlock(&ctx->mutex);
+    return (target != nullptr) ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+error_t apiProbe(Device* device, uint8_t address, TickType_t timeout) {
+    (void)timeout;
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto* target = beginTransfer(ctx, address);
+    mutex_unlock(&ctx->mutex);
+    return (target != nullptr) ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+const I2cControllerApi posix_i2c_api = {
+    .read = apiRead,
+    .write = apiWrite,
+    .write_read = apiWriteRead,
+    .read_register = apiReadRegister,
+    .write_register = apiWriteRegister,
+    .probe = apiProbe
+};
+
+// ---- Driver lifecycle ----
+
+error_t startDevice(Device* device) {
+    auto* ctx = new(std::nothrow) PosixI2cCtx();
+    if (ctx == nullptr) return ERROR_OUT_OF_MEMORY;
+    mutex_construct(&ctx->mutex);
+    device_set_driver_data(device, ctx);
+    LOG_I(TAG, "%s started", device->name);
+    return ERROR_NONE;
+}
+
+error_t stopDevice(Device* device) {
+    auto* ctx = GET_CTX(device);
+    if (ctx == nullptr) return ERROR_NONE;
+    device_set_driver_data(device, nullptr);
+    mutex_destruct(&ctx->mutex);
+    delete ctx;
+    return ERROR_NONE;
+}
+
+} // namespace
+
+extern "C" {
+
+error_t posix_i2c_add_target(Device* device, uint8_t address) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    bool added = ctx->targets.try_emplace(address).second;
+    mutex_unlock(&ctx->mutex);
+    return added ? ERROR_NONE : ERROR_INVALID_STATE;
+}
+
+error_t posix_i2c_set_register(Device* device, uint8_t address, uint8_t reg, uint8_t value) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto iterator = ctx->targets.find(address);
+    bool found = iterator != ctx->targets.end();
+    if (found) {
+        iterator->second.registers[reg] = value;
+    }
+    mutex_unlock(&ctx->mutex);
+    return found ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+error_t posix_i2c_get_register(Device* device, uint8_t address, uint8_t reg, uint8_t* value) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    auto iterator = ctx->targets.find(address);
+    bool found = iterator != ctx->targets.end();
+    if (found) {
+        *value = iterator->second.registers[reg];
+    }
+    mutex_unlock(&ctx->mutex);
+    return found ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+uint32_t posix_i2c_get_transfer_count(Device* device) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    uint32_t count = ctx->transferCount;
+    mutex_unlock(&ctx->mutex);
+    return count;
+}
+
+extern Module platform_posix_module;
+
+Driver posix_i2c_driver = {
+    .name = "mock_i2c",
+    .compatible = (const char*[]) { "posix,mock-i2c", nullptr },
+    .start_device = startDevice,
+    .stop_device = stopDevice,
+    .api = (const void*)&posix_i2c_api,
+    .device_type = &I2C_CONTROLLER_TYPE,
+    .owner = &platform_posix_module,
+    .internal = nullptr
+};
+
+} // extern "C"
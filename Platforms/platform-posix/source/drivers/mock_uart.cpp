@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Mock UART controller for the simulator and tests: a loopback where everything that is written
+// can be read back, as if TX were wired to RX. There's no baud rate limit: bytes are available
+// for reading as soon as the write returns.
+
+#include <tactility/concurrent/mutex.h>
+#include <tactility/device.h>
+#include <tactility/driver.h>
+#include <tactility/drivers/uart_controller.h>
+#include <tactility/freertos/semphr.h>
+#include <tactility/log.h>
+#include <tactility/time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#define TAG "mock_uart"
+
+namespace {
+
+// Large enough for a burst of GPS sentences, so a single task can write before reading
+constexpr size_t MOCK_UART_BUFFER_SIZE = 16384;
+
+struct PosixUartCtx {
+    Mutex mutex {};
+    // Given when bytes are written, so a blocked reader checks the buffer again
+    SemaphoreHandle_t dataWritten = nullptr;
+    // Given when bytes are read, so a blocked writer checks for free space again
+    SemaphoreHandle_t dataRead = nullptr;
+    UartConfig config {};
+    bool configSet = false;
+    bool isOpen = false;
+
+    uint8_t buffer[MOCK_UART_BUFFER_SIZE] = {};
+    // Ring buffer: the bytes to read start at readIndex
+    size_t readIndex = 0;
+    size_t count = 0;
+};
+
+#define GET_CTX(device) (static_cast<PosixUartCtx*>(device_get_driver_data(device)))
+
+TickType_t getTimeoutLeft(TickType_t startTime, TickType_t timeout) {
+    TickType_t passed = get_ticks() - startTime;
+    return (passed < timeout) ? timeout - passed : 0;
+}
+
+// Must be called with the mutex locked
+size_t takeBytes(PosixUartCtx* ctx, uint8_t* out, size_t size) {
+    size_t length = std::min(size, ctx->count);
+    size_t firstPart = std::min(length, MOCK_UART_BUFFER_SIZE - ctx->readIndex);
+    memcpy(out, ctx->buffer + ctx->readIndex, firstPart);
+    memcpy(out + firstPart, ctx->buffer, length - firstPart);
+    ctx->readIndex = (ctx->readIndex + length) % MOCK_UART_BUFFER_SIZE;
+    ctx->count -= length;
+    return length;
+}
+
+// Must be called with the mutex locked
+size_t putBytes(PosixUartCtx* ctx, const uint8_t* data, size_t size) {
+    size_t length = std::min(size, MOCK_UART_BUFFER_SIZE - ctx->count);
+    size_t writeIndex = (ctx->readIndex + ctx->count) % MOCK_UART_BUFFER_SIZE;
+    size_t firstPart = std::min(length, MOCK_UART_BUFFER_SIZE - writeIndex);
+    memcpy(ctx->buffer + writeIndex, data, firstPart);
+    memcpy(ctx->buffer, data + firstPart, length - firstPart);
+    ctx->count += length;
+    return length;
+}
+
+// ---- UartControllerApi ----
+
+error_t apiReadBytes(Device* device, uint8_t* buffer, size_t bufferSize, TickType_t timeout) {
+    auto* ctx = GET_CTX(device);
+    TickType_t startTime = get_ticks();
+    size_t readCount = 0;
+    while (true) {
+        mutex_lock(&ctx->mutex);
+        if (!ctx->isOpen) {
+            mutex_unlock(&ctx->mutex);
+            return ERROR_INVALID_STATE;
+        }
+        size_t length = takeBytes(ctx, buffer + readCount, bufferSize - readCount);
+        mutex_unlock(&ctx->mutex);
+
+        if (length > 0) {
+            xSemaphoreGive(ctx->dataRead);
+        }
+        readCount += length;
+        if (readCount == bufferSize) {
+            return ERROR_NONE;
+        }
+        TickType_t timeoutLeft = getTimeoutLeft(startTime, timeout);
+        if (timeoutLeft == 0 || xSemaphoreTake(ctx->dataWritten, timeoutLeft) != pdTRUE) {
+            return ERROR_TIMEOUT;
+        }
+    }
+}
+
+error_t apiReadByte(Device* device, uint8_t* out, TickType_t timeout) {
+    return apiReadBytes(device, out, 1, timeout);
+}
+
+error_t apiWriteBytes(Device* device, const uint8_t* buffer, size_t bufferSize, TickType_t timeout) {
+    auto* ctx = GET_CTX(device);
+    TickType_t startTime = get_ticks();
+    size_t writeCount = 0;
+    while (true) {
+        mutex_lock(&ctx->mutex);
+        if (!ctx->isOpen) {
+            mutex_unlock(&ctx->mutex);
+            return ERROR_INVALID_STATE;
+        }
+        size_t length = putBytes(ctx, buffer + writeCount, bufferSize - writeCount);
+        mutex_unlock(&ctx->mutex);
+
+        if (length > 0) {
+            xSemaphoreGive(ctx->dataWritten);
+        }
+        writeCount += length;
+        if (writeCount == bufferSize) {
+            return ERROR_NONE;
+        }
+        TickType_t timeoutLeft = getTimeoutLeft(startTime, timeout);
+        if (timeoutLeft == 0 || xSemaphoreTake(ctx->dataRead, timeoutLeft) != pdTRUE) {
+            return ERROR_TIMEOUT;
+        }
+    }
+}
+
+error_t apiWriteByte(Device* device, uint8_t out, TickType_t timeout) {
+    return apiWriteBytes(device, &out, 1, timeout);
+}
+
+error_t apiGetAvailable(Device* device, size_t* available) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    if (!ctx->isOpen) {
+        mutex_unlock(&ctx->mutex);
+        return ERROR_INVALID_STATE;
+    }
+    *available = ctx->count;
+    mutex_unlock(&ctx->mutex);
+    return ERROR_NONE;
+}
+
+error_t apiSetConfig(Device* device, const UartConfig* config) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    if (ctx->isOpen) {
+        mutex_unlock(&ctx->mutex);
+        return ERROR_INVALID_STATE;
+    }
+    ctx->config = *config;
+    ctx->configSet = true;
+    mutex_unlock(&ctx->mutex);
+    return ERROR_NONE;
+}
+
+error_t apiGetConfig(Device* device, UartConfig* config) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    if (!ctx->configSet) {
+        mutex_unlock(&ctx->mutex);
+        return ERROR_RESOURCE;
+    }
+    *config = ctx->config;
+    mutex_unlock(&ctx->mutex);
+    return ERROR_NONE;
+}
+
+error_t apiOpen(Device* device) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    if (ctx->isOpen || !ctx->configSet) {
+        mutex_unlock(&ctx->mutex);
+        return ERROR_INVALID_STATE;
+    }
+    ctx->isOpen = true;
+    ctx->readIndex = 0;
+    ctx->count = 0;
+    mutex_unlock(&ctx->mutex);
+    return ERROR_NONE;
+}
+
+error_t apiClose(Device* device) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    if (!ctx->isOpen) {
+        mutex_unlock(&ctx->mutex);
+        return ERROR_INVALID_STATE;
+    }
+    ctx->isOpen = false;
+    mutex_unlock(&ctx->mutex);
+    return ERROR_NONE;
+}
+
+bool apiIsOpen(Device* device) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    bool isOpen = ctx->isOpen;
+    mutex_unlock(&ctx->mutex);
+    return isOpen;
+}
+
+error_t apiFlushInput(Device* device) {
+    auto* ctx = GET_CTX(device);
+    mutex_lock(&ctx->mutex);
+    if (!ctx->isOpen) {
+        mutex_unlock(&ctx->mutex);
+        return ERROR_INVALID_STATE;
+    }
+    ctx->readIndex = 0;
+    ctx->count = 0;
+    mutex_unlock(&ctx->mutex);
+    xSemaphoreGive(ctx->dataRead);
+    return ERROR_NONE;
+}
+
+const UartControllerApi posix_uart_api = {
+    .read_byte = apiReadByte,
+    .write_byte = apiWriteByte,
+    .write_bytes = apiWriteBytes,
+    .read_bytes = apiReadBytes,
+    .get_available = apiGetAvailable,
+    .set_config = apiSetConfig,
+    .get_config = apiGetConfig,
+    .open = apiOpen,
+    .close = apiClose,
+    .is_open = apiIsOpen,
+    .flush_input = apiFlushInput
+};
+
+// ---- Driver lifecycle ----
+
+error_t startDevice(Device* device) {
+    auto* ctx = new(std::nothrow) PosixUartCtx();
+    if (ctx == nullptr) return ERROR_OUT_OF_MEMORY;
+
+    ctx->dataWritten = xSemaphoreCreateBinary();
+    ctx->dataRead = xSemaphoreCreateBinary();
+    if (ctx->dataWritten == nullptr || ctx->dataRead == nullptr) {
+        if (ctx->dataWritten != nullptr) vSemaphoreDelete(ctx->dataWritten);
+        if (ctx->dataRead != nullptr) vSemaphoreDelete(ctx->dataRead);
+        delete ctx;
+        return ERROR_OUT_OF_MEMORY;
+    }
+    mutex_construct(&ctx->mutex);
+
+    device_set_driver_data(device, ctx);
+
+    LOG_I(TAG, "%s started (loopback)", device->name);
+    return ERROR_NONE;
+}
+
+error_t stopDevice(Device* device) {
+    auto* ctx = GET_CTX(device);
+    if (ctx == nullptr) return ERROR_NONE;
+
+    mutex_lock(&ctx->mutex);
+    bool isOpen = ctx->isOpen;
+    mutex_unlock(&ctx->mutex);
+    if (isOpen) return ERROR_INVALID_STATE;
+
+    device_set_driver_data(device, nullptr);
+    mutex_destruct(&ctx->mutex);
+    vSemaphoreDelete(ctx->dataRead);
+    vSemaphoreDelete(ctx->dataWritten);
+    delete ctx;
+    return ERROR_NONE;
+}
+
+} // namespace
+
+extern "C" {
+
+extern Module platform_posix_module;
+
+Driver posix_uart_driver = {
+    .name = "mock_uart",
+    .compatible = (const char*[]) { "posix,mock-uart", nullptr },
+    .start_device = startDevice,
+    .stop_device = stopDevice,
+    .api = (const void*)&posix_uart_api,
+    .device_type = &UART_CONTROLLER_TYPE,
+    .owner = &platform_posix_module,
+    .internal = nullptr
+};
+
+} // extern "C"
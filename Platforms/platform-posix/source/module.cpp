@@ -3,9 +3,13 @@
 
 extern "C" {
 
+extern Driver posix_i2c_driver;
+extern Driver posix_uart_driver;
 extern Driver posix_wifi_driver;
 
 static Driver* const platform_posix_drivers[] = {
+    &posix_i2c_driver,
+    &posix_uart_driver,
     &posix_wifi_driver,
     nullptr
 };
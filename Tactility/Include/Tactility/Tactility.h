@@ -32,6 +32,17 @@ public:
      */
     bool dispatch(Function function, TickType_t timeout = portMAX_DELAY) const;
 
+    /**
+     * Queue a function to be consumed on the main task, in a priority lane.
+     * @see dispatcher_dispatch_priority_timed()
+     * @param[in] function the function to execute elsewhere
+     * @param[in] priority the lane to queue the function in
+     * @param[in] deadline the maximum ticks to wait behind other functions, or DISPATCHER_NO_DEADLINE
+     * @param[in] timeout lock acquisition timeout
+     * @return true if dispatching was successful (timeout not reached)
+     */
+    bool dispatch(Function function, DispatcherPriority priority, TickType_t deadline = DISPATCHER_NO_DEADLINE, TickType_t timeout = portMAX_DELAY) const;
+
 private:
 
     DispatcherHandle_t handle;
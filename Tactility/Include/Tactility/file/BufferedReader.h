@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Tactility/file/File.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace tt::file {
+
+/**
+ * Reads a file through a buffer of a configurable size, so small reads don't each become a file system access.
+ * The file lock is only held while opening, refilling and closing, so other users of the storage device aren't
+ * blocked while the caller processes the data. It's safe to use without applying file locks manually.
+ */
+class BufferedReader final {
+
+public:
+
+    struct Config {
+        size_t bufferSize = 4096;
+        /**
+         * When true, a refill reads a full buffer, which suits reading a file from start to end.
+         * When false, a refill only reads what the current call asks for, which suits random access.
+         */
+        bool readAhead = true;
+    };
+
+private:
+
+    const std::string filePath;
+    const Config config;
+
+    std::unique_ptr<FILE, FileCloser> file;
+    std::unique_ptr<uint8_t[]> buffer;
+    size_t bufferStart = 0;
+    size_t bufferEnd = 0;
+    /** The file offset of the first byte in the buffer */
+    long bufferOffset = 0;
+    bool endOfFile = false;
+    bool error = false;
+
+    uint32_t fileReadCount = 0;
+    uint64_t bytesRead = 0;
+
+    size_t readFromFile(void* data, size_t size);
+    bool refill(size_t minimumSize);
+
+public:
+
+    explicit BufferedReader(std::string filePath) : BufferedReader(std::move(filePath), Config()) {}
+
+    BufferedReader(std::string filePath, Config config) :
+        filePath(std::move(filePath)),
+        config(config)
+    {}
+
+    ~BufferedReader() { close(); }
+
+    BufferedReader(const BufferedReader&) = delete;
+    BufferedReader& operator=(const BufferedReader&) = delete;
+
+    bool open();
+    void close();
+
+    bool isOpen() const { return file != nullptr; }
+
+    /** @return the amount of bytes that were read, which is less than size at the end of the file or on error */
+    size_t read(void* data, size_t size);
+
+    /**
+     * Reads up to and including the next newline, or until the end of the file.
+     * @param[out] line the line
+     * @param[in] stripNewLine removes the trailing "\n" from the line
+     * @return false when there are no more lines, or on error
+     */
+    bool readLine(std::string& line, bool stripNewLine);
+
+    /** Moves to an absolute offset. The buffer is kept when the offset is within it. */
+    bool seek(long offset);
+
+    /** @return the current offset in the file */
+    long tell() const { return bufferOffset + static_cast<long>(bufferStart); }
+
+    /** @return the file size, or -1 on error */
+    long getSize();
+
+    bool isEndOfFile() const { return endOfFile && bufferStart == bufferEnd; }
+
+    bool hasError() const { return error; }
+
+    /** @return the amount of read calls to the file system */
+    uint32_t getFileReadCount() const { return fileReadCount; }
+
+    /** @return the amount of bytes that were read from the file system */
+    uint64_t getBytesRead() const { return bytesRead; }
+};
+
+}
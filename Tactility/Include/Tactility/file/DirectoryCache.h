@@ -0,0 +1,114 @@
+#pragma once
+
+#include <Tactility/file/File.h>
+#include <Tactility/RecursiveMutex.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tt::file {
+
+/**
+ * The entries of a directory, which are read by a background thread.
+ * The first entries are available right away, so large directories don't block the caller.
+ * Entries stay sorted like direntSortAlphaAndType() while they arrive: each batch is sorted and then merged.
+ * Only the name and type of an entry are stored, and the number of entries is limited.
+ *
+ * Loading never waits for the loader to stop, because the caller can hold the file lock that the loader needs
+ * (e.g. the LVGL lock for SD cards): an abandoned loader stops at its next batch and closes the directory itself.
+ */
+class DirectoryCache final {
+
+public:
+
+    struct Entry {
+        std::string name;
+        /** TT_DT_* */
+        uint8_t type;
+    };
+
+    enum class Status {
+        Idle,
+        Loading,
+        Loaded
+    };
+
+    /** The number of entries that are read while holding the file system lock */
+    static constexpr size_t BATCH_SIZE = 64;
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 10000;
+
+private:
+
+    /** Shared with the loader, which can still be running after the cache is gone */
+    struct Data {
+        mutable RecursiveMutex mutex;
+        std::vector<Entry> entries;
+        std::string path;
+        Status status = Status::Idle;
+        bool truncated = false;
+        uint32_t revision = 0;
+        uint32_t generation = 0;
+        size_t maxEntries;
+        /** Changes for every load, which makes the loader of the previous load stop */
+        std::atomic<uint32_t> loadId = 0;
+
+        explicit Data(size_t maxEntries) : maxEntries(maxEntries) {}
+    };
+
+    std::shared_ptr<Data> data;
+
+    static void loaderMain(const std::shared_ptr<Data>& data, uint32_t loadId, DIR* dir, const std::string& dirPath, ScandirFilter filter);
+    void stopLoader();
+
+public:
+
+    explicit DirectoryCache(size_t maxEntries = DEFAULT_MAX_ENTRIES) : data(std::make_shared<Data>(maxEntries)) {}
+
+    ~DirectoryCache() { stopLoader(); }
+
+    DirectoryCache(const DirectoryCache&) = delete;
+    DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+    /** The sort order of the entries: directories first, then alphabetically */
+    static bool compareEntries(const Entry& left, const Entry& right);
+
+    /**
+     * Clears the entries and starts reading the directory in the background.
+     * A directory that is still being read is abandoned.
+     * @param[in] path the directory
+     * @param[in] filter an optional filter (nullable), like for scandir()
+     * @return false when the directory can't be opened, in which case the entries are unchanged
+     */
+    bool load(const std::string& path, ScandirFilter filter = direntFilterDotEntries);
+
+    /** Replaces the entries, e.g. with mount points that aren't in a real directory. */
+    void setEntries(const std::string& path, std::vector<Entry> newEntries);
+
+    Status getStatus() const;
+
+    std::string getPath() const;
+
+    size_t getCount() const;
+
+    /** @return true when the directory has more than the maximum number of entries, and the rest was skipped */
+    bool isTruncated() const;
+
+    /** @return a number that changes whenever the entries change */
+    uint32_t getRevision() const;
+
+    /** @return a number that changes when the entries are replaced by load() or setEntries(), but not while they are loaded */
+    uint32_t getGeneration() const;
+
+    bool getEntry(size_t index, Entry& entry) const;
+
+    /** @return false when there is no entry with the specified name */
+    bool findEntry(const std::string& name, Entry& entry) const;
+
+    /** @return false when the directory wasn't read completely within the timeout */
+    bool waitUntilLoaded(TickType_t timeout) const;
+};
+
+}
@@ -72,14 +72,14 @@ public:
 
 long getSize(FILE* file);
 
-/** Read a file and return its data.
+/** Read a file and return its data. Small files are served from getFileCache() when they didn't change.
  * @param[in] filepath the path of the file
  * @param[out] size the amount of bytes that were read
  * @return null on error, or an array of bytes in case of success
  */
 std::unique_ptr<uint8_t[]> readBinary(const std::string& filepath, size_t& outSize);
 
-/** Read a file and return a null-terminated string that represents its content.
+/** Read a file and return a null-terminated string that represents its content. Small files are served from getFileCache() when they didn't change.
  * @param[in] filepath the path of the file
  * @return null on error, or an array of bytes in case of success. Empty string returns as a single 0 character.
  */
@@ -133,6 +133,12 @@ typedef int (*ScandirFilter)(const dirent*);
 
 typedef bool (*ScandirSort)(const dirent&, const dirent&);
 
+/** @return true for the TT_DT_* types that are listed before files and opened like a directory */
+bool isDirectoryType(unsigned char type);
+
+/** The order of direntSortAlphaAndType(): directories first, then alphabetically */
+bool compareNameAndType(const char* leftName, unsigned char leftType, const char* rightName, unsigned char rightType);
+
 /** Used for sorting by alphanumeric value and file type */
 bool direntSortAlphaAndType(const dirent& left, const dirent& right);
 
@@ -177,6 +183,12 @@ int scandir(
     ScandirSort sort = nullptr
 );
 
+/** Read a file line by line. Small files are served from getFileCache(), larger ones are read with a BufferedReader.
+ * @param[in] filePath the path of the file
+ * @param[in] stripNewLine removes the trailing "\n" from each line
+ * @param[in] callback called for each line
+ * @return true when the whole file was read
+ */
 bool readLines(const std::string& filePath, bool stripNewLine, std::function<void(const char* line)> callback);
 
 }
@@ -0,0 +1,122 @@
+#pragma once
+
+#ifdef ESP_PLATFORM
+#include <sdkconfig.h>
+#endif
+
+#include <Tactility/RecursiveMutex.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+namespace tt::file {
+
+/**
+ * A least-recently-used cache for the content of small files that are read often (translations, manifests, ...).
+ * An entry is only used while the modification time and size of its file are unchanged.
+ * Writers that can't change either of those (e.g. a FAT file system without a valid clock) must call invalidate():
+ * tt::file does this for the files that it writes or deletes.
+ */
+class FileCache final {
+
+public:
+
+    typedef std::shared_ptr<const std::vector<uint8_t>> Content;
+
+    struct Stats {
+        uint32_t hits;
+        uint32_t misses;
+        /** The bytes that were read from the file system to fill the cache */
+        uint64_t bytesRead;
+        /** The bytes that were served from the cache */
+        uint64_t bytesServed;
+        /** The bytes that are currently in the cache */
+        size_t bytesCached;
+        size_t entryCount;
+
+        /** @return the percentage of lookups that were served from the cache */
+        uint32_t getHitRate() const {
+            uint32_t lookups = hits + misses;
+            return lookups > 0 ? static_cast<uint32_t>(static_cast<uint64_t>(hits) * 100U / lookups) : 0U;
+        }
+    };
+
+    /** Cached content lives on the default heap, which is internal RAM on boards without PSRAM (see TT_FILE_CACHE_SIZE) */
+#ifdef CONFIG_TT_FILE_CACHE_SIZE
+    static constexpr size_t DEFAULT_BUDGET = CONFIG_TT_FILE_CACHE_SIZE;
+#else
+    static constexpr size_t DEFAULT_BUDGET = 16 * 1024;
+#endif
+
+private:
+
+    struct Entry {
+        std::string path;
+        time_t modificationTime;
+        off_t size;
+        Content content;
+    };
+
+    mutable RecursiveMutex mutex;
+    /** The most recently used entry is first */
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> entriesByPath;
+    size_t budget;
+    size_t bytesCached = 0;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesServed = 0;
+
+    void erase(std::list<Entry>::iterator entry);
+    void evict(size_t maxBytes);
+
+public:
+
+    explicit FileCache(size_t budget = DEFAULT_BUDGET) : budget(budget) {}
+
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+    /**
+     * @param[in] path the file path
+     * @param[in] fileStat the current stat() of the file
+     * @return the cached content, or null when it's not cached or when the file changed
+     */
+    Content find(const std::string& path, const struct stat& fileStat);
+
+    /**
+     * Stores the content of a file, which is evicted again when it's larger than getMaxEntrySize().
+     * @param[in] path the file path
+     * @param[in] fileStat the stat() of the file from before its content was read
+     * @param[in] content the file content
+     */
+    void put(const std::string& path, const struct stat& fileStat, Content content);
+
+    /** Removes the file, or all files in a directory, from the cache. */
+    void invalidate(const std::string& path);
+
+    void clear();
+
+    /** Sets the maximum amount of bytes in the cache, and evicts entries until they fit. */
+    void setBudget(size_t newBudget);
+
+    size_t getBudget() const;
+
+    /** Files that are larger than this aren't cached, so a single file can't evict all others. */
+    size_t getMaxEntrySize() const;
+
+    Stats getStats() const;
+
+    void resetStats();
+};
+
+/** @return the cache that readBinary(), readString() and readLines() use */
+FileCache& getFileCache();
+
+}
@@ -20,11 +20,13 @@ struct ChatSettingsData {
     std::array<uint8_t, ESP_NOW_KEY_LEN> encryptionKey = {};
     bool hasEncryptionKey = false;
     std::string chatChannel = "#general";
+    bool historyEnabled = false; // Keep the messages in a log file, so they are restored on the next launch
 };
 
 ChatSettingsData loadSettings();
 bool saveSettings(const ChatSettingsData& settings);
 bool settingsFileExists();
+std::string getHistoryFilePath();
 
 } // namespace tt::app::chat
 
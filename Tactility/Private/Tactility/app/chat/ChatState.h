@@ -1,21 +1,22 @@
 #pragma once
 
-#ifdef ESP_PLATFORM
-#include <sdkconfig.h>
-#endif
-
-#if defined(CONFIG_SOC_WIFI_SUPPORTED) || defined(CONFIG_SLAVE_SOC_WIFI_SUPPORTED)
+// Unlike the rest of the chat app, this doesn't depend on ESP-NOW, so it's also built (and tested) on other targets
 
 #include <Tactility/RecursiveMutex.h>
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <map>
 #include <string>
 #include <vector>
 
 namespace tt::app::chat {
 
 constexpr size_t MAX_MESSAGES = 100;
+// The history log is rewritten with only the stored messages when it has more lines than this
+constexpr size_t MAX_HISTORY_LINES = MAX_MESSAGES * 4;
 
 struct StoredMessage {
     std::string displayText;
@@ -24,14 +25,33 @@ struct StoredMessage {
 };
 
 /** Thread safety: All public methods are mutex-protected.
- *  LVGL sync lock must be held separately when updating UI. */
+ *  LVGL sync lock must be held separately when updating UI.
+ *  The file lock of the history log is always taken before the mutex. */
 class ChatState {
 
     mutable RecursiveMutex mutex;
 
-    std::deque<StoredMessage> messages;
+    // Ring buffer: the message with sequence number N is stored at N % MAX_MESSAGES
+    std::array<StoredMessage, MAX_MESSAGES> messages;
+    // Sequence numbers start at 1, so 0 is before all messages
+    uint32_t nextSequence = 1;
+    // The sequence numbers of the stored messages per target (oldest first). Broadcasts have an empty target.
+    std::map<std::string, std::deque<uint32_t>> targetIndex;
     std::string currentChannel = "#general";
     std::string localNickname = "Device";
+    // Append-only log of the messages, empty when disabled
+    std::string historyPath;
+    size_t historyLineCount = 0;
+    // Lines that are stored, but not written to the history log yet
+    std::vector<std::string> pendingHistoryLines;
+
+    void storeMessage(const StoredMessage& msg);
+    /**
+     * Writes the pending lines to the history log, or rewrites it when it's too long.
+     * Must be called without holding the mutex: the file lock can be the LVGL lock (SD card),
+     * and LVGL callbacks take the mutex while holding that.
+     */
+    void flushHistory();
 
 public:
     ChatState() = default;
@@ -48,12 +68,20 @@ public:
     void setCurrentChannel(const std::string& channel);
     std::string getCurrentChannel() const;
 
-    void addMessage(const StoredMessage& msg);
+    /** Loads the last messages from the history log at the given path, and appends new messages to it. */
+    void enableHistory(const std::string& path);
+
+    /** @return the sequence number of the message */
+    uint32_t addMessage(const StoredMessage& msg);
 
-    /** Returns messages matching the current channel (or broadcast). */
-    std::vector<StoredMessage> getFilteredMessages() const;
+    /**
+     * Appends the messages after the given sequence number that match the current channel (or broadcast).
+     * Only the new messages are visited, so it's cheap to call after every change.
+     * @param[in] sequence 0 for all stored messages, or the result of the previous call
+     * @param[out] out the messages, oldest first
+     * @return the sequence number to pass to the next call
+     */
+    uint32_t getMessagesSince(uint32_t sequence, std::vector<StoredMessage>& out) const;
 };
 
 } // namespace tt::app::chat
-
-#endif // CONFIG_SOC_WIFI_SUPPORTED || CONFIG_SLAVE_SOC_WIFI_SUPPORTED
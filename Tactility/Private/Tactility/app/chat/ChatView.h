@@ -35,6 +35,9 @@ class ChatView {
     lv_obj_t* channelPanel = nullptr;
     lv_obj_t* channelInput = nullptr;
 
+    // The value for the next ChatState::getMessagesSince() call
+    uint32_t lastSequence = 0;
+
     void createInputBar(lv_obj_t* parent);
     void createSettingsPanel(lv_obj_t* parent);
     void createChannelPanel(lv_obj_t* parent);
@@ -63,7 +66,9 @@ public:
 
     void init(lv_obj_t* parent);
 
-    void displayMessage(const StoredMessage& msg);
+    /** Adds the messages that were stored since the last update. */
+    void showNewMessages();
+    /** Rebuilds the message list, e.g. after switching channels. */
     void refreshMessageList();
 
     void showSettings(const ChatSettingsData& current);
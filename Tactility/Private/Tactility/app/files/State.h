@@ -1,12 +1,11 @@
 #pragma once
 
 #include <Tactility/RecursiveMutex.h>
+#include <Tactility/file/DirectoryCache.h>
 
 #include <optional>
 #include <string>
 #include <utility>
-#include <vector>
-#include <dirent.h>
 #include <sys/stat.h>
 
 namespace tt::app::files {
@@ -27,7 +26,7 @@ public:
 private:
 
     RecursiveMutex mutex;
-    std::vector<dirent> dir_entries;
+    file::DirectoryCache dir_entries;
     std::string current_path;
     std::string selected_child_entry;
     PendingAction action = ActionNone;
@@ -43,25 +42,23 @@ public:
 
     State();
 
-    void freeEntries() {
-        dir_entries.clear();
-    }
-
-    ~State() {
-        freeEntries();
-    }
-
     bool setEntriesForChildPath(const std::string& child_path);
+
+    /** Starts loading the entries of the path in the background. */
     bool setEntriesForPath(const std::string& path);
 
-    template <std::invocable<const std::vector<dirent> &> Func>
-    void withEntries(Func&& onEntries) const {
-        mutex.withLock([&] {
-            std::invoke(std::forward<Func>(onEntries), dir_entries);
-        });
-    }
+    bool getEntry(size_t index, file::DirectoryCache::Entry& entry) const { return dir_entries.getEntry(index, entry); }
+
+    bool findEntry(const std::string& name, file::DirectoryCache::Entry& entry) const { return dir_entries.findEntry(name, entry); }
+
+    /** The number of entries that are loaded so far */
+    size_t getEntryCount() const { return dir_entries.getCount(); }
+
+    /** @return a number that changes whenever the entries change */
+    uint32_t getEntriesRevision() const { return dir_entries.getRevision(); }
 
-    bool getDirent(uint32_t index, dirent& dirent);
+    /** @return a number that changes whenever the entries are replaced, e.g. when the current directory is loaded again */
+    uint32_t getEntriesGeneration() const { return dir_entries.getGeneration(); }
 
     void setSelectedChildEntry(const std::string& newFile) {
         selected_child_entry = newFile;
@@ -2,9 +2,12 @@
 
 #include "./State.h"
 
+#include <Tactility/Timer.h>
+
 #include <cstdint>
 #include <lvgl.h>
 #include <memory>
+#include <vector>
 
 namespace tt::app::files {
 
@@ -12,11 +15,22 @@ class View final {
     std::shared_ptr<State> state;
     uint32_t appInstanceId = 0;
 
-    size_t current_start_index = 0;
-    size_t last_loaded_index = 0;
-    const size_t MAX_BATCH = 50;
-
+    /**
+     * The list only has widgets for the visible rows: they are positioned manually and reused while scrolling.
+     * Entry n is shown by row n % rows.size(), and a spacer at the end gives the list its full scroll height.
+     */
     lv_obj_t* dir_entry_list = nullptr;
+    lv_obj_t* dir_entry_spacer = nullptr;
+    std::vector<lv_obj_t*> rows;
+    /** The entry that each row shows, so rows are only bound again (with a stat() call) when it changes */
+    std::vector<file::DirectoryCache::Entry> row_entries;
+    int32_t row_height = 0;
+    uint32_t rows_revision = 0;
+    uint32_t rows_generation = 0;
+    std::string rows_path;
+    /** Shows the entries while they are loaded in the background */
+    std::unique_ptr<Timer> refreshTimer;
+
     lv_obj_t* action_list = nullptr;
     lv_obj_t* navigate_up_button = nullptr;
     lv_obj_t* new_file_button = nullptr;
@@ -32,7 +46,10 @@ class View final {
     void showActionsForMountPoint();
 
     void viewFile(const std::string&path, const std::string&filename);
-    void createDirEntryWidget(lv_obj_t* parent, dirent& dir_entry);
+    lv_obj_t* createRow();
+    void bindRow(lv_obj_t* row, size_t index, const file::DirectoryCache::Entry& entry);
+    void updateRows();
+    bool resolveEntry(uint32_t index, file::DirectoryCache::Entry& entry);
     void onNavigate();
 
 public:
@@ -40,12 +57,12 @@ public:
     explicit View(const std::shared_ptr<State>& state) : state(state) {}
 
     void init(uint32_t appInstanceId, lv_obj_t* parent);
-    void update(size_t start_index = 0);
+    void update();
 
     void onBackPressed();
     void onNavigateUpPressed();
     void onDirEntryPressed(uint32_t index);
-    void onDirEntryLongPressed(int32_t index);
+    void onDirEntryLongPressed(uint32_t index);
     void onRenamePressed();
     void onDeletePressed();
     void onNewFilePressed();
@@ -55,12 +72,13 @@ public:
     void onPastePressed();
     void onEjectPressed();
     void onDirEntryListScrollBegin();
+    void onDirEntryListChanged();
+    void onRefreshTimer();
     void onResult(uint32_t launchId, int32_t result);
     void deinit();
 
 private:
 
-    bool resolveDirentFromListIndex(int32_t list_index, dirent& out_entry);
     void doPaste(const std::string& src, bool is_cut, const std::string& dst);
 };
 
@@ -24,6 +24,7 @@
 #include <Tactility/TactilityConfig.h>
 #include <Tactility/bluetooth/Bluetooth.h>
 #include <Tactility/file/File.h>
+#include <Tactility/file/FileCache.h>
 #include <Tactility/hal/SdCard.h>
 #include <Tactility/lvgl/KeyboardDeviceListener.h>
 #include <Tactility/lvgl/Statusbar.h>
@@ -94,6 +95,15 @@ bool MainDispatcher::dispatch(Function function, TickType_t timeout) const {
     return true;
 }
 
+bool MainDispatcher::dispatch(Function function, DispatcherPriority priority, TickType_t deadline, TickType_t timeout) const {
+    auto* boxed = new Function(std::move(function));
+    if (dispatcher_dispatch_priority_timed(handle, boxed, mainDispatcherTrampoline, priority, deadline, timeout) != ERROR_NONE) {
+        delete boxed;
+        return false;
+    }
+    return true;
+}
+
 // region Default services
 namespace service {
     // Primary
@@ -346,6 +356,10 @@ void prepareFileSystems() {
 
 void registerApps() {
     registerInternalApps();
+    // Reinstalled files can keep their modification time and size, which the file cache relies on
+    app_install_set_files_changed_callback([](const char* path) {
+        file::getFileCache().invalidate(path);
+    });
     registerInstalledAppsFromFileSystems();
 }
 
@@ -67,7 +67,7 @@ void onReceive(Context* ctx, const esp_now_recv_info_t* receiveInfo, const uint8
     ctx->state.addMessage(msg);
 
     lvgl_lock();
-    ctx->view.displayMessage(msg);
+    ctx->view.showNewMessages();
     lvgl_unlock();
 }
 
@@ -106,7 +106,7 @@ void sendMessage(Context* ctx, const std::string& text) {
     ctx->state.addMessage(msg);
 
     lvgl_lock();
-    ctx->view.displayMessage(msg);
+    ctx->view.showNewMessages();
     lvgl_unlock();
 }
 
@@ -176,6 +176,9 @@ int32_t appMain(uint32_t appInstanceId, int argc, char* argv[]) {
     if (!ctx.settings.chatChannel.empty()) {
         ctx.state.setCurrentChannel(ctx.settings.chatChannel);
     }
+    if (ctx.settings.historyEnabled) {
+        ctx.state.enableHistory(getHistoryFilePath());
+    }
     enableEspNow(&ctx);
 
     ctx.receiveSubscription = service::espnow::subscribeReceiver(
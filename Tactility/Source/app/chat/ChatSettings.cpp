@@ -39,6 +39,7 @@ constexpr auto* KEY_SENDER_ID = "senderId";
 constexpr auto* KEY_NICKNAME = "nickname";
 constexpr auto* KEY_ENCRYPTION_KEY = "encryptionKey";
 constexpr auto* KEY_CHAT_CHANNEL = "chatChannel";
+constexpr auto* KEY_HISTORY_ENABLED = "historyEnabled";
 
 uint32_t defaultSenderId = 0;
 
@@ -126,7 +127,8 @@ ChatSettingsData getDefaultSettings() {
         .nickname = "Device",
         .encryptionKey = {},
         .hasEncryptionKey = false,
-        .chatChannel = "#general"
+        .chatChannel = "#general",
+        .historyEnabled = false
     };
 }
 
@@ -171,6 +173,9 @@ ChatSettingsData loadSettings() {
         settings.chatChannel = it->second.substr(0, MAX_TARGET_LEN);
     }
 
+    it = map.find(KEY_HISTORY_ENABLED);
+    settings.historyEnabled = (it != map.end() && it->second == "true");
+
     return settings;
 }
 
@@ -180,6 +185,7 @@ bool saveSettings(const ChatSettingsData& settings) {
     map[KEY_SENDER_ID] = std::to_string(settings.senderId);
     map[KEY_NICKNAME] = settings.nickname;
     map[KEY_CHAT_CHANNEL] = settings.chatChannel;
+    map[KEY_HISTORY_ENABLED] = settings.historyEnabled ? "true" : "false";
 
     if (settings.hasEncryptionKey) {
         std::string encryptedHex;
@@ -203,6 +209,14 @@ bool settingsFileExists() {
     return access(getSettingsFilePath().c_str(), F_OK) == 0;
 }
 
+std::string getHistoryFilePath() {
+    char path[256];
+    if (app_paths_get_user_data_path("tactility.chat", "history.log", path, sizeof(path)) != ERROR_NONE) {
+        return "";
+    }
+    return path;
+}
+
 } // namespace tt::app::chat
 
 #endif // CONFIG_SOC_WIFI_SUPPORTED || CONFIG_SLAVE_SOC_WIFI_SUPPORTED
@@ -1,13 +1,185 @@
-#ifdef ESP_PLATFORM
-#include <sdkconfig.h>
-#endif
+#include <Tactility/app/chat/ChatState.h>
 
-#if defined(CONFIG_SOC_WIFI_SUPPORTED) || defined(CONFIG_SLAVE_SOC_WIFI_SUPPORTED)
+#include <Tactility/file/File.h>
+#include <Tactility/file/FileCache.h>
 
-#include <Tactility/app/chat/ChatState.h>
+#include <tactility/log.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 namespace tt::app::chat {
 
+constexpr auto* TAG = "ChatState";
+
+// region History log
+
+// Each line is "<isOwn>\t<target>\t<displayText>", with tabs, newlines and backslashes escaped
+
+static void appendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        switch (c) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            default:
+                out += c;
+                break;
+        }
+    }
+}
+
+static std::string unescape(const char* text, size_t length) {
+    std::string out;
+    out.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '\\' && i + 1 < length) {
+            i++;
+            switch (text[i]) {
+                case 't':
+                    out += '\t';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                default:
+                    out += text[i];
+                    break;
+            }
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+static std::string toHistoryLine(const StoredMessage& msg) {
+    std::string line = msg.isOwn ? "1\t" : "0\t";
+    appendEscaped(line, msg.target);
+    line += '\t';
+    appendEscaped(line, msg.displayText);
+    line += '\n';
+    return line;
+}
+
+static bool parseHistoryLine(const char* line, StoredMessage& msg) {
+    const char* targetStart = strchr(line, '\t');
+    if (targetStart == nullptr) return false;
+    targetStart++;
+    const char* textStart = strchr(targetStart, '\t');
+    if (textStart == nullptr) return false;
+    textStart++;
+    msg.isOwn = line[0] == '1';
+    msg.target = unescape(targetStart, textStart - targetStart - 1);
+    msg.displayText = unescape(textStart, strlen(textStart));
+    return true;
+}
+
+void ChatState::enableHistory(const std::string& path) {
+    if (path.empty() || !file::findOrCreateParentDirectory(path, 0755)) {
+        LOG_E(TAG, "Can't create the history log at \"%s\"", path.c_str());
+        return;
+    }
+
+    // Read without holding the mutex: see flushHistory()
+    std::vector<StoredMessage> loaded;
+    if (file::isFile(path)) {
+        file::readLines(path, true, [&loaded](const char* line) {
+            StoredMessage msg;
+            if (parseHistoryLine(line, msg)) {
+                loaded.push_back(std::move(msg));
+            }
+        });
+        LOG_I(TAG, "Loaded %d messages from history", (int)std::min(loaded.size(), MAX_MESSAGES));
+    }
+
+    {
+        auto lock = mutex.asScopedLock();
+        lock.lock();
+        historyPath = path;
+        historyLineCount = loaded.size();
+        pendingHistoryLines.clear();
+        for (const auto& msg : loaded) {
+            storeMessage(msg);
+        }
+    }
+
+    if (loaded.size() > MAX_HISTORY_LINES) {
+        flushHistory();
+    }
+}
+
+void ChatState::flushHistory() {
+    std::string path;
+    {
+        auto lock = mutex.asScopedLock();
+        lock.lock();
+        path = historyPath;
+    }
+    if (path.empty()) {
+        return;
+    }
+
+    // Writers are serialized by the file lock, and take the pending lines in order
+    file::FileMutexGuard guard(path);
+
+    std::string content;
+    bool compact;
+    {
+        auto lock = mutex.asScopedLock();
+        lock.lock();
+        if (path != historyPath) {
+            return;
+        }
+        compact = historyLineCount + pendingHistoryLines.size() > MAX_HISTORY_LINES;
+        if (compact) {
+            // The stored messages already include the pending ones
+            uint32_t oldestSequence = (nextSequence > MAX_MESSAGES) ? nextSequence - MAX_MESSAGES : 1;
+            for (uint32_t sequence = oldestSequence; sequence < nextSequence; sequence++) {
+                content += toHistoryLine(messages[sequence % MAX_MESSAGES]);
+            }
+            historyLineCount = nextSequence - oldestSequence;
+        } else {
+            for (const auto& line : pendingHistoryLines) {
+                content += line;
+            }
+            historyLineCount += pendingHistoryLines.size();
+        }
+        pendingHistoryLines.clear();
+    }
+
+    if (content.empty()) {
+        return;
+    }
+
+    FILE* file = fopen(path.c_str(), compact ? "w" : "a");
+    if (file == nullptr) {
+        LOG_E(TAG, "Failed to open %s", path.c_str());
+        return;
+    }
+    if (fwrite(content.data(), 1, content.size(), file) != content.size()) {
+        LOG_E(TAG, "Failed to write %s", path.c_str());
+    }
+    fclose(file);
+    // While holding the file lock, so a concurrent read can't cache the old content again in between
+    file::getFileCache().invalidate(path);
+}
+
+// endregion
+
 void ChatState::setLocalNickname(const std::string& nickname) {
     auto lock = mutex.asScopedLock();
     lock.lock();
@@ -32,29 +204,65 @@ std::string ChatState::getCurrentChannel() const {
     return currentChannel;
 }
 
-void ChatState::addMessage(const StoredMessage& msg) {
-    auto lock = mutex.asScopedLock();
-    lock.lock();
-    if (messages.size() >= MAX_MESSAGES) {
-        messages.pop_front();
+void ChatState::storeMessage(const StoredMessage& msg) {
+    auto& slot = messages[nextSequence % MAX_MESSAGES];
+    if (nextSequence > MAX_MESSAGES) {
+        // The slot holds the oldest message, which is first in the index of its target
+        auto iterator = targetIndex.find(slot.target);
+        if (iterator != targetIndex.end()) {
+            iterator->second.pop_front();
+            if (iterator->second.empty()) {
+                targetIndex.erase(iterator);
+            }
+        }
     }
-    messages.push_back(msg);
+    slot = msg;
+    targetIndex[msg.target].push_back(nextSequence);
+    nextSequence++;
 }
 
-std::vector<StoredMessage> ChatState::getFilteredMessages() const {
+uint32_t ChatState::addMessage(const StoredMessage& msg) {
+    uint32_t sequence;
+    bool hasHistory;
+    {
+        auto lock = mutex.asScopedLock();
+        lock.lock();
+        sequence = nextSequence;
+        storeMessage(msg);
+        hasHistory = !historyPath.empty();
+        if (hasHistory) {
+            pendingHistoryLines.push_back(toHistoryLine(msg));
+        }
+    }
+    if (hasHistory) {
+        flushHistory();
+    }
+    return sequence;
+}
+
+uint32_t ChatState::getMessagesSince(uint32_t sequence, std::vector<StoredMessage>& out) const {
     auto lock = mutex.asScopedLock();
     lock.lock();
-    std::vector<StoredMessage> result;
-    result.reserve(messages.size()); // Avoid reallocations; may over-allocate slightly
-    for (const auto& msg : messages) {
-        // Show if broadcast (empty target) or matches current channel
-        if (msg.target.empty() || msg.target == currentChannel) {
-            result.push_back(msg);
+
+    // Merges the messages of the current channel with the broadcasts, which both are in order
+    static const std::deque<uint32_t> empty;
+    auto channelIterator = targetIndex.find(currentChannel);
+    auto broadcastIterator = currentChannel.empty() ? targetIndex.end() : targetIndex.find("");
+    const auto& channelSequences = (channelIterator != targetIndex.end()) ? channelIterator->second : empty;
+    const auto& broadcastSequences = (broadcastIterator != targetIndex.end()) ? broadcastIterator->second : empty;
+    auto channelNext = std::upper_bound(channelSequences.begin(), channelSequences.end(), sequence);
+    auto broadcastNext = std::upper_bound(broadcastSequences.begin(), broadcastSequences.end(), sequence);
+
+    while (channelNext != channelSequences.end() || broadcastNext != broadcastSequences.end()) {
+        uint32_t next;
+        if (broadcastNext == broadcastSequences.end() || (channelNext != channelSequences.end() && *channelNext < *broadcastNext)) {
+            next = *channelNext++;
+        } else {
+            next = *broadcastNext++;
         }
+        out.push_back(messages[next % MAX_MESSAGES]);
     }
-    return result;
+    return nextSequence - 1;
 }
 
 } // namespace tt::app::chat
-
-#endif // CONFIG_SOC_WIFI_SUPPORTED || CONFIG_SLAVE_SOC_WIFI_SUPPORTED
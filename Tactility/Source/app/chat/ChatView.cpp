@@ -184,17 +184,25 @@ void ChatView::init(lv_obj_t* parent) {
     // Overlay panels (hidden by default)
     createSettingsPanel(parent);
     createChannelPanel(parent);
+
+    // Messages from the history log
+    refreshMessageList();
 }
 
-void ChatView::displayMessage(const StoredMessage& msg) {
+void ChatView::showNewMessages() {
     if (!msgList || !state) return;
 
-    // Only show if matches current channel or broadcast
-    std::string channel = state->getCurrentChannel();
-    if (!msg.target.empty() && msg.target != channel) {
-        return;
+    std::vector<StoredMessage> newMessages;
+    lastSequence = state->getMessagesSince(lastSequence, newMessages);
+    if (newMessages.empty()) return;
+
+    for (const auto& msg : newMessages) {
+        addMessageToList(msgList, msg);
+    }
+    // Keep the list as long as the stored history
+    while (lv_obj_get_child_count(msgList) > MAX_MESSAGES) {
+        lv_obj_delete(lv_obj_get_child(msgList, 0));
     }
-    addMessageToList(msgList, msg);
     lv_obj_scroll_to_y(msgList, LV_COORD_MAX, LV_ANIM_ON);
 }
 
@@ -202,8 +210,9 @@ void ChatView::refreshMessageList() {
     if (!msgList || !state) return;
 
     lv_obj_clean(msgList);
-    auto filtered = state->getFilteredMessages();
-    for (const auto& msg : filtered) {
+    std::vector<StoredMessage> messages;
+    lastSequence = state->getMessagesSince(0, messages);
+    for (const auto& msg : messages) {
         addMessageToList(msgList, msg);
     }
     lv_obj_scroll_to_y(msgList, LV_COORD_MAX, LV_ANIM_OFF);
@@ -6,8 +6,6 @@
 #include <Tactility/file/FileLock.h>
 #include <tactility/log.h>
 
-#include <cstring>
-#include <dirent.h>
 #include <unistd.h>
 #include <vector>
 
@@ -49,25 +47,20 @@ bool State::setEntriesForPath(const std::string& path) {
     bool get_mount_points = (kernel::getPlatform() == kernel::PlatformEsp) && (path == "/");
     if (get_mount_points) {
         LOG_I(TAG, "Setting custom root");
-        dir_entries = file::getFileSystemDirents();
-        current_path = path;
-        selected_child_entry = "";
-        action = ActionNone;
-        return true;
-    } else {
-        dir_entries.clear();
-        int count = file::scandir(path, dir_entries, &file::direntFilterDotEntries, file::direntSortAlphaAndType);
-        if (count >= 0) {
-            LOG_I(TAG, "%s has %d entries", path.c_str(), count);
-            current_path = path;
-            selected_child_entry = "";
-            action = ActionNone;
-            return true;
-        } else {
-            LOG_E(TAG, "Failed to fetch entries for %s", path.c_str());
-            return false;
+        std::vector<file::DirectoryCache::Entry> mount_points;
+        for (const auto& mount_point : file::getFileSystemDirents()) {
+            mount_points.push_back({ mount_point.d_name, mount_point.d_type });
         }
+        dir_entries.setEntries(path, std::move(mount_points));
+    } else if (!dir_entries.load(path)) {
+        LOG_E(TAG, "Failed to fetch entries for %s", path.c_str());
+        return false;
     }
+
+    current_path = path;
+    selected_child_entry = "";
+    action = ActionNone;
+    return true;
 }
 
 bool State::setEntriesForChildPath(const std::string& childPath) {
@@ -76,18 +69,4 @@ bool State::setEntriesForChildPath(const std::string& childPath) {
     return setEntriesForPath(path);
 }
 
-bool State::getDirent(uint32_t index, dirent& dirent) {
-    auto lock = mutex.asScopedLock();
-    if (!lock.lock(50 / portTICK_PERIOD_MS)) {
-        return false;
-    }
-
-    if (index < dir_entries.size()) {
-        dirent = dir_entries[index];
-        return true;
-    } else {
-        return false;
-    }
-}
-
 }
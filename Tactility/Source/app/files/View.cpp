@@ -11,16 +11,18 @@
 #include <Tactility/app/inputdialog/InputDialog.h>
 #include <Tactility/app/notes/Notes.h>
 #include <Tactility/file/File.h>
+#include <Tactility/file/FileCache.h>
 #include <Tactility/Platform.h>
 #include <Tactility/StringUtils.h>
 #include <Tactility/Tactility.h>
 
-#include <tactility/check.h>
 #include <tactility/device.h>
 #include <tactility/drivers/usb_host_msc.h>
 #include <tactility/filesystem/file_mutex.h>
 #include <tactility/log.h>
+#include <tactility/time.h>
 
+#include <algorithm>
 #include <cctype>
 #include <cstdio>
 #include <cstring>
@@ -29,6 +31,10 @@
 namespace tt::app::files {
 
 constexpr auto* TAG = "Files";
+/** The user data of a row that doesn't show an entry */
+constexpr auto NO_ROW_INDEX = UINTPTR_MAX;
+/** How often the list checks for entries that were loaded in the background */
+constexpr uint32_t REFRESH_INTERVAL_MS = 100;
 
 // region Callbacks
 
@@ -37,6 +43,16 @@ static void dirEntryListScrollBeginCallback(lv_event_t* event) {
     view->onDirEntryListScrollBegin();
 }
 
+static void dirEntryListScrollCallback(lv_event_t* event) {
+    auto* view = static_cast<files::View*>(lv_event_get_user_data(event));
+    view->onDirEntryListChanged();
+}
+
+static void dirEntryListSizeChangedCallback(lv_event_t* event) {
+    auto* view = static_cast<files::View*>(lv_event_get_user_data(event));
+    view->onDirEntryListChanged();
+}
+
 static void onBackPressedCallback(lv_event_t* event) {
     auto* view = static_cast<files::View*>(lv_event_get_user_data(event));
     view->onBackPressed();
@@ -45,14 +61,14 @@ static void onBackPressedCallback(lv_event_t* event) {
 static void onDirEntryPressedCallback(lv_event_t* event) {
     auto* view = static_cast<View*>(lv_event_get_user_data(event));
     auto* button = lv_event_get_target_obj(event);
-    auto index = lv_obj_get_index(button);
+    auto index = reinterpret_cast<uintptr_t>(lv_obj_get_user_data(button));
     view->onDirEntryPressed(index);
 }
 
 static void onDirEntryLongPressedCallback(lv_event_t* event) {
     auto* view = static_cast<View*>(lv_event_get_user_data(event));
     auto* button = lv_event_get_target_obj(event);
-    auto index = lv_obj_get_index(button);
+    auto index = reinterpret_cast<uintptr_t>(lv_obj_get_user_data(button));
     view->onDirEntryLongPressed(index);
 }
 
@@ -152,6 +168,7 @@ static bool copyFileContents(const std::string& src, const std::string& dst) {
     if (!success) {
         remove(dst.c_str());
     }
+    file::getFileCache().invalidate(dst);
     unlock_all();
     return success;
 }
@@ -248,34 +265,36 @@ void View::viewFile(const std::string& path, const std::string& filename) {
     onNavigate();
 }
 
-bool View::resolveDirentFromListIndex(int32_t list_index, dirent& out_entry) {
-    const bool is_root = (state->getCurrentPath() == "/");
-    const bool has_back = (!is_root && current_start_index > 0);
-
-    if (has_back && list_index == 0) {
-        return false; // Back button
+bool View::resolveEntry(uint32_t index, file::DirectoryCache::Entry& entry) {
+    if (rows.empty()) {
+        return false;
     }
 
-    const size_t adjusted_index =
-        current_start_index + static_cast<size_t>(list_index) - (has_back ? 1 : 0);
+    if (state->getEntriesRevision() == rows_revision) {
+        return state->getEntry(index, entry);
+    }
 
-    return state->getDirent(static_cast<uint32_t>(adjusted_index), out_entry);
+    // The rows are stale when entries were merged in after they were bound: the index might point to another entry.
+    // Resolve the entry that the row showed when it was pressed, and bind the rows again.
+    std::string name = row_entries[index % rows.size()].name;
+    updateRows();
+    return state->findEntry(name, entry);
 }
 
 void View::onDirEntryPressed(uint32_t index) {
-    dirent dir_entry;
-    if (!resolveDirentFromListIndex(static_cast<int32_t>(index), dir_entry)) {
+    file::DirectoryCache::Entry dir_entry;
+    if (!resolveEntry(index, dir_entry)) {
         return;
     }
 
-    LOG_I(TAG, "Pressed %s %d", dir_entry.d_name, (int)dir_entry.d_type);
-    state->setSelectedChildEntry(dir_entry.d_name);
+    LOG_I(TAG, "Pressed %s %d", dir_entry.name.c_str(), (int)dir_entry.type);
+    state->setSelectedChildEntry(dir_entry.name);
 
     using namespace tt::file;
-    switch (dir_entry.d_type) {
+    switch (dir_entry.type) {
         case TT_DT_DIR:
         case TT_DT_CHR:
-            state->setEntriesForChildPath(dir_entry.d_name);
+            state->setEntriesForChildPath(dir_entry.name);
             onNavigate();
             update();
             break;
@@ -285,25 +304,25 @@ void View::onDirEntryPressed(uint32_t index) {
             break;
 
         default:
-            viewFile(state->getCurrentPath(), dir_entry.d_name);
+            viewFile(state->getCurrentPath(), dir_entry.name);
             onNavigate();
             break;
     }
 }
 
-void View::onDirEntryLongPressed(int32_t index) {
-    dirent dir_entry;
-    if (!resolveDirentFromListIndex(index, dir_entry)) {
+void View::onDirEntryLongPressed(uint32_t index) {
+    file::DirectoryCache::Entry dir_entry;
+    if (!resolveEntry(index, dir_entry)) {
         return;
     }
 
-    LOG_I(TAG, "Long-pressed %s %d", dir_entry.d_name, (int)dir_entry.d_type);
-    state->setSelectedChildEntry(dir_entry.d_name);
+    LOG_I(TAG, "Long-pressed %s %d", dir_entry.name.c_str(), (int)dir_entry.type);
+    state->setSelectedChildEntry(dir_entry.name);
 
     if (state->getCurrentPath() == "/") {
         // At root, only USB mount points support actions (eject).
         // Other root-level entries intentionally have no context actions.
-        const char* name = dir_entry.d_name;
+        const char* name = dir_entry.name.c_str();
         if (strncmp(name, "usb", 3) == 0 && isdigit((unsigned char)name[3])) {
             showActionsForMountPoint();
         }
@@ -311,7 +330,7 @@ void View::onDirEntryLongPressed(int32_t index) {
     }
 
     using namespace file;
-    switch (dir_entry.d_type) {
+    switch (dir_entry.type) {
         case TT_DT_DIR:
         case TT_DT_CHR:
             showActionsForDirectory();
@@ -327,23 +346,33 @@ void View::onDirEntryLongPressed(int32_t index) {
     }
 }
 
-void View::createDirEntryWidget(lv_obj_t* list, dirent& dir_entry) {
-    check(list);
+lv_obj_t* View::createRow() {
+    // Rows always have an icon, so the image is child 0 and the label is child 1
+    lv_obj_t* row = lv_list_add_button(dir_entry_list, LV_SYMBOL_FILE, "");
+    lv_obj_add_event_cb(row, &onDirEntryPressedCallback, LV_EVENT_SHORT_CLICKED, this);
+    lv_obj_add_event_cb(row, &onDirEntryLongPressedCallback, LV_EVENT_LONG_PRESSED, this);
+    lv_obj_set_user_data(row, reinterpret_cast<void*>(NO_ROW_INDEX));
+    rows.push_back(row);
+    row_entries.emplace_back();
+    return row;
+}
+
+void View::bindRow(lv_obj_t* row, size_t index, const file::DirectoryCache::Entry& dir_entry) {
     const char* symbol;
-    if (dir_entry.d_type == file::TT_DT_DIR || dir_entry.d_type == file::TT_DT_CHR) {
+    if (file::isDirectoryType(dir_entry.type)) {
         symbol = LV_SYMBOL_DIRECTORY;
-    } else if (isSupportedImageFile(dir_entry.d_name)) {
+    } else if (isSupportedImageFile(dir_entry.name)) {
         symbol = LV_SYMBOL_IMAGE;
-    } else if (dir_entry.d_type == file::TT_DT_LNK) {
+    } else if (dir_entry.type == file::TT_DT_LNK) {
         symbol = LV_SYMBOL_LOOP;
     } else {
         symbol = LV_SYMBOL_FILE;
     }
 
     // Get file size for regular files
-    std::string label_text = dir_entry.d_name;
-    if (dir_entry.d_type == file::TT_DT_REG) {
-        std::string file_path = file::getChildPath(state->getCurrentPath(), dir_entry.d_name);
+    std::string label_text = dir_entry.name;
+    if (dir_entry.type == file::TT_DT_REG) {
+        std::string file_path = file::getChildPath(state->getCurrentPath(), dir_entry.name);
         struct stat st;
         if (stat(file_path.c_str(), &st) == 0) {
             // Format file size in human-readable format
@@ -370,9 +399,65 @@ void View::createDirEntryWidget(lv_obj_t* list, dirent& dir_entry) {
         }
     }
 
-    lv_obj_t* button = lv_list_add_button(list, symbol, label_text.c_str());
-    lv_obj_add_event_cb(button, &onDirEntryPressedCallback, LV_EVENT_SHORT_CLICKED, this);
-    lv_obj_add_event_cb(button, &onDirEntryLongPressedCallback, LV_EVENT_LONG_PRESSED, this);
+    lv_image_set_src(lv_obj_get_child(row, 0), symbol);
+    lv_label_set_text(lv_obj_get_child(row, 1), label_text.c_str());
+    lv_obj_set_y(row, static_cast<int32_t>(index) * row_height);
+    lv_obj_set_user_data(row, reinterpret_cast<void*>(index));
+    lv_obj_remove_flag(row, LV_OBJ_FLAG_HIDDEN);
+    row_entries[index % rows.size()] = dir_entry;
+}
+
+void View::updateRows() {
+    std::string path = state->getCurrentPath();
+    if (path != rows_path) {
+        rows_path = path;
+        lv_obj_scroll_to_y(dir_entry_list, 0, LV_ANIM_OFF);
+    }
+
+    // Reloaded entries can have the same names, but other file sizes
+    bool is_reloaded = false;
+    uint32_t generation = state->getEntriesGeneration();
+    if (generation != rows_generation) {
+        rows_generation = generation;
+        is_reloaded = true;
+    }
+
+    // Read the revision before the entries: entries that arrive in between trigger another update
+    bool is_changed = is_reloaded;
+    uint32_t revision = state->getEntriesRevision();
+    if (revision != rows_revision) {
+        rows_revision = revision;
+        is_changed = true;
+    }
+
+    size_t count = state->getEntryCount();
+    lv_obj_set_y(dir_entry_spacer, count > 0 ? static_cast<int32_t>(count) * row_height - 1 : 0);
+
+    size_t visible_rows = static_cast<size_t>(lv_obj_get_content_height(dir_entry_list) / row_height) + 2;
+    while (rows.size() < visible_rows) {
+        createRow();
+    }
+
+    size_t first_index = static_cast<size_t>(std::max(lv_obj_get_scroll_y(dir_entry_list), static_cast<int32_t>(0)) / row_height);
+    file::DirectoryCache::Entry dir_entry;
+    for (size_t index = first_index; index < first_index + rows.size(); index++) {
+        auto* row = rows[index % rows.size()];
+        bool is_bound = reinterpret_cast<uintptr_t>(lv_obj_get_user_data(row)) == index;
+        if (!is_changed && is_bound) {
+            continue;
+        }
+        if (index < count && state->getEntry(index, dir_entry)) {
+            // Entries that were merged in while loading only move the rows after them
+            const auto& row_entry = row_entries[index % rows.size()];
+            if (!is_reloaded && is_bound && row_entry.type == dir_entry.type && row_entry.name == dir_entry.name) {
+                continue;
+            }
+            bindRow(row, index, dir_entry);
+        } else {
+            lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_set_user_data(row, reinterpret_cast<void*>(NO_ROW_INDEX));
+        }
+    }
 }
 
 void View::onBackPressed() {
@@ -470,7 +555,7 @@ void View::onEjectPressed() {
     update();
 }
 
-void View::update(size_t start_index) {
+void View::update() {
     const bool is_root = (state->getCurrentPath() == "/");
 
     if (!lvgl_try_lock(500 / portTICK_PERIOD_MS)) {
@@ -478,53 +563,7 @@ void View::update(size_t start_index) {
         return;
     }
 
-    lv_obj_clean(dir_entry_list);
-
-    current_start_index = start_index;
-
-    state->withEntries([this, is_root](const std::vector<dirent>& entries) {
-        size_t total_entries = entries.size();
-        if (current_start_index >= total_entries) {
-            current_start_index = (total_entries > MAX_BATCH)
-                ? (total_entries - MAX_BATCH)
-                : 0;
-        }
-        size_t count = 0;
-
-        if (!is_root && current_start_index > 0) {
-            auto* back_btn = lv_list_add_btn(dir_entry_list, LV_SYMBOL_LEFT, "Back");
-            lv_obj_add_event_cb(back_btn, [](lv_event_t* event) {
-                auto* view = static_cast<View*>(lv_event_get_user_data(event));
-                size_t new_index = (view->current_start_index >= view->MAX_BATCH) ? 
-                                    view->current_start_index - view->MAX_BATCH : 0;
-                view->update(new_index); }, LV_EVENT_SHORT_CLICKED, this);
-        }
-
-        for (size_t i = current_start_index; i < total_entries; ++i) {
-            auto entry = entries[i];
-
-            createDirEntryWidget(dir_entry_list, entry);
-            count++;
-
-            if (count >= MAX_BATCH) {
-                break;
-            }
-        }
-
-        last_loaded_index = std::min(current_start_index + count, total_entries);
-
-        if (!is_root && last_loaded_index < total_entries) {
-            if (total_entries > current_start_index &&
-                (total_entries - current_start_index) > MAX_BATCH) {
-                auto* next_btn = lv_list_add_btn(dir_entry_list, LV_SYMBOL_RIGHT, "Next");
-                lv_obj_add_event_cb(next_btn, [](lv_event_t* event) {
-                    auto* view = static_cast<View*>(lv_event_get_user_data(event));
-                    view->update(view->last_loaded_index); }, LV_EVENT_SHORT_CLICKED, this);
-            }
-        } else {
-            last_loaded_index = total_entries;
-        }
-    });
+    updateRows();
 
     if (is_root) {
         lv_obj_add_flag(lv_obj_get_parent(navigate_up_button), LV_OBJ_FLAG_HIDDEN);
@@ -566,8 +605,24 @@ void View::init(uint32_t appInstanceId, lv_obj_t* parent) {
     dir_entry_list = lv_list_create(wrapper);
     lv_obj_set_height(dir_entry_list, LV_PCT(100));
     lv_obj_set_flex_grow(dir_entry_list, 1);
+    // Rows are positioned by updateRows()
+    lv_obj_set_layout(dir_entry_list, LV_LAYOUT_NONE);
+
+    dir_entry_spacer = lv_obj_create(dir_entry_list);
+    lv_obj_remove_style_all(dir_entry_spacer);
+    lv_obj_set_size(dir_entry_spacer, 1, 1);
+    lv_obj_remove_flag(dir_entry_spacer, LV_OBJ_FLAG_CLICKABLE);
+
+    // All rows have the height of the first one
+    auto* first_row = createRow();
+    lv_obj_update_layout(dir_entry_list);
+    row_height = std::max(lv_obj_get_height(first_row), static_cast<int32_t>(1));
+    lv_obj_add_flag(first_row, LV_OBJ_FLAG_HIDDEN);
 
     lv_obj_add_event_cb(dir_entry_list, dirEntryListScrollBeginCallback, LV_EVENT_SCROLL_BEGIN, this);
+    lv_obj_add_event_cb(dir_entry_list, dirEntryListScrollCallback, LV_EVENT_SCROLL, this);
+    // A larger list needs more rows
+    lv_obj_add_event_cb(dir_entry_list, dirEntryListSizeChangedCallback, LV_EVENT_SIZE_CHANGED, this);
 
     action_list = lv_list_create(wrapper);
     lv_obj_set_height(action_list, LV_PCT(100));
@@ -575,6 +630,11 @@ void View::init(uint32_t appInstanceId, lv_obj_t* parent) {
     lv_obj_add_flag(action_list, LV_OBJ_FLAG_HIDDEN);
 
     update();
+
+    refreshTimer = std::make_unique<Timer>(Timer::Type::Periodic, millis_to_ticks(REFRESH_INTERVAL_MS), [this] {
+        onRefreshTimer();
+    });
+    refreshTimer->start();
 }
 
 void View::onDirEntryListScrollBegin() {
@@ -584,6 +644,19 @@ void View::onDirEntryListScrollBegin() {
     }
 }
 
+void View::onDirEntryListChanged() {
+    updateRows();
+}
+
+void View::onRefreshTimer() {
+    if (lvgl_try_lock(REFRESH_INTERVAL_MS / portTICK_PERIOD_MS)) {
+        if (state->getEntriesRevision() != rows_revision) {
+            updateRows();
+        }
+        lvgl_unlock();
+    }
+}
+
 void View::onNavigate() {
     if (lvgl_try_lock(500 / portTICK_PERIOD_MS)) {
         lv_obj_add_flag(action_list, LV_OBJ_FLAG_HIDDEN);
@@ -617,6 +690,7 @@ void View::onResult(uint32_t launchId, int32_t result) {
                     if (remove(filepath.c_str()) != 0) {
                         LOG_W(TAG, "Failed to delete %s", filepath.c_str());
                     }
+                    file::getFileCache().invalidate(filepath);
                 }
 
                 state->setEntriesForPath(state->getCurrentPath());
@@ -642,6 +716,7 @@ void View::onResult(uint32_t launchId, int32_t result) {
                     } else {
                         LOG_E(TAG, "Failed to rename \"%s\" to \"%s\"", filepath.c_str(), rename_to.c_str());
                     }
+                    file::getFileCache().invalidate(filepath);
                 }
 
                 state->setEntriesForPath(state->getCurrentPath());
@@ -817,12 +892,15 @@ void View::onPastePressed() {
 }
 
 void View::doPaste(const std::string& src, bool is_cut, const std::string& dst) {
+    // The file cache is invalidated by the writers below (copyFileContents(), file::deleteRecursively())
     bool success = false;
     bool src_delete_failed = false;
     if (is_cut) {
         {
             file::FileMutexGuard guard(src);
             success = (rename(src.c_str(), dst.c_str()) == 0);
+            file::getFileCache().invalidate(src);
+            file::getFileCache().invalidate(dst);
         }
         if (!success) {
             // Fallback for cross-filesystem moves: copy then delete.
@@ -866,7 +944,12 @@ void View::doPaste(const std::string& src, bool is_cut, const std::string& dst)
 }
 
 void View::deinit() {
+    if (refreshTimer != nullptr) {
+        refreshTimer->stop();
+    }
     lv_obj_remove_event_cb(dir_entry_list, dirEntryListScrollBeginCallback);
+    lv_obj_remove_event_cb(dir_entry_list, dirEntryListScrollCallback);
+    lv_obj_remove_event_cb(dir_entry_list, dirEntryListSizeChangedCallback);
 }
 
 } // namespace tt::app::files
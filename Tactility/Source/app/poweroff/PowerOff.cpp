@@ -11,6 +11,7 @@
 #include <lvgl/fonts.h>
 #include <tactility/device.h>
 #include <tactility/drivers/power_supply.h>
+#include <tactility/preferences.h>
 
 namespace tt::app::poweroff {
 
@@ -58,6 +59,9 @@ void onYesPressed(lv_event_t* /*event*/) {
         return;
     }
 
+    // Settings with a delayed commit would otherwise be lost
+    preferences_flush_all();
+
     Device* display;
     error_t error = device_get_first_by_type(&DISPLAY_TYPE, &display);
     // TODO: remove this logic path when all displays have been migrated to kernel display drivers
@@ -1,5 +1,7 @@
 #include "tactility/time.h"
 
+#include <tactility/memory.h>
+
 #include <Tactility/DeprecatedPaths.h>
 #include <Tactility/Tactility.h>
 #include <Tactility/TactilityConfig.h>
@@ -15,6 +17,7 @@
 #include <cstring>
 #include <format>
 #include <utility>
+#include <vector>
 
 #include <lvgl/fonts.h>
 #include <lvgl/lvgl.h>
@@ -180,6 +183,26 @@ void updateMemoryBar(const MemoryBarWidgets& widgets, uint64_t free, uint64_t to
         (unsigned long long)free, (unsigned long long)total);
 }
 
+void updateMemoryTags(lv_obj_t* label) {
+    std::vector<MemoryTagStats> stats(memory_tracking_get_stats(nullptr, 0));
+    stats.resize(std::min(stats.size(), memory_tracking_get_stats(stats.data(), stats.size())));
+    std::ranges::sort(stats, [](const auto& left, const auto& right) {
+        return left.current_bytes > right.current_bytes;
+    });
+
+    std::string text = "Allocations by subsystem:";
+    for (const auto& tag_stats : stats) {
+        text += std::format("\n{}: {} kB in {} blocks (peak {} kB, largest {} bytes)",
+            tag_stats.tag,
+            tag_stats.current_bytes / 1024,
+            tag_stats.allocation_count,
+            tag_stats.peak_bytes / 1024,
+            tag_stats.largest_block
+        );
+    }
+    lv_label_set_text(label, text.c_str());
+}
+
 #if configUSE_TRACE_FACILITY
 
 const char* getTaskState(const TaskStatus_t& task) {
@@ -254,6 +277,8 @@ struct Context {
 
     lv_obj_t* tasksContainer = nullptr;
     lv_obj_t* psramContainer = nullptr;
+    /** Only created when allocation tracking is enabled */
+    lv_obj_t* memoryTagsLabel = nullptr;
 
     bool hasExternalMem = false;
     bool hasDataStorage = false;
@@ -267,6 +292,10 @@ void updateMemory(Context* ctx) {
     if (ctx->hasExternalMem) {
         updateMemoryBar(ctx->externalMemBar, getSpiFree(), getSpiTotal());
     }
+
+    if (ctx->memoryTagsLabel) {
+        updateMemoryTags(ctx->memoryTagsLabel);
+    }
 }
 
 void updateStorage(Context* ctx) {
@@ -347,6 +376,11 @@ void createWidgets(lv_obj_t* parent, void* userData) {
         ctx->externalMemBar = createMemoryBar(memory_tab, "External");
     }
 
+    if (memory_tracking_is_enabled()) {
+        ctx->memoryTagsLabel = lv_label_create(memory_tab);
+        lv_obj_set_width(ctx->memoryTagsLabel, LV_PCT(100));
+    }
+
 #ifdef ESP_PLATFORM
     // Storage tab content
     uint64_t storage_total = 0;
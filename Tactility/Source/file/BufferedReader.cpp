@@ -0,0 +1,168 @@
+#include <Tactility/file/BufferedReader.h>
+
+#include <tactility/log.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace tt::file {
+
+constexpr auto* TAG = "BufferedReader";
+
+bool BufferedReader::open() {
+    close();
+
+    FileMutexGuard guard(filePath);
+    auto opening_file = std::unique_ptr<FILE, FileCloser>(fopen(filePath.c_str(), "rb"));
+    if (opening_file == nullptr) {
+        LOG_E(TAG, "Failed to open %s", filePath.c_str());
+        return false;
+    }
+
+    // Reads are already buffered here: stdio's own (small) buffer would split them up
+    setvbuf(opening_file.get(), nullptr, _IONBF, 0);
+
+    buffer = std::make_unique<uint8_t[]>(std::max(config.bufferSize, static_cast<size_t>(1)));
+    bufferStart = 0;
+    bufferEnd = 0;
+    bufferOffset = 0;
+    endOfFile = false;
+    error = false;
+    file = std::move(opening_file);
+    return true;
+}
+
+void BufferedReader::close() {
+    if (file != nullptr) {
+        FileMutexGuard guard(filePath);
+        file = nullptr;
+    }
+    buffer = nullptr;
+}
+
+size_t BufferedReader::readFromFile(void* data, size_t size) {
+    FileMutexGuard guard(filePath);
+    size_t bytes_read = fread(data, 1, size, file.get());
+    fileReadCount++;
+    bytesRead += bytes_read;
+    if (bytes_read < size) {
+        if (feof(file.get())) {
+            endOfFile = true;
+        } else {
+            LOG_E(TAG, "Failed to read %s", filePath.c_str());
+            error = true;
+        }
+    }
+    return bytes_read;
+}
+
+bool BufferedReader::refill(size_t minimumSize) {
+    bufferOffset += static_cast<long>(bufferEnd);
+    bufferStart = 0;
+    bufferEnd = 0;
+    if (endOfFile || error) {
+        return false;
+    }
+
+    size_t size = config.readAhead ? config.bufferSize : std::min(minimumSize, config.bufferSize);
+    bufferEnd = readFromFile(buffer.get(), std::max(size, static_cast<size_t>(1)));
+    return bufferEnd > 0;
+}
+
+size_t BufferedReader::read(void* data, size_t size) {
+    if (file == nullptr) {
+        return 0;
+    }
+
+    auto* output = static_cast<uint8_t*>(data);
+    size_t total = 0;
+    while (total < size) {
+        size_t available = bufferEnd - bufferStart;
+        size_t remaining = size - total;
+        if (available > 0) {
+            size_t count = std::min(available, remaining);
+            memcpy(output + total, buffer.get() + bufferStart, count);
+            bufferStart += count;
+            total += count;
+        } else if (remaining >= config.bufferSize) {
+            // Copying through the buffer wouldn't save any file system reads
+            bufferOffset += static_cast<long>(bufferEnd);
+            bufferStart = 0;
+            bufferEnd = 0;
+            if (endOfFile || error) {
+                break;
+            }
+            size_t count = readFromFile(output + total, remaining);
+            bufferOffset += static_cast<long>(count);
+            total += count;
+            if (count < remaining) {
+                break;
+            }
+        } else if (!refill(remaining)) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+bool BufferedReader::readLine(std::string& line, bool stripNewLine) {
+    line.clear();
+    if (file == nullptr) {
+        return false;
+    }
+
+    while (true) {
+        // The length of a line is unknown, so this always reads ahead
+        if (bufferStart == bufferEnd && !refill(config.bufferSize)) {
+            return !line.empty() && !error;
+        }
+
+        const auto* start = buffer.get() + bufferStart;
+        size_t available = bufferEnd - bufferStart;
+        const auto* newline = static_cast<const uint8_t*>(memchr(start, '\n', available));
+        if (newline != nullptr) {
+            size_t length = newline - start;
+            line.append(reinterpret_cast<const char*>(start), stripNewLine ? length : length + 1);
+            bufferStart += length + 1;
+            return true;
+        }
+
+        line.append(reinterpret_cast<const char*>(start), available);
+        bufferStart = bufferEnd;
+    }
+}
+
+bool BufferedReader::seek(long offset) {
+    if (file == nullptr || offset < 0) {
+        return false;
+    }
+
+    if (offset >= bufferOffset && offset <= bufferOffset + static_cast<long>(bufferEnd)) {
+        bufferStart = static_cast<size_t>(offset - bufferOffset);
+        return true;
+    }
+
+    FileMutexGuard guard(filePath);
+    if (fseek(file.get(), offset, SEEK_SET) != 0) {
+        LOG_E(TAG, "Failed to seek in %s", filePath.c_str());
+        return false;
+    }
+
+    bufferOffset = offset;
+    bufferStart = 0;
+    bufferEnd = 0;
+    endOfFile = false;
+    return true;
+}
+
+long BufferedReader::getSize() {
+    if (file == nullptr) {
+        return -1;
+    }
+
+    FileMutexGuard guard(filePath);
+    return file::getSize(file.get());
+}
+
+}
@@ -0,0 +1,200 @@
+#include <Tactility/file/DirectoryCache.h>
+
+#include <Tactility/DispatcherThread.h>
+
+#include <tactility/log.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace tt::file {
+
+constexpr auto* TAG = "DirectoryCache";
+
+bool DirectoryCache::compareEntries(const Entry& left, const Entry& right) {
+    return compareNameAndType(left.name.c_str(), left.type, right.name.c_str(), right.type);
+}
+
+/**
+ * Reads the directories of all caches, one at a time: an abandoned loader stops at its next batch.
+ * It's never stopped, so it can't be destroyed while a loader still uses it when the application exits.
+ */
+static DispatcherThread& getLoaderThread() {
+    static auto* thread = [] {
+        auto* loader_thread = new DispatcherThread("dir_cache", 4096);
+        loader_thread->start();
+        return loader_thread;
+    }();
+    return *thread;
+}
+
+void DirectoryCache::loaderMain(const std::shared_ptr<Data>& data, uint32_t loadId, DIR* dir, const std::string& dirPath, ScandirFilter filter) {
+    std::vector<Entry> batch;
+    batch.reserve(BATCH_SIZE);
+    bool done = false;
+    while (!done && data->loadId == loadId) {
+        {
+            // Release the lock between batches, so other users of the storage device aren't blocked for long
+            FileMutexGuard guard(dirPath);
+            while (batch.size() < BATCH_SIZE) {
+                dirent* entry = readdir(dir);
+                if (entry == nullptr) {
+                    done = true;
+                    break;
+                }
+                if (filter == nullptr || filter(entry) == 0) {
+                    batch.push_back({ entry->d_name, entry->d_type });
+                }
+            }
+        }
+
+        std::ranges::sort(batch, compareEntries);
+
+        auto lock = data->mutex.asScopedLock();
+        lock.lock();
+        if (data->loadId != loadId) {
+            break;
+        }
+        auto& entries = data->entries;
+        size_t free_entries = data->maxEntries - entries.size();
+        if (batch.size() > free_entries) {
+            LOG_W(TAG, "%s has more than %d entries", dirPath.c_str(), (int)data->maxEntries);
+            batch.resize(free_entries);
+            data->truncated = true;
+            done = true;
+        }
+        auto middle = static_cast<std::ptrdiff_t>(entries.size());
+        std::ranges::move(batch, std::back_inserter(entries));
+        std::inplace_merge(entries.begin(), entries.begin() + middle, entries.end(), compareEntries);
+        if (done) {
+            data->status = Status::Loaded;
+            LOG_I(TAG, "%s has %d entries", dirPath.c_str(), (int)entries.size());
+        }
+        data->revision++;
+        batch.clear();
+    }
+
+    FileMutexGuard guard(dirPath);
+    closedir(dir);
+}
+
+void DirectoryCache::stopLoader() {
+    // Doesn't wait for the loader: the caller might hold the file lock that it needs before it can stop
+    data->loadId++;
+}
+
+bool DirectoryCache::load(const std::string& newPath, ScandirFilter filter) {
+    // The current load continues when the directory can't be opened: it's only abandoned by the new load id below
+    DIR* dir;
+    {
+        FileMutexGuard guard(newPath);
+        dir = opendir(newPath.c_str());
+    }
+    if (dir == nullptr) {
+        LOG_E(TAG, "Failed to open dir %s", newPath.c_str());
+        return false;
+    }
+
+    uint32_t load_id;
+    {
+        auto lock = data->mutex.asScopedLock();
+        lock.lock();
+        load_id = ++data->loadId;
+        data->entries.clear();
+        data->path = newPath;
+        data->status = Status::Loading;
+        data->truncated = false;
+        data->revision++;
+        data->generation++;
+    }
+
+    getLoaderThread().dispatch([data = data, load_id, dir, newPath, filter] {
+        loaderMain(data, load_id, dir, newPath, filter);
+    });
+    return true;
+}
+
+void DirectoryCache::setEntries(const std::string& newPath, std::vector<Entry> newEntries) {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    stopLoader();
+    data->entries = std::move(newEntries);
+    data->path = newPath;
+    data->status = Status::Loaded;
+    data->truncated = false;
+    data->revision++;
+    data->generation++;
+}
+
+DirectoryCache::Status DirectoryCache::getStatus() const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    return data->status;
+}
+
+std::string DirectoryCache::getPath() const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    return data->path;
+}
+
+size_t DirectoryCache::getCount() const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    return data->entries.size();
+}
+
+bool DirectoryCache::isTruncated() const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    return data->truncated;
+}
+
+uint32_t DirectoryCache::getRevision() const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    return data->revision;
+}
+
+uint32_t DirectoryCache::getGeneration() const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    return data->generation;
+}
+
+bool DirectoryCache::getEntry(size_t index, Entry& entry) const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    if (index < data->entries.size()) {
+        entry = data->entries[index];
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool DirectoryCache::findEntry(const std::string& name, Entry& entry) const {
+    auto lock = data->mutex.asScopedLock();
+    lock.lock();
+    // Mount points that were set with setEntries() aren't sorted, so this can't be a binary search
+    auto found = std::ranges::find(data->entries, name, &Entry::name);
+    if (found != data->entries.end()) {
+        entry = *found;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool DirectoryCache::waitUntilLoaded(TickType_t timeout) const {
+    TickType_t start_ticks = kernel::getTicks();
+    while (getStatus() == Status::Loading) {
+        if (kernel::getTicks() - start_ticks > timeout) {
+            return false;
+        }
+        kernel::delayTicks(1);
+    }
+    return true;
+}
+
+}
@@ -1,4 +1,6 @@
 #include <Tactility/file/File.h>
+#include <Tactility/file/BufferedReader.h>
+#include <Tactility/file/FileCache.h>
 
 #include <cstring>
 #include <fstream>
@@ -28,16 +30,24 @@ int direntFilterDotEntries(const dirent* entry) {
     return (strcmp(entry->d_name, "..") == 0 || strcmp(entry->d_name, ".") == 0) ? -1 : 0;
 }
 
-bool direntSortAlphaAndType(const dirent& left, const dirent& right) {
-    bool left_is_dir = left.d_type == TT_DT_DIR || left.d_type == TT_DT_CHR;
-    bool right_is_dir = right.d_type == TT_DT_DIR || right.d_type == TT_DT_CHR;
+bool isDirectoryType(unsigned char type) {
+    return type == TT_DT_DIR || type == TT_DT_CHR;
+}
+
+bool compareNameAndType(const char* leftName, unsigned char leftType, const char* rightName, unsigned char rightType) {
+    bool left_is_dir = isDirectoryType(leftType);
+    bool right_is_dir = isDirectoryType(rightType);
     if (left_is_dir == right_is_dir) {
-        return strcmp(left.d_name, right.d_name) < 0;
+        return strcmp(leftName, rightName) < 0;
     } else {
         return left_is_dir > right_is_dir;
     }
 }
 
+bool direntSortAlphaAndType(const dirent& left, const dirent& right) {
+    return compareNameAndType(left.d_name, left.d_type, right.d_name, right.d_type);
+}
+
 bool listDirectory(
     const std::string& path,
     std::function<void(const dirent&)> onEntry
@@ -96,6 +106,12 @@ int scandir(
 
 
 long getSize(FILE* file) {
+    // Seeking to the end can be slow (e.g. on FAT), so only do it when the file system doesn't report the size
+    struct stat file_stat;
+    if (fstat(fileno(file), &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+        return file_stat.st_size;
+    }
+
     long original_offset = ftell(file);
 
     if (fseek(file, 0, SEEK_END) != 0) {
@@ -117,51 +133,85 @@ long getSize(FILE* file) {
     return file_size;
 }
 
+/** Read the whole file into data, which has the size of the file. The caller holds the file lock. */
+static bool readFully(const std::string& filepath, uint8_t* data, size_t size) {
+    auto file = std::unique_ptr<FILE, FileCloser>(fopen(filepath.c_str(), "rb"));
+    if (file == nullptr) {
+        LOG_E(TAG, "Failed to open %s", filepath.c_str());
+        return false;
+    }
+
+    size_t buffer_offset = 0;
+    while (buffer_offset < size) {
+        size_t bytes_read = fread(&data[buffer_offset], 1, size - buffer_offset, file.get());
+        LOG_D(TAG, "Read %u bytes", (unsigned)bytes_read);
+        if (bytes_read > 0) {
+            buffer_offset += bytes_read;
+        } else { // Something went wrong?
+            break;
+        }
+    }
+
+    return buffer_offset == size;
+}
+
+/** Read a file that is small enough for the cache. The caller holds the file lock.
+ * @param[in] filepath
+ * @param[in] fileStat the stat() of the file
+ * @return null on error
+ */
+static FileCache::Content readCacheable(const std::string& filepath, const struct stat& fileStat) {
+    auto& cache = getFileCache();
+    auto content = cache.find(filepath, fileStat);
+    if (content != nullptr) {
+        return content;
+    }
+
+    auto data = std::make_shared<std::vector<uint8_t>>(fileStat.st_size);
+    if (!readFully(filepath, data->data(), data->size())) {
+        return nullptr;
+    }
+
+    cache.put(filepath, fileStat, data);
+    return data;
+}
+
 /** Read a file.
  * @param[in] filepath
  * @param[out] outSize the amount of bytes that were read, excluding the sizePadding
  * @param[in] sizePadding optional padding to add at the end of the output data (the values are not set)
  */
 static std::unique_ptr<uint8_t[]> readBinaryInternal(const std::string& filepath, size_t& outSize, size_t sizePadding = 0) {
-    FILE* file = fopen(filepath.c_str(), "rb");
+    outSize = 0;
+    FileMutexGuard guard(filepath);
 
-    if (file == nullptr) {
+    struct stat file_stat;
+    if (stat(filepath.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
         LOG_E(TAG, "Failed to open %s", filepath.c_str());
         return nullptr;
     }
 
-    long content_length = getSize(file);
-    if (content_length == -1) {
-        LOG_E(TAG, "Failed to determine content length for %s", filepath.c_str());
-        return nullptr;
-    }
-
+    size_t content_length = file_stat.st_size;
     auto data = std::make_unique<uint8_t[]>(content_length + sizePadding);
     if (data == nullptr) {
-        LOG_E(TAG, "Insufficient memory. Failed to allocate %ld bytes.", content_length);
+        LOG_E(TAG, "Insufficient memory. Failed to allocate %u bytes.", (unsigned)content_length);
         return nullptr;
     }
 
-    size_t buffer_offset = 0;
-    while (buffer_offset < content_length) {
-        size_t bytes_read = fread(&data.get()[buffer_offset], 1, content_length - buffer_offset, file);
-        LOG_D(TAG, "Read %u bytes", (unsigned)bytes_read);
-        if (bytes_read > 0) {
-            buffer_offset += bytes_read;
-        } else { // Something went wrong?
-            break;
+    if (content_length <= getFileCache().getMaxEntrySize()) {
+        // On a miss the content is allocated twice: the cache keeps its own copy, because the caller owns the returned array.
+        // That's limited to small files, the larger ones are read straight into the returned array.
+        auto content = readCacheable(filepath, file_stat);
+        if (content == nullptr) {
+            return nullptr;
         }
-    }
-
-    fclose(file);
-
-    if (buffer_offset == content_length) {
-        outSize = buffer_offset;
-        return data;
-    } else {
-        outSize = 0;
+        std::ranges::copy(*content, data.get());
+    } else if (!readFully(filepath, data.get(), content_length)) {
         return nullptr;
     }
+
+    outSize = content_length;
+    return data;
 }
 
 std::unique_ptr<uint8_t[]> readBinary(const std::string& filepath, size_t& outSize) {
@@ -180,6 +230,7 @@ std::unique_ptr<uint8_t[]> readString(const std::string& filepath) {
 }
 
 bool writeString(const std::string& filepath, const std::string& content) {
+    FileMutexGuard guard(filepath);
     std::ofstream fileStream(filepath);
 
     if (!fileStream.is_open()) {
@@ -188,6 +239,8 @@ bool writeString(const std::string& filepath, const std::string& content) {
 
     fileStream << content;
     fileStream.close();
+    // After the write, so a concurrent read can't cache the old content again in between
+    getFileCache().invalidate(filepath);
 
     return true;
 }
@@ -311,12 +364,16 @@ bool deleteRecursively(const std::string& path) {
 
 bool deleteFile(const std::string& path) {
     FileMutexGuard guard(path);
-    return remove(path.c_str()) == 0;
+    bool removed = remove(path.c_str()) == 0;
+    getFileCache().invalidate(path);
+    return removed;
 }
 
 bool deleteDirectory(const std::string& path) {
     FileMutexGuard guard(path);
-    return rmdir(path.c_str()) == 0;
+    bool removed = rmdir(path.c_str()) == 0;
+    getFileCache().invalidate(path);
+    return removed;
 }
 
 bool isFile(const std::string& path) {
@@ -331,30 +388,45 @@ bool isDirectory(const std::string& path) {
 }
 
 bool readLines(const std::string& filePath, bool stripNewLine, std::function<void(const char* line)> callback) {
-    FileMutexGuard guard(filePath);
+    FileCache::Content content;
+    {
+        FileMutexGuard guard(filePath);
+        struct stat file_stat;
+        if (stat(filePath.c_str(), &file_stat) != 0) {
+            return false;
+        }
+        if (static_cast<size_t>(file_stat.st_size) <= getFileCache().getMaxEntrySize()) {
+            content = readCacheable(filePath, file_stat);
+            if (content == nullptr) {
+                return false;
+            }
+        }
+    }
 
-    auto* file = fopen(filePath.c_str(), "r");
-    if (file == nullptr) {
-        return false;
+    std::string line;
+    if (content != nullptr) {
+        auto begin = content->begin();
+        while (begin != content->end()) {
+            auto newline = std::find(begin, content->end(), '\n');
+            auto end = (newline != content->end() && !stripNewLine) ? newline + 1 : newline;
+            line.assign(begin, end);
+            callback(line.c_str());
+            begin = (newline != content->end()) ? newline + 1 : newline;
+        }
+        return true;
     }
 
-    char line[1024];
+    // Larger files are streamed, so the file lock is released between reads
+    BufferedReader reader(filePath);
+    if (!reader.open()) {
+        return false;
+    }
 
-    while (fgets(line, sizeof(line), file) != nullptr) {
-        // Strip newline
-        if (stripNewLine) {
-            size_t line_length = strlen(line);
-            if (line_length > 0 && line[line_length - 1] == '\n') {
-                line[line_length - 1] = '\0';
-            }
-        }
-        // Publish
-        callback(line);
+    while (reader.readLine(line, stripNewLine)) {
+        callback(line.c_str());
     }
 
-    bool success = feof(file);
-    fclose(file);
-    return success;
+    return !reader.hasError();
 }
 
 }
@@ -0,0 +1,139 @@
+#include <Tactility/file/FileCache.h>
+
+#include <iterator>
+
+namespace tt::file {
+
+FileCache& getFileCache() {
+    static FileCache cache;
+    return cache;
+}
+
+void FileCache::erase(std::list<Entry>::iterator entry) {
+    bytesCached -= entry->content->size();
+    entriesByPath.erase(entry->path);
+    entries.erase(entry);
+}
+
+void FileCache::evict(size_t maxBytes) {
+    while (bytesCached > maxBytes && !entries.empty()) {
+        erase(std::prev(entries.end()));
+    }
+}
+
+FileCache::Content FileCache::find(const std::string& path, const struct stat& fileStat) {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+
+    auto iterator = entriesByPath.find(path);
+    if (iterator == entriesByPath.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    auto entry = iterator->second;
+    if (entry->modificationTime != fileStat.st_mtime || entry->size != fileStat.st_size) {
+        erase(entry);
+        misses++;
+        return nullptr;
+    }
+
+    entries.splice(entries.begin(), entries, entry);
+    hits++;
+    bytesServed += entry->content->size();
+    return entry->content;
+}
+
+void FileCache::put(const std::string& path, const struct stat& fileStat, Content content) {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+
+    bytesRead += content->size();
+
+    auto existing = entriesByPath.find(path);
+    if (existing != entriesByPath.end()) {
+        erase(existing->second);
+    }
+
+    if (content->size() > getMaxEntrySize()) {
+        return;
+    }
+
+    evict(budget - content->size());
+    bytesCached += content->size();
+    entries.push_front({ path, fileStat.st_mtime, fileStat.st_size, std::move(content) });
+    entriesByPath[path] = entries.begin();
+}
+
+void FileCache::invalidate(const std::string& path) {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        auto current = entry++;
+        const auto& entry_path = current->path;
+        bool is_match = entry_path == path ||
+            (entry_path.size() > path.size() && entry_path.starts_with(path) && entry_path[path.size()] == '/');
+        if (is_match) {
+            erase(current);
+        }
+    }
+}
+
+void FileCache::clear() {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+    entries.clear();
+    entriesByPath.clear();
+    bytesCached = 0;
+}
+
+void FileCache::setBudget(size_t newBudget) {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+    budget = newBudget;
+    // Entries that are now too large for a budget this small are evicted first
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        auto current = entry++;
+        if (current->content->size() > getMaxEntrySize()) {
+            erase(current);
+        }
+    }
+    evict(budget);
+}
+
+size_t FileCache::getBudget() const {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+    return budget;
+}
+
+size_t FileCache::getMaxEntrySize() const {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+    return budget / 4;
+}
+
+FileCache::Stats FileCache::getStats() const {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+    return {
+        .hits = hits,
+        .misses = misses,
+        .bytesRead = bytesRead,
+        .bytesServed = bytesServed,
+        .bytesCached = bytesCached,
+        .entryCount = entries.size()
+    };
+}
+
+void FileCache::resetStats() {
+    auto lock = mutex.asScopedLock();
+    lock.lock();
+    hits = 0;
+    misses = 0;
+    bytesRead = 0;
+    bytesServed = 0;
+}
+
+}
@@ -23,6 +23,7 @@
 namespace tt::lvgl {
 
 constexpr auto* TAG = "UsbHidInput";
+constexpr auto* MEMORY_TAG = "usb_hid_input";
 
 constexpr auto HID_EVENT_QUEUE_SIZE    = 64;
 constexpr auto KEY_EVENT_QUEUE_SIZE    = 64;
@@ -288,7 +289,7 @@ void startUsbHidInput() {
     if (s_ctx != nullptr) return;
 
     static constexpr MemoryPolicy CTX_POLICY = { 0, MEMORY_CAPABILITY_EXTERNAL, 0 };
-    auto* ctx_mem = memory_alloc_with_policy(sizeof(UsbHidInputCtx), &CTX_POLICY);
+    auto* ctx_mem = memory_alloc_tagged(sizeof(UsbHidInputCtx), &CTX_POLICY, MEMORY_TAG);
     if (!ctx_mem) {
         LOG_E(TAG, "failed to allocate context");
         return;
@@ -347,10 +348,10 @@ void startUsbHidInput() {
     ctx->running = true;
 
     static constexpr MemoryPolicy STACK_POLICY = { 0, MEMORY_CAPABILITY_EXTERNAL, 0 };
-    ctx->task_stack = static_cast<StackType_t*>(memory_alloc_with_policy(TASK_STACK * sizeof(StackType_t), &STACK_POLICY));
+    ctx->task_stack = static_cast<StackType_t*>(memory_alloc_tagged(TASK_STACK * sizeof(StackType_t), &STACK_POLICY, MEMORY_TAG));
     if (ctx->task_stack != nullptr) {
         static constexpr MemoryPolicy TCB_POLICY = { MEMORY_CAPABILITY_INTERNAL, 0, 0 };
-        ctx->task_tcb = static_cast<StaticTask_t*>(memory_alloc_with_policy(sizeof(StaticTask_t), &TCB_POLICY));
+        ctx->task_tcb = static_cast<StaticTask_t*>(memory_alloc_tagged(sizeof(StaticTask_t), &TCB_POLICY, MEMORY_TAG));
     }
 
     if (ctx->task_tcb != nullptr) {
@@ -1,5 +1,6 @@
 #include <Tactility/Tactility.h>
 #include <Tactility/file/File.h>
+#include <Tactility/file/FileCache.h>
 #include <Tactility/network/Http.h>
 
 #include <tactility/log.h>
@@ -81,18 +82,21 @@ void download(
             int data_read = client->read(buffer, 512);
             if (data_read <= 0) {
                 fclose(file);
+                file::getFileCache().invalidate(downloadFilePath);
                 onError("Failed to read data");
                 return;
             }
             bytes_left -= data_read;
             if (fwrite(buffer, 1, data_read, file) != data_read) {
                 fclose(file);
+                file::getFileCache().invalidate(downloadFilePath);
                 onError("Failed to write all bytes");
                 return;
             }
             taskYIELD();
         }
         fclose(file);
+        file::getFileCache().invalidate(downloadFilePath);
         LOG_I(TAG, "Downloaded %s to %s", url.c_str(), downloadFilePath.c_str());
         onSuccess();
     });
@@ -1,5 +1,6 @@
 #include <Tactility/LogMessages.h>
 #include <Tactility/StringUtils.h>
+#include <Tactility/file/FileCache.h>
 #include <Tactility/network/HttpdReq.h>
 
 #include <tactility/filesystem/file_mutex.h>
@@ -238,6 +239,8 @@ size_t receiveFile(httpd_req_t* request, size_t length, const std::string& fileP
 
     file_mutex_lock(&mutex);
     fclose(file);
+    // After the last write, so a read during the transfer can't leave the old content cached
+    file::getFileCache().invalidate(filePath);
     file_mutex_unlock(&mutex);
     return bytes_received;
 }
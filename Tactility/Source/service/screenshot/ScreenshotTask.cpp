@@ -54,8 +54,25 @@ void ScreenshotTask::setFinished() {
 
 static void makeScreenshot(const std::string& filename) {
     if (lvgl_try_lock(50 / portTICK_PERIOD_MS)) {
-        if (lv_screenshot_create(lv_scr_act(), LV_100ASK_SCREENSHOT_SV_PNG, filename.c_str())) {
+        // Rendering and encoding a strip at a time keeps the memory use low,
+        // and the UI stays responsive while the strips are written.
+        lv_screenshot_stream_config_t config = {
+            .screenshot_sv = LV_100ASK_SCREENSHOT_SV_PNG,
+            .strip_height = 0,
+            .unlock = [](void*) { lvgl_unlock(); },
+            .lock = [](void*) { lvgl_lock(); },
+            .user_data = nullptr
+        };
+        lv_screenshot_stream_stats_t stats;
+        if (lv_screenshot_create_streaming(lv_scr_act(), filename.c_str(), &config, &stats)) {
             LOG_I(TAG, "Screenshot saved to %s", filename.c_str());
+            LOG_I(TAG, "Captured %lu bytes in %lu ms (%lu ms rendering, %lu strips) with %zu bytes of memory",
+                (unsigned long)stats.file_size,
+                (unsigned long)stats.time_ms,
+                (unsigned long)stats.render_time_ms,
+                (unsigned long)stats.strip_count,
+                stats.peak_memory
+            );
         } else {
             LOG_E(TAG, "Screenshot not saved to %s", filename.c_str());
         }
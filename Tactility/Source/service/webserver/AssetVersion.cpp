@@ -3,6 +3,7 @@
 #include <Tactility/service/webserver/AssetVersion.h>
 
 #include <Tactility/file/File.h>
+#include <Tactility/file/FileCache.h>
 
 #include <cJSON.h>
 #include <cstdio>
@@ -293,6 +294,7 @@ static bool copyDirectory(const char* src, const char* dst, int depth = 0) {
                     fileCopySuccess = false;
                     copySuccess = false;
                 }
+                file::getFileCache().invalidate(dstPath);
             } else {
                 // Clean up temp file on failure
                 remove(tempPath.c_str());
@@ -5,6 +5,7 @@
 #include <Tactility/settings/WebServerSettings.h>
 #include <Tactility/MountPoints.h>
 #include <Tactility/file/File.h>
+#include <Tactility/file/FileCache.h>
 #include <Tactility/lvgl/Statusbar.h>
 #include <Tactility/Mutex.h>
 
@@ -905,6 +906,7 @@ esp_err_t WebServerService::handleFsUpload(httpd_req_t* request) {
                 LOG_E(TAG, "Upload recv timeout after %d retries", timeout_retries);
                 fclose(fp);
                 remove(norm.c_str());  // Clean up partial file
+                file::getFileCache().invalidate(norm);
                 httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "recv timeout");
                 return ESP_FAIL;
             }
@@ -916,6 +918,7 @@ esp_err_t WebServerService::handleFsUpload(httpd_req_t* request) {
             LOG_E(TAG, "Upload recv failed with error %d", ret);
             fclose(fp);
             remove(norm.c_str());  // Clean up partial file
+            file::getFileCache().invalidate(norm);
             httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "recv failed");
             return ESP_FAIL;
         }
@@ -925,13 +928,18 @@ esp_err_t WebServerService::handleFsUpload(httpd_req_t* request) {
         if (written != (size_t)ret) {
             fclose(fp);
             remove(norm.c_str());
+            file::getFileCache().invalidate(norm);
             httpd_resp_send_err(request, HTTPD_500_INTERNAL_SERVER_ERROR, "write failed");
             return ESP_FAIL;
         }
         remaining -= ret;
         received += ret;
     }
-    fclose(fp);
+    {
+        file::FileMutexGuard guard(norm);
+        fclose(fp);
+        file::getFileCache().invalidate(norm);
+    }
     httpd_resp_set_type(request, "text/plain");
     std::string msg = std::string("Uploaded ") + std::to_string(received) + " bytes";
     httpd_resp_sendstr(request, msg.c_str());
@@ -1655,7 +1663,12 @@ esp_err_t WebServerService::handleFsRename(httpd_req_t* request) {
     }
 
     // perform rename
-    int r = rename(norm.c_str(), target.c_str());
+    int r;
+    {
+        file::FileMutexGuard guard(norm);
+        r = rename(norm.c_str(), target.c_str());
+        file::getFileCache().invalidate(norm);
+    }
     if (r != 0) {
         int e = errno;
         LOG_W(TAG, "rename failed errno=%d (%s) -> %s -> %s", e, strerror(e), norm.c_str(), target.c_str());
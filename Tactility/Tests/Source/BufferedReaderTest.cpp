@@ -0,0 +1,131 @@
+#include "doctest.h"
+#include <Tactility/file/BufferedReader.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using tt::file::BufferedReader;
+
+constexpr auto* TEST_FILE = "/tmp/buffered_reader_test.bin";
+
+static std::vector<uint8_t> createTestFile(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<uint8_t>((i * 31) ^ (i >> 8));
+    }
+    FILE* file = fopen(TEST_FILE, "wb");
+    REQUIRE(file != nullptr);
+    CHECK_EQ(fwrite(data.data(), 1, data.size(), file), data.size());
+    fclose(file);
+    return data;
+}
+
+static void createTestFile(const std::string& content) {
+    FILE* file = fopen(TEST_FILE, "wb");
+    REQUIRE(file != nullptr);
+    CHECK_EQ(fwrite(content.data(), 1, content.size(), file), content.size());
+    fclose(file);
+}
+
+TEST_CASE("BufferedReader reads across buffer boundaries") {
+    auto data = createTestFile(1000);
+
+    BufferedReader reader(TEST_FILE, { .bufferSize = 64, .readAhead = true });
+    REQUIRE(reader.open());
+    CHECK_EQ(reader.getSize(), 1000);
+
+    std::vector<uint8_t> output(data.size());
+    size_t offset = 0;
+    size_t chunk_size = 1;
+    while (offset < output.size()) {
+        size_t bytes_read = reader.read(output.data() + offset, std::min(chunk_size, output.size() - offset));
+        REQUIRE(bytes_read > 0);
+        offset += bytes_read;
+        // Includes reads that are larger than the buffer
+        chunk_size = (chunk_size * 7) % 150 + 1;
+    }
+    CHECK_EQ(output, data);
+    CHECK_EQ(reader.tell(), 1000);
+
+    uint8_t byte;
+    CHECK_EQ(reader.read(&byte, 1), 0);
+    CHECK(reader.isEndOfFile());
+    CHECK_FALSE(reader.hasError());
+    CHECK_EQ(reader.getBytesRead(), 1000);
+
+    remove(TEST_FILE);
+}
+
+TEST_CASE("BufferedReader reads lines") {
+    createTestFile("first\nsecond line\n\nlast");
+
+    BufferedReader reader(TEST_FILE, { .bufferSize = 4, .readAhead = true });
+    REQUIRE(reader.open());
+
+    std::string line;
+    CHECK(reader.readLine(line, true));
+    CHECK_EQ(line, "first");
+    CHECK(reader.readLine(line, false));
+    CHECK_EQ(line, "second line\n");
+    CHECK(reader.readLine(line, true));
+    CHECK_EQ(line, "");
+    CHECK(reader.readLine(line, true));
+    CHECK_EQ(line, "last");
+    CHECK_FALSE(reader.readLine(line, true));
+
+    remove(TEST_FILE);
+}
+
+TEST_CASE("BufferedReader seeks within and outside of the buffer") {
+    auto data = createTestFile(256);
+
+    BufferedReader reader(TEST_FILE, { .bufferSize = 32, .readAhead = true });
+    REQUIRE(reader.open());
+
+    uint8_t byte;
+    CHECK_EQ(reader.read(&byte, 1), 1);
+    CHECK_EQ(reader.getFileReadCount(), 1);
+
+    // Within the buffer: no file system access
+    CHECK(reader.seek(20));
+    CHECK_EQ(reader.read(&byte, 1), 1);
+    CHECK_EQ(byte, data[20]);
+    CHECK_EQ(reader.getFileReadCount(), 1);
+
+    CHECK(reader.seek(200));
+    CHECK_EQ(reader.read(&byte, 1), 1);
+    CHECK_EQ(byte, data[200]);
+    CHECK_EQ(reader.tell(), 201);
+
+    CHECK(reader.seek(3));
+    CHECK_EQ(reader.read(&byte, 1), 1);
+    CHECK_EQ(byte, data[3]);
+
+    remove(TEST_FILE);
+}
+
+TEST_CASE("BufferedReader without read-ahead only reads what is asked for") {
+    createTestFile(1024);
+
+    BufferedReader reader(TEST_FILE, { .bufferSize = 512, .readAhead = false });
+    REQUIRE(reader.open());
+
+    uint8_t bytes[16];
+    CHECK(reader.seek(100));
+    CHECK_EQ(reader.read(bytes, sizeof(bytes)), sizeof(bytes));
+    CHECK(reader.seek(900));
+    CHECK_EQ(reader.read(bytes, sizeof(bytes)), sizeof(bytes));
+    CHECK_EQ(reader.getFileReadCount(), 2);
+    CHECK_EQ(reader.getBytesRead(), 2 * sizeof(bytes));
+
+    remove(TEST_FILE);
+}
+
+TEST_CASE("BufferedReader fails to open a missing file") {
+    BufferedReader reader("/tmp/buffered_reader_test_missing.bin");
+    CHECK_FALSE(reader.open());
+    CHECK_FALSE(reader.isOpen());
+    uint8_t byte;
+    CHECK_EQ(reader.read(&byte, 1), 0);
+}
@@ -0,0 +1,102 @@
+#include "doctest.h"
+#include <Tactility/app/chat/ChatState.h>
+#include <Tactility/file/File.h>
+
+#include <string>
+#include <vector>
+
+using namespace tt::app::chat;
+
+static StoredMessage createMessage(const std::string& target, int number) {
+    return { .displayText = target + " " + std::to_string(number), .target = target, .isOwn = false };
+}
+
+static std::vector<std::string> getTexts(const std::vector<StoredMessage>& messages) {
+    std::vector<std::string> texts;
+    for (const auto& message : messages) {
+        texts.push_back(message.displayText);
+    }
+    return texts;
+}
+
+TEST_CASE("ChatState merges the current channel with broadcasts, in order") {
+    ChatState state;
+    state.setCurrentChannel("#general");
+    state.addMessage(createMessage("#general", 1));
+    state.addMessage(createMessage("", 2));
+    state.addMessage(createMessage("#other", 3));
+    state.addMessage(createMessage("#general", 4));
+    state.addMessage(createMessage("", 5));
+
+    std::vector<StoredMessage> messages;
+    uint32_t sequence = state.getMessagesSince(0, messages);
+    CHECK_EQ(sequence, 5);
+    CHECK_EQ(getTexts(messages), std::vector<std::string> { "#general 1", " 2", "#general 4", " 5" });
+
+    // Only the messages after the previous call
+    state.addMessage(createMessage("#other", 6));
+    state.addMessage(createMessage("#general", 7));
+    messages.clear();
+    sequence = state.getMessagesSince(sequence, messages);
+    CHECK_EQ(sequence, 7);
+    CHECK_EQ(getTexts(messages), std::vector<std::string> { "#general 7" });
+
+    state.setCurrentChannel("#other");
+    messages.clear();
+    state.getMessagesSince(0, messages);
+    CHECK_EQ(getTexts(messages), std::vector<std::string> { " 2", "#other 3", " 5", "#other 6" });
+}
+
+TEST_CASE("ChatState evicts the oldest messages from the ring buffer") {
+    ChatState state;
+    state.setCurrentChannel("#a");
+    // Every third message is for #b, which is evicted like the others
+    for (int i = 1; i <= static_cast<int>(MAX_MESSAGES) + 50; i++) {
+        state.addMessage(createMessage((i % 3 == 0) ? "#b" : "#a", i));
+    }
+
+    std::vector<StoredMessage> messages;
+    state.getMessagesSince(0, messages);
+    REQUIRE_FALSE(messages.empty());
+    // Messages 1 to 50 were evicted
+    CHECK_EQ(messages.front().displayText, "#a 52");
+    CHECK_EQ(messages.back().displayText, "#a 149");
+    for (const auto& message : messages) {
+        CHECK_EQ(message.target, "#a");
+    }
+
+    state.setCurrentChannel("#b");
+    messages.clear();
+    state.getMessagesSince(0, messages);
+    // 51, 54, ..., 150
+    CHECK_EQ(messages.size(), 34);
+    CHECK_EQ(messages.front().displayText, "#b 51");
+    CHECK_EQ(messages.back().displayText, "#b 150");
+}
+
+TEST_CASE("ChatState keeps and compacts its history") {
+    constexpr auto* path = "/tmp/chat_state_test/history.log";
+    tt::file::deleteRecursively("/tmp/chat_state_test");
+
+    {
+        ChatState state;
+        state.enableHistory(path);
+        for (int i = 1; i <= static_cast<int>(MAX_HISTORY_LINES) + 10; i++) {
+            state.addMessage(createMessage("", i));
+        }
+    }
+
+    size_t line_count = 0;
+    CHECK(tt::file::readLines(path, true, [&line_count](const char*) { line_count++; }));
+    CHECK_LE(line_count, MAX_HISTORY_LINES);
+
+    ChatState state;
+    state.setCurrentChannel("#general");
+    state.enableHistory(path);
+    std::vector<StoredMessage> messages;
+    state.getMessagesSince(0, messages);
+    REQUIRE_EQ(messages.size(), MAX_MESSAGES);
+    CHECK_EQ(messages.back().displayText, " " + std::to_string(MAX_HISTORY_LINES + 10));
+
+    tt::file::deleteRecursively("/tmp/chat_state_test");
+}
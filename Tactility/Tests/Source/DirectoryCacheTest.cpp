@@ -0,0 +1,197 @@
+#include "doctest.h"
+#include <Tactility/file/DirectoryCache.h>
+#include <Tactility/RecursiveMutex.h>
+
+#include <cstdio>
+#include <cstring>
+#include <format>
+
+using tt::file::DirectoryCache;
+
+constexpr auto* TEST_DIRECTORY = "/tmp/directory_cache_test";
+constexpr TickType_t LOAD_TIMEOUT = 5000 / portTICK_PERIOD_MS;
+
+/** Creates a directory with files named "file-<n>" and directories named "dir-<n>" */
+static void createTestDirectory(int fileCount, int directoryCount, const char* directory = TEST_DIRECTORY) {
+    tt::file::deleteRecursively(directory);
+    CHECK_EQ(tt::file::findOrCreateDirectory(directory, 0777), true);
+    // Not created in order, so the entries aren't already sorted
+    for (int i = fileCount - 1; i >= 0; i--) {
+        auto path = std::format("{}/file-{:05}", directory, i);
+        FILE* file = fopen(path.c_str(), "w");
+        REQUIRE(file != nullptr);
+        fclose(file);
+    }
+    for (int i = directoryCount - 1; i >= 0; i--) {
+        CHECK_EQ(tt::file::findOrCreateDirectory(std::format("{}/dir-{:05}", directory, i), 0777), true);
+    }
+}
+
+TEST_CASE("DirectoryCache lists a large directory sorted, with directories first") {
+    createTestDirectory(2000, 20);
+
+    DirectoryCache cache;
+    uint32_t generation = cache.getGeneration();
+    CHECK_EQ(cache.load(TEST_DIRECTORY), true);
+    CHECK_NE(cache.getGeneration(), generation);
+    generation = cache.getGeneration();
+    CHECK_EQ(cache.waitUntilLoaded(LOAD_TIMEOUT), true);
+    CHECK_EQ(cache.getStatus(), DirectoryCache::Status::Loaded);
+    CHECK_EQ(cache.getCount(), 2020);
+    // Entries that arrive while loading don't start a new generation
+    CHECK_EQ(cache.getGeneration(), generation);
+    CHECK_EQ(cache.isTruncated(), false);
+
+    DirectoryCache::Entry entry;
+    CHECK_EQ(cache.getEntry(0, entry), true);
+    CHECK_EQ(entry.name, "dir-00000");
+    CHECK_EQ(entry.type, tt::file::TT_DT_DIR);
+    CHECK_EQ(cache.getEntry(20, entry), true);
+    CHECK_EQ(entry.name, "file-00000");
+    CHECK_EQ(cache.getEntry(2019, entry), true);
+    CHECK_EQ(entry.name, "file-01999");
+    CHECK_EQ(cache.getEntry(2020, entry), false);
+
+    DirectoryCache::Entry previous;
+    cache.getEntry(0, previous);
+    for (size_t i = 1; i < cache.getCount(); i++) {
+        cache.getEntry(i, entry);
+        CHECK(DirectoryCache::compareEntries(previous, entry));
+        previous = entry;
+    }
+
+    tt::file::deleteRecursively(TEST_DIRECTORY);
+}
+
+TEST_CASE("DirectoryCache limits the number of entries") {
+    createTestDirectory(300, 0);
+
+    DirectoryCache cache(100);
+    CHECK_EQ(cache.load(TEST_DIRECTORY), true);
+    CHECK_EQ(cache.waitUntilLoaded(LOAD_TIMEOUT), true);
+    CHECK_EQ(cache.getCount(), 100);
+    CHECK_EQ(cache.isTruncated(), true);
+
+    tt::file::deleteRecursively(TEST_DIRECTORY);
+}
+
+TEST_CASE("DirectoryCache can switch directories while loading") {
+    createTestDirectory(1000, 0);
+
+    DirectoryCache cache;
+    uint32_t revision = cache.getRevision();
+    CHECK_EQ(cache.load(TEST_DIRECTORY), true);
+    CHECK_NE(cache.getRevision(), revision);
+    // Abandons the first load
+    CHECK_EQ(cache.load("/tmp"), true);
+    CHECK_EQ(cache.waitUntilLoaded(LOAD_TIMEOUT), true);
+    CHECK_EQ(cache.getPath(), "/tmp");
+
+    DirectoryCache::Entry entry;
+    bool has_test_directory = false;
+    for (size_t i = 0; cache.getEntry(i, entry); i++) {
+        has_test_directory |= (entry.name == "directory_cache_test");
+    }
+    CHECK_EQ(has_test_directory, true);
+
+    tt::file::deleteRecursively(TEST_DIRECTORY);
+}
+
+TEST_CASE("DirectoryCache keeps its entries when a directory can't be opened") {
+    DirectoryCache cache;
+    cache.setEntries("/", { { "data", tt::file::TT_DT_DIR } });
+    CHECK_EQ(cache.load("/tmp/directory_cache_test_missing"), false);
+    CHECK_EQ(cache.getPath(), "/");
+    CHECK_EQ(cache.getCount(), 1);
+
+    // A directory that is still being read is finished as well
+    createTestDirectory(1000, 0);
+    CHECK_EQ(cache.load(TEST_DIRECTORY), true);
+    CHECK_EQ(cache.load("/tmp/directory_cache_test_missing"), false);
+    CHECK_EQ(cache.waitUntilLoaded(LOAD_TIMEOUT), true);
+    CHECK_EQ(cache.getStatus(), DirectoryCache::Status::Loaded);
+    CHECK_EQ(cache.getPath(), TEST_DIRECTORY);
+    CHECK_EQ(cache.getCount(), 1000);
+
+    tt::file::deleteRecursively(TEST_DIRECTORY);
+}
+
+TEST_CASE("DirectoryCache finds entries by name, also when they aren't sorted") {
+    DirectoryCache cache;
+    cache.setEntries("/", { { "sdcard", tt::file::TT_DT_DIR }, { "data", tt::file::TT_DT_DIR } });
+
+    DirectoryCache::Entry entry;
+    CHECK_EQ(cache.findEntry("data", entry), true);
+    CHECK_EQ(entry.name, "data");
+    CHECK_EQ(entry.type, tt::file::TT_DT_DIR);
+    CHECK_EQ(cache.findEntry("system", entry), false);
+}
+
+TEST_CASE("DirectoryCache sorts entries like direntSortAlphaAndType()") {
+    dirent left = {};
+    dirent right = {};
+    for (auto left_type : { tt::file::TT_DT_DIR, tt::file::TT_DT_CHR, tt::file::TT_DT_REG, tt::file::TT_DT_LNK }) {
+        for (auto right_type : { tt::file::TT_DT_DIR, tt::file::TT_DT_CHR, tt::file::TT_DT_REG, tt::file::TT_DT_LNK }) {
+            for (auto [left_name, right_name] : { std::pair { "a", "b" }, std::pair { "b", "a" }, std::pair { "a", "a" } }) {
+                left.d_type = left_type;
+                right.d_type = right_type;
+                strcpy(left.d_name, left_name);
+                strcpy(right.d_name, right_name);
+                DirectoryCache::Entry left_entry = { left_name, static_cast<uint8_t>(left_type) };
+                DirectoryCache::Entry right_entry = { right_name, static_cast<uint8_t>(right_type) };
+                CHECK_EQ(DirectoryCache::compareEntries(left_entry, right_entry), tt::file::direntSortAlphaAndType(left, right));
+            }
+        }
+    }
+}
+
+// region Blocking file system lock
+
+/**
+ * The file lock of this directory is held by the test, like the LVGL lock that guards SD cards
+ * is held by the LVGL event callbacks that call DirectoryCache::load().
+ */
+constexpr auto* LOCKED_DIRECTORY = "/tmp/directory_cache_locked";
+
+static tt::RecursiveMutex lockedDirectoryMutex;
+
+static void registerLockedFileSystem() {
+    static const FileMutex locked_mutex = {
+        .lock = [] { lockedDirectoryMutex.lock(); },
+        .try_lock = nullptr,
+        .unlock = [] { lockedDirectoryMutex.unlock(); }
+    };
+    file_mutex_register(&locked_mutex, LOCKED_DIRECTORY);
+}
+
+// endregion
+
+TEST_CASE("DirectoryCache doesn't wait for its loader while the caller holds the file lock") {
+    registerLockedFileSystem();
+    createTestDirectory(1000, 0, LOCKED_DIRECTORY);
+
+    lockedDirectoryMutex.lock();
+    {
+        DirectoryCache cache;
+        CHECK_EQ(cache.load(LOCKED_DIRECTORY), true);
+        // The loader can't read the directory until the lock is released
+        tt::kernel::delayMillis(20);
+        CHECK_EQ(cache.getStatus(), DirectoryCache::Status::Loading);
+        CHECK_EQ(cache.getCount(), 0);
+
+        // Each of these abandons the loader that is waiting for the lock
+        CHECK_EQ(cache.load(LOCKED_DIRECTORY), true);
+        cache.setEntries("/", { { "data", tt::file::TT_DT_DIR } });
+        CHECK_EQ(cache.getStatus(), DirectoryCache::Status::Loaded);
+        CHECK_EQ(cache.load(LOCKED_DIRECTORY), true);
+    } // Destroyed while its loader is still waiting
+    lockedDirectoryMutex.unlock();
+
+    // The abandoned loaders stopped, so a new load gets its turn
+    DirectoryCache cache;
+    CHECK_EQ(cache.load(LOCKED_DIRECTORY), true);
+    CHECK_EQ(cache.waitUntilLoaded(LOAD_TIMEOUT), true);
+    CHECK_EQ(cache.getCount(), 1000);
+
+    tt::file::deleteRecursively(LOCKED_DIRECTORY);
+}
@@ -0,0 +1,236 @@
+#include "doctest.h"
+#include <Tactility/file/BufferedReader.h>
+#include <Tactility/file/File.h>
+#include <Tactility/file/FileCache.h>
+
+#include <tactility/filesystem/file_mutex.h>
+#include <tactility/time.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace tt;
+using file::FileCache;
+
+static FileCache::Content createContent(const std::string& text) {
+    return std::make_shared<std::vector<uint8_t>>(text.begin(), text.end());
+}
+
+static struct stat createStat(time_t modificationTime, off_t size) {
+    struct stat file_stat {};
+    file_stat.st_mtime = modificationTime;
+    file_stat.st_size = size;
+    return file_stat;
+}
+
+TEST_CASE("FileCache returns content until the file changes") {
+    FileCache cache(1024);
+    auto file_stat = createStat(1000, 5);
+    CHECK_EQ(cache.find("/data/a", file_stat), nullptr);
+
+    cache.put("/data/a", file_stat, createContent("hello"));
+    auto content = cache.find("/data/a", file_stat);
+    REQUIRE(content != nullptr);
+    CHECK_EQ(std::string(content->begin(), content->end()), "hello");
+
+    // Changed modification time
+    CHECK_EQ(cache.find("/data/a", createStat(1001, 5)), nullptr);
+    CHECK_EQ(cache.getStats().entryCount, 0);
+
+    auto stats = cache.getStats();
+    CHECK_EQ(stats.hits, 1);
+    CHECK_EQ(stats.misses, 2);
+    CHECK_EQ(stats.bytesRead, 5);
+    CHECK_EQ(stats.bytesServed, 5);
+    CHECK_EQ(stats.getHitRate(), 33);
+}
+
+TEST_CASE("FileCache evicts the least recently used entries") {
+    FileCache cache(400);
+    auto file_stat = createStat(1000, 100);
+    std::string text(100, 'x');
+    cache.put("/data/a", file_stat, createContent(text));
+    cache.put("/data/b", file_stat, createContent(text));
+    cache.put("/data/c", file_stat, createContent(text));
+    CHECK(cache.find("/data/a", file_stat) != nullptr);
+    cache.put("/data/d", file_stat, createContent(text));
+    cache.put("/data/e", file_stat, createContent(text));
+
+    // b was used least recently
+    CHECK_EQ(cache.find("/data/b", file_stat), nullptr);
+    CHECK(cache.find("/data/a", file_stat) != nullptr);
+    CHECK(cache.find("/data/e", file_stat) != nullptr);
+    CHECK_EQ(cache.getStats().bytesCached, 400);
+
+    // Larger than a quarter of the budget
+    cache.put("/data/large", createStat(1000, 101), createContent(std::string(101, 'x')));
+    CHECK_EQ(cache.find("/data/large", createStat(1000, 101)), nullptr);
+
+    cache.setBudget(200);
+    CHECK_EQ(cache.getStats().entryCount, 0);
+}
+
+TEST_CASE("FileCache invalidates files and directories") {
+    FileCache cache(1024);
+    auto file_stat = createStat(1000, 1);
+    cache.put("/data/dir/a", file_stat, createContent("a"));
+    cache.put("/data/dir/b", file_stat, createContent("b"));
+    cache.put("/data/directory", file_stat, createContent("c"));
+
+    cache.invalidate("/data/dir/a");
+    CHECK_EQ(cache.find("/data/dir/a", file_stat), nullptr);
+    CHECK(cache.find("/data/dir/b", file_stat) != nullptr);
+
+    cache.invalidate("/data/dir");
+    CHECK_EQ(cache.find("/data/dir/b", file_stat), nullptr);
+    CHECK(cache.find("/data/directory", file_stat) != nullptr);
+}
+
+TEST_CASE("readString is served from the cache until the file is written") {
+    constexpr auto* path = "/tmp/file_cache_test.txt";
+    file::getFileCache().clear();
+    file::getFileCache().resetStats();
+
+    CHECK(file::writeString(path, "first"));
+    auto data = file::readString(path);
+    REQUIRE(data != nullptr);
+    CHECK_EQ(std::string(reinterpret_cast<char*>(data.get())), "first");
+    data = file::readString(path);
+    REQUIRE(data != nullptr);
+    CHECK_EQ(std::string(reinterpret_cast<char*>(data.get())), "first");
+    CHECK_EQ(file::getFileCache().getStats().hits, 1);
+
+    // Same size, and likely the same modification time: writeString() invalidates the entry
+    CHECK(file::writeString(path, "other"));
+    data = file::readString(path);
+    REQUIRE(data != nullptr);
+    CHECK_EQ(std::string(reinterpret_cast<char*>(data.get())), "other");
+
+    std::vector<std::string> lines;
+    CHECK(file::writeString(path, "one\ntwo\n"));
+    CHECK(file::readLines(path, true, [&lines](const char* line) { lines.push_back(line); }));
+    CHECK_EQ(lines, std::vector<std::string> { "one", "two" });
+
+    CHECK(file::deleteFile(path));
+    CHECK_EQ(file::readString(path), nullptr);
+}
+
+// region Simulated slow file system
+
+/**
+ * The file lock of the paths below simulates an SD card on a shared SPI bus:
+ * each access has a fixed latency, and everything that happens while holding the lock is slower.
+ */
+constexpr auto* SLOW_DIRECTORY = "/tmp/file_cache_slow";
+constexpr uint64_t SLOW_ACCESS_LATENCY_US = 100;
+constexpr uint64_t SLOW_DOWN_FACTOR = 50;
+
+static uint64_t slowLockTime = 0;
+static uint32_t slowAccessCount = 0;
+
+static void slowLock() {
+    slowAccessCount++;
+    slowLockTime = get_micros_since_boot();
+}
+
+static void slowUnlock() {
+    uint64_t held_time = get_micros_since_boot() - slowLockTime;
+    usleep(SLOW_ACCESS_LATENCY_US + held_time * (SLOW_DOWN_FACTOR - 1));
+}
+
+static void registerSlowFileSystem() {
+    static const FileMutex slow_mutex = {
+        .lock = slowLock,
+        .try_lock = nullptr,
+        .unlock = slowUnlock
+    };
+    file_mutex_register(&slow_mutex, SLOW_DIRECTORY);
+    CHECK(file::findOrCreateDirectory(SLOW_DIRECTORY, 0777));
+}
+
+// endregion
+
+TEST_CASE("FileCache benchmark on a simulated slow file system") {
+    registerSlowFileSystem();
+    constexpr int FILE_COUNT = 8;
+    constexpr int ITERATIONS = 20;
+    std::vector<std::string> paths;
+    for (int i = 0; i < FILE_COUNT; i++) {
+        auto path = file::getChildPath(SLOW_DIRECTORY, "strings" + std::to_string(i) + ".txt");
+        CHECK(file::writeString(path, std::string(1000, 'a' + i)));
+        paths.push_back(path);
+    }
+
+    auto& cache = file::getFileCache();
+    size_t original_budget = cache.getBudget();
+
+    auto measure = [&](size_t budget) {
+        cache.clear();
+        cache.setBudget(budget);
+        cache.resetStats();
+        uint64_t start = get_micros_since_boot();
+        for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+            for (const auto& path : paths) {
+                auto data = file::readString(path);
+                CHECK(data != nullptr);
+            }
+        }
+        return get_micros_since_boot() - start;
+    };
+
+    uint64_t uncached_us = measure(0);
+    uint64_t cached_us = measure(FileCache::DEFAULT_BUDGET * 2);
+    auto stats = cache.getStats();
+    CHECK_EQ(stats.misses, FILE_COUNT);
+    CHECK_EQ(stats.hits, FILE_COUNT * (ITERATIONS - 1));
+    CHECK_EQ(stats.bytesRead, FILE_COUNT * 1000);
+
+    cache.setBudget(original_budget);
+    cache.clear();
+
+    MESSAGE("readString without cache: " << uncached_us / (FILE_COUNT * ITERATIONS) << " us per file");
+    MESSAGE("readString with cache: " << cached_us / (FILE_COUNT * ITERATIONS) << " us per file, hit rate " << stats.getHitRate() << "%");
+
+    CHECK(file::deleteRecursively(SLOW_DIRECTORY));
+}
+
+TEST_CASE("BufferedReader benchmark on a simulated slow file system") {
+    registerSlowFileSystem();
+    auto path = file::getChildPath(SLOW_DIRECTORY, "lines.txt");
+    std::string content;
+    for (int i = 0; i < 2000; i++) {
+        content += "key" + std::to_string(i) + "=value\n";
+    }
+    CHECK(file::writeString(path, content));
+
+    auto measure = [&](size_t bufferSize, uint32_t& accessCount) {
+        file::BufferedReader reader(path, { .bufferSize = bufferSize, .readAhead = true });
+        slowAccessCount = 0;
+        uint64_t start = get_micros_since_boot();
+        REQUIRE(reader.open());
+        std::string line;
+        size_t line_count = 0;
+        while (reader.readLine(line, true)) {
+            line_count++;
+        }
+        reader.close();
+        CHECK_EQ(line_count, 2000);
+        accessCount = slowAccessCount;
+        return get_micros_since_boot() - start;
+    };
+
+    uint32_t small_access_count;
+    uint32_t large_access_count;
+    // 128 bytes is the default stdio buffer on ESP-IDF
+    uint64_t small_us = measure(128, small_access_count);
+    uint64_t large_us = measure(4096, large_access_count);
+    CHECK_LT(large_access_count, small_access_count);
+
+    MESSAGE("readLine, 128 byte buffer: " << small_us << " us, " << small_access_count << " file system accesses");
+    MESSAGE("readLine, 4096 byte buffer: " << large_us << " us, " << large_access_count << " file system accesses");
+
+    CHECK(file::deleteRecursively(SLOW_DIRECTORY));
+}
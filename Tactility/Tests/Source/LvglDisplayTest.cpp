@@ -0,0 +1,363 @@
+#include "doctest.h"
+
+#include <lvgl.h>
+#include <lvgl/devices/display.h>
+
+#include <tactility/device.h>
+#include <tactility/driver.h>
+#include <tactility/drivers/display.h>
+#include <tactility/freertos/task.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr uint16_t DISPLAY_WIDTH = 100;
+constexpr uint16_t DISPLAY_HEIGHT = 100;
+constexpr uint16_t BUFFER_HEIGHT = 10;
+constexpr uint32_t BYTES_PER_PIXEL = 2;
+constexpr uint32_t TILE_COUNT = DISPLAY_HEIGHT / BUFFER_HEIGHT;
+constexpr TickType_t DMA_WAIT_TIMEOUT = pdMS_TO_TICKS(1000);
+
+// region Mock display
+
+struct Transfer {
+    // Exclusive end, like DisplayApi::draw_bitmap()
+    int32_t x_start;
+    int32_t y_start;
+    int32_t x_end;
+    int32_t y_end;
+    const void* color_data;
+};
+
+/**
+ * An RGB565 display with an optional asynchronous draw. An async transfer is finished by a separate task (the "DMA"),
+ * but only once the LVGL task is blocked: like a DMA transfer that is still busy while LVGL renders the next tile,
+ * after which LVGL has to wait for it in the bridge's flush wait callback.
+ */
+struct MockDisplay {
+    Device* device = nullptr;
+    std::vector<Transfer> transfers;
+    std::atomic<DisplayDrawDoneCallback> pending_callback = nullptr;
+    std::atomic<void*> pending_context = nullptr;
+    // The task that renders and flushes, which the DMA task waits for to block
+    TaskHandle_t lvgl_task = nullptr;
+    TaskHandle_t dma_task = nullptr;
+    std::atomic<bool> dma_stop_requested = false;
+    std::atomic<bool> dma_stopped = false;
+    // Set while the test itself waits for the last transfer of a frame, which LVGL doesn't wait for
+    std::atomic<bool> draining = false;
+    std::atomic<uint32_t> started_count = 0;
+    // Transfers whose done callback returned
+    std::atomic<uint32_t> finished_count = 0;
+    // Transfers that were still busy when LVGL had rendered the next tile and had to wait for them
+    std::atomic<uint32_t> overlapped_count = 0;
+    // Draws that were started while another one was still busy
+    uint32_t busy_draw_count = 0;
+};
+
+MockDisplay mock;
+
+const char* compatible[] = { "lvgl_display_test", nullptr };
+
+error_t mockDrawBitmap(Device*, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data) {
+    mock.transfers.push_back({ x_start, y_start, x_end, y_end, color_data });
+    return ERROR_NONE;
+}
+
+error_t mockDrawBitmapAsync(Device* device, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data, DisplayDrawDoneCallback on_done, void* context) {
+    if (mock.pending_callback.load() != nullptr) {
+        mock.busy_draw_count++;
+        return ERROR_RESOURCE_BUSY;
+    }
+    mockDrawBitmap(device, x_start, y_start, x_end, y_end, color_data);
+    mock.pending_context = context;
+    mock.pending_callback = on_done;
+    mock.started_count++;
+    xTaskNotifyGive(mock.dma_task);
+    return ERROR_NONE;
+}
+
+/** A task that is blocked on a semaphore without a timeout is in the suspended list */
+bool isLvglTaskBlocked() {
+    eTaskState state = eTaskGetState(mock.lvgl_task);
+    return state == eBlocked || state == eSuspended;
+}
+
+/** Simulates the transfer-done interrupt of every transfer, once the LVGL task waits for it */
+void mockDmaTask(void*) {
+    while (!mock.dma_stop_requested) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        auto callback = mock.pending_callback.load();
+        if (callback == nullptr) {
+            continue;
+        }
+        // A LVGL task that spins instead of blocking would never let the transfer finish: give up after a while
+        TickType_t start_ticks = xTaskGetTickCount();
+        bool is_blocked = isLvglTaskBlocked();
+        while (!is_blocked && xTaskGetTickCount() - start_ticks < DMA_WAIT_TIMEOUT) {
+            vTaskDelay(1);
+            is_blocked = isLvglTaskBlocked();
+        }
+        if (is_blocked && !mock.draining) {
+            mock.overlapped_count++;
+        }
+        mock.pending_callback = nullptr;
+        callback(mock.device, mock.pending_context);
+        mock.finished_count++;
+    }
+    mock.dma_stopped = true;
+    vTaskDelete(nullptr);
+}
+
+void resetMock() {
+    mock.device = nullptr;
+    mock.transfers.clear();
+    mock.pending_callback = nullptr;
+    mock.pending_context = nullptr;
+    mock.lvgl_task = nullptr;
+    mock.dma_task = nullptr;
+    mock.dma_stop_requested = false;
+    mock.dma_stopped = false;
+    mock.draining = false;
+    mock.started_count = 0;
+    mock.finished_count = 0;
+    mock.overlapped_count = 0;
+    mock.busy_draw_count = 0;
+}
+
+/** Waits until the last transfer is done: LVGL doesn't wait for it at the end of a refresh */
+void waitForTransfer() {
+    mock.draining = true;
+    while (mock.finished_count != mock.started_count) {
+        vTaskDelay(1);
+    }
+    mock.draining = false;
+}
+
+DisplayColorFormat mockGetColorFormat(Device*) {
+    return DISPLAY_COLOR_FORMAT_RGB565;
+}
+
+uint16_t mockGetResolutionX(Device*) {
+    return DISPLAY_WIDTH;
+}
+
+uint16_t mockGetResolutionY(Device*) {
+    return DISPLAY_HEIGHT;
+}
+
+uint8_t mockGetFrameBufferCount(Device*) {
+    return 0;
+}
+
+DisplayApi createApi(bool async) {
+    return {
+        .capabilities = async ? (uint32_t)DISPLAY_CAPABILITY_ASYNC_DRAW : 0U,
+        .reset = nullptr,
+        .init = nullptr,
+        .draw_bitmap = mockDrawBitmap,
+        .mirror = nullptr,
+        .swap_xy = nullptr,
+        .get_swap_xy = nullptr,
+        .get_mirror_x = nullptr,
+        .get_mirror_y = nullptr,
+        .set_gap = nullptr,
+        .get_gap_x = nullptr,
+        .get_gap_y = nullptr,
+        .invert_color = nullptr,
+        .disp_on_off = nullptr,
+        .disp_sleep = nullptr,
+        .get_color_format = mockGetColorFormat,
+        .get_resolution_x = mockGetResolutionX,
+        .get_resolution_y = mockGetResolutionY,
+        .get_frame_buffer = nullptr,
+        .get_frame_buffer_count = mockGetFrameBufferCount,
+        .get_backlight = nullptr,
+        .has_capability = nullptr,
+        .draw_bitmap_async = async ? mockDrawBitmapAsync : nullptr,
+    };
+}
+
+// endregion
+
+/** A mock display device that is bound to LVGL, with its first (full screen) frame already flushed */
+struct LvglDisplayFixture {
+    DisplayApi api {};
+    Driver driver {};
+    Device device { .name = "lvgl_display_test_device" };
+    lv_display_t* display = nullptr;
+
+    LvglDisplayFixture(bool async, bool flushPipeline) : api(createApi(async)) {
+        if (!lv_is_initialized()) {
+            lv_init();
+        }
+        resetMock();
+        mock.device = &device;
+        mock.lvgl_task = xTaskGetCurrentTaskHandle();
+        // The same priority as the LVGL task, so it only runs while that one is blocked or between time slices
+        REQUIRE_EQ(xTaskCreate(mockDmaTask, "mock_dma", 4096, nullptr, uxTaskPriorityGet(nullptr), &mock.dma_task), pdPASS);
+        driver = {
+            .name = "lvgl_display_test_driver",
+            .compatible = compatible,
+            .start_device = nullptr,
+            .stop_device = nullptr,
+            .api = &api,
+            .device_type = &DISPLAY_TYPE,
+            .owner = nullptr,
+            .internal = nullptr,
+        };
+        REQUIRE_EQ(device_construct(&device), ERROR_NONE);
+        device_set_driver(&device, &driver);
+
+        LvglDisplayConfig config = {
+            .buffer_height = BUFFER_HEIGHT,
+            .double_buffer = async,
+            .sw_rotate = false,
+            .swap_bytes = false,
+            .force_full_frame = false,
+            .prefer_external_ram = false,
+            .flush_pipeline = flushPipeline
+        };
+        REQUIRE_EQ(lvgl_display_add(&device, &config, &display), ERROR_NONE);
+
+        invalidate(0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+        refresh();
+        mock.transfers.clear();
+        mock.overlapped_count = 0;
+    }
+
+    ~LvglDisplayFixture() {
+        lvgl_display_remove(display);
+        mock.dma_stop_requested = true;
+        xTaskNotifyGive(mock.dma_task);
+        while (!mock.dma_stopped) {
+            vTaskDelay(1);
+        }
+        device_set_driver(&device, nullptr);
+        CHECK_EQ(device_destruct(&device), ERROR_NONE);
+    }
+
+    void invalidate(int32_t x1, int32_t y1, int32_t x2, int32_t y2) const {
+        lv_area_t area = { x1, y1, x2, y2 };
+        lv_inv_area(display, &area);
+    }
+
+    /** Renders and flushes the invalidated areas, and finishes the last transfer */
+    void refresh() const {
+        lv_refr_now(display);
+        waitForTransfer();
+    }
+
+    LvglDisplayFlushStats getStats() const {
+        LvglDisplayFlushStats stats {};
+        CHECK_EQ(lvgl_display_get_flush_stats(display, &stats), ERROR_NONE);
+        return stats;
+    }
+};
+
+bool hasTransfer(int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end) {
+    for (const auto& transfer : mock.transfers) {
+        if (transfer.x_start == x_start && transfer.y_start == y_start && transfer.x_end == x_end && transfer.y_end == y_end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_CASE("lvgl_display merges nearby invalidated areas into a single transfer") {
+    LvglDisplayFixture fixture(true, true);
+    uint32_t coalesced_before = fixture.getStats().coalesced_areas;
+
+    // 20x10 and 20x8 with a 2 pixel gap: LVGL itself doesn't join these, because the joined area (20x20) is larger than both
+    fixture.invalidate(10, 10, 29, 19);
+    fixture.invalidate(10, 22, 29, 29);
+    // Too far away to merge
+    fixture.invalidate(70, 70, 79, 79);
+    fixture.refresh();
+
+    CHECK_EQ(mock.transfers.size(), 2);
+    CHECK(hasTransfer(10, 10, 30, 30));
+    CHECK(hasTransfer(70, 70, 80, 80));
+    auto stats = fixture.getStats();
+    CHECK_EQ(stats.coalesced_areas - coalesced_before, 1);
+    CHECK_EQ(stats.last_frame_transfers, 2);
+    CHECK_EQ(stats.last_frame_bytes, (20 * 20 + 10 * 10) * BYTES_PER_PIXEL);
+}
+
+TEST_CASE("lvgl_display flushes each invalidated area separately without the flush pipeline") {
+    LvglDisplayFixture fixture(false, false);
+
+    fixture.invalidate(10, 10, 29, 19);
+    fixture.invalidate(10, 22, 29, 29);
+    fixture.invalidate(70, 70, 79, 79);
+    fixture.refresh();
+
+    CHECK_EQ(mock.transfers.size(), 3);
+    CHECK(hasTransfer(10, 10, 30, 20));
+    CHECK(hasTransfer(10, 22, 30, 30));
+    CHECK(hasTransfer(70, 70, 80, 80));
+    CHECK_EQ(fixture.getStats().coalesced_areas, 0);
+}
+
+TEST_CASE("lvgl_display renders the next tile while the previous one is still being transferred") {
+    LvglDisplayFixture fixture(true, true);
+
+    fixture.invalidate(0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+    fixture.refresh();
+
+    REQUIRE_EQ(mock.transfers.size(), TILE_COUNT);
+    // Every tile but the first was rendered while the transfer of the one before it was busy. The LVGL task then
+    // blocked in the bridge's flush wait callback: the mock only finishes a transfer early when LVGL doesn't spin.
+    CHECK_GE(mock.overlapped_count.load(), TILE_COUNT - 1);
+    // LVGL waited for each transfer before it started the next one
+    CHECK_EQ(mock.busy_draw_count, 0);
+    // Rendering alternates between the 2 draw buffers
+    for (size_t i = 1; i < mock.transfers.size(); i++) {
+        CHECK_NE(mock.transfers[i].color_data, mock.transfers[i - 1].color_data);
+        CHECK_EQ(mock.transfers[i].y_start, mock.transfers[i - 1].y_end);
+    }
+}
+
+TEST_CASE("lvgl_display flush pipeline transfers synchronously for drivers without async support") {
+    LvglDisplayFixture fixture(false, true);
+
+    fixture.invalidate(0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+    fixture.refresh();
+
+    CHECK_EQ(mock.transfers.size(), TILE_COUNT);
+    // Every transfer was done before LVGL rendered the next tile
+    CHECK_EQ(mock.overlapped_count.load(), 0);
+    CHECK_EQ(mock.transfers.front().color_data, mock.transfers.back().color_data);
+}
+
+TEST_CASE("lvgl_display_get_flush_stats reports every flushed frame") {
+    LvglDisplayFixture fixture(true, true);
+    auto initial_stats = fixture.getStats();
+    // The first frame of the fixture
+    CHECK_EQ(initial_stats.frame_count, 1);
+    CHECK_EQ(initial_stats.last_frame_transfers, TILE_COUNT);
+
+    fixture.invalidate(0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+    fixture.refresh();
+    fixture.invalidate(0, 0, 9, 9);
+    fixture.refresh();
+
+    auto stats = fixture.getStats();
+    constexpr uint32_t FULL_FRAME_BYTES = DISPLAY_WIDTH * DISPLAY_HEIGHT * BYTES_PER_PIXEL;
+    CHECK_EQ(stats.frame_count, 3);
+    CHECK_EQ(stats.last_frame_transfers, 1);
+    CHECK_EQ(stats.last_frame_bytes, 10 * 10 * BYTES_PER_PIXEL);
+    CHECK_EQ(stats.total_bytes, 2 * FULL_FRAME_BYTES + 10 * 10 * BYTES_PER_PIXEL);
+    CHECK_GE(stats.max_frame_flush_us, stats.last_frame_flush_us);
+
+    // Nothing was invalidated, so nothing is flushed
+    fixture.refresh();
+    CHECK_EQ(fixture.getStats().frame_count, 3);
+
+    CHECK_EQ(lvgl_display_get_flush_stats(fixture.display, nullptr), ERROR_INVALID_ARGUMENT);
+}
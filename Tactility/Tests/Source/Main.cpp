@@ -7,6 +7,9 @@
 #include <tactility/check.h>
 #include <tactility/dts.h>
 #include <tactility/kernel_init.h>
+#include <tactility/memory.h>
+
+#include <cstdio>
 
 typedef struct {
     int argc;
@@ -31,8 +34,19 @@ void test_task(void* parameter) {
     DtsDevice dts_devices[] = { DTS_DEVICE_TERMINATOR };
     check(kernel_init(dts_modules, dts_devices) == ERROR_NONE);
 
+    // Leak check: memory_* allocations made by the tests that are still alive after the run are logged, and fail the run
+    memory_tracking_set_enabled(true);
+
     data->result = context.run();
 
+    size_t leak_count = memory_tracking_log_leaks();
+    if (leak_count > 0) {
+        printf("%zu memory_* allocations were not freed\n", leak_count);
+        if (data->result == 0) {
+            data->result = 1;
+        }
+    }
+
     vTaskEndScheduler();
 
     vTaskDelete(nullptr);
@@ -0,0 +1,175 @@
+#include "doctest.h"
+
+#include <lvgl.h>
+#include <save_png_stream.h>
+#include <src/libs/lodepng/lodepng.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// region In-memory lv_fs drive
+
+std::vector<uint8_t>* memoryFileData = nullptr;
+
+void* memoryOpen(lv_fs_drv_t* /*driver*/, const char* /*path*/, lv_fs_mode_t /*mode*/) {
+    return memoryFileData;
+}
+
+lv_fs_res_t memoryClose(lv_fs_drv_t* /*driver*/, void* /*file*/) {
+    return LV_FS_RES_OK;
+}
+
+lv_fs_res_t memoryWrite(lv_fs_drv_t* /*driver*/, void* file, const void* data, uint32_t size, uint32_t* written) {
+    auto* bytes = static_cast<const uint8_t*>(data);
+    auto* file_data = static_cast<std::vector<uint8_t>*>(file);
+    file_data->insert(file_data->end(), bytes, bytes + size);
+    *written = size;
+    return LV_FS_RES_OK;
+}
+
+void registerMemoryDrive() {
+    static lv_fs_drv_t driver;
+    static bool isRegistered = false;
+    if (!lv_is_initialized()) {
+        lv_init();
+    }
+    if (!isRegistered) {
+        lv_fs_drv_init(&driver);
+        driver.letter = 'M';
+        driver.open_cb = memoryOpen;
+        driver.close_cb = memoryClose;
+        driver.write_cb = memoryWrite;
+        lv_fs_drv_register(&driver);
+        isRegistered = true;
+    }
+}
+
+// endregion
+
+class Random {
+    uint32_t state;
+public:
+    explicit Random(uint32_t seed) : state(seed) {}
+    uint8_t next() {
+        state = state * 1664525U + 1013904223U;
+        return static_cast<uint8_t>(state >> 24);
+    }
+};
+
+/**
+ * An RGB888 image (blue first) that looks like a UI: plain backgrounds and buttons, gradients and noisy areas
+ * like text and photos. These make the encoder pick each of the row filters, and the noise doesn't compress,
+ * so the deflate window slides many times.
+ */
+std::vector<uint8_t> createImage(uint32_t width, uint32_t height) {
+    std::vector<uint8_t> pixels(width * height * 3);
+    Random random(width * height);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t* pixel = &pixels[(y * width + x) * 3];
+            if (y < height / 8) {
+                // Status bar
+                pixel[0] = 0x30;
+                pixel[1] = 0x20;
+                pixel[2] = 0x10;
+            } else if (y < height / 4) {
+                // Horizontal gradient
+                pixel[0] = static_cast<uint8_t>(x);
+                pixel[1] = static_cast<uint8_t>(x * 2);
+                pixel[2] = 0x80;
+            } else if (y < height * 3 / 8) {
+                // Dithered dark area: only the unfiltered bytes are small
+                uint8_t value = ((x + y) % 2 == 0) ? 0x00 : 0x08;
+                pixel[0] = value;
+                pixel[1] = value;
+                pixel[2] = value;
+            } else if (y < height / 2) {
+                // Diagonal gradient: every pixel is the average of its left and upper neighbours
+                auto value = static_cast<uint8_t>(64 + ((x - y) & 127));
+                pixel[0] = value;
+                pixel[1] = value + 16;
+                pixel[2] = value + 32;
+            } else if (y < height * 5 / 8) {
+                // Vertical gradient with a button
+                bool is_button = x > width / 4 && x < width / 2;
+                pixel[0] = is_button ? 0xFF : static_cast<uint8_t>(y * 3);
+                pixel[1] = is_button ? 0x80 : static_cast<uint8_t>(y);
+                pixel[2] = is_button ? 0x00 : static_cast<uint8_t>(255 - y);
+            } else if (x < width / 2) {
+                // Diagonal pattern
+                pixel[0] = static_cast<uint8_t>(x + y);
+                pixel[1] = static_cast<uint8_t>((x ^ y) & 0xF0);
+                pixel[2] = static_cast<uint8_t>(x * y);
+            } else {
+                // Noise
+                pixel[0] = random.next();
+                pixel[1] = random.next();
+                pixel[2] = random.next();
+            }
+        }
+    }
+    return pixels;
+}
+
+std::vector<uint8_t> encode(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height) {
+    registerMemoryDrive();
+    std::vector<uint8_t> file_data;
+    memoryFileData = &file_data;
+
+    lv_fs_file_t file;
+    REQUIRE_EQ(lv_fs_open(&file, "M:screenshot.png", LV_FS_MODE_WR), LV_FS_RES_OK);
+    auto* stream = lv_screenshot_png_stream_open(&file, width, height);
+    REQUIRE(stream != nullptr);
+    for (uint32_t y = 0; y < height; y++) {
+        CHECK(lv_screenshot_png_stream_write_row(stream, pixels.data() + y * width * 3));
+    }
+    CHECK(lv_screenshot_png_stream_finish(stream));
+    lv_screenshot_png_stream_free(stream);
+    lv_fs_close(&file);
+
+    memoryFileData = nullptr;
+    return file_data;
+}
+
+void checkDecodedImage(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height) {
+    auto png = encode(pixels, width, height);
+
+    unsigned char* decoded = nullptr;
+    unsigned decoded_width = 0;
+    unsigned decoded_height = 0;
+    // lodepng verifies the chunk CRCs and the zlib checksum too
+    REQUIRE_EQ(lodepng_decode24(&decoded, &decoded_width, &decoded_height, png.data(), png.size()), 0);
+    CHECK_EQ(decoded_width, width);
+    CHECK_EQ(decoded_height, height);
+
+    // The input is blue first, the PNG is red first
+    size_t mismatch_count = 0;
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+        const uint8_t* expected = &pixels[i * 3];
+        const uint8_t* actual = &decoded[i * 3];
+        if (actual[0] != expected[2] || actual[1] != expected[1] || actual[2] != expected[0]) {
+            mismatch_count++;
+        }
+    }
+    CHECK_EQ(mismatch_count, 0);
+    lv_free(decoded);
+
+    MESSAGE(width << "x" << height << ": " << pixels.size() << " bytes encoded to " << png.size() << " bytes");
+}
+
+} // namespace
+
+TEST_CASE("lv_screenshot_png_stream output decodes to the original pixels") {
+    checkDecodedImage(createImage(320, 240), 320, 240);
+    checkDecodedImage(createImage(480, 320), 480, 320);
+}
+
+TEST_CASE("lv_screenshot_png_stream encodes plain and tiny images") {
+    std::vector<uint8_t> plain(64 * 64 * 3, 0x7F);
+    checkDecodedImage(plain, 64, 64);
+
+    std::vector<uint8_t> single_pixel = { 0x01, 0x02, 0x03 };
+    checkDecodedImage(single_pixel, 1, 1);
+}
@@ -14,6 +14,7 @@
 #include "symbols/stl.h"
 #include "symbols/string.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
@@ -411,19 +412,12 @@ const esp_elfsym main_symbols[] {
     ESP_ELFSYM_END
 };
 
-uintptr_t resolve_symbol(const esp_elfsym* source, const char* symbolName) {
-    const esp_elfsym* symbol_iterator = source;
-    while (symbol_iterator->name != nullptr) {
-        if (strcmp(symbol_iterator->name, symbolName) == 0) {
-            return reinterpret_cast<uintptr_t>(symbol_iterator->sym);
-        }
-        symbol_iterator++;
-    }
-    return 0;
-}
-
-uintptr_t tt_symbol_resolver(const char* symbolName) {
-    static const std::vector all_symbols = {
+/**
+ * All the symbols above, sorted by name for a binary search.
+ * For equal names, the symbol from the list that comes first in all_symbols comes first.
+ */
+static std::vector<const esp_elfsym*> create_symbol_index() {
+    const esp_elfsym* all_symbols[] = {
         main_symbols,
         gcc_soft_float_symbols,
         stl_symbols,
@@ -436,12 +430,28 @@ uintptr_t tt_symbol_resolver(const char* symbolName) {
         mbedtls_symbols,
     };
 
+    std::vector<const esp_elfsym*> index;
     for (const auto* symbols : all_symbols) {
-        const uintptr_t address = resolve_symbol(symbols, symbolName);
-        if (address != 0) {
-            return address;
+        for (const auto* symbol = symbols; symbol->name != nullptr; symbol++) {
+            index.push_back(symbol);
         }
     }
+    std::stable_sort(index.begin(), index.end(), [](const esp_elfsym* left, const esp_elfsym* right) {
+        return strcmp(left->name, right->name) < 0;
+    });
+    index.shrink_to_fit();
+    return index;
+}
+
+uintptr_t tt_symbol_resolver(const char* symbolName) {
+    static const std::vector<const esp_elfsym*> symbol_index = create_symbol_index();
+
+    auto iterator = std::lower_bound(symbol_index.begin(), symbol_index.end(), symbolName, [](const esp_elfsym* symbol, const char* name) {
+        return strcmp(symbol->name, name) < 0;
+    });
+    if (iterator != symbol_index.end() && strcmp((*iterator)->name, symbolName) == 0) {
+        return reinterpret_cast<uintptr_t>((*iterator)->sym);
+    }
 
     uintptr_t symbol_address;
     if (module_resolve_symbol_global(symbolName, &symbol_address)) {
@@ -12,9 +12,10 @@
 #include <esp_log.h>
 #endif
 
+#include <array>
+#include <deque>
 #include <functional>
 #include <memory>
-#include <queue>
 
 namespace tt {
 
@@ -22,6 +23,10 @@ namespace tt {
  * A thread-safe way to defer code execution.
  * Generally, one task would dispatch the execution,
  * while the other thread consumes and executes the work.
+ *
+ * Functions are queued in priority lanes. Consumers take functions from the highest lane that has any,
+ * but a lane with waiting functions goes first after STARVATION_LIMIT functions were taken from higher lanes.
+ * A function that has waited for its deadline goes ahead of all lanes.
  */
 class Dispatcher final {
 
@@ -33,13 +38,122 @@ public:
 
     typedef std::function<void()> Function;
 
+    /** The lanes, from most to least urgent */
+    enum class Priority {
+        /** Latency-sensitive work such as input and audio control */
+        High,
+        Normal,
+        /** Bulk work such as refreshing lists */
+        Low
+    };
+
+    static constexpr size_t PRIORITY_COUNT = 3;
+    /** A lane with waiting functions goes first after this many functions were taken from higher lanes */
+    static constexpr uint32_t STARVATION_LIMIT = 8U;
+    /** Use as deadline when a function has no deadline */
+    static constexpr TickType_t NO_DEADLINE = kernel::FREERTOS_MAX_TICKS;
+
+    /** Counters of a single lane. Latencies are the ticks between dispatching a function and calling it. */
+    struct LaneStats {
+        /** The amount of functions that are waiting */
+        uint32_t depth = 0;
+        /** The highest depth so far */
+        uint32_t depthPeak = 0;
+        /** The amount of functions that were called */
+        uint32_t executed = 0;
+        /** The amount of functions that were called after their deadline had passed */
+        uint32_t deadlineMisses = 0;
+        TickType_t latencyMax = 0;
+        uint64_t latencyTotal = 0;
+    };
+
 private:
 
+    struct Entry {
+        Function function;
+        TickType_t dispatchTime;
+        TickType_t deadline;
+    };
+
+    struct Lane {
+        std::deque<Entry> queue;
+        /** Amount of functions that were taken from higher lanes while this lane had functions waiting */
+        uint32_t skipped = 0;
+        LaneStats stats;
+    };
+
     Mutex mutex;
-    std::queue<Function> queue = {};
+    std::array<Lane, PRIORITY_COUNT> lanes = {};
+    size_t queueSize = 0;
+    /** Amount of waiting functions that have a deadline */
+    size_t deadlineCount = 0;
     EventGroup eventFlag;
     bool shutdown = false;
 
+    /**
+     * Take the function that has been waiting the longest past its deadline.
+     * @warning must hold the mutex
+     * @return false when no function is overdue
+     */
+    bool takeOverdue(TickType_t now, Lane*& selectedLane, Entry& entry) {
+        Lane* overdueLane = nullptr;
+        size_t overdueIndex = 0;
+        TickType_t overdueTicks = 0;
+        for (auto& lane : lanes) {
+            for (size_t i = 0; i < lane.queue.size(); i++) {
+                const auto& candidate = lane.queue[i];
+                if (candidate.deadline == NO_DEADLINE) {
+                    continue;
+                }
+                TickType_t waited = now - candidate.dispatchTime;
+                if (waited >= candidate.deadline && (overdueLane == nullptr || waited - candidate.deadline > overdueTicks)) {
+                    overdueLane = &lane;
+                    overdueIndex = i;
+                    overdueTicks = waited - candidate.deadline;
+                }
+            }
+        }
+        if (overdueLane == nullptr) {
+            return false;
+        }
+        entry = std::move(overdueLane->queue[overdueIndex]);
+        overdueLane->queue.erase(overdueLane->queue.begin() + static_cast<std::ptrdiff_t>(overdueIndex));
+        selectedLane = overdueLane;
+        return true;
+    }
+
+    /**
+     * Take the next function by priority, with starvation protection.
+     * @warning must hold the mutex
+     * @return false when all lanes are empty
+     */
+    bool takeNext(Lane*& selectedLane, Entry& entry) {
+        selectedLane = nullptr;
+        for (auto& lane : lanes) {
+            if (lane.queue.empty()) {
+                continue;
+            }
+            if (selectedLane == nullptr) {
+                selectedLane = &lane;
+            } else if (lane.skipped >= STARVATION_LIMIT) {
+                selectedLane = &lane;
+                break;
+            }
+        }
+        if (selectedLane == nullptr) {
+            return false;
+        }
+        for (auto& lane : lanes) {
+            if (&lane != selectedLane && !lane.queue.empty()) {
+                lane.skipped++;
+            }
+        }
+        selectedLane->skipped = 0;
+        entry = std::move(selectedLane->queue.front());
+        selectedLane->queue.pop_front();
+        return true;
+    }
+
 public:
 
     explicit Dispatcher() = default;
@@ -58,6 +172,18 @@ public:
      * @return true if dispatching was successful (timeout not reached)
      */
     bool dispatch(Function function, TickType_t timeout = kernel::FREERTOS_MAX_TICKS) {
+        return dispatch(std::move(function), Priority::Normal, NO_DEADLINE, timeout);
+    }
+
+    /**
+     * Queue a function in a priority lane to be consumed elsewhere.
+     * @param[in] function the function to execute elsewhere
+     * @param[in] priority the lane to queue the function in
+     * @param[in] deadline the maximum ticks to wait behind other functions, or NO_DEADLINE. The function is always called, even when it's late.
+     * @param[in] timeout lock acquisition timeout
+     * @return true if dispatching was successful (timeout not reached)
+     */
+    bool dispatch(Function function, Priority priority, TickType_t deadline = NO_DEADLINE, TickType_t timeout = kernel::FREERTOS_MAX_TICKS) {
         // Mutate
         if (!mutex.lock(timeout)) {
 #ifdef ESP_PLATFORM
@@ -71,8 +197,17 @@ public:
             return false;
         }
 
-        queue.push(std::move(function));
-        if (queue.size() == BACKPRESSURE_WARNING_COUNT) {
+        auto& lane = lanes[static_cast<size_t>(priority)];
+        lane.queue.push_back({ std::move(function), kernel::getTicks(), deadline });
+        lane.stats.depth++;
+        if (lane.stats.depth > lane.stats.depthPeak) {
+            lane.stats.depthPeak = lane.stats.depth;
+        }
+        if (deadline != NO_DEADLINE) {
+            deadlineCount++;
+        }
+        queueSize++;
+        if (queueSize == BACKPRESSURE_WARNING_COUNT) {
 #ifdef ESP_PLATFORM
             ESP_LOGW(TAG, "Backpressure: You're not consuming fast enough (100 queued)");
 #endif
@@ -107,14 +242,29 @@ public:
         uint32_t consumed = 0;
         do {
             if (mutex.lock(10)) {
-                if (!queue.empty()) {
-                    auto function = queue.front();
-                    queue.pop();
+                TickType_t now = kernel::getTicks();
+                Lane* lane = nullptr;
+                Entry entry;
+                if ((deadlineCount > 0 && takeOverdue(now, lane, entry)) || takeNext(lane, entry)) {
+                    queueSize--;
+                    processing = (queueSize != 0);
+                    TickType_t waited = now - entry.dispatchTime;
+                    lane->stats.depth--;
+                    lane->stats.executed++;
+                    lane->stats.latencyTotal += waited;
+                    if (waited > lane->stats.latencyMax) {
+                        lane->stats.latencyMax = waited;
+                    }
+                    if (entry.deadline != NO_DEADLINE) {
+                        deadlineCount--;
+                        if (waited > entry.deadline) {
+                            lane->stats.deadlineMisses++;
+                        }
+                    }
                     consumed++;
-                    processing = !queue.empty();
                     // Don't keep lock as callback might be slow
                     mutex.unlock();
-                    function();
+                    entry.function();
                 } else {
                     processing = false;
                     mutex.unlock();
@@ -129,6 +279,14 @@ public:
 
         return consumed;
     }
+
+    /** @return the counters of a lane */
+    LaneStats getStats(Priority priority) {
+        mutex.lock();
+        LaneStats stats = lanes[static_cast<size_t>(priority)].stats;
+        mutex.unlock();
+        return stats;
+    }
 };
 
 } // namespace
@@ -50,6 +50,17 @@ public:
         return dispatcher.dispatch(function, timeout);
     }
 
+    /**
+     * Dispatch a message in a priority lane.
+     * @see Dispatcher::dispatch(Function, Dispatcher::Priority, TickType_t, TickType_t)
+     */
+    bool dispatch(const Dispatcher::Function& function, Dispatcher::Priority priority, TickType_t deadline = Dispatcher::NO_DEADLINE, TickType_t timeout = kernel::FREERTOS_MAX_TICKS) {
+        return dispatcher.dispatch(function, priority, deadline, timeout);
+    }
+
+    /** @return the counters of a priority lane */
+    Dispatcher::LaneStats getStats(Dispatcher::Priority priority) { return dispatcher.getStats(priority); }
+
     /** Start the thread (blocking). */
     void start() {
         interruptThread = false;
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include "DispatcherThread.h"
+#include "Mutex.h"
+#include "kernel/Kernel.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+#include <esp_log.h>
+#endif
+
+#include <cassert>
+
+namespace tt {
+
+/**
+ * Publish and subscribe to messages in a thread-safe manner, without blocking.
+ *
+ * Unlike PubSub, the mutex is never held while calling subscribers. Subscribing and unsubscribing
+ * replace an immutable snapshot of the subscriber list, and publish() calls the subscribers from
+ * the snapshot it started with. A slow subscriber therefore doesn't block other publishers or
+ * (un)subscribing, and subscribers may (un)subscribe from their own callback.
+ *
+ * When created with a DispatcherThread, publish() returns right away and the subscribers are called
+ * on that thread in publishing order.
+ *
+ * @warning A publish that already started may still call a subscriber after unsubscribe() returned.
+ *          Subscribers must not capture anything that is destroyed right after unsubscribing.
+ */
+template<typename DataType>
+class SnapshotPubSub final {
+
+public:
+
+    typedef void* SubscriptionHandle;
+    typedef std::function<void(DataType)> Callback;
+
+private:
+
+    struct Subscription {
+        uint64_t id;
+        Callback callback;
+    };
+
+    /** Never modified after it's published: changes create a new snapshot */
+    typedef std::vector<Subscription> Subscriptions;
+
+    uint64_t lastId = 0;
+    std::shared_ptr<const Subscriptions> snapshot = std::make_shared<const Subscriptions>();
+    Mutex mutex;
+    DispatcherThread* deliveryThread;
+
+    std::shared_ptr<const Subscriptions> getSnapshot() {
+        mutex.lock();
+        auto result = snapshot;
+        mutex.unlock();
+        return result;
+    }
+
+    static void deliver(const Subscriptions& subscriptions, const DataType& data) {
+        for (const auto& subscription : subscriptions) {
+            subscription.callback(data);
+        }
+    }
+
+public:
+
+    /**
+     * @param[in] deliveryThread when set, subscribers are called on this thread instead of the publishing thread.
+     *            It must outlive this instance and be started to deliver anything.
+     */
+    explicit SnapshotPubSub(DispatcherThread* deliveryThread = nullptr) : deliveryThread(deliveryThread) {}
+
+    ~SnapshotPubSub() {
+        if (!snapshot->empty()) {
+#ifdef ESP_PLATFORM
+            ESP_LOGW("SnapshotPubSub", "Destroying with %zu active subscriptions", snapshot->size());
+#endif
+        }
+    }
+
+    /**
+     * Start receiving messages at the specified handle (Re-entrable)
+     * @param[in] callback
+     * @return subscription instance
+     */
+    SubscriptionHandle subscribe(Callback callback) {
+        mutex.lock();
+
+        auto subscriptions = std::make_shared<Subscriptions>(*snapshot);
+        uint64_t id = ++lastId;
+        subscriptions->push_back({
+            .id = id,
+            .callback = std::move(callback)
+        });
+        snapshot = std::move(subscriptions);
+
+        mutex.unlock();
+
+        return reinterpret_cast<SubscriptionHandle>(id);
+    }
+
+    /**
+     * Stop receiving messages at the specified handle (Re-entrable)
+     * @param[in] subscription
+     */
+    void unsubscribe(SubscriptionHandle subscription) {
+        assert(subscription);
+
+        mutex.lock();
+
+        bool result = false;
+        auto id = reinterpret_cast<uint64_t>(subscription);
+        auto subscriptions = std::make_shared<Subscriptions>();
+        subscriptions->reserve(snapshot->size());
+        for (const auto& item : *snapshot) {
+            if (item.id == id) {
+                result = true;
+            } else {
+                subscriptions->push_back(item);
+            }
+        }
+        if (result) {
+            snapshot = std::move(subscriptions);
+        }
+
+        mutex.unlock();
+        assert(result);
+    }
+
+    /**
+     * Publish something to all subscribers (Re-entrable)
+     * @param[in] data the data to publish
+     * @param[in] timeout the time to wait for the delivery thread to accept the message (only used with a delivery thread)
+     * @return false when the delivery thread didn't accept the message
+     */
+    bool publish(DataType data, TickType_t timeout = kernel::FREERTOS_MAX_TICKS) {
+        auto subscriptions = getSnapshot();
+        if (subscriptions->empty()) {
+            return true;
+        }
+
+        if (deliveryThread == nullptr) {
+            deliver(*subscriptions, data);
+            return true;
+        }
+
+        return deliveryThread->dispatch([subscriptions = std::move(subscriptions), data = std::move(data)] {
+            deliver(*subscriptions, data);
+        }, timeout);
+    }
+
+    /** @return the amount of active subscriptions */
+    size_t getSubscriptionCount() {
+        return getSnapshot()->size();
+    }
+};
+
+} // namespace
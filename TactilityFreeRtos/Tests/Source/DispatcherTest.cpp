@@ -1,6 +1,8 @@
 #include "doctest.h"
 #include <Tactility/Dispatcher.h>
 
+#include <vector>
+
 using namespace tt;
 
 TEST_CASE("dispatcher should not call callback if consume isn't called") {
@@ -35,3 +37,45 @@ TEST_CASE("message should be passed on correctly") {
     dispatcher.dispatch([]() { /* NO-OP */ });
     dispatcher.consume(100);
 }
+
+TEST_CASE("dispatcher should call higher priority lanes first") {
+    Dispatcher dispatcher;
+    std::vector<int> order;
+
+    dispatcher.dispatch([&order] { order.push_back(3); }, Dispatcher::Priority::Low);
+    dispatcher.dispatch([&order] { order.push_back(2); });
+    dispatcher.dispatch([&order] { order.push_back(1); }, Dispatcher::Priority::High);
+    CHECK_EQ(dispatcher.consume(100), 3);
+
+    CHECK_EQ(order, std::vector<int> { 1, 2, 3 });
+    auto stats = dispatcher.getStats(Dispatcher::Priority::High);
+    CHECK_EQ(stats.executed, 1);
+    CHECK_EQ(stats.depthPeak, 1);
+}
+
+TEST_CASE("dispatcher should not starve lower priority lanes") {
+    Dispatcher dispatcher;
+    std::vector<int> order;
+
+    dispatcher.dispatch([&order] { order.push_back(3); }, Dispatcher::Priority::Low);
+    for (int i = 0; i < 20; i++) {
+        dispatcher.dispatch([&order] { order.push_back(1); }, Dispatcher::Priority::High);
+    }
+    CHECK_EQ(dispatcher.consume(100), 21);
+
+    REQUIRE_EQ(order.size(), 21);
+    CHECK_EQ(order[Dispatcher::STARVATION_LIMIT], 3);
+}
+
+TEST_CASE("dispatcher should move a function ahead when its deadline has passed") {
+    Dispatcher dispatcher;
+    std::vector<int> order;
+
+    dispatcher.dispatch([&order] { order.push_back(1); }, Dispatcher::Priority::High);
+    dispatcher.dispatch([&order] { order.push_back(3); }, Dispatcher::Priority::Low, 1);
+    kernel::delayTicks(3);
+    CHECK_EQ(dispatcher.consume(100), 2);
+
+    CHECK_EQ(order, std::vector<int> { 3, 1 });
+    CHECK_EQ(dispatcher.getStats(Dispatcher::Priority::Low).deadlineMisses, 1);
+}
@@ -1,5 +1,13 @@
 #include "doctest.h"
 #include <Tactility/PubSub.h>
+#include <Tactility/Semaphore.h>
+#include <Tactility/SnapshotPubSub.h>
+#include <Tactility/Thread.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
 
 using namespace tt;
 
@@ -34,3 +42,127 @@ TEST_CASE("PubSub unsubscribed subscription does not receive published data") {
 
     CHECK_EQ(value, 0);
 }
+
+TEST_CASE("SnapshotPubSub subscription receives published data until unsubscribed") {
+    SnapshotPubSub<int> pubsub;
+    int value = 0;
+
+    auto subscription = pubsub.subscribe([&value](auto newValue) {
+        value = newValue;
+    });
+    CHECK_EQ(pubsub.getSubscriptionCount(), 1);
+    CHECK(pubsub.publish(1));
+    CHECK_EQ(value, 1);
+
+    pubsub.unsubscribe(subscription);
+    CHECK_EQ(pubsub.getSubscriptionCount(), 0);
+    CHECK(pubsub.publish(2));
+    CHECK_EQ(value, 1);
+}
+
+TEST_CASE("SnapshotPubSub subscribers can unsubscribe from their own callback") {
+    SnapshotPubSub<int> pubsub;
+    int calls = 0;
+    SnapshotPubSub<int>::SubscriptionHandle subscription = nullptr;
+
+    subscription = pubsub.subscribe([&](int) {
+        calls++;
+        pubsub.unsubscribe(subscription);
+    });
+    pubsub.publish(1);
+    pubsub.publish(2);
+
+    CHECK_EQ(calls, 1);
+}
+
+TEST_CASE("SnapshotPubSub should deliver in order on the delivery thread") {
+    DispatcherThread thread("pubsub_delivery");
+    thread.start();
+    SnapshotPubSub<int> pubsub(&thread);
+    std::vector<int> values;
+    Semaphore done(1, 0);
+
+    auto subscription = pubsub.subscribe([&](int value) {
+        values.push_back(value);
+        if (value == 3) {
+            done.release();
+        }
+    });
+    for (int i = 1; i <= 3; i++) {
+        CHECK(pubsub.publish(i));
+    }
+
+    CHECK(done.acquire(pdMS_TO_TICKS(2000)));
+    CHECK_EQ(values, std::vector<int> { 1, 2, 3 });
+    pubsub.unsubscribe(subscription);
+    thread.stop();
+}
+
+namespace {
+
+constexpr int PUBLISHER_COUNT = 2;
+constexpr int PUBLISH_COUNT = 20;
+
+/**
+ * Publish from several threads to a slow subscriber, while the calling thread keeps subscribing and unsubscribing.
+ * @return the slowest subscribe+unsubscribe pair in microseconds
+ */
+template<typename PubSubType>
+int64_t measureUnsubscribeLatency(PubSubType& pubsub, std::atomic<int>& received) {
+    // Blocks like a subscriber that waits for I/O
+    auto slow = pubsub.subscribe([&received](int) {
+        kernel::delayMillis(1);
+        received++;
+    });
+
+    std::atomic<int> publishersDone = 0;
+    std::vector<std::unique_ptr<Thread>> publishers;
+    for (int i = 0; i < PUBLISHER_COUNT; i++) {
+        publishers.push_back(std::make_unique<Thread>("publisher", 4096, [&pubsub, &publishersDone] {
+            for (int j = 0; j < PUBLISH_COUNT; j++) {
+                pubsub.publish(j);
+            }
+            publishersDone++;
+            return 0;
+        }));
+        publishers.back()->start();
+    }
+
+    int64_t maxLatency = 0;
+    while (publishersDone < PUBLISHER_COUNT) {
+        kernel::delayTicks(1);
+        auto start = std::chrono::steady_clock::now();
+        auto subscription = pubsub.subscribe([](int) {});
+        pubsub.unsubscribe(subscription);
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        maxLatency = std::max<int64_t>(maxLatency, latency);
+    }
+
+    for (auto& publisher : publishers) {
+        publisher->join();
+    }
+    pubsub.unsubscribe(slow);
+    return maxLatency;
+}
+
+} // namespace
+
+TEST_CASE("PubSub contention benchmark") {
+    std::atomic<int> lockedReceived = 0;
+    PubSub<int> locked;
+    auto start = std::chrono::steady_clock::now();
+    auto lockedLatency = measureUnsubscribeLatency(locked, lockedReceived);
+    auto lockedDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::atomic<int> snapshotReceived = 0;
+    SnapshotPubSub<int> snapshot;
+    start = std::chrono::steady_clock::now();
+    auto snapshotLatency = measureUnsubscribeLatency(snapshot, snapshotReceived);
+    auto snapshotDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    CHECK_EQ(lockedReceived, PUBLISHER_COUNT * PUBLISH_COUNT);
+    CHECK_EQ(snapshotReceived, PUBLISHER_COUNT * PUBLISH_COUNT);
+    MESSAGE("PubSub: " << lockedDuration << " ms to publish, " << lockedLatency << " us worst (un)subscribe");
+    // Latencies are only reported: the locked variant makes (un)subscribe wait for the slow subscriber, so it's usually slower
+    MESSAGE("SnapshotPubSub: " << snapshotDuration << " ms to publish, " << snapshotLatency << " us worst (un)subscribe");
+}
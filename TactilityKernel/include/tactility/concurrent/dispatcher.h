@@ -8,6 +8,8 @@
 #include <tactility/freertos/freertos.h>
 #include <tactility/error.h>
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,23 +17,113 @@ extern "C" {
 typedef void (*DispatcherCallback)(void* context);
 typedef void* DispatcherHandle_t;
 
+enum DispatcherBackend {
+    /** Unbounded FIFO guarded by a mutex. Every dispatch allocates a small node and signals the consumer. */
+    DISPATCHER_BACKEND_QUEUE,
+    /**
+     * Fixed-capacity lock-free ring. Dispatching doesn't allocate or lock, is safe from an ISR
+     * and only signals the consumer when the ring was empty. Consumers drain the ring in one batch per wakeup.
+     */
+    DISPATCHER_BACKEND_RING
+};
+
+/** The lanes of DISPATCHER_BACKEND_QUEUE, from most to least urgent */
+enum DispatcherPriority {
+    /** Latency-sensitive work such as input and audio control */
+    DISPATCHER_PRIORITY_HIGH,
+    /** The lane that dispatcher_dispatch_timed() uses */
+    DISPATCHER_PRIORITY_NORMAL,
+    /** Bulk work such as refreshing lists */
+    DISPATCHER_PRIORITY_LOW
+};
+
+#define DISPATCHER_PRIORITY_COUNT 3U
+
+/** Use as deadline when a function has no deadline */
+#define DISPATCHER_NO_DEADLINE portMAX_DELAY
+
+/** Counters of a single priority lane. Latencies are the ticks between dispatching a function and calling it. */
+struct DispatcherLaneStats {
+    /** The amount of functions that are waiting */
+    uint32_t depth;
+    /** The highest depth so far */
+    uint32_t depth_peak;
+    /** The amount of functions that were called */
+    uint32_t executed;
+    /** The amount of functions that were called after their deadline had passed */
+    uint32_t deadline_misses;
+    TickType_t latency_max;
+    uint64_t latency_total;
+};
+
+struct DispatcherConfig {
+    enum DispatcherBackend backend;
+    /** The amount of pending functions that fit in the ring: a power of 2 that is at least 2 (only used by DISPATCHER_BACKEND_RING) */
+    uint32_t ring_capacity;
+};
+
+/** Allocate a dispatcher with DISPATCHER_BACKEND_QUEUE */
 DispatcherHandle_t dispatcher_alloc(void);
 
+/**
+ * @param[in] config non-null configuration
+ * @return the dispatcher, or NULL when the configuration is invalid or memory is exhausted
+ */
+DispatcherHandle_t dispatcher_alloc_with_config(const struct DispatcherConfig* config);
+
 void dispatcher_free(DispatcherHandle_t dispatcher);
 
 /**
  * Queue a function to be consumed elsewhere.
+ * With DISPATCHER_BACKEND_RING, this can be called from an ISR. The timeout is ignored there.
  *
  * @param[in] callbackContext the data to pass to the function upon execution
  * @param[in] callback the function to execute elsewhere
- * @param[in] timeout lock acquisition timeout
+ * @param[in] timeout lock acquisition timeout, or how long to wait for room in the ring
  * @retval ERROR_TIMEOUT
  * @retval ERROR_RESOURCE when failing to set event
  * @retval ERROR_INVALID_STATE when the dispatcher is in the process of shutting down
+ * @retval ERROR_OUT_OF_MEMORY when the queue entry can't be allocated
+ * @retval ERROR_BUFFER_OVERFLOW when the ring stayed full until the timeout
  * @retval ERROR_NONE
  */
 error_t dispatcher_dispatch_timed(DispatcherHandle_t dispatcher, void* callbackContext, DispatcherCallback callback, TickType_t timeout);
 
+/**
+ * Queue a function in a priority lane to be consumed elsewhere.
+ *
+ * Consumers take functions from the highest lane that has any. A lane that has functions waiting
+ * goes first after 8 functions were taken from higher lanes, so bulk work can't be starved.
+ * A function that has waited for its deadline goes ahead of all lanes, so it is called as soon as
+ * the consumer is done with the current function. The function is always called, even when it's late.
+ *
+ * @param[in] callbackContext the data to pass to the function upon execution
+ * @param[in] callback the function to execute elsewhere
+ * @param[in] priority the lane to queue the function in
+ * @param[in] deadline the maximum ticks to wait behind other functions, or DISPATCHER_NO_DEADLINE
+ * @param[in] timeout lock acquisition timeout
+ * @retval ERROR_INVALID_ARGUMENT when the priority is invalid
+ * @retval ERROR_NOT_SUPPORTED when using a priority other than DISPATCHER_PRIORITY_NORMAL or a deadline with DISPATCHER_BACKEND_RING
+ * @return the same as dispatcher_dispatch_timed() otherwise
+ */
+error_t dispatcher_dispatch_priority_timed(
+    DispatcherHandle_t dispatcher,
+    void* callbackContext,
+    DispatcherCallback callback,
+    enum DispatcherPriority priority,
+    TickType_t deadline,
+    TickType_t timeout
+);
+
+/**
+ * @param[in] priority the lane to get the counters for
+ * @param[out] stats the counters
+ * @retval ERROR_INVALID_ARGUMENT when the priority is invalid
+ * @retval ERROR_NOT_SUPPORTED for DISPATCHER_BACKEND_RING
+ * @retval ERROR_NONE
+ */
+error_t dispatcher_get_lane_stats(DispatcherHandle_t dispatcher, enum DispatcherPriority priority, struct DispatcherLaneStats* stats);
+
 /**
  * Queue a function to be consumed elsewhere.
  *
@@ -40,6 +132,8 @@ error_t dispatcher_dispatch_timed(DispatcherHandle_t dispatcher, void* callbackC
  * @retval ERROR_RESOURCE when failing to set event
  * @retval ERROR_TIMEOUT unlikely to occur unless there's an issue with the internal mutex
  * @retval ERROR_INVALID_STATE when the dispatcher is in the process of shutting down
+ * @retval ERROR_OUT_OF_MEMORY when the queue entry can't be allocated
+ * @retval ERROR_BUFFER_OVERFLOW when the ring is full and this is called from an ISR
  * @retval ERROR_NONE
  */
 static inline error_t dispatcher_dispatch(DispatcherHandle_t dispatcher, void* callbackContext, DispatcherCallback callback) {
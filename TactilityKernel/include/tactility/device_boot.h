@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <tactility/dts.h>
+#include <tactility/error.h>
+#include <tactility/freertos/freertos.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct Device;
+
+/** The outcome of bringing up a single devicetree device */
+struct DeviceBootRecord {
+    /** The device this record belongs to */
+    struct Device* device;
+    /**
+     * ERROR_NONE on success, the error from construct/add/start on failure,
+     * or ERROR_INVALID_STATE when the device was skipped because the boot was aborted.
+     */
+    error_t result;
+    /** When the bring-up of this device began, relative to the start of device_boot() */
+    uint64_t start_offset_us;
+    /** Time spent constructing, adding and (when enabled) starting this device */
+    uint64_t duration_us;
+};
+
+struct DeviceBootConfig {
+    /**
+     * Maximum number of devices that are brought up at the same time.
+     * When this is 1, devices are brought up one by one in array order on the calling thread.
+     */
+    uint32_t worker_count;
+    /** Stack size for each additional worker thread (only used when worker_count > 1) */
+    configSTACK_DEPTH_TYPE worker_stack_size;
+};
+
+/**
+ * Construct, add and start the devices from the devicetree.
+ *
+ * A device is only brought up after its parent (when that parent is part of the same array) has
+ * been brought up. Devices in independent subtrees are brought up concurrently on up to
+ * config->worker_count threads. Ready devices are always picked in array order.
+ *
+ * @warning Only parent/child relationships are tracked. Devices that depend on a device outside
+ *          their ancestry (e.g. a gpio-hog on an IO expander pin) are only guaranteed to see that
+ *          dependency started when worker_count is 1.
+ * @param[in] dts_devices the devices, terminated with DTS_DEVICE_TERMINATOR
+ * @param[in] config non-null configuration
+ * @param[out] records nullable array with one entry per device in dts_devices (excluding the terminator)
+ * @retval ERROR_RESOURCE when any device failed. No new devices are started after the first failure.
+ * @retval ERROR_OUT_OF_MEMORY when the internal state or a worker thread could not be allocated
+ * @retval ERROR_NONE on success
+ */
+error_t device_boot(const struct DtsDevice dts_devices[], const struct DeviceBootConfig* config, struct DeviceBootRecord* records);
+
+/**
+ * @param[in] dts_devices the devices, terminated with DTS_DEVICE_TERMINATOR
+ * @return the amount of devices in the array, excluding the terminator
+ */
+size_t device_boot_count(const struct DtsDevice dts_devices[]);
+
+/**
+ * Log the records from device_boot(), slowest device first.
+ *
+ * @param[in] records the records filled in by device_boot()
+ * @param[in] record_count the amount of records
+ */
+void device_boot_log_report(const struct DeviceBootRecord* records, size_t record_count);
+
+#ifdef __cplusplus
+}
+#endif
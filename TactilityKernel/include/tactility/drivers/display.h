@@ -29,7 +29,12 @@ enum DisplayCapability {
      * it copies/converts into its own buffer first). Lets the LVGL bridge allocate this display's
      * draw buffer(s) from non-DMA-capable memory instead of forcing scarce internal RAM.
      */
-    DISPLAY_CAPABILITY_PREFER_EXTERNAL_RAM = 1 << 9
+    DISPLAY_CAPABILITY_PREFER_EXTERNAL_RAM = 1 << 9,
+    /**
+     * draw_bitmap_async() is implemented: the transfer continues in the background (e.g. via DMA)
+     * after the call returns, so the caller can render the next tile in the meantime.
+     */
+    DISPLAY_CAPABILITY_ASYNC_DRAW = 1 << 10
 };
 
 /**
@@ -49,6 +54,14 @@ enum DisplayColorFormat {
     DISPLAY_COLOR_FORMAT_GRAYSCALE8 = 0x6,
 };
 
+/**
+ * @brief Called when an asynchronous draw has finished reading its color data.
+ * @warning Can be called from an ISR.
+ * @param[in] device the display device
+ * @param[in] context the context that was passed to draw_bitmap_async()
+ */
+typedef void (*DisplayDrawDoneCallback)(struct Device* device, void* context);
+
 /**
  * @brief API for display panel drivers.
  */
@@ -227,6 +240,22 @@ struct DisplayApi {
      * @return true if all specified capabilities are available for this device instance
      */
     bool (*has_capability)(struct Device* device, uint32_t capability);
+
+    /**
+     * @brief Starts drawing pixel data into the given rectangle, without waiting for the transfer to finish.
+     * At most 1 draw is in flight: the caller waits for on_done before drawing again.
+     * @warning Function pointer should be null if capability not available (DISPLAY_CAPABILITY_ASYNC_DRAW).
+     * @param[in] device the display device
+     * @param[in] x_start left edge (inclusive)
+     * @param[in] y_start top edge (inclusive)
+     * @param[in] x_end right edge (exclusive)
+     * @param[in] y_end bottom edge (exclusive)
+     * @param[in] color_data pixel data in the panel's configured color format, which must stay valid and unchanged until on_done is called
+     * @param[in] on_done called once when color_data is no longer used, only when ERROR_NONE is returned
+     * @param[in] context passed to on_done
+     * @retval ERROR_NONE when the transfer was started
+     */
+    error_t (*draw_bitmap_async)(struct Device* device, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data, DisplayDrawDoneCallback on_done, void* context);
 };
 
 /**
@@ -252,6 +281,15 @@ error_t display_init(struct Device* device);
  */
 error_t display_draw_bitmap(struct Device* device, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data);
 
+/**
+ * @brief Starts drawing pixel data into the given rectangle using the specified display. See DisplayApi::draw_bitmap_async().
+ * Drivers without DISPLAY_CAPABILITY_ASYNC_DRAW draw synchronously instead, and call on_done before returning.
+ * @param[in] on_done called once when color_data is no longer used, only when ERROR_NONE is returned
+ * @param[in] context passed to on_done
+ * @retval ERROR_NONE when the transfer was started (or finished)
+ */
+error_t display_draw_bitmap_async(struct Device* device, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data, DisplayDrawDoneCallback on_done, void* context);
+
 /**
  * @brief Mirrors the image along the X and/or Y axis using the specified display.
  */
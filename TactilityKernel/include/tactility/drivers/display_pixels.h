@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+// Pixel conversion kernels for display flushing: RGB565 byte swapping and 90/180/270 degree rotation, in 1 pass when combined.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tactility/error.h>
+
+/**
+ * @brief Clockwise display rotations, with the same meaning as LVGL's LV_DISPLAY_ROTATION_*:
+ * a pixel at (x, y) in a w*h source block ends up at:
+ * - 90: (y, w - 1 - x)
+ * - 180: (w - 1 - x, h - 1 - y)
+ * - 270: (h - 1 - y, x)
+ */
+enum DisplayPixelRotation {
+    DISPLAY_PIXEL_ROTATION_0 = 0,
+    DISPLAY_PIXEL_ROTATION_90 = 1,
+    DISPLAY_PIXEL_ROTATION_180 = 2,
+    DISPLAY_PIXEL_ROTATION_270 = 3
+};
+
+/**
+ * @brief Swaps the 2 bytes of every RGB565 pixel in place (little endian <-> big endian).
+ * @param[inout] pixels the pixels, aligned to 2 bytes
+ * @param[in] pixel_count the number of pixels
+ */
+void display_pixels_swap_rgb565(void* pixels, size_t pixel_count);
+
+/**
+ * @brief Rotates a block of pixels into another buffer, optionally swapping RGB565 bytes in the same pass.
+ * For 90 and 270 degrees the destination is height pixels wide and width pixels high.
+ * @param[in] source the source pixels
+ * @param[out] destination the rotated pixels, must not overlap with source
+ * @param[in] width the source width in pixels
+ * @param[in] height the source height in pixels
+ * @param[in] source_stride the number of bytes between the starts of 2 source rows
+ * @param[in] destination_stride the number of bytes between the starts of 2 destination rows
+ * @param[in] bytes_per_pixel 1 (e.g. L8), 2 (RGB565), 3 (RGB888) or 4 (ARGB8888)
+ * @param[in] rotation the rotation to apply
+ * @param[in] swap_rgb565 also swap the bytes of each pixel, only valid when bytes_per_pixel is 2
+ * @retval ERROR_NONE when the pixels were rotated
+ * @retval ERROR_INVALID_ARGUMENT when the size, strides, pixel size or rotation are not supported
+ */
+error_t display_pixels_rotate(
+    const void* source,
+    void* destination,
+    int32_t width,
+    int32_t height,
+    size_t source_stride,
+    size_t destination_stride,
+    uint8_t bytes_per_pixel,
+    enum DisplayPixelRotation rotation,
+    bool swap_rgb565
+);
+
+#ifdef __cplusplus
+}
+#endif
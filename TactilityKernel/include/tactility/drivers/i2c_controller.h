@@ -6,6 +6,7 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "gpio.h"
@@ -262,6 +263,108 @@ error_t i2c_controller_register16be_get(struct Device* device, uint8_t address,
  */
 error_t i2c_controller_register16be_set(struct Device* device, uint8_t address, uint8_t reg, uint16_t value, TickType_t timeout);
 
+/** @brief The maximum number of operations in an I2cBatch */
+#define I2C_BATCH_OPERATIONS_MAX 16
+
+/** @brief The maximum number of bytes that all operations of an I2cBatch write and read together */
+#define I2C_BATCH_DATA_SIZE_MAX 64
+
+/**
+ * @brief The slave device increments its register address after each byte, so operations on consecutive
+ * registers can be merged into a single transfer.
+ */
+#define I2C_BATCH_FLAG_AUTO_INCREMENT (1U << 0)
+
+enum I2cBatchOperationType {
+    I2C_BATCH_OPERATION_WRITE_REGISTER,
+    I2C_BATCH_OPERATION_READ_REGISTER,
+};
+
+struct I2cBatchOperation {
+    enum I2cBatchOperationType type;
+    uint8_t reg;
+    uint8_t size;
+    /** @brief Where the data is in I2cBatch::data */
+    uint8_t data_offset;
+    /** @brief Where the data is copied to for reads */
+    uint8_t* read_data;
+};
+
+/**
+ * @brief Register operations for 1 slave device that are queued and then submitted together.
+ * Only access it through the i2c_batch_*() functions.
+ */
+struct I2cBatch {
+    struct Device* device;
+    uint8_t address;
+    uint8_t flags;
+    uint8_t operation_count;
+    uint8_t data_size;
+    /** @brief The first error while queueing, returned by i2c_batch_submit() */
+    error_t error;
+    struct I2cBatchOperation operations[I2C_BATCH_OPERATIONS_MAX];
+    uint8_t data[I2C_BATCH_DATA_SIZE_MAX];
+};
+
+/**
+ * @brief Initializes an empty batch.
+ * @param[out] batch the batch to initialize
+ * @param[in] device the I2C controller device
+ * @param[in] address the 7-bit I2C address of the slave device
+ * @param[in] flags I2C_BATCH_FLAG_* bits, or 0
+ */
+void i2c_batch_init(struct I2cBatch* batch, struct Device* device, uint8_t address, uint8_t flags);
+
+/**
+ * @brief Queues a register write. The data is copied, so it doesn't need to stay valid until the batch is submitted.
+ * @param[in,out] batch the batch
+ * @param[in] reg the register address to write to
+ * @param[in] data the buffer containing the data to write
+ * @param[in] dataSize the number of bytes to write
+ * @retval ERROR_NONE when the operation was queued
+ * @retval ERROR_INVALID_ARGUMENT when dataSize is 0: the error is also returned by i2c_batch_submit()
+ * @retval ERROR_BUFFER_OVERFLOW when the batch is full: the error is also returned by i2c_batch_submit()
+ */
+error_t i2c_batch_write_register(struct I2cBatch* batch, uint8_t reg, const uint8_t* data, uint8_t dataSize);
+
+/**
+ * @brief Queues a write of an 8-bit register.
+ * @param[in,out] batch the batch
+ * @param[in] reg the register address to write to
+ * @param[in] value the value to set the register to
+ * @retval ERROR_NONE when the operation was queued
+ * @retval ERROR_BUFFER_OVERFLOW when the batch is full: the error is also returned by i2c_batch_submit()
+ */
+error_t i2c_batch_register8_set(struct I2cBatch* batch, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Queues a register read.
+ * @param[in,out] batch the batch
+ * @param[in] reg the register address to read from
+ * @param[out] data the buffer to store the read data, which must stay valid until the batch is submitted
+ * @param[in] dataSize the number of bytes to read
+ * @retval ERROR_NONE when the operation was queued
+ * @retval ERROR_INVALID_ARGUMENT when dataSize is 0: the error is also returned by i2c_batch_submit()
+ * @retval ERROR_BUFFER_OVERFLOW when the batch is full: the error is also returned by i2c_batch_submit()
+ */
+error_t i2c_batch_read_register(struct I2cBatch* batch, uint8_t reg, uint8_t* data, uint8_t dataSize);
+
+/**
+ * @brief Executes the queued operations in order and empties the batch.
+ * The controller device is locked with device_lock() for the whole batch, so the operations don't interleave
+ * with other batches and register caches on the same bus. The other i2c_controller_*() functions don't take
+ * that lock: callers that mix them with batches on the same slave device must lock the controller themselves.
+ * With I2C_BATCH_FLAG_AUTO_INCREMENT, consecutive operations of the same
+ * type on consecutive registers are merged into a single transfer.
+ * @param[in,out] batch the batch
+ * @param[in] timeout the maximum time to wait for each transfer to complete
+ * @retval ERROR_NONE when all operations were successful
+ * @retval ERROR_BUFFER_OVERFLOW when operations didn't fit the batch: nothing was executed
+ * @retval ERROR_INVALID_ARGUMENT when an operation had no data: nothing was executed
+ * @return otherwise the error of the first transfer that failed: the operations after it were not executed
+ */
+error_t i2c_batch_submit(struct I2cBatch* batch, TickType_t timeout);
+
 extern const struct DeviceType I2C_CONTROLLER_TYPE;
 
 #ifdef __cplusplus
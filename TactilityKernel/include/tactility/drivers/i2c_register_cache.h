@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Write-through cache for the 8-bit registers of an I2C slave device, e.g. a PMIC or an IO expander.
+// Reads of cached registers don't use the bus, and read-modify-write operations only write, or don't
+// use the bus at all when the value doesn't change. Registers that the device changes by itself
+// (e.g. input ports and interrupt status) must be marked as volatile: they are always read from the bus.
+// Each transfer locks the controller device with device_lock(), so it doesn't interleave with i2c_batch_submit().
+// The cached values have their own lock, which is held for the whole operation.
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tactility/freertos/freertos.h>
+#include <tactility/error.h>
+
+struct Device;
+
+struct I2cRegisterCache;
+
+/**
+ * @brief Allocates a register cache for a slave device. The cache is empty: registers are cached when they're first read or written.
+ * Only access the registers through the cache afterwards, so the cached values stay valid.
+ * @param[in] device the I2C controller device
+ * @param[in] address the 7-bit I2C address of the slave device
+ * @param[in] volatile_registers the registers that are never cached, or NULL
+ * @param[in] volatile_register_count the number of items in volatile_registers
+ * @return the cache, or NULL when out of memory
+ */
+struct I2cRegisterCache* i2c_register_cache_alloc(struct Device* device, uint8_t address, const uint8_t* volatile_registers, size_t volatile_register_count);
+
+/**
+ * @brief Frees a register cache.
+ * @param[in] cache the cache to free
+ */
+void i2c_register_cache_free(struct I2cRegisterCache* cache);
+
+/**
+ * @brief Gets the value of a register: from the cache when it's cached, otherwise from the device.
+ * @param[in] cache the cache
+ * @param[in] reg the register address
+ * @param[out] value the register value
+ * @param[in] timeout the maximum time to wait for the read operation to complete
+ * @retval ERROR_NONE when the value was read
+ */
+error_t i2c_register_cache_get(struct I2cRegisterCache* cache, uint8_t reg, uint8_t* value, TickType_t timeout);
+
+/**
+ * @brief Writes a register and caches the value.
+ * @param[in] cache the cache
+ * @param[in] reg the register address
+ * @param[in] value the value to write
+ * @param[in] timeout the maximum time to wait for the write operation to complete
+ * @retval ERROR_NONE when the value was written
+ */
+error_t i2c_register_cache_set(struct I2cRegisterCache* cache, uint8_t reg, uint8_t value, TickType_t timeout);
+
+/**
+ * @brief Changes bits of a register. The register is only written when its value changes.
+ * @param[in] cache the cache
+ * @param[in] reg the register address
+ * @param[in] mask the bits to change
+ * @param[in] value the new values of the bits in mask
+ * @param[in] timeout the maximum time to wait for each operation to complete
+ * @retval ERROR_NONE when the register has the new value
+ */
+error_t i2c_register_cache_update_bits(struct I2cRegisterCache* cache, uint8_t reg, uint8_t mask, uint8_t value, TickType_t timeout);
+
+/**
+ * @brief Sets bits of a register, like i2c_controller_register8_set_bits().
+ * @param[in] cache the cache
+ * @param[in] reg the register address
+ * @param[in] bits_to_set a bitmask of bits to set (set to 1)
+ * @param[in] timeout the maximum time to wait for each operation to complete
+ * @retval ERROR_NONE when the register has the new value
+ */
+error_t i2c_register_cache_set_bits(struct I2cRegisterCache* cache, uint8_t reg, uint8_t bits_to_set, TickType_t timeout);
+
+/**
+ * @brief Resets bits of a register, like i2c_controller_register8_reset_bits().
+ * @param[in] cache the cache
+ * @param[in] reg the register address
+ * @param[in] bits_to_reset a bitmask of bits to reset (set to 0)
+ * @param[in] timeout the maximum time to wait for each operation to complete
+ * @retval ERROR_NONE when the register has the new value
+ */
+error_t i2c_register_cache_reset_bits(struct I2cRegisterCache* cache, uint8_t reg, uint8_t bits_to_reset, TickType_t timeout);
+
+/**
+ * @brief Forgets all cached values, e.g. after a reset of the device.
+ * @param[in] cache the cache
+ */
+void i2c_register_cache_invalidate(struct I2cRegisterCache* cache);
+
+#ifdef __cplusplus
+}
+#endif
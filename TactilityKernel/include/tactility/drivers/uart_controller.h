@@ -173,6 +173,8 @@ error_t uart_controller_read_bytes(struct Device* device, uint8_t* buffer, size_
 
 /**
  * @brief Reads from UART until a specific byte is encountered.
+ * Reads 1 byte per driver call, so it doesn't read past until_byte. Use a UartReader (see uart_reader.h)
+ * to read lines continuously, e.g. from a GPS module.
  * @param[in] device the UART controller device
  * @param[out] buffer the buffer to store the read data
  * @param[in] buffer_size the size of the buffer
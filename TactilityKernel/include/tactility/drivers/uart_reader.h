@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Apache-2.0
+
+// Buffered reading from a UART controller: each driver call reads all the bytes that are
+// available, instead of 1 byte per call like uart_controller_read_until(). Lines are returned
+// as views into the reader's buffer, so they don't need to be copied.
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tactility/freertos/freertos.h>
+#include <tactility/error.h>
+
+struct Device;
+
+/** @brief The buffer size that fits the longest NMEA sentences and most module responses */
+#define UART_READER_BUFFER_SIZE_DEFAULT 256
+
+struct UartReader;
+
+/**
+ * @brief Allocates a reader for an open UART controller.
+ * Only read through the reader afterwards: bytes that it already buffered are not available to other readers.
+ * @param[in] device the UART controller device
+ * @param[in] buffer_size the buffer size in bytes, which is also the maximum line length
+ * @return the reader, or NULL when out of memory or when buffer_size is 0
+ */
+struct UartReader* uart_reader_alloc(struct Device* device, size_t buffer_size);
+
+/**
+ * @brief Frees a reader. Bytes that it buffered but didn't return yet are lost.
+ * @param[in] reader the reader to free
+ */
+void uart_reader_free(struct UartReader* reader);
+
+/**
+ * @brief Reads the next line, up to and including the delimiter.
+ * @param[in] reader the reader
+ * @param[in] delimiter the last byte of a line, e.g. '\n'
+ * @param[out] out_line the start of the line, only valid until the next call for this reader
+ * @param[out] out_length the length of the line, including the delimiter
+ * @param[in] timeout the maximum time to wait for the rest of the line
+ * @retval ERROR_NONE when a line was read
+ * @retval ERROR_TIMEOUT when the line isn't complete yet: the bytes are kept for the next call
+ * @retval ERROR_BUFFER_OVERFLOW when the line doesn't fit the buffer: the buffer is returned as an
+ * incomplete line and the rest of the line is returned by the next call
+ * @retval ERROR_INVALID_STATE when the UART controller isn't open
+ */
+error_t uart_reader_read_line(struct UartReader* reader, uint8_t delimiter, const uint8_t** out_line, size_t* out_length, TickType_t timeout);
+
+/**
+ * @brief Reads the bytes that are available, waiting until there is at least 1 byte.
+ * @param[in] reader the reader
+ * @param[out] buffer the buffer to store the data
+ * @param[in] buffer_size the maximum number of bytes to read
+ * @param[out] out_length the number of bytes that were read
+ * @param[in] timeout the maximum time to wait for the first byte
+ * @retval ERROR_NONE when at least 1 byte was read
+ * @retval ERROR_TIMEOUT when no bytes arrived within the timeout
+ * @retval ERROR_INVALID_STATE when the UART controller isn't open
+ */
+error_t uart_reader_read(struct UartReader* reader, uint8_t* buffer, size_t buffer_size, size_t* out_length, TickType_t timeout);
+
+/**
+ * @brief Gets the number of bytes that the reader buffered and didn't return yet.
+ * @param[in] reader the reader
+ * @return the number of buffered bytes
+ */
+size_t uart_reader_get_buffered(const struct UartReader* reader);
+
+/**
+ * @brief Discards the buffered bytes, e.g. after uart_controller_flush_input().
+ * @param[in] reader the reader
+ */
+void uart_reader_reset(struct UartReader* reader);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,6 +4,9 @@
 
 #ifdef ESP_PLATFORM
 #include <esp_log.h>
+#else
+#include <tactility/error.h>
+#include <stdint.h>
 #endif
 
 #ifdef __cplusplus
@@ -23,12 +26,146 @@ enum LogLevel {
 
 void log_generic(enum LogLevel level, const char* tag, const char* format, ...);
 
+/** Maximum length of a tag that can have its own level, excluding the null terminator */
+#define LOG_TAG_LENGTH_MAX 23U
+
+/** Configuration for log_async_start() */
+struct LogAsyncConfig {
+    /** Amount of records in the ring buffer. Must be a power of 2. */
+    uint32_t record_count;
+    /** How long the drain task sleeps before each pass over the ring buffer */
+    uint32_t drain_interval_ms;
+    /** Stack size of the drain task */
+    uint32_t drain_stack_size;
+    /** Nullable path of the file to append the output to. Output goes to stdout when this is NULL. */
+    const char* file_path;
+};
+
+struct LogStats {
+    /** Amount of records that were written to the output */
+    uint32_t written;
+    /** Amount of records that were discarded because the ring buffer was full */
+    uint32_t dropped;
+};
+
+/**
+ * Set the level for a specific tag. Messages with a higher (more verbose) level are discarded
+ * before they are formatted.
+ *
+ * @param[in] tag the tag, which is copied
+ * @param[in] level the most verbose level that is still logged for this tag
+ * @retval ERROR_INVALID_ARGUMENT when the tag is longer than LOG_TAG_LENGTH_MAX
+ * @retval ERROR_RESOURCE when the maximum amount of tags with their own level is reached
+ * @retval ERROR_NONE on success
+ */
+error_t log_set_level(const char* tag, enum LogLevel level);
+
+/**
+ * @param[in] tag the tag
+ * @return the level for the tag, or the default level when the tag has no level of its own
+ */
+enum LogLevel log_get_level(const char* tag);
+
+/** Set the level for tags that don't have their own level. The default is LOG_LEVEL_VERBOSE. */
+void log_set_default_level(enum LogLevel level);
+
+/**
+ * Start writing log output from a dedicated drain task.
+ * After this, log_generic() only formats the message into a ring buffer. When the ring buffer is full,
+ * messages are dropped and counted instead of blocking the caller.
+ *
+ * @param[in] config non-null configuration
+ * @retval ERROR_INVALID_STATE when the async output is already started
+ * @retval ERROR_INVALID_ARGUMENT when the record count is not a power of 2
+ * @retval ERROR_RESOURCE when the file can't be opened or the drain task can't be started
+ * @retval ERROR_OUT_OF_MEMORY when the ring buffer can't be allocated
+ * @retval ERROR_NONE on success
+ */
+error_t log_async_start(const struct LogAsyncConfig* config);
+
+/**
+ * Stop the drain task, write out all buffered records and return to synchronous output on stdout.
+ * @retval ERROR_INVALID_STATE when the async output wasn't started
+ * @retval ERROR_NONE on success
+ */
+error_t log_async_stop(void);
+
+/** Write out all buffered records on the calling thread. Does nothing when the async output isn't started. */
+void log_flush(void);
+
+/**
+ * Write out all buffered records and switch to synchronous output, without waiting for the drain task
+ * or stopping it. Used on the crash path, where the drain task itself might be the task that crashed.
+ */
+void log_flush_on_crash(void);
+
+/** @param[out] stats the counters since the async output was started */
+void log_get_stats(struct LogStats* stats);
+
 #define LOG_E(tag, ...) log_generic(LOG_LEVEL_ERROR, tag, ##__VA_ARGS__)
 #define LOG_W(tag, ...) log_generic(LOG_LEVEL_WARNING, tag, ##__VA_ARGS__)
 #define LOG_I(tag, ...) log_generic(LOG_LEVEL_INFO, tag, ##__VA_ARGS__)
 #define LOG_D(tag, ...) log_generic(LOG_LEVEL_DEBUG, tag, ##__VA_ARGS__)
 #define LOG_V(tag, ...) log_generic(LOG_LEVEL_VERBOSE, tag, ##__VA_ARGS__)
 
+/** Maximum amount of arguments for LOG_FAST() */
+#define LOG_FAST_ARG_COUNT_MAX 8U
+
+/**
+ * Log a message of which the formatting is deferred. Use LOG_FAST() instead of calling this directly.
+ * @param[in] level the log level
+ * @param[in] tag the tag, which must stay valid for the lifetime of the application (e.g. a string literal)
+ * @param[in] format the format, which must stay valid for the lifetime of the application (e.g. a string literal)
+ * @param[in] args the arguments, each converted to 64 bits by LOG_FAST()
+ * @param[in] arg_count the amount of arguments
+ */
+void log_fast_generic(enum LogLevel level, const char* tag, const char* format, const uint64_t* args, uint32_t arg_count);
+
+#ifdef __cplusplus
+
+#define LOG_FAST_ARGS_0()
+#define LOG_FAST_ARGS_1(a) log_fast_arg(a)
+#define LOG_FAST_ARGS_2(a, ...) log_fast_arg(a), LOG_FAST_ARGS_1(__VA_ARGS__)
+#define LOG_FAST_ARGS_3(a, ...) log_fast_arg(a), LOG_FAST_ARGS_2(__VA_ARGS__)
+#define LOG_FAST_ARGS_4(a, ...) log_fast_arg(a), LOG_FAST_ARGS_3(__VA_ARGS__)
+#define LOG_FAST_ARGS_5(a, ...) log_fast_arg(a), LOG_FAST_ARGS_4(__VA_ARGS__)
+#define LOG_FAST_ARGS_6(a, ...) log_fast_arg(a), LOG_FAST_ARGS_5(__VA_ARGS__)
+#define LOG_FAST_ARGS_7(a, ...) log_fast_arg(a), LOG_FAST_ARGS_6(__VA_ARGS__)
+#define LOG_FAST_ARGS_8(a, ...) log_fast_arg(a), LOG_FAST_ARGS_7(__VA_ARGS__)
+#define LOG_FAST_ARGS_SELECT(_0, _1, _2, _3, _4, _5, _6, _7, _8, name, ...) name
+#define LOG_FAST_ARGS(...) LOG_FAST_ARGS_SELECT(_0 __VA_OPT__(,) __VA_ARGS__, LOG_FAST_ARGS_8, LOG_FAST_ARGS_7, LOG_FAST_ARGS_6, LOG_FAST_ARGS_5, LOG_FAST_ARGS_4, LOG_FAST_ARGS_3, LOG_FAST_ARGS_2, LOG_FAST_ARGS_1, LOG_FAST_ARGS_0)(__VA_ARGS__)
+
+/**
+ * Log without formatting on the calling thread: only the format pointer and the raw arguments are stored.
+ * The message is formatted by the drain task (see log_async_start()), or immediately when logging is synchronous.
+ * Only on posix: on ESP32, LOG_FAST_* are the regular ESP_LOG* macros, which format on the calling task.
+ *
+ * Restrictions compared to LOG_E() etc.:
+ * - The tag and the format must be string literals (or otherwise live forever)
+ * - Strings passed for %s must live forever, because only their pointer is stored
+ * - At most LOG_FAST_ARG_COUNT_MAX arguments, and no '*' width or precision
+ * The format is still checked by the compiler.
+ */
+#define LOG_FAST(level, tag, format, ...) \
+    do { \
+        (void)sizeof(log_fast_check_format(format, ##__VA_ARGS__)); \
+        const uint64_t log_fast_args[] = { 0U, LOG_FAST_ARGS(__VA_ARGS__) }; \
+        log_fast_generic(level, tag, format, log_fast_args + 1U, (sizeof(log_fast_args) / sizeof(uint64_t)) - 1U); \
+    } while (0)
+
+#else
+
+// Plain C has no overloading to convert the arguments, so the formatting isn't deferred
+#define LOG_FAST(level, tag, ...) log_generic(level, tag, ##__VA_ARGS__)
+
+#endif
+
+#define LOG_FAST_E(tag, ...) LOG_FAST(LOG_LEVEL_ERROR, tag, ##__VA_ARGS__)
+#define LOG_FAST_W(tag, ...) LOG_FAST(LOG_LEVEL_WARNING, tag, ##__VA_ARGS__)
+#define LOG_FAST_I(tag, ...) LOG_FAST(LOG_LEVEL_INFO, tag, ##__VA_ARGS__)
+#define LOG_FAST_D(tag, ...) LOG_FAST(LOG_LEVEL_DEBUG, tag, ##__VA_ARGS__)
+#define LOG_FAST_V(tag, ...) LOG_FAST(LOG_LEVEL_VERBOSE, tag, ##__VA_ARGS__)
+
 #else
 
 #define LOG_E(tag, ...) ESP_LOGE(tag, ##__VA_ARGS__)
@@ -37,8 +174,48 @@ void log_generic(enum LogLevel level, const char* tag, const char* format, ...);
 #define LOG_D(tag, ...) ESP_LOGD(tag, ##__VA_ARGS__)
 #define LOG_V(tag, ...) ESP_LOGV(tag, ##__VA_ARGS__)
 
+// ESP-IDF formats on the calling task, so LOG_FAST_* only defers the formatting on posix
+#define LOG_FAST_E(tag, ...) ESP_LOGE(tag, ##__VA_ARGS__)
+#define LOG_FAST_W(tag, ...) ESP_LOGW(tag, ##__VA_ARGS__)
+#define LOG_FAST_I(tag, ...) ESP_LOGI(tag, ##__VA_ARGS__)
+#define LOG_FAST_D(tag, ...) ESP_LOGD(tag, ##__VA_ARGS__)
+#define LOG_FAST_V(tag, ...) ESP_LOGV(tag, ##__VA_ARGS__)
+
 #endif
 
 #ifdef __cplusplus
 }
 #endif
+
+#if defined(__cplusplus) && !defined(ESP_PLATFORM)
+
+// This header can end up inside an extern "C" block of another header
+extern "C++" {
+
+#include <cstring>
+#include <type_traits>
+
+/** Only used in unevaluated context by LOG_FAST(), for compile-time format checking */
+int log_fast_check_format(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+/** Convert a LOG_FAST() argument to 64 bits, in a way that log.cpp can convert back for the conversion specifier */
+template<typename T>
+inline uint64_t log_fast_arg(T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        double double_value = static_cast<double>(value);
+        uint64_t bits;
+        std::memcpy(&bits, &double_value, sizeof(bits));
+        return bits;
+    } else if constexpr (std::is_null_pointer_v<T>) {
+        return 0U;
+    } else if constexpr (std::is_pointer_v<T>) {
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+    } else {
+        // Signed values are sign-extended, so they can be truncated back to any smaller type
+        return static_cast<uint64_t>(value);
+    }
+}
+
+} // extern "C++"
+
+#endif
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <tactility/error.h>
+
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -37,6 +40,28 @@ struct MemoryPolicy {
     size_t alignment;
 };
 
+/** The maximum length of MemoryTagStats::tag, including the null terminator. Longer tags are truncated. */
+#define MEMORY_TAG_NAME_MAX 32U
+
+/** Allocation statistics for a single tag (see memory_alloc_tagged()) */
+struct MemoryTagStats {
+    /** A copy of the tag, or MEMORY_TAG_UNTAGGED for allocations with a NULL tag */
+    char tag[MEMORY_TAG_NAME_MAX];
+    /** Bytes currently allocated */
+    size_t current_bytes;
+    /** Highest value of current_bytes since tracking was enabled */
+    size_t peak_bytes;
+    /** Allocations that are currently alive */
+    size_t allocation_count;
+    /** Allocations made since tracking was enabled, including the ones that were freed */
+    size_t total_allocation_count;
+    /** Size of the largest single allocation since tracking was enabled */
+    size_t largest_block;
+};
+
+/** The tag under which allocations without a tag are tracked */
+#define MEMORY_TAG_UNTAGGED "untagged"
+
 /** The default policy: no required/desired capabilities, no alignment requirement. */
 extern const struct MemoryPolicy MEMORY_POLICY_DEFAULT;
 
@@ -75,6 +100,37 @@ void* memory_realloc_with_policy(void* ptr, size_t size, const struct MemoryPoli
  */
 void* memory_calloc_with_policy(size_t count, size_t size, const struct MemoryPolicy* policy);
 
+/**
+ * @brief Like memory_alloc_with_policy(), and accounts the allocation to @a tag while allocation tracking is enabled
+ * (see memory_tracking_set_enabled()).
+ * @param[in] size number of bytes to allocate
+ * @param[in] policy the allocation constraints
+ * @param[in] tag nullable name of the subsystem that owns the allocation. When NULL, the allocation is accounted
+ * to the tag of the calling thread (see memory_tracking_set_thread_tag()).
+ * @return the allocated memory, or NULL on failure
+ */
+void* memory_alloc_tagged(size_t size, const struct MemoryPolicy* policy, const char* tag);
+
+/**
+ * @brief Like memory_realloc_with_policy(), and accounts the new allocation to @a tag. See memory_alloc_tagged().
+ * @param[in] ptr the memory to resize, or NULL to allocate a new block
+ * @param[in] size new memory size in bytes
+ * @param[in] policy the policy for the new allocation
+ * @param[in] tag nullable name of the subsystem that owns the allocation
+ * @return the (possibly moved) allocated memory, or NULL on failure - in which case ptr is left untouched
+ */
+void* memory_realloc_tagged(void* ptr, size_t size, const struct MemoryPolicy* policy, const char* tag);
+
+/**
+ * @brief Like memory_calloc_with_policy(), and accounts the allocation to @a tag. See memory_alloc_tagged().
+ * @param[in] count number of elements
+ * @param[in] size size of each element in bytes
+ * @param[in] policy the allocation constraints
+ * @param[in] tag nullable name of the subsystem that owns the allocation
+ * @return the allocated memory, or NULL on failure
+ */
+void* memory_calloc_tagged(size_t count, size_t size, const struct MemoryPolicy* policy, const char* tag);
+
 /**
  * @brief Allocates memory using MEMORY_POLICY_DEFAULT.
  * @param[in] size number of bytes to allocate
@@ -110,6 +166,135 @@ inline void* memory_realloc(void* ptr, size_t size) {
  */
 void memory_free(void* ptr);
 
+/** An allocator for blocks of a single size, carved from larger chunks that are kept until the pool is freed */
+struct MemoryPool;
+
+struct MemoryPoolStats {
+    /** The size of each block, after rounding up for alignment */
+    size_t block_size;
+    /** Blocks that are currently handed out */
+    size_t blocks_in_use;
+    /** Highest value of blocks_in_use since the pool was created */
+    size_t blocks_in_use_peak;
+    /** Blocks in all chunks, handed out or not */
+    size_t block_capacity;
+    /** Amount of chunks that were allocated from the heap */
+    size_t chunk_count;
+};
+
+/**
+ * @brief Create a pool for blocks of a single size.
+ * Chunks are allocated with the given policy, so a pool with MEMORY_CAPABILITY_INTERNAL in policy->required
+ * only hands out internal memory. Blocks are aligned to policy->alignment, or to the platform's maximum
+ * fundamental alignment when that is larger.
+ * @param[in] block_size the size of each block in bytes
+ * @param[in] blocks_per_chunk how many blocks are added to the pool each time it runs out
+ * @param[in] policy the policy for the chunks
+ * @return the pool, or NULL when out of memory
+ */
+struct MemoryPool* memory_pool_alloc(size_t block_size, size_t blocks_per_chunk, const struct MemoryPolicy* policy);
+
+/**
+ * @brief Free the pool and all its chunks.
+ * @warning all blocks must have been returned with memory_pool_block_free()
+ * @param[in] pool the pool to free
+ */
+void memory_pool_free(struct MemoryPool* pool);
+
+/**
+ * @brief Take a block from the pool, growing the pool by one chunk when it's empty.
+ * @param[in] pool the pool
+ * @return the uninitialized block, or NULL when out of memory
+ */
+void* memory_pool_block_alloc(struct MemoryPool* pool);
+
+/**
+ * @brief Return a block to the pool it was taken from.
+ * @param[in] pool the pool
+ * @param[in] block the block, or NULL (a no-op)
+ */
+void memory_pool_block_free(struct MemoryPool* pool, void* block);
+
+/**
+ * @param[in] pool the pool
+ * @param[out] stats the statistics of the pool
+ */
+void memory_pool_get_stats(struct MemoryPool* pool, struct MemoryPoolStats* stats);
+
+/** Allocations up to this size are served by the shared size class pools of memory_small_alloc() */
+#define MEMORY_SMALL_SIZE_MAX 256U
+
+/** The tag of the chunks of the memory_small_alloc() pools. These chunks are never freed. */
+#define MEMORY_TAG_SMALL "memory_small"
+
+/**
+ * @brief Allocate a small block from the shared size class pools, for objects that are created and destroyed often.
+ * Sizes above MEMORY_SMALL_SIZE_MAX are passed on to memory_alloc().
+ * @param[in] size number of bytes to allocate
+ * @return the allocated memory, aligned to the platform's maximum fundamental alignment, or NULL on failure
+ */
+void* memory_small_alloc(size_t size);
+
+/**
+ * @brief Free memory from memory_small_alloc().
+ * @param[in] ptr the memory to free, or NULL (a no-op)
+ * @param[in] size the size that was passed to memory_small_alloc()
+ */
+void memory_small_free(void* ptr, size_t size);
+
+/**
+ * @brief Get the statistics of the size class pools of memory_small_alloc(), smallest class first.
+ * @param[out] stats nullable array to fill in
+ * @param[in] max_count the capacity of stats
+ * @return the amount of size classes
+ */
+size_t memory_small_get_stats(struct MemoryPoolStats* stats, size_t max_count);
+
+/**
+ * @brief Start or stop tracking the allocations of the memory_* functions per tag (see memory_alloc_tagged()).
+ * Only allocations made while tracking is enabled are accounted. Disabling tracking discards all statistics.
+ * @note Memory from new, malloc() and other allocators that don't go through the memory_* functions is not tracked.
+ * @param[in] enabled true to start tracking
+ */
+void memory_tracking_set_enabled(bool enabled);
+
+/** @return true when allocation tracking is enabled */
+bool memory_tracking_is_enabled(void);
+
+/**
+ * @brief Set the tag of the calling thread's memory_* allocations that don't have a tag of their own.
+ * Service managers use this to account a service's memory_* allocations to the service while it starts and stops.
+ * Allocations through new or malloc() are not accounted, so the statistics of a tag are a lower bound.
+ * @param[in] tag the tag, which must stay valid until it is replaced, or NULL for MEMORY_TAG_UNTAGGED
+ * @return the previous tag of the thread, so it can be restored
+ */
+const char* memory_tracking_set_thread_tag(const char* tag);
+
+/**
+ * @brief Get the statistics of all tags that were used since tracking was enabled.
+ * @param[out] stats nullable array to fill in
+ * @param[in] max_count the capacity of stats
+ * @return the amount of tags, which can be larger than max_count
+ */
+size_t memory_tracking_get_stats(struct MemoryTagStats* stats, size_t max_count);
+
+/**
+ * @brief Get the statistics of a single tag.
+ * @param[in] tag the tag, or MEMORY_TAG_UNTAGGED
+ * @param[out] stats the statistics
+ * @retval ERROR_INVALID_STATE when tracking is disabled
+ * @retval ERROR_NOT_FOUND when nothing was allocated with this tag since tracking was enabled
+ * @retval ERROR_NONE on success
+ */
+error_t memory_tracking_get_stats_by_tag(const char* tag, struct MemoryTagStats* stats);
+
+/**
+ * @brief Log every tracked allocation that is still alive.
+ * Chunks of the memory_small_alloc() pools are not reported, because they are kept by design.
+ * @return the amount of reported allocations
+ */
+size_t memory_tracking_log_leaks(void);
+
 #ifdef __cplusplus
 }
 #endif
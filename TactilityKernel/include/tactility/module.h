@@ -158,7 +158,8 @@ bool module_resolve_symbol(struct Module* module, const char* symbol_name, uintp
 
 /**
  * @brief Resolve a symbol from any module
- * @details This function iterates through all started modules in the parent and attempts to resolve the symbol.
+ * @details This function searches the symbols of all started modules, in the order that the modules were added.
+ * It uses an index of all these symbols, which is rebuilt on the first call after a module is started or stopped.
  * @param symbol_name name of the symbol to resolve
  * @param symbol_address pointer to store the address of the resolved symbol
  * @return true if the symbol was found, false otherwise
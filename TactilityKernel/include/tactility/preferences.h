@@ -1,7 +1,14 @@
 // SPDX-License-Identifier: Apache-2.0
 
 /**
- * @brief Key-value settings, persisted as a .properties file on disk (instead of NVS/in-memory).
+ * @brief Key-value settings, persisted as a file on disk (instead of NVS/in-memory).
+ *
+ * Every file is loaded once and then cached in memory, shared by all handles that are opened for
+ * the same path: reopening it doesn't read the file again unless it was changed by something else.
+ * A file is only written when values were changed, always via a temporary file that replaces the
+ * previous one, so a crash or power loss during a commit leaves the previous content intact. The
+ * previous file is kept as "<path>.bak" during the replacement, and is restored by the next load
+ * when the commit didn't complete.
  */
 #pragma once
 
@@ -20,21 +27,78 @@ extern "C" {
  */
 typedef struct Preferences Preferences;
 
+/** On-disk formats of a preferences file. Both formats are recognized when loading. */
+enum PreferencesFormat {
+    /** A .properties file with tagged values ("i32:42"), can be edited by hand */
+    PREFERENCES_FORMAT_PROPERTIES = 0,
+    /** A compact binary file that's faster to load and commit */
+    PREFERENCES_FORMAT_BINARY = 1
+};
+
+struct PreferencesOptions {
+    /** The format that commits write */
+    enum PreferencesFormat format;
+    /**
+     * 0 to commit changes when a handle is closed, like preferences_open() does.
+     * Otherwise changes are written back this many milliseconds after the last change, so many
+     * changes in a row (e.g. a settings screen with sliders) result in a single write.
+     * Use preferences_flush() to commit earlier, e.g. before powering off.
+     */
+    uint32_t commit_delay_ms;
+};
+
+/** File access counters for all preferences files, for diagnostics and benchmarks */
+struct PreferencesStats {
+    uint32_t file_reads;
+    uint32_t file_writes;
+    /** Files that are currently cached in memory, including closed ones */
+    uint32_t cached_files;
+};
+
 /**
- * Open (or create) a preferences store backed by the properties file at @a path. The parent
- * directory is created (recursively, like mkdir -p) if it doesn't already exist. The file is
- * read into memory now; changes made with preferences_put_*() are only written back to disk by
- * preferences_close().
+ * Open (or create) a preferences store backed by the file at @a path, with the default options:
+ * commits use the properties format, and happen when a handle is closed. Both formats are read.
+ * The parent directory is created (recursively, like mkdir -p) if it doesn't already exist. The
+ * file is read into memory now, unless it's already cached; changes made with preferences_put_*()
+ * are only written back to disk by preferences_close().
  * @param[in] path absolute or relative file path (e.g. "/data/settings.properties")
- * @return the new instance, or NULL if the parent directory couldn't be created, or on
- * allocation failure
+ * @return the new instance, or NULL if the parent directory couldn't be created, if @a path is
+ * already open with other options, or on allocation failure
  */
 Preferences* preferences_open(const char* path);
 
-/** Writes any pending preferences_put_*() changes to the backing file, then releases the
- * instance. */
+/**
+ * Like preferences_open(), with a choice of file format and write-back commits.
+ * All handles for @a path share its options: they're set by the first open, and can only change
+ * once all handles are closed and their changes are committed.
+ * @param[in] path absolute or relative file path (e.g. "/data/settings.bin")
+ * @param[in] options the format and commit behaviour
+ * @return the new instance, or NULL if the parent directory couldn't be created, if @a path is
+ * already open (or has pending changes) with other options, or on allocation failure
+ */
+Preferences* preferences_open_with_options(const char* path, const struct PreferencesOptions* options);
+
+/** Writes any pending preferences_put_*() changes to the backing file (or schedules that, when
+ * it was opened with a commit_delay_ms), then releases the instance. */
 void preferences_close(Preferences* preferences);
 
+/**
+ * Writes pending changes to the backing file now.
+ * @retval ERROR_NONE when the file is up-to-date
+ * @retval ERROR_RESOURCE writing failed (full filesystem, I/O error, ...) - the changes remain pending
+ */
+error_t preferences_flush(Preferences* preferences);
+
+/**
+ * Writes the pending changes of all preferences files now, e.g. before a reboot or power-off.
+ * @retval ERROR_NONE when all files are up-to-date
+ * @retval ERROR_RESOURCE writing one or more files failed - their changes remain pending
+ */
+error_t preferences_flush_all(void);
+
+/** Gets the file access counters since boot. */
+void preferences_get_stats(struct PreferencesStats* out_stats);
+
 bool preferences_has_bool(const Preferences* preferences, const char* key);
 bool preferences_has_int32(const Preferences* preferences, const char* key);
 bool preferences_has_int64(const Preferences* preferences, const char* key);
@@ -51,7 +115,7 @@ bool preferences_opt_int64(const Preferences* preferences, const char* key, int6
 error_t preferences_opt_string(const Preferences* preferences, const char* key, char* out_value, size_t out_value_size);
 
 /** Sets the value in the in-memory cache; only persisted to the backing file by
- * preferences_close(). */
+ * preferences_close(), preferences_flush() or a delayed commit (see PreferencesOptions). */
 void preferences_put_bool(Preferences* preferences, const char* key, bool value);
 void preferences_put_int32(Preferences* preferences, const char* key, int32_t value);
 void preferences_put_int64(Preferences* preferences, const char* key, int64_t value);
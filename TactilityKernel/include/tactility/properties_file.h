@@ -43,6 +43,12 @@ PropertiesFile* properties_file_open(const char* path);
  */
 error_t properties_file_close(PropertiesFile* file);
 
+/**
+ * Releases the instance without writing anything to the backing file, e.g. after only reading it.
+ * Pending properties_file_set() changes are lost.
+ */
+void properties_file_discard(PropertiesFile* file);
+
 bool properties_file_has(const PropertiesFile* file, const char* key);
 
 /**
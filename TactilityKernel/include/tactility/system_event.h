@@ -99,7 +99,9 @@ typedef void (*system_event_callback_t)(struct SystemEvent* event, void* context
  * @param[in] type the event type to subscribe to
  * @param[in] callback the callback to invoke when a matching event is emitted
  * @param[in] context an opaque pointer passed back to @a callback unmodified
- * @return ERROR_NONE on success
+ * @retval ERROR_NONE on success
+ * @retval ERROR_INVALID_ARGUMENT @a type is not a known SystemEventType
+ * @retval ERROR_OUT_OF_MEMORY failed to allocate the new subscription table
  */
 error_t system_event_callback_add(
     enum SystemEventType type,
@@ -112,7 +114,9 @@ error_t system_event_callback_add(
  * @warning Does not work in ISR context.
  * @param[in] type the event type passed to the matching system_event_callback_add() call
  * @param[in] callback the callback passed to the matching system_event_callback_add() call
- * @return ERROR_NONE on success, ERROR_NOT_FOUND if no matching subscription exists
+ * @retval ERROR_NONE on success
+ * @retval ERROR_NOT_FOUND if no matching subscription exists
+ * @retval ERROR_OUT_OF_MEMORY failed to allocate the new subscription table; nothing was removed
  */
 error_t system_event_callback_remove(
     enum SystemEventType type,
@@ -127,7 +131,8 @@ error_t system_event_callback_remove(
  * @param[in] data optional pointer to the type-specific event struct (see SystemEventType);
  * only valid for the duration of this call, subscribers must not retain it
  * @param[in] data_len size of @a data in bytes (0 if @a data is NULL)
- * @return ERROR_NONE on success
+ * @retval ERROR_NONE on success
+ * @retval ERROR_INVALID_ARGUMENT @a type is not a known SystemEventType
  */
 error_t system_event_emit(
     enum SystemEventType type,
@@ -135,6 +140,25 @@ error_t system_event_emit(
     size_t data_len
 );
 
+/**
+ * Emit a system event from an ISR (or any other context that must not block).
+ * The event is copied into one of a small fixed set of slots and delivered later from the timer
+ * service task, exactly as system_event_emit() would deliver it. The timestamp is taken now.
+ * @param[in] type the event type
+ * @param[in] data optional pointer to the type-specific event struct (see SystemEventType);
+ * copied before this call returns
+ * @param[in] data_len size of @a data in bytes (0 if @a data is NULL)
+ * @retval ERROR_NONE the event was queued for delivery
+ * @retval ERROR_INVALID_ARGUMENT @a type is not a known SystemEventType
+ * @retval ERROR_RESOURCE all slots are taken by events that haven't been delivered yet
+ * @retval ERROR_TIMEOUT the timer service queue is full
+ */
+error_t system_event_emit_from_isr(
+    enum SystemEventType type,
+    const void* data,
+    size_t data_len
+);
+
 /** Size of the largest type-specific event struct documented in SystemEventType, i.e. the
  * embedded buffer size needed by SystemEventSubscription to hold any event's payload by value. */
 #define SYSTEM_EVENT_MAX_DATA_SIZE (sizeof(struct NetworkConnectedEvent))
@@ -208,6 +232,7 @@ struct SystemEventSubscription {
  * @retval ERROR_NONE on success
  * @retval ERROR_OUT_OF_MEMORY failed to allocate the subscription's wakeup semaphore; @a sub
  * was not registered
+ * @retval ERROR_INVALID_ARGUMENT @a sub->event.type is not a known SystemEventType
  * @retval ERROR_INVALID_STATE @a sub is already registered
  */
 error_t system_event_subscribe(struct SystemEventSubscription* sub);
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <tactility/memory.h>
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Internal to TactilityKernel: invoked by the platform implementations of the memory_* functions
+// (memory_posix.cpp/memory_esp32.cpp). All hooks return immediately while tracking is disabled.
+
+/** Record an allocation. Call after the allocation succeeded. */
+void memory_tracking_on_alloc(void* ptr, size_t size, const char* tag);
+
+/** Forget an allocation. Call before freeing, so the address can't be handed out and recorded again in between. */
+void memory_tracking_on_free(void* ptr);
+
+/**
+ * Call before a realloc. When this returns true, memory_tracking_on_realloc() must be called afterwards:
+ * the tracking lock is held in between, because the old address can be reused as soon as realloc() frees it.
+ */
+bool memory_tracking_before_realloc(void);
+
+/**
+ * Complete memory_tracking_before_realloc(). new_ptr is NULL when the realloc failed.
+ * The old pointer is passed as an address, because it can't be used anymore once realloc() freed it.
+ */
+void memory_tracking_on_realloc(uintptr_t old_address, void* new_ptr, size_t size, const char* tag);
+
+/**
+ * Set the current records aside, so tracking can be disabled and enabled again without losing them, e.g. by a test
+ * while the leak check of its test runner is active. Frees of set-aside allocations are still accounted while
+ * tracking is enabled. Records can't be set aside twice.
+ */
+void memory_tracking_save(void);
+
+/** Discard the current records and bring back the ones that were set aside by memory_tracking_save() */
+void memory_tracking_restore(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <tactility/check.h>
+#include <tactility/memory.h>
+
+#include <cstddef>
+
+// Internal to TactilityKernel: a standard allocator backed by memory_small_alloc(), for containers
+// whose nodes are created and destroyed often (e.g. map entries). Allocations larger than
+// MEMORY_SMALL_SIZE_MAX (such as bucket arrays) fall through to memory_alloc().
+template<typename T>
+struct SmallAllocator {
+    using value_type = T;
+
+    SmallAllocator() noexcept = default;
+
+    template<typename U>
+    SmallAllocator(const SmallAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        void* memory = memory_small_alloc(count * sizeof(T));
+        // Same outcome as std::allocator in a build without exceptions
+        check(memory != nullptr, "Out of memory");
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* pointer, size_t count) noexcept {
+        memory_small_free(pointer, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const SmallAllocator<U>&) const noexcept { return true; }
+};
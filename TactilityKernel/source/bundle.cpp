@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <tactility/bundle.h>
+#include <tactility/small_allocator.h>
 
 #include <cstring>
 #include <new>
@@ -25,12 +26,21 @@ struct Value {
     std::string value_string;
 };
 
+// Bundles are created and destroyed often (app parameters and results), so their nodes come from the small block pools
+using BundleEntries = std::unordered_map<
+    std::string,
+    Value,
+    std::hash<std::string>,
+    std::equal_to<std::string>,
+    SmallAllocator<std::pair<const std::string, Value>>
+>;
+
 } // namespace
 
 // Definition of the opaque handle declared in tactility/bundle.h - C callers only ever see it
 // through a Bundle* pointer, never its members.
 struct Bundle {
-    std::unordered_map<std::string, Value> entries;
+    BundleEntries entries;
 };
 
 extern "C" {
@@ -1,64 +1,196 @@
 // SPDX-License-Identifier: Apache-2.0
 
-#include <queue>
-
 #include <tactility/concurrent/dispatcher.h>
 
 #include "tactility/error.h"
 
 #include <atomic>
+#include <new>
 #include <tactility/concurrent/event_group.h>
 #include <tactility/concurrent/mutex.h>
+#include <tactility/delay.h>
 #include <tactility/log.h>
+#include <tactility/memory.h>
+#include <tactility/time.h>
 
 #define TAG "Dispatcher"
 
 static constexpr EventBits_t BACKPRESSURE_WARNING_COUNT = 100U;
 static constexpr EventBits_t WAIT_FLAG = 1U;
+/** A lane with pending items runs at least once after this many items were taken from higher lanes */
+static constexpr uint32_t STARVATION_LIMIT = 8U;
 
+// Nodes come from the small block pools: they are allocated and freed for every dispatch
 struct QueuedItem {
     DispatcherCallback callback;
     void* context;
+    QueuedItem* next;
+    TickType_t dispatch_time;
+    /** Ticks this item may wait before it is moved ahead of everything else, or DISPATCHER_NO_DEADLINE */
+    TickType_t deadline;
+};
+
+/** FIFO of pending items of one priority, guarded by DispatcherData::mutex */
+struct QueueLane {
+    QueuedItem* head = nullptr;
+    QueuedItem* tail = nullptr;
+    /** Amount of items that were taken from higher lanes while this lane had items waiting */
+    uint32_t skipped = 0;
+    DispatcherLaneStats stats = {};
+};
+
+/** A slot of the lock-free ring. The sequence tells whether it's free or holds an item (see ring_push() and ring_pop()). */
+struct RingSlot {
+    std::atomic<uint32_t> sequence;
+    DispatcherCallback callback;
+    void* context;
 };
 
 struct DispatcherData {
-    Mutex mutex = { 0 };
-    std::queue<QueuedItem> queue = {};
+    DispatcherBackend backend;
     EventGroupHandle_t eventGroup = nullptr;
     std::atomic<bool> shutdown{false}; // TODO: Use EventGroup
 
-    DispatcherData() {
+    // DISPATCHER_BACKEND_QUEUE
+    Mutex mutex = { 0 };
+    /** Indexed by DispatcherPriority, guarded by mutex */
+    QueueLane lanes[DISPATCHER_PRIORITY_COUNT];
+    /** Total amount of pending items over all lanes, guarded by mutex */
+    size_t queue_size = 0;
+    /** Amount of pending items that have a deadline, guarded by mutex */
+    size_t deadline_count = 0;
+
+    // DISPATCHER_BACKEND_RING: bounded multi-producer ring buffer (Vyukov)
+    RingSlot* ring_slots = nullptr;
+    uint32_t ring_mask = 0;
+    std::atomic<uint32_t> ring_enqueue_position{0};
+    std::atomic<uint32_t> ring_dequeue_position{0};
+    /** Amount of dispatch calls that are currently writing to the ring, so dispatcher_free() can wait for them */
+    std::atomic<uint32_t> ring_producers{0};
+
+    explicit DispatcherData(DispatcherBackend backend) : backend(backend) {
         event_group_construct(&eventGroup);
-        mutex_construct(&mutex);
+        if (backend == DISPATCHER_BACKEND_QUEUE) {
+            mutex_construct(&mutex);
+        }
     }
 
     ~DispatcherData() {
+        if (backend == DISPATCHER_BACKEND_QUEUE) {
+            for (auto& lane : lanes) {
+                while (lane.head != nullptr) {
+                    QueuedItem* next = lane.head->next;
+                    memory_small_free(lane.head, sizeof(QueuedItem));
+                    lane.head = next;
+                }
+            }
+            mutex_destruct(&mutex);
+        } else {
+            delete[] ring_slots;
+        }
         event_group_destruct(&eventGroup);
-        mutex_destruct(&mutex);
     }
 };
 
 #define dispatcher_data(handle) static_cast<DispatcherData*>(handle)
 
-extern "C" {
+/**
+ * Add an item to the ring.
+ * @param[out] position the position of the new item in the ring
+ * @return false when the ring is full
+ */
+static bool ring_push(DispatcherData* data, void* callbackContext, DispatcherCallback callback, uint32_t& position) {
+    position = data->ring_enqueue_position.load(std::memory_order_relaxed);
+    RingSlot* slot;
+    while (true) {
+        slot = &data->ring_slots[position & data->ring_mask];
+        uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int32_t>(sequence - position);
+        if (difference == 0) {
+            if (data->ring_enqueue_position.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = data->ring_enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
 
-DispatcherHandle_t dispatcher_alloc(void) {
-    return new DispatcherData();
+    slot->callback = callback;
+    slot->context = callbackContext;
+    slot->sequence.store(position + 1U, std::memory_order_seq_cst);
+    return true;
 }
 
-void dispatcher_free(DispatcherHandle_t dispatcher) {
-    auto* data = dispatcher_data(dispatcher);
-    data->shutdown.store(true, std::memory_order_release);
-    mutex_lock(&data->mutex);
-    mutex_unlock(&data->mutex);
-    delete data;
+/** @return false when the ring is empty, or when the item at the front is still being written */
+static bool ring_pop(DispatcherData* data, DispatcherCallback& callback, void*& callbackContext) {
+    uint32_t position = data->ring_dequeue_position.load(std::memory_order_relaxed);
+    while (true) {
+        RingSlot* slot = &data->ring_slots[position & data->ring_mask];
+        uint32_t sequence = slot->sequence.load(std::memory_order_seq_cst);
+        auto difference = static_cast<int32_t>(sequence - (position + 1U));
+        if (difference == 0) {
+            if (data->ring_dequeue_position.compare_exchange_weak(position, position + 1U, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                callback = slot->callback;
+                callbackContext = slot->context;
+                slot->sequence.store(position + data->ring_mask + 1U, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = data->ring_dequeue_position.load(std::memory_order_relaxed);
+        }
+    }
 }
 
-error_t dispatcher_dispatch_timed(DispatcherHandle_t dispatcher, void* callbackContext, DispatcherCallback callback, TickType_t timeout) {
-    auto* data = dispatcher_data(dispatcher);
+static error_t dispatch_ring(DispatcherData* data, void* callbackContext, DispatcherCallback callback, TickType_t timeout) {
+    data->ring_producers.fetch_add(1U, std::memory_order_seq_cst);
+    if (data->shutdown.load(std::memory_order_seq_cst)) {
+        data->ring_producers.fetch_sub(1U, std::memory_order_release);
+        return ERROR_INVALID_STATE;
+    }
+
+    bool in_isr = (xPortInIsrContext() == pdTRUE);
+    TickType_t start_time = in_isr ? 0 : get_ticks();
+    error_t result = ERROR_NONE;
+    uint32_t position;
+    while (!ring_push(data, callbackContext, callback, position)) {
+        // Full: wait for the consumer to make room (never from an ISR)
+        if (in_isr || get_timeout_remaining_ticks(timeout, start_time) == 0) {
+            result = ERROR_BUFFER_OVERFLOW;
+            break;
+        }
+        delay_ticks(1);
+    }
+
+    // Only the item at the consumer's position needs a wakeup: the consumer drains everything that follows it.
+    // A consumer that stops at this position reads the sequence after storing its position, and this reads
+    // the position after storing the sequence, so (with seq_cst on both sides) at least one of them sees the other.
+    if (result == ERROR_NONE && data->ring_dequeue_position.load(std::memory_order_seq_cst) == position) {
+        if (event_group_set(data->eventGroup, WAIT_FLAG) != ERROR_NONE) {
+            result = ERROR_RESOURCE;
+        }
+    }
+
+    data->ring_producers.fetch_sub(1U, std::memory_order_release);
+    return result;
+}
+
+static error_t dispatch_queue(DispatcherData* data, void* callbackContext, DispatcherCallback callback, DispatcherPriority priority, TickType_t deadline, TickType_t timeout) {
+    auto* item = static_cast<QueuedItem*>(memory_small_alloc(sizeof(QueuedItem)));
+    if (item == nullptr) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    item->callback = callback;
+    item->context = callbackContext;
+    item->next = nullptr;
+    item->deadline = deadline;
 
     // Mutate
     if (!mutex_try_lock(&data->mutex, timeout)) {
+        memory_small_free(item, sizeof(QueuedItem));
 #ifdef ESP_PLATFORM
         LOG_E(TAG, "Mutex acquisition timeout");
 #endif
@@ -67,15 +199,28 @@ error_t dispatcher_dispatch_timed(DispatcherHandle_t dispatcher, void* callbackC
 
     if (data->shutdown.load(std::memory_order_acquire)) {
         mutex_unlock(&data->mutex);
+        memory_small_free(item, sizeof(QueuedItem));
         return ERROR_INVALID_STATE;
     }
 
-    data->queue.push({
-        .callback = callback,
-        .context = callbackContext
-    });
+    auto& lane = data->lanes[priority];
+    if (lane.tail != nullptr) {
+        lane.tail->next = item;
+    } else {
+        lane.head = item;
+    }
+    lane.tail = item;
+    item->dispatch_time = get_ticks();
+    lane.stats.depth++;
+    if (lane.stats.depth > lane.stats.depth_peak) {
+        lane.stats.depth_peak = lane.stats.depth;
+    }
+    data->queue_size++;
+    if (deadline != DISPATCHER_NO_DEADLINE) {
+        data->deadline_count++;
+    }
 
-    if (data->queue.size() == BACKPRESSURE_WARNING_COUNT) {
+    if (data->queue_size == BACKPRESSURE_WARNING_COUNT) {
 #ifdef ESP_PLATFORM
         LOG_W(TAG, "Backpressure: You're not consuming fast enough (100 queued)");
 #endif
@@ -93,37 +238,121 @@ error_t dispatcher_dispatch_timed(DispatcherHandle_t dispatcher, void* callbackC
     return ERROR_NONE;
 }
 
-error_t dispatcher_consume_timed(DispatcherHandle_t dispatcher, TickType_t timeout) {
-    auto* data = dispatcher_data(dispatcher);
+static void consume_ring(DispatcherData* data) {
+    DispatcherCallback callback;
+    void* context;
+    // Drain the whole batch: the producers only signal for the first item after the ring ran empty
+    while (!data->shutdown.load(std::memory_order_acquire) && ring_pop(data, callback, context)) {
+        callback(context);
+    }
+}
 
-    // TODO: keep track of time and consider the timeout input as total timeout
+/** @warning must hold data->mutex */
+static void lane_remove(QueueLane* lane, QueuedItem* previous, QueuedItem* item) {
+    if (previous != nullptr) {
+        previous->next = item->next;
+    } else {
+        lane->head = item->next;
+    }
+    if (lane->tail == item) {
+        lane->tail = previous;
+    }
+}
 
-    // Wait for signal
-    error_t error = event_group_wait(data->eventGroup, WAIT_FLAG, false, true, nullptr, timeout);
-    if (error != ERROR_NONE) {
-        if (error == ERROR_TIMEOUT) {
-            return ERROR_TIMEOUT;
-        } else {
-            return ERROR_RESOURCE;
+/**
+ * Take the overdue item that has been waiting the longest past its deadline.
+ * @warning must hold data->mutex
+ * @return the item, or nullptr when no item is overdue
+ */
+static QueuedItem* take_overdue(DispatcherData* data, TickType_t now, QueueLane*& selected_lane) {
+    QueuedItem* selected = nullptr;
+    QueuedItem* selected_previous = nullptr;
+    TickType_t selected_overdue = 0;
+    for (auto& lane : data->lanes) {
+        QueuedItem* previous = nullptr;
+        for (QueuedItem* item = lane.head; item != nullptr; previous = item, item = item->next) {
+            if (item->deadline == DISPATCHER_NO_DEADLINE) {
+                continue;
+            }
+            TickType_t waited = now - item->dispatch_time;
+            if (waited >= item->deadline && (selected == nullptr || waited - item->deadline > selected_overdue)) {
+                selected = item;
+                selected_previous = previous;
+                selected_overdue = waited - item->deadline;
+                selected_lane = &lane;
+            }
         }
     }
+    if (selected != nullptr) {
+        lane_remove(selected_lane, selected_previous, selected);
+    }
+    return selected;
+}
 
-    if (data->shutdown.load(std::memory_order_acquire)) {
-        return ERROR_INVALID_STATE;
+/**
+ * Take the next item by priority. A lower lane goes first when it was skipped STARVATION_LIMIT times.
+ * @warning must hold data->mutex
+ * @return the item, or nullptr when all lanes are empty
+ */
+static QueuedItem* take_next(DispatcherData* data, QueueLane*& selected_lane) {
+    selected_lane = nullptr;
+    for (auto& lane : data->lanes) {
+        if (lane.head == nullptr) {
+            continue;
+        }
+        if (selected_lane == nullptr) {
+            selected_lane = &lane;
+        } else if (lane.skipped >= STARVATION_LIMIT) {
+            selected_lane = &lane;
+            break;
+        }
     }
+    if (selected_lane == nullptr) {
+        return nullptr;
+    }
+    for (auto& lane : data->lanes) {
+        if (&lane != selected_lane && lane.head != nullptr) {
+            lane.skipped++;
+        }
+    }
+    selected_lane->skipped = 0;
+    QueuedItem* item = selected_lane->head;
+    lane_remove(selected_lane, nullptr, item);
+    return item;
+}
 
-    // Mutate
+static void consume_queue(DispatcherData* data) {
     bool processing = true;
     do {
         if (mutex_try_lock(&data->mutex, 10)) {
-            if (!data->queue.empty()) {
-                // Make a copy, so it's thread-safe when we unlock
-                auto entry = data->queue.front();
-                data->queue.pop();
-                processing = !data->queue.empty();
+            TickType_t now = get_ticks();
+            QueueLane* lane = nullptr;
+            QueuedItem* item = (data->deadline_count > 0U) ? take_overdue(data, now, lane) : nullptr;
+            if (item == nullptr) {
+                item = take_next(data, lane);
+            }
+            if (item != nullptr) {
+                data->queue_size--;
+                processing = (data->queue_size != 0U);
+                TickType_t waited = now - item->dispatch_time;
+                lane->stats.depth--;
+                lane->stats.executed++;
+                lane->stats.latency_total += waited;
+                if (waited > lane->stats.latency_max) {
+                    lane->stats.latency_max = waited;
+                }
+                if (item->deadline != DISPATCHER_NO_DEADLINE) {
+                    data->deadline_count--;
+                    if (waited > item->deadline) {
+                        lane->stats.deadline_misses++;
+                    }
+                }
                 // Don't keep lock as callback might be slow and we want to allow dispatch in the meanwhile
                 mutex_unlock(&data->mutex);
-                entry.callback(entry.context);
+                DispatcherCallback callback = item->callback;
+                void* context = item->context;
+                memory_small_free(item, sizeof(QueuedItem));
+                callback(context);
             } else {
                 processing = false;
                 mutex_unlock(&data->mutex);
@@ -135,8 +364,129 @@ error_t dispatcher_consume_timed(DispatcherHandle_t dispatcher, TickType_t timeo
         }
 
     } while (processing && !data->shutdown.load(std::memory_order_acquire));
+}
+
+extern "C" {
+
+DispatcherHandle_t dispatcher_alloc(void) {
+    return new DispatcherData(DISPATCHER_BACKEND_QUEUE);
+}
+
+DispatcherHandle_t dispatcher_alloc_with_config(const DispatcherConfig* config) {
+    if (config->backend == DISPATCHER_BACKEND_QUEUE) {
+        return dispatcher_alloc();
+    }
+
+    uint32_t capacity = config->ring_capacity;
+    if (config->backend != DISPATCHER_BACKEND_RING || capacity < 2U || (capacity & (capacity - 1U)) != 0U) {
+        return nullptr;
+    }
+
+    auto* slots = new(std::nothrow) RingSlot[capacity];
+    if (slots == nullptr) {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    auto* data = new(std::nothrow) DispatcherData(DISPATCHER_BACKEND_RING);
+    if (data == nullptr) {
+        delete[] slots;
+        return nullptr;
+    }
+    data->ring_slots = slots;
+    data->ring_mask = capacity - 1U;
+    return data;
+}
+
+void dispatcher_free(DispatcherHandle_t dispatcher) {
+    auto* data = dispatcher_data(dispatcher);
+    data->shutdown.store(true, std::memory_order_seq_cst);
+    if (data->backend == DISPATCHER_BACKEND_QUEUE) {
+        mutex_lock(&data->mutex);
+        mutex_unlock(&data->mutex);
+    } else {
+        // Dispatchers that got past the shutdown check are still writing to the ring
+        while (data->ring_producers.load(std::memory_order_acquire) != 0U) {
+            delay_ticks(1);
+        }
+    }
+    delete data;
+}
+
+error_t dispatcher_dispatch_timed(DispatcherHandle_t dispatcher, void* callbackContext, DispatcherCallback callback, TickType_t timeout) {
+    auto* data = dispatcher_data(dispatcher);
+    if (data->backend == DISPATCHER_BACKEND_RING) {
+        return dispatch_ring(data, callbackContext, callback, timeout);
+    } else {
+        return dispatch_queue(data, callbackContext, callback, DISPATCHER_PRIORITY_NORMAL, DISPATCHER_NO_DEADLINE, timeout);
+    }
+}
+
+error_t dispatcher_dispatch_priority_timed(
+    DispatcherHandle_t dispatcher,
+    void* callbackContext,
+    DispatcherCallback callback,
+    DispatcherPriority priority,
+    TickType_t deadline,
+    TickType_t timeout
+) {
+    if (priority >= DISPATCHER_PRIORITY_COUNT) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    auto* data = dispatcher_data(dispatcher);
+    if (data->backend == DISPATCHER_BACKEND_RING) {
+        if (priority != DISPATCHER_PRIORITY_NORMAL || deadline != DISPATCHER_NO_DEADLINE) {
+            return ERROR_NOT_SUPPORTED;
+        }
+        return dispatch_ring(data, callbackContext, callback, timeout);
+    } else {
+        return dispatch_queue(data, callbackContext, callback, priority, deadline, timeout);
+    }
+}
+
+error_t dispatcher_get_lane_stats(DispatcherHandle_t dispatcher, DispatcherPriority priority, DispatcherLaneStats* stats) {
+    if (priority >= DISPATCHER_PRIORITY_COUNT) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    auto* data = dispatcher_data(dispatcher);
+    if (data->backend != DISPATCHER_BACKEND_QUEUE) {
+        return ERROR_NOT_SUPPORTED;
+    }
+    mutex_lock(&data->mutex);
+    *stats = data->lanes[priority].stats;
+    mutex_unlock(&data->mutex);
+    return ERROR_NONE;
+}
+
+error_t dispatcher_consume_timed(DispatcherHandle_t dispatcher, TickType_t timeout) {
+    auto* data = dispatcher_data(dispatcher);
+
+    // TODO: keep track of time and consider the timeout input as total timeout
+
+    // Wait for signal
+    error_t error = event_group_wait(data->eventGroup, WAIT_FLAG, false, true, nullptr, timeout);
+    if (error != ERROR_NONE) {
+        if (error == ERROR_TIMEOUT) {
+            return ERROR_TIMEOUT;
+        } else {
+            return ERROR_RESOURCE;
+        }
+    }
+
+    if (data->shutdown.load(std::memory_order_acquire)) {
+        return ERROR_INVALID_STATE;
+    }
+
+    // Mutate
+    if (data->backend == DISPATCHER_BACKEND_RING) {
+        consume_ring(data);
+    } else {
+        consume_queue(data);
+    }
 
     return ERROR_NONE;
 }
 
-}
\ No newline at end of file
+}
@@ -26,6 +26,10 @@ static void log_task_info() {
 extern "C" {
 
 __attribute__((noreturn)) void __crash(void) {
+#ifndef ESP_PLATFORM
+    // Write out what led up to the crash before the crash report itself
+    log_flush_on_crash();
+#endif
     log_task_info();
     log_memory_info();
     // TODO: Add breakpoint when debugger is attached.
@@ -8,9 +8,13 @@
 #include <tactility/check.h>
 #include <tactility/concurrent/recursive_mutex.h>
 
+#include <algorithm>
 #include <ranges>
 #include <cassert>
 #include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #define TAG "device"
@@ -47,10 +51,29 @@ struct DeviceInternal {
     // device_get()/device_put() bracket construct/destruct, not start/stop, so a ref can be held
     // across a device_stop(). device_destruct() refuses to run while this is > 0.
     int32_t ref_count = 0;
+    // The driver this device was indexed under by device_add(). Kept separately from `driver` so
+    // device_remove() can always find the buckets to clear, even if the driver was swapped in between.
+    Driver* indexed_driver = nullptr;
 };
 
+/** Transparent hash so the string-keyed indexes can be searched with a const char* without allocating */
+struct DeviceIndexHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view value) const { return std::hash<std::string_view> {}(value); }
+};
+
+template<typename Key>
+using DeviceIndex = std::unordered_map<Key, std::vector<Device*>, DeviceIndexHash, std::equal_to<>>;
+
 struct DeviceLedger {
+    /** All added devices, in the order they were added */
     std::vector<Device*> devices;
+    // Lookup indexes over `devices`, maintained by device_add()/device_remove() and guarded by `mutex`.
+    // Every bucket keeps insertion order, so "first" lookups return the same device a scan of
+    // `devices` would have returned.
+    DeviceIndex<std::string> devices_by_name;
+    DeviceIndex<std::string> devices_by_compatible;
+    std::unordered_map<const DeviceType*, std::vector<Device*>> devices_by_type;
     Mutex mutex { 0 };
 
     DeviceLedger() {
@@ -69,6 +92,83 @@ static DeviceLedger& get_ledger() {
 
 #define ledger get_ledger()
 
+template<typename Map, typename Key>
+static void index_insert(Map& index, const Key& key, Device* device) {
+    auto iterator = index.find(key);
+    if (iterator == index.end()) {
+        iterator = index.emplace(key, std::vector<Device*>()).first;
+    }
+    iterator->second.push_back(device);
+}
+
+template<typename Map, typename Key>
+static void index_erase(Map& index, const Key& key, Device* device) {
+    auto iterator = index.find(key);
+    if (iterator == index.end()) {
+        return;
+    }
+    auto& bucket = iterator->second;
+    const auto device_iterator = std::ranges::find(bucket, device);
+    if (device_iterator != bucket.end()) {
+        bucket.erase(device_iterator);
+    }
+    if (bucket.empty()) {
+        index.erase(iterator);
+    }
+}
+
+/** @warning must hold ledger_lock */
+static void ledger_index_add(Device* device) {
+    if (device->name != nullptr) {
+        index_insert(ledger.devices_by_name, std::string_view(device->name), device);
+    }
+
+    auto* driver = device->internal->driver;
+    device->internal->indexed_driver = driver;
+    if (driver == nullptr) {
+        return;
+    }
+
+    if (driver->device_type != nullptr) {
+        index_insert(ledger.devices_by_type, driver->device_type, device);
+    }
+
+    if (driver->compatible != nullptr) {
+        for (const char** compatible = driver->compatible; *compatible != nullptr; compatible++) {
+            index_insert(ledger.devices_by_compatible, std::string_view(*compatible), device);
+        }
+    }
+}
+
+/** @warning must hold ledger_lock */
+static void ledger_index_remove(Device* device) {
+    if (device->name != nullptr) {
+        index_erase(ledger.devices_by_name, std::string_view(device->name), device);
+    }
+
+    auto* driver = device->internal->indexed_driver;
+    device->internal->indexed_driver = nullptr;
+    if (driver == nullptr) {
+        return;
+    }
+
+    if (driver->device_type != nullptr) {
+        index_erase(ledger.devices_by_type, driver->device_type, device);
+    }
+
+    if (driver->compatible != nullptr) {
+        for (const char** compatible = driver->compatible; *compatible != nullptr; compatible++) {
+            index_erase(ledger.devices_by_compatible, std::string_view(*compatible), device);
+        }
+    }
+}
+
+/** @warning must hold ledger_lock */
+static const std::vector<Device*>* ledger_find_by_type(const DeviceType* type) {
+    const auto iterator = ledger.devices_by_type.find(type);
+    return iterator != ledger.devices_by_type.end() ? &iterator->second : nullptr;
+}
+
 extern "C" {
 
 #define ledger_lock() mutex_lock(&ledger.mutex)
@@ -142,6 +242,7 @@ error_t device_add(Device* device) {
     // Add to ledger
     ledger_lock();
     ledger.devices.push_back(device);
+    ledger_index_add(device);
     ledger_unlock();
 
     // Add self to parent's children list
@@ -174,6 +275,7 @@ error_t device_remove(Device* device) {
         goto failed_ledger_lookup;
     }
     ledger.devices.erase(iterator);
+    ledger_index_remove(device);
     ledger_unlock();
 
     device->internal->state.added = false;
@@ -426,13 +528,11 @@ size_t device_get_child_count(Device* device) {
 
 void device_for_each_of_type(const DeviceType* type, void* callbackContext, bool(*on_device)(Device* device, void* context)) {
     ledger_lock();
-    for (auto* device : ledger.devices) {
-        auto* driver = device->internal->driver;
-        if (driver != nullptr) {
-            if (driver->device_type == type) {
-                if (!on_device(device, callbackContext)) {
-                    break;
-                }
+    const auto* devices = ledger_find_by_type(type);
+    if (devices != nullptr) {
+        for (auto* device : *devices) {
+            if (!on_device(device, callbackContext)) {
+                break;
             }
         }
     }
@@ -440,28 +540,17 @@ void device_for_each_of_type(const DeviceType* type, void* callbackContext, bool
 }
 
 bool device_exists_of_type(const DeviceType* type) {
-    bool found = false;
     ledger_lock();
-    for (auto* device : ledger.devices) {
-        auto* driver = device->internal->driver;
-        if (driver != nullptr && driver->device_type == type) {
-            found = true;
-            break;
-        }
-    }
+    bool found = ledger_find_by_type(type) != nullptr;
     ledger_unlock();
     return found;
 }
 
-error_t device_get_by_name(const char* name, Device** out_device) {
-    ledger_lock();
-    Device* found = nullptr;
-    for (auto* device : ledger.devices) {
-        if (device->name != nullptr && std::strcmp(device->name, name) == 0) {
-            found = device;
-            break;
-        }
-    }
+/**
+ * Take a reference on a device found by one of the lookups below.
+ * @warning must hold ledger_lock, and releases it
+ */
+static error_t ledger_get_found_and_unlock(Device* found, Device** out_device) {
     if (found == nullptr) {
         ledger_unlock();
         return ERROR_NOT_FOUND;
@@ -480,59 +569,49 @@ error_t device_get_by_name(const char* name, Device** out_device) {
     return error;
 }
 
-error_t device_get_first_by_type(const DeviceType* type, Device** out_device) {
+error_t device_get_by_name(const char* name, Device** out_device) {
     ledger_lock();
     Device* found = nullptr;
-    for (auto* device : ledger.devices) {
-        auto* driver = device->internal->driver;
-        if (driver != nullptr && driver->device_type == type) {
-            found = device;
-            break;
-        }
-    }
-    if (found == nullptr) {
-        ledger_unlock();
-        return ERROR_NOT_FOUND;
+    const auto iterator = ledger.devices_by_name.find(std::string_view(name));
+    if (iterator != ledger.devices_by_name.end()) {
+        found = iterator->second.front();
     }
-    error_t error = device_get(found);
-    ledger_unlock();
-    if (error == ERROR_NONE) {
-        *out_device = found;
+    return ledger_get_found_and_unlock(found, out_device);
+}
+
+error_t device_get_first_by_type(const DeviceType* type, Device** out_device) {
+    ledger_lock();
+    Device* found = nullptr;
+    const auto* devices = ledger_find_by_type(type);
+    if (devices != nullptr) {
+        found = devices->front();
     }
-    return error;
+    return ledger_get_found_and_unlock(found, out_device);
 }
 
 error_t device_get_first_active_by_type(const DeviceType* type, Device** out_device) {
     ledger_lock();
     Device* found = nullptr;
-    for (auto* device : ledger.devices) {
-        auto* driver = device->internal->driver;
-        if (driver != nullptr && driver->device_type == type && device->internal->state.started) {
-            found = device;
-            break;
+    const auto* devices = ledger_find_by_type(type);
+    if (devices != nullptr) {
+        for (auto* device : *devices) {
+            if (device->internal->state.started) {
+                found = device;
+                break;
+            }
         }
     }
-    if (found == nullptr) {
-        ledger_unlock();
-        return ERROR_NOT_FOUND;
-    }
-    error_t error = device_get(found);
-    ledger_unlock();
-    if (error == ERROR_NONE) {
-        *out_device = found;
-    }
-    return error;
+    return ledger_get_found_and_unlock(found, out_device);
 }
 
 bool device_has_active_by_type(const struct DeviceType* type) {
     ledger_lock();
     bool found = false;
-    for (auto* device : ledger.devices) {
-        auto* driver = device->internal->driver;
-        if (driver != nullptr && driver->device_type == type && device->internal->state.started) {
-            found = true;
-            break;
-        }
+    const auto* devices = ledger_find_by_type(type);
+    if (devices != nullptr) {
+        found = std::ranges::any_of(*devices, [](auto* device) {
+            return device->internal->state.started;
+        });
     }
     ledger_unlock();
     return found;
@@ -541,22 +620,11 @@ bool device_has_active_by_type(const struct DeviceType* type) {
 error_t device_get_first_by_compatible(const char* compatible, Device** out_device) {
     ledger_lock();
     Device* found = nullptr;
-    for (auto* device : ledger.devices) {
-        if (device_is_compatible(device, compatible)) {
-            found = device;
-            break;
-        }
-    }
-    if (found == nullptr) {
-        ledger_unlock();
-        return ERROR_NOT_FOUND;
+    const auto iterator = ledger.devices_by_compatible.find(std::string_view(compatible));
+    if (iterator != ledger.devices_by_compatible.end()) {
+        found = iterator->second.front();
     }
-    error_t error = device_get(found);
-    ledger_unlock();
-    if (error == ERROR_NONE) {
-        *out_device = found;
-    }
-    return error;
+    return ledger_get_found_and_unlock(found, out_device);
 }
 
 } // extern "C"
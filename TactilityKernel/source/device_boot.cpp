@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <tactility/device_boot.h>
+
+#include <tactility/check.h>
+#include <tactility/concurrent/event_group.h>
+#include <tactility/concurrent/mutex.h>
+#include <tactility/concurrent/thread.h>
+#include <tactility/device.h>
+#include <tactility/log.h>
+#include <tactility/time.h>
+
+#include <algorithm>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#define TAG "device_boot"
+
+// Set whenever a device finishes, so idle workers re-check for devices that became ready
+#define BOOT_PROGRESS_BIT (1U << 0U)
+
+namespace {
+
+enum class BootState : uint8_t {
+    Pending,
+    Running,
+    Done,
+    Failed,
+    Skipped
+};
+
+struct BootEntry {
+    const DtsDevice* dts_device;
+    /** Index of the parent device in the entries, or -1 when the parent isn't part of this boot */
+    int32_t parent_index;
+    BootState state;
+};
+
+struct BootContext {
+    std::vector<BootEntry> entries;
+    DeviceBootRecord* records;
+    uint64_t start_time;
+    /** Amount of entries that haven't reached a final state yet */
+    size_t remaining;
+    bool aborted = false;
+    Mutex mutex { 0 };
+    EventGroupHandle_t progress = nullptr;
+
+    BootContext() {
+        mutex_construct(&mutex);
+        event_group_construct(&progress);
+    }
+
+    ~BootContext() {
+        event_group_destruct(&progress);
+        mutex_destruct(&mutex);
+    }
+};
+
+/** @warning must hold context->mutex */
+void skip_pending(BootContext* context) {
+    for (size_t i = 0; i < context->entries.size(); i++) {
+        auto& entry = context->entries[i];
+        if (entry.state == BootState::Pending) {
+            entry.state = BootState::Skipped;
+            context->remaining--;
+            if (context->records != nullptr) {
+                context->records[i].result = ERROR_INVALID_STATE;
+            }
+        }
+    }
+}
+
+/**
+ * @warning must hold context->mutex
+ * @return the index of the first entry that can be brought up, or -1 if there is none
+ */
+int32_t find_ready(BootContext* context) {
+    for (size_t i = 0; i < context->entries.size(); i++) {
+        const auto& entry = context->entries[i];
+        if (entry.state != BootState::Pending) {
+            continue;
+        }
+        if (entry.parent_index < 0 || context->entries[entry.parent_index].state == BootState::Done) {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
+error_t bring_up(const DtsDevice* dts_device) {
+    if (dts_device->status == DTS_DEVICE_STATUS_OKAY) {
+        if (device_construct_add_start(dts_device->device, dts_device->compatible) != ERROR_NONE) {
+            LOG_E(TAG, "Failed to construct+add+start device: %s (%s)", dts_device->device->name, dts_device->compatible);
+            return ERROR_RESOURCE;
+        }
+    } else if (dts_device->status == DTS_DEVICE_STATUS_DISABLED) {
+        if (device_construct_add(dts_device->device, dts_device->compatible) != ERROR_NONE) {
+            LOG_E(TAG, "Failed to construct+add device: %s (%s)", dts_device->device->name, dts_device->compatible);
+            return ERROR_RESOURCE;
+        }
+    } else {
+        check(false, "DTS status not implemented");
+    }
+    return ERROR_NONE;
+}
+
+int32_t boot_worker(void* parameter) {
+    auto* context = static_cast<BootContext*>(parameter);
+
+    mutex_lock(&context->mutex);
+    while (true) {
+        if (context->aborted) {
+            skip_pending(context);
+        }
+
+        int32_t index = find_ready(context);
+        if (index >= 0) {
+            auto& entry = context->entries[index];
+            entry.state = BootState::Running;
+            mutex_unlock(&context->mutex);
+
+            uint64_t start_time = get_micros_since_boot();
+            error_t result = bring_up(entry.dts_device);
+            uint64_t end_time = get_micros_since_boot();
+
+            mutex_lock(&context->mutex);
+            entry.state = (result == ERROR_NONE) ? BootState::Done : BootState::Failed;
+            if (result != ERROR_NONE) {
+                context->aborted = true;
+            }
+            if (context->records != nullptr) {
+                auto& record = context->records[index];
+                record.result = result;
+                record.start_offset_us = start_time - context->start_time;
+                record.duration_us = end_time - start_time;
+            }
+            context->remaining--;
+            event_group_set(context->progress, BOOT_PROGRESS_BIT);
+            continue;
+        }
+
+        if (context->remaining == 0) {
+            break;
+        }
+
+        // Nothing is ready until a running device finishes. Clearing under the mutex guarantees
+        // that a completion after this point sets the bit again, so the wait can't miss it.
+        event_group_clear(context->progress, BOOT_PROGRESS_BIT);
+        mutex_unlock(&context->mutex);
+        event_group_wait(context->progress, BOOT_PROGRESS_BIT, false, false, nullptr, portMAX_DELAY);
+        mutex_lock(&context->mutex);
+    }
+    mutex_unlock(&context->mutex);
+
+    return 0;
+}
+
+} // namespace
+
+extern "C" {
+
+size_t device_boot_count(const DtsDevice dts_devices[]) {
+    size_t count = 0;
+    while (dts_devices[count].device != nullptr) {
+        count++;
+    }
+    return count;
+}
+
+error_t device_boot(const DtsDevice dts_devices[], const DeviceBootConfig* config, DeviceBootRecord* records) {
+    auto* context = new(std::nothrow) BootContext();
+    if (context == nullptr) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t count = device_boot_count(dts_devices);
+    std::unordered_map<const Device*, int32_t> indices;
+    context->entries.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        indices[dts_devices[i].device] = static_cast<int32_t>(i);
+    }
+    for (size_t i = 0; i < count; i++) {
+        auto parent_iterator = indices.find(dts_devices[i].device->parent);
+        int32_t parent_index = (parent_iterator != indices.end()) ? parent_iterator->second : -1;
+        context->entries.push_back({ &dts_devices[i], parent_index, BootState::Pending });
+        if (records != nullptr) {
+            records[i] = { dts_devices[i].device, ERROR_NONE, 0, 0 };
+        }
+    }
+    context->records = records;
+    context->remaining = count;
+    context->start_time = get_micros_since_boot();
+
+    // The calling thread is one of the workers
+    uint32_t thread_count = std::min<size_t>(std::max<uint32_t>(config->worker_count, 1U), std::max<size_t>(count, 1U)) - 1U;
+    std::vector<Thread*> threads;
+    bool threads_failed = false;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        auto* thread = thread_alloc_full("device_boot", config->worker_stack_size, boot_worker, context, -1);
+        if (thread == nullptr) {
+            threads_failed = true;
+            break;
+        }
+        if (thread_start(thread) != ERROR_NONE) {
+            thread_free(thread);
+            threads_failed = true;
+            break;
+        }
+        threads.push_back(thread);
+    }
+
+    if (threads_failed) {
+        LOG_W(TAG, "Started %u of %u workers", (unsigned)threads.size() + 1U, (unsigned)thread_count + 1U);
+    }
+
+    boot_worker(context);
+
+    for (auto* thread : threads) {
+        thread_join(thread, MAX_TICKS, 1);
+        thread_free(thread);
+    }
+
+    error_t result = context->aborted ? ERROR_RESOURCE : ERROR_NONE;
+    delete context;
+    return result;
+}
+
+void device_boot_log_report(const DeviceBootRecord* records, size_t record_count) {
+    std::vector<const DeviceBootRecord*> sorted;
+    sorted.reserve(record_count);
+    uint64_t total_us = 0;
+    for (size_t i = 0; i < record_count; i++) {
+        sorted.push_back(&records[i]);
+        total_us = std::max(total_us, records[i].start_offset_us + records[i].duration_us);
+    }
+    std::ranges::sort(sorted, [](const auto* left, const auto* right) {
+        return left->duration_us > right->duration_us;
+    });
+
+    LOG_I(TAG, "%u devices in %u ms", (unsigned)record_count, (unsigned)(total_us / 1000U));
+    for (const auto* record : sorted) {
+        LOG_I(TAG, "  %-24s %6u.%03u ms at +%u ms (%s)",
+            record->device->name,
+            (unsigned)(record->duration_us / 1000U),
+            (unsigned)(record->duration_us % 1000U),
+            (unsigned)(record->start_offset_us / 1000U),
+            error_to_string(record->result)
+        );
+    }
+}
+
+} // extern "C"
@@ -30,6 +30,19 @@ error_t display_draw_bitmap(Device* device, int32_t x_start, int32_t y_start, in
     return DISPLAY_DRIVER_API(driver)->draw_bitmap(device, x_start, y_start, x_end, y_end, color_data);
 }
 
+error_t display_draw_bitmap_async(Device* device, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data, DisplayDrawDoneCallback on_done, void* context) {
+    const auto* driver = device_get_driver(device);
+    const auto* api = DISPLAY_DRIVER_API(driver);
+    if (api->draw_bitmap_async != nullptr) {
+        return api->draw_bitmap_async(device, x_start, y_start, x_end, y_end, color_data, on_done, context);
+    }
+    error_t error = api->draw_bitmap(device, x_start, y_start, x_end, y_end, color_data);
+    if (error == ERROR_NONE) {
+        on_done(device, context);
+    }
+    return error;
+}
+
 error_t display_mirror(Device* device, bool x_axis, bool y_axis) {
     const auto* driver = device_get_driver(device);
     return DISPLAY_DRIVER_API(driver)->mirror(device, x_axis, y_axis);
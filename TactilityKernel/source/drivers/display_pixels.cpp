@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <tactility/drivers/display_pixels.h>
+
+#include <cstring>
+
+namespace {
+
+// Rotation walks the image in square blocks: the block's source rows and destination rows both fit
+// in the data cache (2 x 2 kB for RGB565), instead of reading a whole column per destination row.
+constexpr int32_t BLOCK_SIZE = 32;
+
+struct Pixel24 {
+    uint8_t bytes[3];
+};
+
+inline uint16_t swap_rgb565(uint16_t pixel) {
+    return static_cast<uint16_t>((pixel << 8) | (pixel >> 8));
+}
+
+/** Swaps the bytes of every 16-bit half of a word, i.e. of 2 or 4 pixels at once */
+inline uintptr_t swap_rgb565_word(uintptr_t word) {
+    constexpr auto mask = static_cast<uintptr_t>(0x00FF00FF00FF00FFULL);
+    return ((word & mask) << 8) | ((word >> 8) & mask);
+}
+
+template<typename Pixel, bool Swap>
+inline Pixel convert(Pixel pixel) {
+    if constexpr (Swap) {
+        return swap_rgb565(pixel);
+    } else {
+        return pixel;
+    }
+}
+
+template<typename Pixel>
+inline const Pixel* source_pixel(const uint8_t* source, size_t source_stride, int32_t x, int32_t y) {
+    return reinterpret_cast<const Pixel*>(source + static_cast<size_t>(y) * source_stride) + x;
+}
+
+template<typename Pixel>
+inline Pixel* destination_row(uint8_t* destination, size_t destination_stride, int32_t y) {
+    return reinterpret_cast<Pixel*>(destination + static_cast<size_t>(y) * destination_stride);
+}
+
+template<typename Pixel, bool Swap>
+void copy(const uint8_t* source, uint8_t* destination, int32_t width, int32_t height, size_t source_stride, size_t destination_stride) {
+    for (int32_t y = 0; y < height; y++) {
+        auto* out = destination_row<Pixel>(destination, destination_stride, y);
+        std::memcpy(out, source_pixel<Pixel>(source, source_stride, 0, y), static_cast<size_t>(width) * sizeof(Pixel));
+        if constexpr (Swap) {
+            display_pixels_swap_rgb565(out, static_cast<size_t>(width));
+        }
+    }
+}
+
+template<typename Pixel, bool Swap>
+void rotate_180(const uint8_t* source, uint8_t* destination, int32_t width, int32_t height, size_t source_stride, size_t destination_stride) {
+    for (int32_t y = 0; y < height; y++) {
+        const auto* in = source_pixel<Pixel>(source, source_stride, 0, y);
+        auto* out = destination_row<Pixel>(destination, destination_stride, height - 1 - y) + (width - 1);
+        for (int32_t x = 0; x < width; x++) {
+            *out-- = convert<Pixel, Swap>(in[x]);
+        }
+    }
+}
+
+/**
+ * Source column x becomes destination row (width - 1 - x) for 90 degrees or row x for 270 degrees.
+ * Each destination row is written sequentially, 1 block at a time.
+ */
+template<typename Pixel, bool Swap, bool Rotate90>
+void rotate_90_270(const uint8_t* source, uint8_t* destination, int32_t width, int32_t height, size_t source_stride, size_t destination_stride) {
+    for (int32_t block_y = 0; block_y < height; block_y += BLOCK_SIZE) {
+        int32_t block_y_end = (block_y + BLOCK_SIZE < height) ? block_y + BLOCK_SIZE : height;
+        for (int32_t block_x = 0; block_x < width; block_x += BLOCK_SIZE) {
+            int32_t block_x_end = (block_x + BLOCK_SIZE < width) ? block_x + BLOCK_SIZE : width;
+            for (int32_t x = block_x; x < block_x_end; x++) {
+                const auto* in = reinterpret_cast<const uint8_t*>(source_pixel<Pixel>(source, source_stride, x, block_y));
+                if constexpr (Rotate90) {
+                    auto* out = destination_row<Pixel>(destination, destination_stride, width - 1 - x) + block_y;
+                    for (int32_t y = block_y; y < block_y_end; y++) {
+                        *out++ = convert<Pixel, Swap>(*reinterpret_cast<const Pixel*>(in));
+                        in += source_stride;
+                    }
+                } else {
+                    auto* out = destination_row<Pixel>(destination, destination_stride, x) + (height - 1 - block_y);
+                    for (int32_t y = block_y; y < block_y_end; y++) {
+                        *out-- = convert<Pixel, Swap>(*reinterpret_cast<const Pixel*>(in));
+                        in += source_stride;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename Pixel, bool Swap>
+void rotate(const uint8_t* source, uint8_t* destination, int32_t width, int32_t height, size_t source_stride, size_t destination_stride, DisplayPixelRotation rotation) {
+    switch (rotation) {
+        case DISPLAY_PIXEL_ROTATION_0:
+            copy<Pixel, Swap>(source, destination, width, height, source_stride, destination_stride);
+            break;
+        case DISPLAY_PIXEL_ROTATION_90:
+            rotate_90_270<Pixel, Swap, true>(source, destination, width, height, source_stride, destination_stride);
+            break;
+        case DISPLAY_PIXEL_ROTATION_180:
+            rotate_180<Pixel, Swap>(source, destination, width, height, source_stride, destination_stride);
+            break;
+        case DISPLAY_PIXEL_ROTATION_270:
+            rotate_90_270<Pixel, Swap, false>(source, destination, width, height, source_stride, destination_stride);
+            break;
+    }
+}
+
+bool is_aligned(const void* pointer, size_t stride_a, size_t stride_b, size_t alignment) {
+    return (reinterpret_cast<uintptr_t>(pointer) % alignment) == 0 && (stride_a % alignment) == 0 && (stride_b % alignment) == 0;
+}
+
+} // namespace
+
+extern "C" {
+
+void display_pixels_swap_rgb565(void* pixels, size_t pixel_count) {
+    auto* pixel = static_cast<uint16_t*>(pixels);
+
+    // Single pixels until the rest can be handled as aligned words
+    while (pixel_count > 0 && (reinterpret_cast<uintptr_t>(pixel) % sizeof(uintptr_t)) != 0) {
+        *pixel = swap_rgb565(*pixel);
+        pixel++;
+        pixel_count--;
+    }
+
+    constexpr size_t PIXELS_PER_WORD = sizeof(uintptr_t) / sizeof(uint16_t);
+    auto* bytes = reinterpret_cast<uint8_t*>(pixel);
+    size_t word_count = pixel_count / PIXELS_PER_WORD;
+    for (size_t i = 0; i < word_count; i++) {
+        uintptr_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        word = swap_rgb565_word(word);
+        std::memcpy(bytes, &word, sizeof(word));
+        bytes += sizeof(word);
+    }
+
+    pixel = reinterpret_cast<uint16_t*>(bytes);
+    for (size_t i = 0; i < pixel_count % PIXELS_PER_WORD; i++) {
+        pixel[i] = swap_rgb565(pixel[i]);
+    }
+}
+
+error_t display_pixels_rotate(
+    const void* source,
+    void* destination,
+    int32_t width,
+    int32_t height,
+    size_t source_stride,
+    size_t destination_stride,
+    uint8_t bytes_per_pixel,
+    enum DisplayPixelRotation rotation,
+    bool swap_rgb565
+) {
+    if (source == nullptr || destination == nullptr || width <= 0 || height <= 0) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    if (rotation < DISPLAY_PIXEL_ROTATION_0 || rotation > DISPLAY_PIXEL_ROTATION_270) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    if (swap_rgb565 && bytes_per_pixel != 2) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    bool swapped_size = rotation == DISPLAY_PIXEL_ROTATION_90 || rotation == DISPLAY_PIXEL_ROTATION_270;
+    auto destination_width = static_cast<size_t>(swapped_size ? height : width);
+    if (source_stride < static_cast<size_t>(width) * bytes_per_pixel || destination_stride < destination_width * bytes_per_pixel) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t alignment = (bytes_per_pixel == 3) ? 1 : bytes_per_pixel;
+    if (!is_aligned(source, source_stride, destination_stride, alignment) || !is_aligned(destination, 0, 0, alignment)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    const auto* in = static_cast<const uint8_t*>(source);
+    auto* out = static_cast<uint8_t*>(destination);
+    switch (bytes_per_pixel) {
+        case 1:
+            rotate<uint8_t, false>(in, out, width, height, source_stride, destination_stride, rotation);
+            return ERROR_NONE;
+        case 2:
+            if (swap_rgb565) {
+                rotate<uint16_t, true>(in, out, width, height, source_stride, destination_stride, rotation);
+            } else {
+                rotate<uint16_t, false>(in, out, width, height, source_stride, destination_stride, rotation);
+            }
+            return ERROR_NONE;
+        case 3:
+            rotate<Pixel24, false>(in, out, width, height, source_stride, destination_stride, rotation);
+            return ERROR_NONE;
+        case 4:
+            rotate<uint32_t, false>(in, out, width, height, source_stride, destination_stride, rotation);
+            return ERROR_NONE;
+        default:
+            return ERROR_INVALID_ARGUMENT;
+    }
+}
+
+}
@@ -1,7 +1,10 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <tactility/device.h>
 #include <tactility/drivers/i2c_controller.h>
 #include <tactility/error.h>
 
+#include <cstring>
+
 #define I2C_DRIVER_API(driver) ((struct I2cControllerApi*)driver->api)
 
 extern "C" {
@@ -107,6 +110,97 @@ error_t i2c_controller_register16be_set(Device* device, uint8_t address, uint8_t
     return i2c_controller_write_register(device, address, reg, buf, 2, timeout);
 }
 
+void i2c_batch_init(struct I2cBatch* batch, Device* device, uint8_t address, uint8_t flags) {
+    batch->device = device;
+    batch->address = address;
+    batch->flags = flags;
+    batch->operation_count = 0;
+    batch->data_size = 0;
+    batch->error = ERROR_NONE;
+}
+
+static I2cBatchOperation* i2c_batch_add(I2cBatch* batch, I2cBatchOperationType type, uint8_t reg, uint8_t dataSize) {
+    if (batch->error != ERROR_NONE) {
+        return nullptr;
+    }
+    if (dataSize == 0 || batch->operation_count == I2C_BATCH_OPERATIONS_MAX || dataSize > I2C_BATCH_DATA_SIZE_MAX - batch->data_size) {
+        batch->error = (dataSize == 0) ? ERROR_INVALID_ARGUMENT : ERROR_BUFFER_OVERFLOW;
+        return nullptr;
+    }
+    auto* operation = &batch->operations[batch->operation_count++];
+    operation->type = type;
+    operation->reg = reg;
+    operation->size = dataSize;
+    operation->data_offset = batch->data_size;
+    operation->read_data = nullptr;
+    batch->data_size += dataSize;
+    return operation;
+}
+
+error_t i2c_batch_write_register(struct I2cBatch* batch, uint8_t reg, const uint8_t* data, uint8_t dataSize) {
+    auto* operation = i2c_batch_add(batch, I2C_BATCH_OPERATION_WRITE_REGISTER, reg, dataSize);
+    if (operation == nullptr) {
+        return batch->error;
+    }
+    memcpy(batch->data + operation->data_offset, data, dataSize);
+    return ERROR_NONE;
+}
+
+error_t i2c_batch_register8_set(struct I2cBatch* batch, uint8_t reg, uint8_t value) {
+    return i2c_batch_write_register(batch, reg, &value, 1);
+}
+
+error_t i2c_batch_read_register(struct I2cBatch* batch, uint8_t reg, uint8_t* data, uint8_t dataSize) {
+    auto* operation = i2c_batch_add(batch, I2C_BATCH_OPERATION_READ_REGISTER, reg, dataSize);
+    if (operation == nullptr) {
+        return batch->error;
+    }
+    operation->read_data = data;
+    return ERROR_NONE;
+}
+
+/** @return true when the next operation continues where the previous one ended, so they can be a single transfer */
+static bool i2c_batch_can_merge(const I2cBatch* batch, const I2cBatchOperation& previous, const I2cBatchOperation& next) {
+    // The operations' data is stored in order, so consecutive operations have consecutive data
+    return (batch->flags & I2C_BATCH_FLAG_AUTO_INCREMENT) != 0 &&
+        next.type == previous.type &&
+        next.reg == previous.reg + previous.size;
+}
+
+error_t i2c_batch_submit(struct I2cBatch* batch, TickType_t timeout) {
+    error_t error = batch->error;
+    if (error == ERROR_NONE) {
+        const auto* api = I2C_DRIVER_API(device_get_driver(batch->device));
+        device_lock(batch->device);
+        uint8_t index = 0;
+        while (index < batch->operation_count && error == ERROR_NONE) {
+            const auto& first = batch->operations[index];
+            uint8_t end = index + 1;
+            uint16_t size = first.size;
+            while (end < batch->operation_count && i2c_batch_can_merge(batch, batch->operations[end - 1], batch->operations[end])) {
+                size += batch->operations[end].size;
+                end++;
+            }
+
+            uint8_t* data = batch->data + first.data_offset;
+            if (first.type == I2C_BATCH_OPERATION_WRITE_REGISTER) {
+                error = api->write_register(batch->device, batch->address, first.reg, data, size, timeout);
+            } else {
+                error = api->read_register(batch->device, batch->address, first.reg, data, size, timeout);
+                for (uint8_t i = index; i < end && error == ERROR_NONE; i++) {
+                    const auto& operation = batch->operations[i];
+                    memcpy(operation.read_data, batch->data + operation.data_offset, operation.size);
+                }
+            }
+            index = end;
+        }
+        device_unlock(batch->device);
+    }
+
+    i2c_batch_init(batch, batch->device, batch->address, batch->flags);
+    return error;
+}
+
 const struct DeviceType I2C_CONTROLLER_TYPE {
     .name = "i2c-controller"
 };
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <tactility/drivers/i2c_register_cache.h>
+#include <tactility/concurrent/mutex.h>
+#include <tactility/device.h>
+#include <tactility/drivers/i2c_controller.h>
+
+#include <bitset>
+#include <new>
+
+struct I2cRegisterCache {
+    struct Device* device;
+    uint8_t address;
+    // Guards the cached values for the whole operation, so read-modify-write operations of the same cache
+    // don't interleave. The controller device is only locked during the transfers: device_lock() is also
+    // taken by e.g. device_add_child(), which shouldn't wait for a read-modify-write to complete.
+    Mutex mutex {};
+    std::bitset<256> is_volatile;
+    std::bitset<256> is_cached;
+    uint8_t values[256] = {};
+};
+
+namespace {
+
+// Locks the controller device for the transfer, so it doesn't interleave with a batch on the same bus
+error_t read_register(I2cRegisterCache* cache, uint8_t reg, uint8_t* value, TickType_t timeout) {
+    device_lock(cache->device);
+    error_t error = i2c_controller_register8_get(cache->device, cache->address, reg, value, timeout);
+    device_unlock(cache->device);
+    return error;
+}
+
+// Locks the controller device for the transfer, so it doesn't interleave with a batch on the same bus
+error_t write_register(I2cRegisterCache* cache, uint8_t reg, uint8_t value, TickType_t timeout) {
+    device_lock(cache->device);
+    error_t error = i2c_controller_register8_set(cache->device, cache->address, reg, value, timeout);
+    device_unlock(cache->device);
+    return error;
+}
+
+// Must be called with the mutex locked
+error_t get_locked(I2cRegisterCache* cache, uint8_t reg, uint8_t* value, TickType_t timeout) {
+    if (cache->is_cached[reg]) {
+        *value = cache->values[reg];
+        return ERROR_NONE;
+    }
+    error_t error = read_register(cache, reg, value, timeout);
+    if (error == ERROR_NONE && !cache->is_volatile[reg]) {
+        cache->values[reg] = *value;
+        cache->is_cached[reg] = true;
+    }
+    return error;
+}
+
+// Must be called with the mutex locked
+error_t set_locked(I2cRegisterCache* cache, uint8_t reg, uint8_t value, TickType_t timeout) {
+    error_t error = write_register(cache, reg, value, timeout);
+    if (error == ERROR_NONE && !cache->is_volatile[reg]) {
+        cache->values[reg] = value;
+        cache->is_cached[reg] = true;
+    } else {
+        // The write might have reached the device or not
+        cache->is_cached[reg] = false;
+    }
+    return error;
+}
+
+} // namespace
+
+extern "C" {
+
+struct I2cRegisterCache* i2c_register_cache_alloc(struct Device* device, uint8_t address, const uint8_t* volatile_registers, size_t volatile_register_count) {
+    auto* cache = new (std::nothrow) I2cRegisterCache();
+    if (cache == nullptr) {
+        return nullptr;
+    }
+    cache->device = device;
+    cache->address = address;
+    for (size_t i = 0; i < volatile_register_count; i++) {
+        cache->is_volatile[volatile_registers[i]] = true;
+    }
+    mutex_construct(&cache->mutex);
+    return cache;
+}
+
+void i2c_register_cache_free(struct I2cRegisterCache* cache) {
+    mutex_destruct(&cache->mutex);
+    delete cache;
+}
+
+error_t i2c_register_cache_get(struct I2cRegisterCache* cache, uint8_t reg, uint8_t* value, TickType_t timeout) {
+    mutex_lock(&cache->mutex);
+    error_t error = get_locked(cache, reg, value, timeout);
+    mutex_unlock(&cache->mutex);
+    return error;
+}
+
+error_t i2c_register_cache_set(struct I2cRegisterCache* cache, uint8_t reg, uint8_t value, TickType_t timeout) {
+    mutex_lock(&cache->mutex);
+    error_t error = set_locked(cache, reg, value, timeout);
+    mutex_unlock(&cache->mutex);
+    return error;
+}
+
+error_t i2c_register_cache_update_bits(struct I2cRegisterCache* cache, uint8_t reg, uint8_t mask, uint8_t value, TickType_t timeout) {
+    mutex_lock(&cache->mutex);
+    uint8_t old_value = 0;
+    error_t error = get_locked(cache, reg, &old_value, timeout);
+    if (error == ERROR_NONE) {
+        auto new_value = static_cast<uint8_t>((old_value & ~mask) | (value & mask));
+        // Volatile registers are always written: e.g. writing 1 might clear an interrupt flag that reads as 1
+        if (new_value != old_value || cache->is_volatile[reg]) {
+            error = set_locked(cache, reg, new_value, timeout);
+        }
+    }
+    mutex_unlock(&cache->mutex);
+    return error;
+}
+
+error_t i2c_register_cache_set_bits(struct I2cRegisterCache* cache, uint8_t reg, uint8_t bits_to_set, TickType_t timeout) {
+    return i2c_register_cache_update_bits(cache, reg, bits_to_set, bits_to_set, timeout);
+}
+
+error_t i2c_register_cache_reset_bits(struct I2cRegisterCache* cache, uint8_t reg, uint8_t bits_to_reset, TickType_t timeout) {
+    return i2c_register_cache_update_bits(cache, reg, bits_to_reset, 0, timeout);
+}
+
+void i2c_register_cache_invalidate(struct I2cRegisterCache* cache) {
+    mutex_lock(&cache->mutex);
+    cache->is_cached.reset();
+    mutex_unlock(&cache->mutex);
+}
+
+}
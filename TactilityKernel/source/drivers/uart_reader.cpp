@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <tactility/drivers/uart_reader.h>
+#include <tactility/drivers/uart_controller.h>
+#include <tactility/time.h>
+
+#include <cstring>
+#include <new>
+
+struct UartReader {
+    struct Device* device;
+    uint8_t* buffer;
+    size_t buffer_size;
+    // The bytes that weren't returned yet are [start, end)
+    size_t start;
+    size_t end;
+    // The bytes in [start, scanned) were searched for the delimiter already
+    size_t scanned;
+};
+
+namespace {
+
+TickType_t get_timeout_left(TickType_t start_time, TickType_t timeout) {
+    TickType_t passed = get_ticks() - start_time;
+    return (passed < timeout) ? timeout - passed : 0;
+}
+
+/** Moves the buffered bytes to the start of the buffer, to make room at the end */
+void compact(UartReader* reader) {
+    if (reader->start == 0) {
+        return;
+    }
+    size_t length = reader->end - reader->start;
+    std::memmove(reader->buffer, reader->buffer + reader->start, length);
+    reader->scanned -= reader->start;
+    reader->start = 0;
+    reader->end = length;
+}
+
+/**
+ * Reads at least 1 byte into the free space at the end of the buffer, and then everything else
+ * that's available and fits, in a single driver call.
+ */
+error_t fill(UartReader* reader, TickType_t timeout) {
+    if (reader->end == reader->buffer_size) {
+        compact(reader);
+    }
+    uint8_t* free_space = reader->buffer + reader->end;
+    size_t free_size = reader->buffer_size - reader->end;
+
+    size_t available = 0;
+    error_t error = uart_controller_get_available(reader->device, &available);
+    if (error != ERROR_NONE) {
+        return error;
+    }
+    if (available == 0) {
+        // Wait for the first byte, then see what else arrived in the meantime
+        error = uart_controller_read_bytes(reader->device, free_space, 1, timeout);
+        if (error != ERROR_NONE) {
+            return error;
+        }
+        reader->end++;
+        free_space++;
+        free_size--;
+        if (uart_controller_get_available(reader->device, &available) != ERROR_NONE) {
+            return ERROR_NONE;
+        }
+    }
+
+    size_t read_size = (available < free_size) ? available : free_size;
+    if (read_size > 0) {
+        error = uart_controller_read_bytes(reader->device, free_space, read_size, 0);
+        if (error != ERROR_NONE) {
+            return error;
+        }
+        reader->end += read_size;
+    }
+    return ERROR_NONE;
+}
+
+} // namespace
+
+extern "C" {
+
+struct UartReader* uart_reader_alloc(struct Device* device, size_t buffer_size) {
+    if (buffer_size == 0) {
+        return nullptr;
+    }
+    auto* reader = new (std::nothrow) UartReader();
+    if (reader == nullptr) {
+        return nullptr;
+    }
+    reader->buffer = new (std::nothrow) uint8_t[buffer_size];
+    if (reader->buffer == nullptr) {
+        delete reader;
+        return nullptr;
+    }
+    reader->device = device;
+    reader->buffer_size = buffer_size;
+    return reader;
+}
+
+void uart_reader_free(struct UartReader* reader) {
+    delete[] reader->buffer;
+    delete reader;
+}
+
+error_t uart_reader_read_line(struct UartReader* reader, uint8_t delimiter, const uint8_t** out_line, size_t* out_length, TickType_t timeout) {
+    TickType_t start_time = get_ticks();
+    while (true) {
+        const uint8_t* line = reader->buffer + reader->start;
+        auto* found = static_cast<const uint8_t*>(std::memchr(reader->buffer + reader->scanned, delimiter, reader->end - reader->scanned));
+        if (found != nullptr) {
+            *out_line = line;
+            *out_length = static_cast<size_t>(found - line) + 1;
+            reader->start += *out_length;
+            reader->scanned = reader->start;
+            return ERROR_NONE;
+        }
+        reader->scanned = reader->end;
+
+        size_t length = reader->end - reader->start;
+        if (length == reader->buffer_size) {
+            *out_line = line;
+            *out_length = length;
+            reader->start = reader->end;
+            reader->scanned = reader->end;
+            return ERROR_BUFFER_OVERFLOW;
+        }
+
+        error_t error = fill(reader, get_timeout_left(start_time, timeout));
+        if (error != ERROR_NONE) {
+            return error;
+        }
+    }
+}
+
+error_t uart_reader_read(struct UartReader* reader, uint8_t* buffer, size_t buffer_size, size_t* out_length, TickType_t timeout) {
+    if (reader->start == reader->end) {
+        reader->start = 0;
+        reader->end = 0;
+        reader->scanned = 0;
+        error_t error = fill(reader, timeout);
+        if (error != ERROR_NONE) {
+            *out_length = 0;
+            return error;
+        }
+    }
+
+    size_t length = reader->end - reader->start;
+    if (length > buffer_size) {
+        length = buffer_size;
+    }
+    std::memcpy(buffer, reader->buffer + reader->start, length);
+    reader->start += length;
+    if (reader->scanned < reader->start) {
+        reader->scanned = reader->start;
+    }
+    *out_length = length;
+    return ERROR_NONE;
+}
+
+size_t uart_reader_get_buffered(const struct UartReader* reader) {
+    return reader->end - reader->start;
+}
+
+void uart_reader_reset(struct UartReader* reader) {
+    reader->start = 0;
+    reader->end = 0;
+    reader->scanned = 0;
+}
+
+}
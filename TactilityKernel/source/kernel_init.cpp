@@ -1,7 +1,11 @@
 #include <tactility/kernel_init.h>
 
 #include <tactility/device.h>
+#include <tactility/device_boot.h>
 #include <tactility/log.h>
+#include <tactility/memory.h>
+
+#include <vector>
 
 #ifdef __cplusplus
 extern "C" {
@@ -9,6 +13,16 @@ extern "C" {
 
 #define TAG "kernel"
 
+// Devices are brought up one by one in devicetree order by default: drivers may depend on devices
+// outside their ancestry (e.g. gpio-hogs on IO expander pins), which the boot scheduler can't see.
+#ifdef CONFIG_TT_KERNEL_DEVICE_BOOT_WORKERS
+#define DEVICE_BOOT_WORKERS CONFIG_TT_KERNEL_DEVICE_BOOT_WORKERS
+#else
+#define DEVICE_BOOT_WORKERS 1
+#endif
+
+#define DEVICE_BOOT_WORKER_STACK_SIZE 8192
+
 extern const ModuleSymbol KERNEL_SYMBOLS[];
 
 static error_t start() {
@@ -46,6 +60,10 @@ Module root_module = {
 error_t kernel_init(Module* const dts_modules[], const DtsDevice dts_devices[]) {
     LOG_I(TAG, "init");
 
+#ifdef CONFIG_TT_KERNEL_MEMORY_TRACKING
+    memory_tracking_set_enabled(true);
+#endif
+
     if (module_construct_add_start(&root_module) != ERROR_NONE) {
         LOG_E(TAG, "root module init failed");
         return ERROR_RESOURCE;
@@ -60,22 +78,16 @@ error_t kernel_init(Module* const dts_modules[], const DtsDevice dts_devices[])
         dts_module++;
     }
 
-    const DtsDevice* dts_device = dts_devices;
-    while (dts_device->device != nullptr) {
-        if (dts_device->status == DTS_DEVICE_STATUS_OKAY) {
-            if (device_construct_add_start(dts_device->device, dts_device->compatible) != ERROR_NONE) {
-                LOG_E(TAG, "kernel_init failed to construct+add+start device: %s (%s)", dts_device->device->name, dts_device->compatible);
-                return ERROR_RESOURCE;
-            }
-        } else if (dts_device->status == DTS_DEVICE_STATUS_DISABLED) {
-            if (device_construct_add(dts_device->device, dts_device->compatible) != ERROR_NONE) {
-                LOG_E(TAG, "kernel_init failed to construct+add device: %s (%s)", dts_device->device->name, dts_device->compatible);
-                return ERROR_RESOURCE;
-            }
-        } else {
-            check(false, "DTS status not implemented");
-        }
-        dts_device++;
+    const DeviceBootConfig boot_config = {
+        .worker_count = DEVICE_BOOT_WORKERS,
+        .worker_stack_size = DEVICE_BOOT_WORKER_STACK_SIZE
+    };
+    std::vector<DeviceBootRecord> boot_records(device_boot_count(dts_devices));
+    error_t boot_error = device_boot(dts_devices, &boot_config, boot_records.data());
+    device_boot_log_report(boot_records.data(), boot_records.size());
+    if (boot_error != ERROR_NONE) {
+        LOG_E(TAG, "device boot failed: %s", error_to_string(boot_error));
+        return ERROR_RESOURCE;
     }
 
     LOG_I(TAG, "init done");
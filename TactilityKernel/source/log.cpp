@@ -4,13 +4,98 @@
 
 #include <tactility/log.h>
 
+#include <tactility/concurrent/event_group.h>
+#include <tactility/concurrent/thread.h>
+#include <tactility/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <mutex>
+#include <new>
 #include <inttypes.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdarg.h>
 #include <sys/time.h>
 
+/** Maximum length of a formatted message in the ring buffer, including the null terminator. Longer messages are truncated. */
+#define LOG_MESSAGE_SIZE 224U
+/** Maximum amount of tags with their own level */
+#define LOG_TAG_LEVEL_COUNT 32U
+/** How often log_flush_on_crash() retries to take over the ring buffer from the drain task */
+#define LOG_CRASH_FLUSH_ATTEMPTS 1000U
+/** Set by log_async_stop() to end the drain task without waiting for the drain interval */
+#define LOG_DRAIN_STOP_BIT (1U << 0U)
+
+namespace {
+
+struct LogRecord {
+    /** Position in the ring buffer this record is ready for (see claim() and drain()) */
+    std::atomic<uint32_t> sequence;
+    LogLevel level;
+    uint64_t timestamp;
+    /** Set for records from log_fast_generic(): the message is formatted from deferred_args by the drain task */
+    const char* deferred_format;
+    /** The tag of a deferred record, which is not copied */
+    const char* deferred_tag;
+    uint32_t deferred_arg_count;
+    char tag[LOG_TAG_LENGTH_MAX + 1U];
+    union {
+        char message[LOG_MESSAGE_SIZE];
+        uint64_t deferred_args[LOG_FAST_ARG_COUNT_MAX];
+    };
+};
+
+/**
+ * Bounded multi-producer ring buffer (Vyukov). Each record carries a sequence number that tells
+ * whether it's free for the producer at a position or filled for the consumer at a position.
+ * Producers only contend on the enqueue position, the single consumer owns the dequeue position.
+ */
+struct LogRing {
+    LogRecord* records;
+    uint32_t mask;
+    std::atomic<uint32_t> enqueue_position;
+    uint32_t dequeue_position;
+};
+
+struct TagLevel {
+    char tag[LOG_TAG_LENGTH_MAX + 1U];
+    std::atomic<uint8_t> level;
+};
+
+TagLevel tag_levels[LOG_TAG_LEVEL_COUNT];
+/** Entries are immutable once counted, except for their level */
+std::atomic<uint32_t> tag_level_count = 0;
+std::atomic<uint8_t> default_level = LOG_LEVEL_VERBOSE;
+std::mutex tag_levels_mutex;
+
+std::atomic<LogRing*> async_ring = nullptr;
+/** Amount of calls that might still be using async_ring or output */
+std::atomic<uint32_t> async_producers = 0;
+/** Set while a thread is consuming the ring buffer */
+std::atomic_flag consumer_busy = ATOMIC_FLAG_INIT;
+/** Set by log_flush_on_crash(): log_generic() then writes synchronously, even though the ring buffer still exists */
+std::atomic<bool> async_crashed = false;
+/** Whether log_flush_on_crash() took consumer_busy over from the drain task */
+bool crash_owns_consumer = false;
+std::atomic<uint32_t> written_count = 0;
+std::atomic<uint32_t> dropped_count = 0;
+/** The amount of dropped records that was last reported in the output */
+uint32_t reported_dropped_count = 0;
+
+Thread* drain_thread = nullptr;
+EventGroupHandle_t drain_events = nullptr;
+uint32_t drain_interval_ms = 0;
+/**
+ * Load it after registering in async_producers: log_async_stop() swaps it back to stdout
+ * and waits for async_producers to reach zero before it closes the file.
+ */
+std::atomic<FILE*> output = stdout;
+
+} // namespace
+
 static const char* get_log_color(LogLevel level) {
     using enum LogLevel;
     switch (level) {
@@ -61,17 +146,529 @@ static uint64_t get_log_timestamp() {
     return now - base;
 }
 
+static bool is_level_enabled(LogLevel level, const char* tag) {
+    return static_cast<uint8_t>(level) <= static_cast<uint8_t>(log_get_level(tag));
+}
+
+/** Only the terminal gets colors, log files don't */
+static bool has_colors(FILE* file) {
+    return file == stdout;
+}
+
+static void write_prefix(FILE* file, LogLevel level, uint64_t timestamp, const char* tag) {
+    if (has_colors(file)) {
+        fprintf(file, "%s %c (%" PRIu64 ") %s ", get_log_color(level), get_log_prefix(level), timestamp, tag);
+    } else {
+        fprintf(file, "%c (%" PRIu64 ") %s ", get_log_prefix(level), timestamp, tag);
+    }
+}
+
+static void write_suffix(FILE* file) {
+    fputs(has_colors(file) ? "\033[0m\n" : "\n", file);
+}
+
+static void write_line(FILE* file, LogLevel level, uint64_t timestamp, const char* tag, const char* message) {
+    flockfile(file);
+    write_prefix(file, level, timestamp, tag);
+    fputs(message, file);
+    write_suffix(file);
+    funlockfile(file);
+}
+
+/** Append the output of snprintf() to the buffer and advance it, truncating when the buffer is full */
+template<typename T>
+static void append_formatted(char*& buffer, size_t& size, const char* specification, T value) {
+    int written = snprintf(buffer, size, specification, value);
+    if (written < 0) {
+        return;
+    }
+    size_t advance = std::min(static_cast<size_t>(written), size - 1U);
+    buffer += advance;
+    size -= advance;
+}
+
+static double to_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * printf() for the arguments of a deferred record. Every conversion consumes one argument.
+ * Arguments are stored as 64-bit values by LOG_FAST(), so they are converted back to the type
+ * that the conversion specifier and length modifier ask for.
+ */
+static void format_deferred(char* buffer, size_t size, const char* format, const uint64_t* args, uint32_t arg_count) {
+    uint32_t arg_index = 0U;
+    const char* cursor = format;
+    while (*cursor != '\0' && size > 1U) {
+        if (*cursor != '%') {
+            *buffer++ = *cursor++;
+            size--;
+            continue;
+        }
+
+        const char* specification_start = cursor++;
+        if (*cursor == '%') {
+            *buffer++ = '%';
+            size--;
+            cursor++;
+            continue;
+        }
+
+        // Flags, width and precision, where '*' would take an extra argument which LOG_FAST() doesn't support
+        while (*cursor != '\0' && strchr("-+ #0123456789.", *cursor) != nullptr) {
+            cursor++;
+        }
+        const char* length_start = cursor;
+        while (*cursor != '\0' && strchr("hljztL", *cursor) != nullptr) {
+            cursor++;
+        }
+        char conversion = *cursor;
+        if (conversion == '\0') {
+            break;
+        }
+        cursor++;
+
+        char specification[32];
+        size_t specification_length = static_cast<size_t>(cursor - specification_start);
+        if (specification_length >= sizeof(specification) || arg_index >= arg_count) {
+            append_formatted(buffer, size, "%s", "<?>");
+            continue;
+        }
+        memcpy(specification, specification_start, specification_length);
+        specification[specification_length] = '\0';
+
+        uint64_t arg = args[arg_index++];
+        size_t length_size = static_cast<size_t>(cursor - 1 - length_start);
+        bool is_long_long = (length_size == 2U && length_start[0] == 'l') || (length_size == 1U && length_start[0] == 'j');
+        bool is_long = (length_size == 1U && strchr("lzt", length_start[0]) != nullptr);
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                if (is_long_long) {
+                    append_formatted(buffer, size, specification, static_cast<long long>(arg));
+                } else if (is_long) {
+                    append_formatted(buffer, size, specification, static_cast<long>(arg));
+                } else {
+                    append_formatted(buffer, size, specification, static_cast<int>(arg));
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                if (is_long_long) {
+                    append_formatted(buffer, size, specification, static_cast<unsigned long long>(arg));
+                } else if (is_long) {
+                    append_formatted(buffer, size, specification, static_cast<unsigned long>(arg));
+                } else {
+                    append_formatted(buffer, size, specification, static_cast<unsigned int>(arg));
+                }
+                break;
+            case 'c':
+                append_formatted(buffer, size, specification, static_cast<int>(arg));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (length_size == 1U && length_start[0] == 'L') {
+                    append_formatted(buffer, size, specification, static_cast<long double>(to_double(arg)));
+                } else {
+                    append_formatted(buffer, size, specification, to_double(arg));
+                }
+                break;
+            case 's':
+                append_formatted(buffer, size, specification, reinterpret_cast<const char*>(static_cast<uintptr_t>(arg)));
+                break;
+            case 'p':
+                append_formatted(buffer, size, specification, reinterpret_cast<void*>(static_cast<uintptr_t>(arg)));
+                break;
+            default:
+                // %n and unknown conversions
+                append_formatted(buffer, size, "%s", "<?>");
+                break;
+        }
+    }
+    *buffer = '\0';
+}
+
+static void write_line_va(FILE* file, LogLevel level, uint64_t timestamp, const char* tag, const char* format, va_list args) {
+    flockfile(file);
+    write_prefix(file, level, timestamp, tag);
+    vfprintf(file, format, args);
+    write_suffix(file);
+    funlockfile(file);
+}
+
+/**
+ * Reserve the next record in the ring buffer. Pass it to publish() once it's filled in.
+ * @param[out] position the position to pass to publish()
+ * @return the record, or nullptr when the ring buffer is full
+ */
+static LogRecord* claim(LogRing* ring, uint32_t& position) {
+    position = ring->enqueue_position.load(std::memory_order_relaxed);
+    LogRecord* record;
+    while (true) {
+        record = &ring->records[position & ring->mask];
+        uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int32_t>(sequence - position);
+        if (difference == 0) {
+            if (ring->enqueue_position.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return nullptr;
+        } else {
+            position = ring->enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+    return record;
+}
+
+/** Make a claimed record available to the consumer */
+static void publish(LogRecord* record, uint32_t position) {
+    record->sequence.store(position + 1U, std::memory_order_release);
+}
+
+/** @return false when the ring buffer is full */
+static bool enqueue(LogRing* ring, LogLevel level, uint64_t timestamp, const char* tag, const char* format, va_list args) {
+    uint32_t position;
+    LogRecord* record = claim(ring, position);
+    if (record == nullptr) {
+        return false;
+    }
+    record->level = level;
+    record->timestamp = timestamp;
+    record->deferred_format = nullptr;
+    strncpy(record->tag, tag, LOG_TAG_LENGTH_MAX);
+    record->tag[LOG_TAG_LENGTH_MAX] = '\0';
+    vsnprintf(record->message, LOG_MESSAGE_SIZE, format, args);
+    publish(record, position);
+    return true;
+}
+
+/** @return false when the ring buffer is full */
+static bool enqueue_deferred(LogRing* ring, LogLevel level, uint64_t timestamp, const char* tag, const char* format, const uint64_t* args, uint32_t arg_count) {
+    uint32_t position;
+    LogRecord* record = claim(ring, position);
+    if (record == nullptr) {
+        return false;
+    }
+    record->level = level;
+    record->timestamp = timestamp;
+    record->deferred_format = format;
+    record->deferred_tag = tag;
+    record->deferred_arg_count = arg_count;
+    memcpy(record->deferred_args, args, arg_count * sizeof(uint64_t));
+    publish(record, position);
+    return true;
+}
+
+/**
+ * Write out all records that are ready.
+ * @warning must own consumer_busy, and be registered in async_producers, be the drain task or be log_async_stop()
+ */
+static void drain(LogRing* ring) {
+    FILE* file = output.load();
+    bool wrote = false;
+    while (true) {
+        LogRecord* record = &ring->records[ring->dequeue_position & ring->mask];
+        uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+        if (sequence != ring->dequeue_position + 1U) {
+            // Empty, or the producer that claimed this record is still writing it
+            break;
+        }
+        if (record->deferred_format != nullptr) {
+            char message[LOG_MESSAGE_SIZE];
+            format_deferred(message, sizeof(message), record->deferred_format, record->deferred_args, record->deferred_arg_count);
+            write_line(file, record->level, record->timestamp, record->deferred_tag, message);
+        } else {
+            write_line(file, record->level, record->timestamp, record->tag, record->message);
+        }
+        record->sequence.store(ring->dequeue_position + ring->mask + 1U, std::memory_order_release);
+        ring->dequeue_position++;
+        written_count.fetch_add(1U, std::memory_order_relaxed);
+        wrote = true;
+    }
+
+    uint32_t dropped = dropped_count.load(std::memory_order_relaxed);
+    if (dropped != reported_dropped_count) {
+        fprintf(file, "(%" PRIu32 " log messages dropped)\n", dropped - reported_dropped_count);
+        reported_dropped_count = dropped;
+        wrote = true;
+    }
+
+    if (wrote) {
+        fflush(file);
+    }
+}
+
+static void lock_consumer() {
+    while (consumer_busy.test_and_set(std::memory_order_acquire)) {
+        sched_yield();
+    }
+}
+
+static void unlock_consumer() {
+    consumer_busy.clear(std::memory_order_release);
+}
+
+static int32_t drain_main(void* context) {
+    auto* ring = static_cast<LogRing*>(context);
+    // The ring buffer is empty at the start, and log_async_stop() drains what's left after the stop bit is set
+    while (event_group_wait(drain_events, LOG_DRAIN_STOP_BIT, false, false, nullptr, pdMS_TO_TICKS(drain_interval_ms)) != ERROR_NONE) {
+        lock_consumer();
+        drain(ring);
+        unlock_consumer();
+    }
+    return 0;
+}
+
 extern "C" {
 
 void log_generic(enum LogLevel level, const char* tag, const char* format, ...) {
+    if (!is_level_enabled(level, tag)) {
+        return;
+    }
+
+    uint64_t timestamp = get_log_timestamp();
     va_list args;
     va_start(args, format);
-    printf("%s %c (%" PRIu64 ") %s ", get_log_color(level), get_log_prefix(level), get_log_timestamp(), tag);
-    vprintf(format, args);
-    printf("\033[0m\n");
+
+    // Registering as producer before loading the ring and the output makes log_async_stop() wait for this call
+    async_producers.fetch_add(1U);
+    LogRing* ring = async_crashed.load() ? nullptr : async_ring.load();
+    if (ring != nullptr) {
+        if (!enqueue(ring, level, timestamp, tag, format, args)) {
+            dropped_count.fetch_add(1U, std::memory_order_relaxed);
+        }
+    } else {
+        write_line_va(output.load(), level, timestamp, tag, format, args);
+    }
+    async_producers.fetch_sub(1U);
+
     va_end(args);
 }
 
+void log_fast_generic(enum LogLevel level, const char* tag, const char* format, const uint64_t* args, uint32_t arg_count) {
+    if (!is_level_enabled(level, tag)) {
+        return;
+    }
+
+    uint64_t timestamp = get_log_timestamp();
+    if (arg_count > LOG_FAST_ARG_COUNT_MAX) {
+        arg_count = LOG_FAST_ARG_COUNT_MAX;
+    }
+
+    async_producers.fetch_add(1U);
+    LogRing* ring = async_crashed.load() ? nullptr : async_ring.load();
+    if (ring != nullptr) {
+        if (!enqueue_deferred(ring, level, timestamp, tag, format, args, arg_count)) {
+            dropped_count.fetch_add(1U, std::memory_order_relaxed);
+        }
+    } else {
+        char message[LOG_MESSAGE_SIZE];
+        format_deferred(message, sizeof(message), format, args, arg_count);
+        write_line(output.load(), level, timestamp, tag, message);
+    }
+    async_producers.fetch_sub(1U);
+}
+
+error_t log_set_level(const char* tag, enum LogLevel level) {
+    if (strlen(tag) > LOG_TAG_LENGTH_MAX) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    std::lock_guard lock(tag_levels_mutex);
+    uint32_t count = tag_level_count.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(tag_levels[i].tag, tag) == 0) {
+            tag_levels[i].level.store(level, std::memory_order_relaxed);
+            return ERROR_NONE;
+        }
+    }
+
+    if (count == LOG_TAG_LEVEL_COUNT) {
+        return ERROR_RESOURCE;
+    }
+
+    strcpy(tag_levels[count].tag, tag);
+    tag_levels[count].level.store(level, std::memory_order_relaxed);
+    // Publishes the entry to is_level_enabled(), which reads it without locking
+    tag_level_count.store(count + 1U, std::memory_order_release);
+    return ERROR_NONE;
+}
+
+enum LogLevel log_get_level(const char* tag) {
+    uint32_t count = tag_level_count.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(tag_levels[i].tag, tag) == 0) {
+            return static_cast<LogLevel>(tag_levels[i].level.load(std::memory_order_relaxed));
+        }
+    }
+    return static_cast<LogLevel>(default_level.load(std::memory_order_relaxed));
+}
+
+void log_set_default_level(enum LogLevel level) {
+    default_level.store(level, std::memory_order_relaxed);
+}
+
+error_t log_async_start(const struct LogAsyncConfig* config) {
+    if (async_ring.load() != nullptr || drain_thread != nullptr) {
+        return ERROR_INVALID_STATE;
+    }
+
+    if (config->record_count == 0U || (config->record_count & (config->record_count - 1U)) != 0U) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+    auto* ring = new(std::nothrow) LogRing();
+    auto* records = new(std::nothrow) LogRecord[config->record_count];
+    if (ring == nullptr || records == nullptr) {
+        delete ring;
+        delete[] records;
+        return ERROR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; i < config->record_count; i++) {
+        records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    ring->records = records;
+    ring->mask = config->record_count - 1U;
+    ring->enqueue_position = 0U;
+    ring->dequeue_position = 0U;
+
+    FILE* file = stdout;
+    if (config->file_path != nullptr) {
+        file = fopen(config->file_path, "a");
+        if (file == nullptr) {
+            delete[] records;
+            delete ring;
+            return ERROR_RESOURCE;
+        }
+    }
+
+    written_count = 0U;
+    dropped_count = 0U;
+    reported_dropped_count = 0U;
+    async_crashed = false;
+    crash_owns_consumer = false;
+
+    event_group_construct(&drain_events);
+    drain_interval_ms = config->drain_interval_ms;
+    drain_thread = thread_alloc_full("log_drain", config->drain_stack_size, drain_main, ring, -1);
+    if (drain_thread == nullptr || thread_start(drain_thread) != ERROR_NONE) {
+        if (drain_thread != nullptr) {
+            thread_free(drain_thread);
+            drain_thread = nullptr;
+        }
+        event_group_destruct(&drain_events);
+        if (file != stdout) {
+            fclose(file);
+        }
+        delete[] records;
+        delete ring;
+        return ERROR_RESOURCE;
+    }
+
+    // Synchronous writers might still be writing to the previous output, but that's always stdout, which stays open
+    fflush(stdout);
+    output.store(file);
+    async_ring.store(ring);
+    return ERROR_NONE;
+}
+
+error_t log_async_stop(void) {
+    if (drain_thread == nullptr) {
+        return ERROR_INVALID_STATE;
+    }
+
+    event_group_set(drain_events, LOG_DRAIN_STOP_BIT);
+    if (crash_owns_consumer) {
+        crash_owns_consumer = false;
+        unlock_consumer();
+    }
+    thread_join(drain_thread, MAX_TICKS, 1);
+    thread_free(drain_thread);
+    drain_thread = nullptr;
+    event_group_destruct(&drain_events);
+
+    LogRing* ring = async_ring.exchange(nullptr);
+    if (ring != nullptr) {
+        // New calls now write synchronously, but calls that loaded the ring earlier might still be writing a record
+        while (async_producers.load() != 0U) {
+            sched_yield();
+        }
+        lock_consumer();
+        drain(ring);
+        unlock_consumer();
+        delete[] ring->records;
+        delete ring;
+    }
+
+    FILE* file = output.exchange(stdout);
+    if (file != stdout) {
+        // Synchronous writers that loaded the file before the exchange might still be writing to it
+        while (async_producers.load() != 0U) {
+            sched_yield();
+        }
+        fclose(file);
+    }
+    return ERROR_NONE;
+}
+
+void log_flush(void) {
+    async_producers.fetch_add(1U);
+    LogRing* ring = async_ring.load();
+    if (ring != nullptr) {
+        lock_consumer();
+        drain(ring);
+        unlock_consumer();
+    }
+    async_producers.fetch_sub(1U);
+}
+
+void log_flush_on_crash(void) {
+    if (async_crashed.exchange(true)) {
+        return;
+    }
+
+    // From here on, log_generic() writes synchronously
+    async_producers.fetch_add(1U);
+    LogRing* ring = async_ring.load();
+    if (ring == nullptr) {
+        async_producers.fetch_sub(1U);
+        return;
+    }
+
+    // The drain task normally releases the ring buffer within one drain pass. When it doesn't,
+    // it probably crashed while holding it and the buffered records are lost.
+    for (uint32_t attempt = 0U; attempt < LOG_CRASH_FLUSH_ATTEMPTS; attempt++) {
+        if (!consumer_busy.test_and_set(std::memory_order_acquire)) {
+            drain(ring);
+            // Keep the drain task away from the output, so it can't interleave with the crash report
+            crash_owns_consumer = true;
+            async_producers.fetch_sub(1U);
+            return;
+        }
+        sched_yield();
+    }
+    FILE* file = output.load();
+    fputs("(log buffer lost: drain task is unresponsive)\n", file);
+    fflush(file);
+    async_producers.fetch_sub(1U);
+}
+
+void log_get_stats(struct LogStats* stats) {
+    stats->written = written_count.load(std::memory_order_relaxed);
+    stats->dropped = dropped_count.load(std::memory_order_relaxed);
+}
+
 }
 
 #endif
\ No newline at end of file
@@ -5,7 +5,10 @@
 #include <esp_heap_caps.h>
 #endif
 
+#include <algorithm>
+
 constexpr auto* TAG = "memory";
+constexpr size_t PRINTED_TAGS_MAX = 16;
 
 extern "C" {
 
@@ -15,6 +18,18 @@ const struct MemoryPolicy MEMORY_POLICY_DEFAULT = {
     .alignment = 0,
 };
 
+void* memory_alloc_with_policy(size_t size, const struct MemoryPolicy* policy) {
+    return memory_alloc_tagged(size, policy, nullptr);
+}
+
+void* memory_realloc_with_policy(void* ptr, size_t size, const struct MemoryPolicy* policy) {
+    return memory_realloc_tagged(ptr, size, policy, nullptr);
+}
+
+void* memory_calloc_with_policy(size_t count, size_t size, const struct MemoryPolicy* policy) {
+    return memory_calloc_tagged(count, size, policy, nullptr);
+}
+
 void memory_print_stats() {
 #ifdef ESP_PLATFORM
     size_t heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
@@ -24,6 +39,23 @@ void memory_print_stats() {
     size_t ext_total = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
     LOG_I(TAG, "External: %zu / %zu available", ext_free, ext_total);
 #endif
+
+    if (memory_tracking_is_enabled()) {
+        MemoryTagStats stats[PRINTED_TAGS_MAX];
+        size_t count = memory_tracking_get_stats(stats, PRINTED_TAGS_MAX);
+        for (size_t i = 0; i < std::min(count, PRINTED_TAGS_MAX); i++) {
+            LOG_I(TAG, "  %s: %zu bytes in %zu blocks (peak %zu, largest %zu)",
+                stats[i].tag,
+                stats[i].current_bytes,
+                stats[i].allocation_count,
+                stats[i].peak_bytes,
+                stats[i].largest_block
+            );
+        }
+        if (count > PRINTED_TAGS_MAX) {
+            LOG_I(TAG, "  (%zu more tags)", count - PRINTED_TAGS_MAX);
+        }
+    }
 }
 
 }
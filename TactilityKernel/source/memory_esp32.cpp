@@ -2,6 +2,7 @@
 #ifdef ESP_PLATFORM
 
 #include <tactility/memory.h>
+#include <tactility/memory_tracking_internal.h>
 
 #include <esp_heap_caps.h>
 
@@ -21,7 +22,7 @@ uint32_t toHeapCaps(uint16_t capabilityFlags) {
 
 extern "C" {
 
-void* memory_alloc_with_policy(size_t size, const struct MemoryPolicy* policy) {
+void* memory_alloc_tagged(size_t size, const struct MemoryPolicy* policy, const char* tag) {
     uint32_t required_caps = toHeapCaps(policy->required);
     uint32_t desired_caps = toHeapCaps(policy->desired);
 
@@ -39,23 +40,29 @@ void* memory_alloc_with_policy(size_t size, const struct MemoryPolicy* policy) {
             ptr = heap_caps_malloc(size, required_caps);
         }
     }
+    memory_tracking_on_alloc(ptr, size, tag);
     return ptr;
 }
 
-void* memory_realloc_with_policy(void* ptr, size_t size, const struct MemoryPolicy* policy) {
+void* memory_realloc_tagged(void* ptr, size_t size, const struct MemoryPolicy* policy, const char* tag) {
     uint32_t required_caps = toHeapCaps(policy->required);
     uint32_t desired_caps = toHeapCaps(policy->desired);
 
+    bool tracking = memory_tracking_before_realloc();
+    auto old_address = reinterpret_cast<uintptr_t>(ptr);
     // No aligned-realloc counterpart in the heap_caps API - policy->alignment is only honored
-    // on fresh allocations (memory_alloc_with_policy/memory_calloc_with_policy).
+    // on fresh allocations (memory_alloc_tagged/memory_calloc_tagged).
     void* result = heap_caps_realloc(ptr, size, required_caps | desired_caps);
     if (result == nullptr && desired_caps != 0) {
         result = heap_caps_realloc(ptr, size, required_caps);
     }
+    if (tracking) {
+        memory_tracking_on_realloc(old_address, result, size, tag);
+    }
     return result;
 }
 
-void* memory_calloc_with_policy(size_t count, size_t size, const struct MemoryPolicy* policy) {
+void* memory_calloc_tagged(size_t count, size_t size, const struct MemoryPolicy* policy, const char* tag) {
     uint32_t required_caps = toHeapCaps(policy->required);
     uint32_t desired_caps = toHeapCaps(policy->desired);
 
@@ -71,10 +78,12 @@ void* memory_calloc_with_policy(size_t count, size_t size, const struct MemoryPo
             ptr = heap_caps_calloc(count, size, required_caps);
         }
     }
+    memory_tracking_on_alloc(ptr, count * size, tag);
     return ptr;
 }
 
 void memory_free(void* ptr) {
+    memory_tracking_on_free(ptr);
     heap_caps_free(ptr);
 }
 
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <tactility/memory.h>
+
+#include <tactility/check.h>
+#include <tactility/concurrent/mutex.h>
+#include <tactility/log.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+#define TAG "memory_pool"
+
+namespace {
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+/** Header of each chunk. The blocks follow it, starting at MemoryPool::chunk_header_size. */
+struct Chunk {
+    Chunk* next;
+};
+
+constexpr size_t SMALL_SIZE_CLASSES[] = { 16, 32, 48, 64, 96, 128, 192, MEMORY_SMALL_SIZE_MAX };
+constexpr size_t SMALL_SIZE_CLASS_COUNT = sizeof(SMALL_SIZE_CLASSES) / sizeof(SMALL_SIZE_CLASSES[0]);
+/** Target size of the chunks of the size class pools */
+constexpr size_t SMALL_CHUNK_SIZE = 2048;
+constexpr size_t SMALL_BLOCKS_PER_CHUNK_MIN = 8;
+
+constexpr size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1U) & ~(alignment - 1U);
+}
+
+} // namespace
+
+struct MemoryPool {
+    Mutex mutex { 0 };
+    MemoryPolicy policy;
+    /** The tag of the chunks, for allocation tracking */
+    const char* tag = nullptr;
+    size_t block_size;
+    size_t blocks_per_chunk;
+    size_t chunk_header_size;
+    Chunk* chunks = nullptr;
+    FreeBlock* free_blocks = nullptr;
+    size_t chunk_count = 0;
+    size_t blocks_in_use = 0;
+    size_t blocks_in_use_peak = 0;
+
+    MemoryPool() {
+        mutex_construct(&mutex);
+    }
+
+    ~MemoryPool() {
+        mutex_destruct(&mutex);
+    }
+};
+
+namespace {
+
+/** @warning must hold pool->mutex */
+bool grow(MemoryPool* pool) {
+    size_t chunk_size = pool->chunk_header_size + (pool->block_size * pool->blocks_per_chunk);
+    auto* chunk = static_cast<Chunk*>(memory_alloc_tagged(chunk_size, &pool->policy, pool->tag));
+    if (chunk == nullptr) {
+        return false;
+    }
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+    pool->chunk_count++;
+
+    // Push in reverse, so blocks are handed out in address order
+    auto* blocks = reinterpret_cast<uint8_t*>(chunk) + pool->chunk_header_size;
+    for (size_t i = pool->blocks_per_chunk; i > 0; i--) {
+        auto* block = reinterpret_cast<FreeBlock*>(blocks + ((i - 1U) * pool->block_size));
+        block->next = pool->free_blocks;
+        pool->free_blocks = block;
+    }
+    return true;
+}
+
+MemoryPool** get_small_pools() {
+    // Never destructed: blocks may still be freed by static destructors at exit
+    static MemoryPool** pools = [] {
+        static MemoryPool* instances[SMALL_SIZE_CLASS_COUNT];
+        for (size_t i = 0; i < SMALL_SIZE_CLASS_COUNT; i++) {
+            size_t blocks_per_chunk = std::max(SMALL_CHUNK_SIZE / SMALL_SIZE_CLASSES[i], SMALL_BLOCKS_PER_CHUNK_MIN);
+            instances[i] = memory_pool_alloc(SMALL_SIZE_CLASSES[i], blocks_per_chunk, &MEMORY_POLICY_DEFAULT);
+            check(instances[i] != nullptr);
+            instances[i]->tag = MEMORY_TAG_SMALL;
+        }
+        return instances;
+    }();
+    return pools;
+}
+
+/** @return the index of the smallest size class that fits size, or SMALL_SIZE_CLASS_COUNT when it's too large */
+size_t get_size_class(size_t size) {
+    for (size_t i = 0; i < SMALL_SIZE_CLASS_COUNT; i++) {
+        if (size <= SMALL_SIZE_CLASSES[i]) {
+            return i;
+        }
+    }
+    return SMALL_SIZE_CLASS_COUNT;
+}
+
+} // namespace
+
+extern "C" {
+
+struct MemoryPool* memory_pool_alloc(size_t block_size, size_t blocks_per_chunk, const struct MemoryPolicy* policy) {
+    if (block_size == 0U || blocks_per_chunk == 0U) {
+        return nullptr;
+    }
+
+    auto* pool = new(std::nothrow) MemoryPool();
+    if (pool == nullptr) {
+        return nullptr;
+    }
+
+    size_t alignment = std::max(policy->alignment, alignof(std::max_align_t));
+    pool->policy = *policy;
+    pool->policy.alignment = alignment;
+    // Each block must be able to hold the free list link while it's not handed out
+    pool->block_size = round_up(std::max(block_size, sizeof(FreeBlock)), alignment);
+    pool->blocks_per_chunk = blocks_per_chunk;
+    pool->chunk_header_size = round_up(sizeof(Chunk), alignment);
+    return pool;
+}
+
+void memory_pool_free(struct MemoryPool* pool) {
+    if (pool->blocks_in_use != 0U) {
+        LOG_W(TAG, "Freeing pool with %zu blocks of %zu bytes in use", pool->blocks_in_use, pool->block_size);
+    }
+
+    Chunk* chunk = pool->chunks;
+    while (chunk != nullptr) {
+        Chunk* next = chunk->next;
+        memory_free(chunk);
+        chunk = next;
+    }
+    delete pool;
+}
+
+void* memory_pool_block_alloc(struct MemoryPool* pool) {
+    mutex_lock(&pool->mutex);
+    if (pool->free_blocks == nullptr && !grow(pool)) {
+        mutex_unlock(&pool->mutex);
+        return nullptr;
+    }
+    FreeBlock* block = pool->free_blocks;
+    pool->free_blocks = block->next;
+    pool->blocks_in_use++;
+    pool->blocks_in_use_peak = std::max(pool->blocks_in_use_peak, pool->blocks_in_use);
+    mutex_unlock(&pool->mutex);
+    return block;
+}
+
+void memory_pool_block_free(struct MemoryPool* pool, void* block) {
+    if (block == nullptr) {
+        return;
+    }
+    mutex_lock(&pool->mutex);
+    auto* free_block = static_cast<FreeBlock*>(block);
+    free_block->next = pool->free_blocks;
+    pool->free_blocks = free_block;
+    pool->blocks_in_use--;
+    mutex_unlock(&pool->mutex);
+}
+
+void memory_pool_get_stats(struct MemoryPool* pool, struct MemoryPoolStats* stats) {
+    mutex_lock(&pool->mutex);
+    *stats = {
+        .block_size = pool->block_size,
+        .blocks_in_use = pool->blocks_in_use,
+        .blocks_in_use_peak = pool->blocks_in_use_peak,
+        .block_capacity = pool->chunk_count * pool->blocks_per_chunk,
+        .chunk_count = pool->chunk_count
+    };
+    mutex_unlock(&pool->mutex);
+}
+
+void* memory_small_alloc(size_t size) {
+    size_t size_class = get_size_class(size);
+    if (size_class == SMALL_SIZE_CLASS_COUNT) {
+        return memory_alloc(size);
+    }
+    return memory_pool_block_alloc(get_small_pools()[size_class]);
+}
+
+void memory_small_free(void* ptr, size_t size) {
+    size_t size_class = get_size_class(size);
+    if (size_class == SMALL_SIZE_CLASS_COUNT) {
+        memory_free(ptr);
+    } else {
+        memory_pool_block_free(get_small_pools()[size_class], ptr);
+    }
+}
+
+size_t memory_small_get_stats(struct MemoryPoolStats* stats, size_t max_count) {
+    if (stats != nullptr) {
+        MemoryPool** pools = get_small_pools();
+        for (size_t i = 0; i < std::min(max_count, SMALL_SIZE_CLASS_COUNT); i++) {
+            memory_pool_get_stats(pools[i], &stats[i]);
+        }
+    }
+    return SMALL_SIZE_CLASS_COUNT;
+}
+
+} // extern "C"
@@ -2,6 +2,7 @@
 #ifndef ESP_PLATFORM
 
 #include <tactility/memory.h>
+#include <tactility/memory_tracking_internal.h>
 
 #include <cstdint>
 #include <cstdlib>
@@ -24,24 +25,32 @@ extern "C" {
 
 // MEMORY_CAP_* flags are meaningless on the desktop simulator (no capability-restricted memory regions)
 // policy->required/desired are intentionally ignored here.
-void* memory_alloc_with_policy(size_t size, const struct MemoryPolicy* policy) {
+void* memory_alloc_tagged(size_t size, const struct MemoryPolicy* policy, const char* tag) {
+    void* ptr = nullptr;
     if (policy->alignment > 0) {
-        void* ptr = nullptr;
         if (posix_memalign(&ptr, normalizeAlignment(policy->alignment), size) != 0) {
             return nullptr;
         }
-        return ptr;
+    } else {
+        ptr = malloc(size);
     }
-    return malloc(size);
+    memory_tracking_on_alloc(ptr, size, tag);
+    return ptr;
 }
 
-void* memory_realloc_with_policy(void* ptr, size_t size, const struct MemoryPolicy* policy) {
+void* memory_realloc_tagged(void* ptr, size_t size, const struct MemoryPolicy* policy, const char* tag) {
+    bool tracking = memory_tracking_before_realloc();
+    auto old_address = reinterpret_cast<uintptr_t>(ptr);
     // Alignment can't be preserved across a POSIX realloc; only honored on fresh allocations
-    // (memory_alloc_with_policy/memory_calloc_with_policy).
-    return realloc(ptr, size);
+    // (memory_alloc_tagged/memory_calloc_tagged).
+    void* result = realloc(ptr, size);
+    if (tracking) {
+        memory_tracking_on_realloc(old_address, result, size, tag);
+    }
+    return result;
 }
 
-void* memory_calloc_with_policy(size_t count, size_t size, const struct MemoryPolicy* policy) {
+void* memory_calloc_tagged(size_t count, size_t size, const struct MemoryPolicy* policy, const char* tag) {
     if (policy->alignment > 0) {
         size_t total_size = count * size;
         if (count != 0 && total_size / count != size) {
@@ -54,12 +63,16 @@ void* memory_calloc_with_policy(size_t count, size_t size, const struct MemoryPo
             return nullptr;
         }
         memset(ptr, 0, total_size);
+        memory_tracking_on_alloc(ptr, total_size, tag);
         return ptr;
     }
-    return calloc(count, size);
+    void* ptr = calloc(count, size);
+    memory_tracking_on_alloc(ptr, count * size, tag);
+    return ptr;
 }
 
 void memory_free(void* ptr) {
+    memory_tracking_on_free(ptr);
     free(ptr);
 }
 
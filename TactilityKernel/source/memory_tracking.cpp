@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include <tactility/memory_tracking_internal.h>
+
+#include <tactility/concurrent/mutex.h>
+#include <tactility/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#define TAG "memory"
+
+namespace {
+
+struct TagStats {
+    /** Points into the key of the tag map, so it stays valid after the caller's tag string is gone */
+    const char* tag;
+    size_t current_bytes = 0;
+    size_t peak_bytes = 0;
+    size_t allocation_count = 0;
+    size_t total_allocation_count = 0;
+    size_t largest_block = 0;
+};
+
+struct Allocation {
+    size_t size;
+    TagStats* stats;
+};
+
+/** Transparent hash so the tag map can be searched with a std::string_view without allocating */
+struct TagHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view tag) const { return std::hash<std::string_view>()(tag); }
+};
+
+// The containers allocate through malloc()/operator new, not through the memory_* functions,
+// so tracking doesn't recurse into itself.
+struct MemoryTracker {
+    Mutex mutex { 0 };
+    /**
+     * Keyed by a copy of the tag content: equal string literals from different translation units can have
+     * different addresses, and tags such as service ids can be freed while their statistics are still listed.
+     */
+    std::unordered_map<std::string, TagStats, TagHash, std::equal_to<>> tags;
+    /** Keyed by address, because a reallocated pointer can't be used anymore */
+    std::unordered_map<uintptr_t, Allocation> allocations;
+    /** The records that were set aside by memory_tracking_save() */
+    std::unordered_map<std::string, TagStats, TagHash, std::equal_to<>> saved_tags;
+    std::unordered_map<uintptr_t, Allocation> saved_allocations;
+
+    MemoryTracker() {
+        mutex_construct(&mutex);
+    }
+
+    ~MemoryTracker() {
+        mutex_destruct(&mutex);
+    }
+};
+
+MemoryTracker tracker;
+std::atomic<bool> tracking_enabled = false;
+thread_local const char* thread_tag = nullptr;
+
+/** @warning must hold tracker.mutex */
+TagStats& get_tag_stats(std::string_view tag) {
+    auto iterator = tracker.tags.find(tag);
+    if (iterator == tracker.tags.end()) {
+        iterator = tracker.tags.emplace(std::string(tag), TagStats()).first;
+        iterator->second.tag = iterator->first.c_str();
+    }
+    return iterator->second;
+}
+
+/** @warning must hold tracker.mutex */
+void record_alloc(void* ptr, size_t size, const char* tag) {
+    if (tag == nullptr) {
+        tag = (thread_tag != nullptr) ? thread_tag : MEMORY_TAG_UNTAGGED;
+    }
+    auto& stats = get_tag_stats(tag);
+    stats.current_bytes += size;
+    stats.peak_bytes = std::max(stats.peak_bytes, stats.current_bytes);
+    stats.allocation_count++;
+    stats.total_allocation_count++;
+    stats.largest_block = std::max(stats.largest_block, size);
+    tracker.allocations[reinterpret_cast<uintptr_t>(ptr)] = { size, &stats };
+}
+
+/** @warning must hold tracker.mutex */
+bool erase_allocation(std::unordered_map<uintptr_t, Allocation>& allocations, uintptr_t address) {
+    auto iterator = allocations.find(address);
+    if (iterator == allocations.end()) {
+        return false;
+    }
+    auto& allocation = iterator->second;
+    allocation.stats->current_bytes -= allocation.size;
+    allocation.stats->allocation_count--;
+    allocations.erase(iterator);
+    return true;
+}
+
+/** @warning must hold tracker.mutex */
+void record_free(uintptr_t address) {
+    // Allocations from before tracking was enabled aren't known
+    if (!erase_allocation(tracker.allocations, address)) {
+        erase_allocation(tracker.saved_allocations, address);
+    }
+}
+
+void to_public_stats(const TagStats& stats, MemoryTagStats* out) {
+    // Copied, because the tag map key is gone once tracking is disabled
+    snprintf(out->tag, sizeof(out->tag), "%s", stats.tag);
+    out->current_bytes = stats.current_bytes;
+    out->peak_bytes = stats.peak_bytes;
+    out->allocation_count = stats.allocation_count;
+    out->total_allocation_count = stats.total_allocation_count;
+    out->largest_block = stats.largest_block;
+}
+
+} // namespace
+
+extern "C" {
+
+void memory_tracking_on_alloc(void* ptr, size_t size, const char* tag) {
+    if (ptr == nullptr || !tracking_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    mutex_lock(&tracker.mutex);
+    record_alloc(ptr, size, tag);
+    mutex_unlock(&tracker.mutex);
+}
+
+void memory_tracking_on_free(void* ptr) {
+    if (ptr == nullptr || !tracking_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    mutex_lock(&tracker.mutex);
+    record_free(reinterpret_cast<uintptr_t>(ptr));
+    mutex_unlock(&tracker.mutex);
+}
+
+bool memory_tracking_before_realloc(void) {
+    if (!tracking_enabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    mutex_lock(&tracker.mutex);
+    return true;
+}
+
+void memory_tracking_on_realloc(uintptr_t old_address, void* new_ptr, size_t size, const char* tag) {
+    // Tracking can't be disabled in the meantime, because that requires the lock
+    if (new_ptr != nullptr) {
+        if (old_address != 0U) {
+            record_free(old_address);
+        }
+        record_alloc(new_ptr, size, tag);
+    } else if (size == 0U && old_address != 0U) {
+        // realloc(ptr, 0) may free the memory and return NULL
+        record_free(old_address);
+    }
+    mutex_unlock(&tracker.mutex);
+}
+
+void memory_tracking_set_enabled(bool enabled) {
+    mutex_lock(&tracker.mutex);
+    if (!enabled) {
+        tracker.allocations.clear();
+        tracker.tags.clear();
+    }
+    tracking_enabled.store(enabled);
+    mutex_unlock(&tracker.mutex);
+}
+
+void memory_tracking_save(void) {
+    mutex_lock(&tracker.mutex);
+    // Moving the maps keeps their nodes, so the TagStats pointers of the allocations stay valid
+    tracker.saved_tags = std::move(tracker.tags);
+    tracker.saved_allocations = std::move(tracker.allocations);
+    tracker.tags.clear();
+    tracker.allocations.clear();
+    mutex_unlock(&tracker.mutex);
+}
+
+void memory_tracking_restore(void) {
+    mutex_lock(&tracker.mutex);
+    tracker.tags = std::move(tracker.saved_tags);
+    tracker.allocations = std::move(tracker.saved_allocations);
+    tracker.saved_tags.clear();
+    tracker.saved_allocations.clear();
+    mutex_unlock(&tracker.mutex);
+}
+
+bool memory_tracking_is_enabled(void) {
+    return tracking_enabled.load();
+}
+
+const char* memory_tracking_set_thread_tag(const char* tag) {
+    const char* previous_tag = thread_tag;
+    thread_tag = tag;
+    return previous_tag;
+}
+
+size_t memory_tracking_get_stats(struct MemoryTagStats* stats, size_t max_count) {
+    mutex_lock(&tracker.mutex);
+    size_t index = 0;
+    for (const auto& [tag, tag_stats] : tracker.tags) {
+        if (stats != nullptr && index < max_count) {
+            to_public_stats(tag_stats, &stats[index]);
+        }
+        index++;
+    }
+    mutex_unlock(&tracker.mutex);
+    return index;
+}
+
+error_t memory_tracking_get_stats_by_tag(const char* tag, struct MemoryTagStats* stats) {
+    if (!tracking_enabled.load()) {
+        return ERROR_INVALID_STATE;
+    }
+    mutex_lock(&tracker.mutex);
+    auto iterator = tracker.tags.find(std::string_view(tag));
+    bool found = (iterator != tracker.tags.end());
+    if (found) {
+        to_public_stats(iterator->second, stats);
+    }
+    mutex_unlock(&tracker.mutex);
+    return found ? ERROR_NONE : ERROR_NOT_FOUND;
+}
+
+size_t memory_tracking_log_leaks(void) {
+    mutex_lock(&tracker.mutex);
+    size_t count = 0;
+    for (const auto& [address, allocation] : tracker.allocations) {
+        if (std::string_view(allocation.stats->tag) != MEMORY_TAG_SMALL) {
+            LOG_W(TAG, "Leak: %zu bytes at %p (%s)", allocation.size, reinterpret_cast<void*>(address), allocation.stats->tag);
+            count++;
+        }
+    }
+    mutex_unlock(&tracker.mutex);
+    return count;
+}
+
+} // extern "C"
@@ -17,6 +17,13 @@ struct ModuleInternal {
 
 struct ModuleLedger {
     std::vector<Module*> modules;
+    /**
+     * The symbols of all started modules, sorted by name for a binary search.
+     * For equal names, the symbol that a linear search would find comes first.
+     * Rebuilt on the first lookup after a module was started, stopped, added or removed.
+     */
+    std::vector<const ModuleSymbol*> symbol_index;
+    bool symbol_index_valid = false;
     Mutex mutex {};
 
     ModuleLedger() { mutex_construct(&mutex); }
@@ -25,6 +32,30 @@ struct ModuleLedger {
 
 static ModuleLedger ledger;
 
+static void invalidate_symbol_index() {
+    mutex_lock(&ledger.mutex);
+    ledger.symbol_index_valid = false;
+    mutex_unlock(&ledger.mutex);
+}
+
+// Must be called with the ledger mutex locked
+static void build_symbol_index() {
+    ledger.symbol_index.clear();
+    for (auto* module : ledger.modules) {
+        if (!module_is_started(module) || module->symbols == nullptr)
+            continue;
+        for (auto* symbol = module->symbols; symbol->name != nullptr; symbol++) {
+            ledger.symbol_index.push_back(symbol);
+        }
+    }
+    // Stable, so duplicate names keep the module and list order of the linear search
+    std::stable_sort(ledger.symbol_index.begin(), ledger.symbol_index.end(), [](const ModuleSymbol* left, const ModuleSymbol* right) {
+        return strcmp(left->name, right->name) < 0;
+    });
+    ledger.symbol_index.shrink_to_fit();
+    ledger.symbol_index_valid = true;
+}
+
 extern "C" {
 
 error_t module_construct(Module* module) {
@@ -44,6 +75,7 @@ error_t module_destruct(Module* module) {
     }
     delete module->internal;
     module->internal = nullptr;
+    invalidate_symbol_index();
     return ERROR_NONE;
 }
 
@@ -58,6 +90,7 @@ error_t module_add(Module* module) {
     }
     if (!exists) {
         ledger.modules.push_back(module);
+        ledger.symbol_index_valid = false;
     }
     mutex_unlock(&ledger.mutex);
     return exists ? ERROR_INVALID_STATE : ERROR_NONE;
@@ -66,6 +99,7 @@ error_t module_add(Module* module) {
 error_t module_remove(Module* module) {
     mutex_lock(&ledger.mutex);
     ledger.modules.erase(std::remove(ledger.modules.begin(), ledger.modules.end(), module), ledger.modules.end());
+    ledger.symbol_index_valid = false;
     mutex_unlock(&ledger.mutex);
     return ERROR_NONE;
 }
@@ -95,6 +129,7 @@ error_t module_start(Module* module) {
     }
 
     internal->started = true;
+    invalidate_symbol_index();
     return ERROR_NONE;
 }
 
@@ -129,6 +164,7 @@ error_t module_stop(Module* module) {
     }
 
     internal->started = false;
+    invalidate_symbol_index();
     return ERROR_NONE;
 }
 
@@ -191,16 +227,18 @@ bool module_resolve_symbol(Module* module, const char* symbol_name, uintptr_t* s
 
 bool module_resolve_symbol_global(const char* symbol_name, uintptr_t* symbol_address) {
     mutex_lock(&ledger.mutex);
-    for (auto* module : ledger.modules) {
-        if (!module_is_started(module))
-            continue;
-        if (module_resolve_symbol(module, symbol_name, symbol_address)) {
-            mutex_unlock(&ledger.mutex);
-            return true;
-        }
+    if (!ledger.symbol_index_valid) {
+        build_symbol_index();
+    }
+    auto iterator = std::lower_bound(ledger.symbol_index.begin(), ledger.symbol_index.end(), symbol_name, [](const ModuleSymbol* symbol, const char* name) {
+        return strcmp(symbol->name, name) < 0;
+    });
+    bool found = iterator != ledger.symbol_index.end() && strcmp((*iterator)->name, symbol_name) == 0;
+    if (found) {
+        *symbol_address = reinterpret_cast<uintptr_t>((*iterator)->symbol);
     }
     mutex_unlock(&ledger.mutex);
-    return false;
+    return found;
 }
 
 }
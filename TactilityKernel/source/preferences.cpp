@@ -1,24 +1,43 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <tactility/preferences.h>
 
+#include <tactility/concurrent/event_group.h>
+#include <tactility/concurrent/mutex.h>
+#include <tactility/concurrent/thread.h>
+#include <tactility/filesystem/file_mutex.h>
 #include <tactility/log.h>
 #include <tactility/paths.h>
 #include <tactility/properties_file.h>
+#include <tactility/time.h>
 
 #include <cerrno>
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <new>
 #include <string>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 namespace {
 
 constexpr auto* TAG = "preferences";
 
+// Start of a PREFERENCES_FORMAT_BINARY file: "TPRF", a '\0' (which a properties file can't
+// start with) and the format version.
+constexpr char BINARY_MAGIC[] = { 'T', 'P', 'R', 'F', '\0', 1 };
+
+// Closed files without pending changes are dropped from the cache once more files than this are cached.
+constexpr size_t CACHED_STORES_MAX = 16;
+
+constexpr configSTACK_DEPTH_TYPE COMMIT_THREAD_STACK_SIZE = 4096;
+// Set when a store with a commit_delay_ms changed, so the commit thread recalculates its wait
+constexpr uint32_t COMMIT_WAKE_BIT = 1U << 0;
+
 // Escapes '\\' and '\n' so a string value can never break properties_file's one-entry-per-line
 // on-disk format, regardless of its content.
 std::string escape(const std::string& value) {
@@ -144,33 +163,530 @@ std::string parent_directory(const std::string& path) {
     return path.substr(0, slash);
 }
 
+enum class ValueType : uint8_t {
+    Bool = 1,
+    Int32 = 2,
+    Int64 = 3,
+    String = 4,
+    // A properties value that couldn't be parsed: kept verbatim so a commit doesn't lose it
+    Raw = 5
+};
+
+// A value as it's cached: parsed once when the file is loaded, instead of on every get.
+struct Value {
+    ValueType type;
+    int64_t number;
+    std::string text;
+
+    bool operator==(const Value& other) const = default;
+};
+
+Value parse_tagged(const std::string& tagged_value) {
+    std::string tag, raw_value;
+    if (split_tag(tagged_value, tag, raw_value)) {
+        bool bool_value;
+        int32_t int32_value;
+        int64_t int64_value;
+        if (tag == "b" && parse_bool(raw_value, bool_value)) {
+            return { ValueType::Bool, bool_value ? 1 : 0, {} };
+        }
+        if (tag == "i32" && parse_int32(raw_value, int32_value)) {
+            return { ValueType::Int32, int32_value, {} };
+        }
+        if (tag == "i64" && parse_int64(raw_value, int64_value)) {
+            return { ValueType::Int64, int64_value, {} };
+        }
+        if (tag == "s") {
+            return { ValueType::String, 0, unescape(raw_value) };
+        }
+    }
+    return { ValueType::Raw, 0, tagged_value };
+}
+
+std::string to_tagged(const Value& value) {
+    char buffer[40];
+    switch (value.type) {
+        case ValueType::Bool:
+            return value.number != 0 ? "b:1" : "b:0";
+        case ValueType::Int32:
+            std::snprintf(buffer, sizeof(buffer), "i32:%" PRId32, static_cast<int32_t>(value.number));
+            return buffer;
+        case ValueType::Int64:
+            std::snprintf(buffer, sizeof(buffer), "i64:%" PRId64, value.number);
+            return buffer;
+        case ValueType::String:
+            return "s:" + escape(value.text);
+        case ValueType::Raw:
+            break;
+    }
+    return value.text;
+}
+
+void append_uint(std::string& out, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        out += static_cast<char>((value >> (i * 8)) & 0xFFU);
+    }
+}
+
+bool read_uint(const std::string& in, size_t& offset, size_t size, uint64_t& out_value) {
+    if (in.size() - offset < size) {
+        return false;
+    }
+    out_value = 0;
+    for (size_t i = 0; i < size; i++) {
+        out_value |= static_cast<uint64_t>(static_cast<uint8_t>(in[offset + i])) << (i * 8);
+    }
+    offset += size;
+    return true;
+}
+
+bool read_string(const std::string& in, size_t& offset, size_t length, std::string& out_value) {
+    if (in.size() - offset < length) {
+        return false;
+    }
+    out_value = in.substr(offset, length);
+    offset += length;
+    return true;
+}
+
+// Binary format: the magic, then per entry: type (1 byte), key length (2 bytes), key, value.
+// Values: bool is 1 byte, int32 4, int64 8, strings have a 4 byte length and then the bytes.
+// Numbers are little endian.
+bool decode_binary(const std::string& content, std::unordered_map<std::string, Value>& out_values) {
+    size_t offset = sizeof(BINARY_MAGIC);
+    while (offset < content.size()) {
+        uint64_t type, key_length, number;
+        std::string key;
+        Value value {};
+        if (!read_uint(content, offset, 1, type) || !read_uint(content, offset, 2, key_length) ||
+            !read_string(content, offset, key_length, key)) {
+            return false;
+        }
+        value.type = static_cast<ValueType>(type);
+        switch (value.type) {
+            case ValueType::Bool:
+            case ValueType::Int32:
+            case ValueType::Int64: {
+                size_t size = (value.type == ValueType::Bool) ? 1 : (value.type == ValueType::Int32) ? 4 : 8;
+                if (!read_uint(content, offset, size, number)) {
+                    return false;
+                }
+                // Sign-extend the 4 byte int32
+                value.number = (size == 4) ? static_cast<int32_t>(number) : static_cast<int64_t>(number);
+                break;
+            }
+            case ValueType::String:
+            case ValueType::Raw: {
+                uint64_t length;
+                if (!read_uint(content, offset, 4, length) || !read_string(content, offset, length, value.text)) {
+                    return false;
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+        out_values[key] = std::move(value);
+    }
+    return true;
+}
+
+std::string encode_binary(const std::unordered_map<std::string, Value>& values) {
+    std::string content(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    for (const auto& [key, value] : values) {
+        if (key.size() > UINT16_MAX) {
+            LOG_E(TAG, "Key too long, not stored: %.32s...", key.c_str());
+            continue;
+        }
+        append_uint(content, static_cast<uint64_t>(value.type), 1);
+        append_uint(content, key.size(), 2);
+        content += key;
+        switch (value.type) {
+            case ValueType::Bool:
+                append_uint(content, value.number, 1);
+                break;
+            case ValueType::Int32:
+                append_uint(content, static_cast<uint64_t>(value.number), 4);
+                break;
+            case ValueType::Int64:
+                append_uint(content, static_cast<uint64_t>(value.number), 8);
+                break;
+            case ValueType::String:
+            case ValueType::Raw:
+                append_uint(content, value.text.size(), 4);
+                content += value.text;
+                break;
+        }
+    }
+    return content;
+}
+
+// Matches properties_file's own output, so either can read what the other wrote.
+std::string encode_properties(const std::unordered_map<std::string, Value>& values) {
+    std::string content;
+    for (const auto& [key, value] : values) {
+        content += key;
+        content += '=';
+        content += to_tagged(value);
+        content += '\n';
+    }
+    return content;
+}
+
+// Identifies the version of a file that was loaded or written, to detect changes made through
+// something other than this API. FAT only has a 2 second mtime resolution, so the size is compared too.
+struct FileSignature {
+    bool exists;
+    int64_t mtime;
+    int64_t size;
+
+    bool operator==(const FileSignature& other) const = default;
+};
+
+FileSignature get_file_signature(const std::string& path) {
+    struct stat info {};
+    if (stat(path.c_str(), &info) != 0) {
+        return { false, 0, 0 };
+    }
+    return { true, static_cast<int64_t>(info.st_mtime), static_cast<int64_t>(info.st_size) };
+}
+
+// Writes a temporary file in the same directory and renames it over the real path. rename() can't
+// replace an existing file on FAT, so the previous file is first renamed to a backup, which
+// recover_backup() restores when a reset happens before the new file is in place. The data is
+// synced to the medium before the renames, so the new file is never empty after a power loss.
+bool write_file_atomically(const std::string& path, const std::string& content) {
+    FileMutex mutex {};
+    file_mutex_get(&mutex, path.c_str());
+    file_mutex_lock(&mutex);
+
+    std::string temp_path = path + ".tmp";
+    FILE* handle = std::fopen(temp_path.c_str(), "wb");
+    if (handle == nullptr) {
+        LOG_E(TAG, "Failed to open %s", temp_path.c_str());
+        file_mutex_unlock(&mutex);
+        return false;
+    }
+
+    bool write_ok = std::fwrite(content.data(), 1, content.size(), handle) == content.size();
+    bool flush_ok = std::fflush(handle) == 0 && fsync(fileno(handle)) == 0;
+    bool close_ok = std::fclose(handle) == 0;
+    if (!write_ok || !flush_ok || !close_ok) {
+        LOG_E(TAG, "Failed to write %s", temp_path.c_str());
+        std::remove(temp_path.c_str());
+        file_mutex_unlock(&mutex);
+        return false;
+    }
+
+    std::string backup_path = path + ".bak";
+    // A leftover from a reset after the last rename below
+    std::remove(backup_path.c_str());
+    bool has_backup = std::rename(path.c_str(), backup_path.c_str()) == 0;
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        LOG_E(TAG, "Failed to replace %s", path.c_str());
+        if (has_backup) {
+            std::rename(backup_path.c_str(), path.c_str());
+        }
+        std::remove(temp_path.c_str());
+        file_mutex_unlock(&mutex);
+        return false;
+    }
+    if (has_backup) {
+        std::remove(backup_path.c_str());
+    }
+
+    file_mutex_unlock(&mutex);
+    return true;
+}
+
+// Restores the previous file when write_file_atomically() was interrupted between its renames
+void recover_backup(const std::string& path) {
+    FileMutex mutex {};
+    file_mutex_get(&mutex, path.c_str());
+    file_mutex_lock(&mutex);
+    std::string backup_path = path + ".bak";
+    struct stat info {};
+    if (stat(path.c_str(), &info) != 0 && stat(backup_path.c_str(), &info) == 0) {
+        LOG_W(TAG, "Restoring %s from an interrupted commit", path.c_str());
+        if (std::rename(backup_path.c_str(), path.c_str()) != 0) {
+            LOG_E(TAG, "Failed to restore %s", path.c_str());
+        }
+    }
+    file_mutex_unlock(&mutex);
+}
+
+// The cached content of one preferences file, shared by all handles that were opened for its path.
+struct PreferencesStore {
+    std::string path;
+    std::unordered_map<std::string, Value> values;
+    // Set by the open that created the store, or by the first open after it was committed and closed
+    PreferencesOptions options;
+    // The file as it was when it was last loaded or committed
+    FileSignature signature;
+    // Open handles: the store is never removed from the cache while this isn't 0
+    uint32_t open_count;
+    // Changes that haven't been committed yet
+    bool dirty;
+    // Incremented on every change, so a commit knows whether the values changed while it was writing
+    uint32_t change_count;
+    TickType_t last_change_ticks;
+};
+
+struct PreferencesLedger {
+    std::unordered_map<std::string, std::unique_ptr<PreferencesStore>> stores;
+    PreferencesStats stats {};
+    // Commits stores with a commit_delay_ms, created on first use
+    Thread* commit_thread = nullptr;
+    EventGroupHandle_t commit_events = nullptr;
+    Mutex mutex {};
+    // Held for the duration of a commit, so commits of the same file are written in order.
+    // Taken before the ledger mutex, never while holding it.
+    Mutex commit_mutex {};
+
+    PreferencesLedger() {
+        mutex_construct(&mutex);
+        mutex_construct(&commit_mutex);
+    }
+
+    ~PreferencesLedger() {
+        mutex_destruct(&commit_mutex);
+        mutex_destruct(&mutex);
+    }
+
+    void lock() { mutex_lock(&mutex); }
+    void unlock() { mutex_unlock(&mutex); }
+};
+
+PreferencesLedger ledger;
+
+struct LedgerLock {
+    LedgerLock() { ledger.lock(); }
+    ~LedgerLock() { ledger.unlock(); }
+};
+
+// Reads the file without touching the ledger, so it can be called without holding the ledger lock.
+// @param[out] out_values the values, empty when the file doesn't exist
+// @param[out] out_signature the file that was read
+// @return false if the file exists but couldn't be read
+bool load_values(const std::string& path, std::unordered_map<std::string, Value>& out_values, FileSignature& out_signature) {
+    out_values.clear();
+    recover_backup(path);
+
+    FileMutex mutex {};
+    file_mutex_get(&mutex, path.c_str());
+    file_mutex_lock(&mutex);
+    out_signature = get_file_signature(path);
+    if (!out_signature.exists) {
+        file_mutex_unlock(&mutex);
+        return true;
+    }
+    FILE* handle = std::fopen(path.c_str(), "rb");
+    if (handle == nullptr) {
+        file_mutex_unlock(&mutex);
+        LOG_E(TAG, "Failed to open %s", path.c_str());
+        return false;
+    }
+    char magic[sizeof(BINARY_MAGIC)];
+    bool is_binary = std::fread(magic, 1, sizeof(magic), handle) == sizeof(magic) &&
+        std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+    std::string content(magic, is_binary ? sizeof(magic) : 0);
+    bool read_ok = true;
+    if (is_binary) {
+        char buffer[256];
+        size_t length;
+        while ((length = std::fread(buffer, 1, sizeof(buffer), handle)) > 0) {
+            content.append(buffer, length);
+        }
+        read_ok = std::ferror(handle) == 0;
+    }
+    std::fclose(handle);
+    file_mutex_unlock(&mutex);
+
+    if (!read_ok) {
+        LOG_E(TAG, "Failed to read %s", path.c_str());
+        return false;
+    }
+
+    if (is_binary) {
+        if (!decode_binary(content, out_values)) {
+            // Likely written by a newer version: start over rather than failing every open
+            LOG_E(TAG, "Ignoring corrupt or unsupported file %s", path.c_str());
+            out_values.clear();
+        }
+        return true;
+    }
+
+    PropertiesFile* file = properties_file_open(path.c_str());
+    if (file == nullptr) {
+        return false;
+    }
+    properties_file_for_each(file, [](const char* key, const char* value, void* context) {
+        (*static_cast<std::unordered_map<std::string, Value>*>(context))[key] = parse_tagged(value);
+    }, &out_values);
+    properties_file_discard(file);
+    return true;
+}
+
+// Drops closed stores without pending changes while more than CACHED_STORES_MAX are cached.
+// Call while holding the ledger lock.
+void evict_stores() {
+    for (auto entry = ledger.stores.begin(); entry != ledger.stores.end() && ledger.stores.size() > CACHED_STORES_MAX;) {
+        if (entry->second->open_count == 0 && !entry->second->dirty) {
+            entry = ledger.stores.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+}
+
+// Writes the pending changes of the store for @a path, if it has any. The content is encoded while
+// holding the ledger lock, but written without it, so other handles aren't blocked by the file I/O.
+// @return false if writing failed - the changes remain pending
+bool commit_store(const std::string& path) {
+    mutex_lock(&ledger.commit_mutex);
+    ledger.lock();
+    auto entry = ledger.stores.find(path);
+    if (entry == ledger.stores.end() || !entry->second->dirty) {
+        ledger.unlock();
+        mutex_unlock(&ledger.commit_mutex);
+        return true;
+    }
+    const PreferencesStore& store = *entry->second;
+    std::string content = (store.options.format == PREFERENCES_FORMAT_BINARY)
+        ? encode_binary(store.values)
+        : encode_properties(store.values);
+    uint32_t change_count = store.change_count;
+    ledger.unlock();
+
+    bool written = write_file_atomically(path, content);
+    if (written) {
+        FileSignature signature = get_file_signature(path);
+        LedgerLock lock;
+        ledger.stats.file_writes++;
+        entry = ledger.stores.find(path);
+        if (entry != ledger.stores.end()) {
+            entry->second->signature = signature;
+            // Changes made during the write are committed by the next commit
+            if (entry->second->change_count == change_count) {
+                entry->second->dirty = false;
+                evict_stores();
+            }
+        }
+    }
+    mutex_unlock(&ledger.commit_mutex);
+    return written;
+}
+
+// Commits the stores whose last change is at least commit_delay_ms ago.
+// @return the ticks until the next store is due, or MAX_TICKS when nothing is pending
+TickType_t commit_due_stores() {
+    TickType_t next_ticks = MAX_TICKS;
+    std::vector<std::string> due_paths;
+    ledger.lock();
+    TickType_t now = get_ticks();
+    for (const auto& [path, store] : ledger.stores) {
+        if (!store->dirty || store->options.commit_delay_ms == 0) {
+            continue;
+        }
+        TickType_t delay_ticks = millis_to_ticks(store->options.commit_delay_ms);
+        TickType_t elapsed_ticks = now - store->last_change_ticks;
+        if (elapsed_ticks < delay_ticks) {
+            next_ticks = std::min(next_ticks, delay_ticks - elapsed_ticks);
+        } else {
+            due_paths.push_back(path);
+        }
+    }
+    ledger.unlock();
+
+    for (const auto& path : due_paths) {
+        if (commit_store(path)) {
+            continue;
+        }
+        // Try again later, e.g. when the SD card was removed temporarily
+        LedgerLock lock;
+        auto entry = ledger.stores.find(path);
+        if (entry != ledger.stores.end() && entry->second->dirty) {
+            entry->second->last_change_ticks = get_ticks();
+            next_ticks = std::min(next_ticks, millis_to_ticks(entry->second->options.commit_delay_ms));
+        }
+    }
+    return next_ticks;
+}
+
+int32_t commit_main(void* /*context*/) {
+    while (true) {
+        TickType_t wait_ticks = commit_due_stores();
+        event_group_wait(ledger.commit_events, COMMIT_WAKE_BIT, false, true, nullptr, wait_ticks);
+    }
+}
+
+// Wakes up (or starts) the thread that commits stores with a commit_delay_ms.
+// Call while holding the ledger lock.
+void schedule_commit() {
+    if (ledger.commit_thread == nullptr) {
+        event_group_construct(&ledger.commit_events);
+        ledger.commit_thread = thread_alloc_full("preferences", COMMIT_THREAD_STACK_SIZE, commit_main, nullptr, -1);
+        if (ledger.commit_thread == nullptr || thread_start(ledger.commit_thread) != ERROR_NONE) {
+            LOG_E(TAG, "Failed to start commit thread");
+            if (ledger.commit_thread != nullptr) {
+                thread_free(ledger.commit_thread);
+                ledger.commit_thread = nullptr;
+            }
+            event_group_destruct(&ledger.commit_events);
+            return;
+        }
+    }
+    event_group_set(ledger.commit_events, COMMIT_WAKE_BIT);
+}
+
+const Value* find_value(const PreferencesStore* store, const char* key, ValueType type) {
+    auto entry = store->values.find(key);
+    if (entry == store->values.end() || entry->second.type != type) {
+        return nullptr;
+    }
+    return &entry->second;
+}
+
 } // namespace
 
 // Definition of the opaque handle declared in tactility/preferences.h - C callers only ever
-// see it through a Preferences* pointer, never its members. Backed by a PropertiesFile
-// (tactility/properties_file.h) rather than its own file I/O - each value is stored as a
-// tagged string ("b:1", "i32:42", "i64:123", "s:escaped text") since PropertiesFile only knows
-// about plain strings.
+// see it through a Preferences* pointer, never its members. Each value is stored on disk as a
+// tagged string ("b:1", "i32:42", "i64:123", "s:escaped text") in the properties format, or
+// with a type byte in the binary format.
 struct Preferences {
-    PropertiesFile* file;
+    PreferencesStore* store;
 };
 
 namespace {
 
-// Grow-and-retry: properties_file_get() needs a bounded buffer, and a string preference's
-// value (unlike bool/int32/int64's short encodings) can be arbitrarily long.
-bool try_get_tagged(const PropertiesFile* file, const char* key, std::string& tag, std::string& raw_value) {
-    std::vector<char> buffer(32);
-    while (true) {
-        error_t error = properties_file_get(file, key, buffer.data(), buffer.size());
-        if (error == ERROR_NONE) {
-            return split_tag(std::string(buffer.data()), tag, raw_value);
-        }
-        if (error == ERROR_NOT_FOUND) {
-            return false;
-        }
-        buffer.resize(buffer.size() * 2);
+void put_value(Preferences* preferences, const char* key, Value value) {
+    PreferencesStore* store = preferences->store;
+    ledger.lock();
+    auto entry = store->values.find(key);
+    // Setting the current value again doesn't need a commit
+    if (entry != store->values.end() && entry->second == value) {
+        ledger.unlock();
+        return;
+    }
+    store->values[key] = std::move(value);
+    store->dirty = true;
+    store->change_count++;
+    store->last_change_ticks = get_ticks();
+    if (store->options.commit_delay_ms > 0) {
+        schedule_commit();
     }
+    ledger.unlock();
+}
+
+bool is_same_options(const PreferencesOptions& left, const PreferencesOptions& right) {
+    return left.format == right.format && left.commit_delay_ms == right.commit_delay_ms;
+}
+
+// Call while holding the ledger lock
+void attach(Preferences* preferences, PreferencesStore& store, const PreferencesOptions& options) {
+    store.options = options;
+    store.open_count++;
+    preferences->store = &store;
 }
 
 } // namespace
@@ -178,111 +694,213 @@ bool try_get_tagged(const PropertiesFile* file, const char* key, std::string& ta
 extern "C" {
 
 Preferences* preferences_open(const char* path) {
+    PreferencesOptions options = {
+        .format = PREFERENCES_FORMAT_PROPERTIES,
+        .commit_delay_ms = 0
+    };
+    return preferences_open_with_options(path, &options);
+}
+
+Preferences* preferences_open_with_options(const char* path, const PreferencesOptions* options) {
     std::string directory = parent_directory(path);
     if (!directory.empty() && !ensure_directory_recursive(directory)) {
         LOG_E(TAG, "Directory not found: %s", directory.c_str());
         return nullptr;
     }
 
-    PropertiesFile* file = properties_file_open(path);
-    if (file == nullptr) {
-        LOG_E(TAG, "Failed to open %s", path);
+    auto* preferences = new (std::nothrow) Preferences { nullptr };
+    if (preferences == nullptr) {
+        LOG_E(TAG, "Out of memory");
         return nullptr;
     }
 
-    auto* preferences = new (std::nothrow) Preferences { file };
-    if (preferences == nullptr) {
-        LOG_E(TAG, "Out of memory");
-        properties_file_close(file);
+    // The file is read and checked for changes without holding the ledger lock, so other handles
+    // aren't blocked by the file I/O. The store is then updated, unless it changed in the meantime.
+    FileSignature file_signature = get_file_signature(path);
+    bool needs_load;
+    FileSignature seen_signature {};
+    {
+        LedgerLock lock;
+        auto entry = ledger.stores.find(path);
+        if (entry == ledger.stores.end()) {
+            needs_load = true;
+        } else {
+            PreferencesStore& store = *entry->second;
+            if ((store.open_count > 0 || store.dirty) && !is_same_options(store.options, *options)) {
+                // The other handles rely on their options, and the pending changes were made with them
+                LOG_E(TAG, "%s is already open with different options", path);
+                delete preferences;
+                return nullptr;
+            }
+            // Pending changes are newer than the file anyway
+            needs_load = !store.dirty && file_signature != store.signature;
+            seen_signature = store.signature;
+        }
+        if (!needs_load) {
+            attach(preferences, *entry->second, *options);
+            return preferences;
+        }
+    }
+
+    std::unordered_map<std::string, Value> values;
+    FileSignature loaded_signature {};
+    if (!load_values(path, values, loaded_signature)) {
+        delete preferences;
+        return nullptr;
+    }
+
+    LedgerLock lock;
+    if (loaded_signature.exists) {
+        ledger.stats.file_reads++;
+    }
+    auto& store = ledger.stores[path];
+    if (store == nullptr) {
+        store = std::make_unique<PreferencesStore>();
+        store->path = path;
+        store->values = std::move(values);
+        store->signature = loaded_signature;
+    } else if ((store->open_count > 0 || store->dirty) && !is_same_options(store->options, *options)) {
+        // Opened by someone else while the file was read
+        LOG_E(TAG, "%s is already open with different options", path);
+        delete preferences;
         return nullptr;
+    } else if (!store->dirty && store->signature == seen_signature) {
+        // Otherwise the store was loaded or committed by someone else while the file was read,
+        // which is at least as recent as what was read here
+        store->values = std::move(values);
+        store->signature = loaded_signature;
     }
+    attach(preferences, *store, *options);
     return preferences;
 }
 
 void preferences_close(Preferences* preferences) {
-    properties_file_close(preferences->file);
+    PreferencesStore* store = preferences->store;
     delete preferences;
+
+    ledger.lock();
+    store->open_count--;
+    // Stores with a commit_delay_ms were already scheduled by preferences_put_*()
+    bool commit = store->dirty && store->options.commit_delay_ms == 0;
+    std::string path = store->path;
+    evict_stores();
+    ledger.unlock();
+
+    if (commit) {
+        commit_store(path);
+    }
+}
+
+error_t preferences_flush(Preferences* preferences) {
+    // The path never changes, and the store stays cached while it has open handles
+    if (!commit_store(preferences->store->path)) {
+        return ERROR_RESOURCE;
+    }
+    return ERROR_NONE;
+}
+
+error_t preferences_flush_all(void) {
+    std::vector<std::string> dirty_paths;
+    ledger.lock();
+    for (const auto& [path, store] : ledger.stores) {
+        if (store->dirty) {
+            dirty_paths.push_back(path);
+        }
+    }
+    ledger.unlock();
+
+    error_t result = ERROR_NONE;
+    for (const auto& path : dirty_paths) {
+        if (!commit_store(path)) {
+            result = ERROR_RESOURCE;
+        }
+    }
+    return result;
+}
+
+void preferences_get_stats(PreferencesStats* out_stats) {
+    LedgerLock lock;
+    *out_stats = ledger.stats;
+    out_stats->cached_files = static_cast<uint32_t>(ledger.stores.size());
 }
 
 bool preferences_has_bool(const Preferences* preferences, const char* key) {
-    std::string tag, raw_value;
-    bool value;
-    return try_get_tagged(preferences->file, key, tag, raw_value) && tag == "b" && parse_bool(raw_value, value);
+    LedgerLock lock;
+    return find_value(preferences->store, key, ValueType::Bool) != nullptr;
 }
 
 bool preferences_has_int32(const Preferences* preferences, const char* key) {
-    std::string tag, raw_value;
-    int32_t value;
-    return try_get_tagged(preferences->file, key, tag, raw_value) && tag == "i32" && parse_int32(raw_value, value);
+    LedgerLock lock;
+    return find_value(preferences->store, key, ValueType::Int32) != nullptr;
 }
 
 bool preferences_has_int64(const Preferences* preferences, const char* key) {
-    std::string tag, raw_value;
-    int64_t value;
-    return try_get_tagged(preferences->file, key, tag, raw_value) && tag == "i64" && parse_int64(raw_value, value);
+    LedgerLock lock;
+    return find_value(preferences->store, key, ValueType::Int64) != nullptr;
 }
 
 bool preferences_has_string(const Preferences* preferences, const char* key) {
-    std::string tag, raw_value;
-    return try_get_tagged(preferences->file, key, tag, raw_value) && tag == "s";
+    LedgerLock lock;
+    return find_value(preferences->store, key, ValueType::String) != nullptr;
 }
 
 bool preferences_opt_bool(const Preferences* preferences, const char* key, bool* out_value) {
-    std::string tag, raw_value;
-    if (!try_get_tagged(preferences->file, key, tag, raw_value) || tag != "b") {
+    LedgerLock lock;
+    const Value* value = find_value(preferences->store, key, ValueType::Bool);
+    if (value == nullptr) {
         return false;
     }
-    return parse_bool(raw_value, *out_value);
+    *out_value = value->number != 0;
+    return true;
 }
 
 bool preferences_opt_int32(const Preferences* preferences, const char* key, int32_t* out_value) {
-    std::string tag, raw_value;
-    if (!try_get_tagged(preferences->file, key, tag, raw_value) || tag != "i32") {
+    LedgerLock lock;
+    const Value* value = find_value(preferences->store, key, ValueType::Int32);
+    if (value == nullptr) {
         return false;
     }
-    return parse_int32(raw_value, *out_value);
+    *out_value = static_cast<int32_t>(value->number);
+    return true;
 }
 
 bool preferences_opt_int64(const Preferences* preferences, const char* key, int64_t* out_value) {
-    std::string tag, raw_value;
-    if (!try_get_tagged(preferences->file, key, tag, raw_value) || tag != "i64") {
+    LedgerLock lock;
+    const Value* value = find_value(preferences->store, key, ValueType::Int64);
+    if (value == nullptr) {
         return false;
     }
-    return parse_int64(raw_value, *out_value);
+    *out_value = value->number;
+    return true;
 }
 
 error_t preferences_opt_string(const Preferences* preferences, const char* key, char* out_value, size_t out_value_size) {
-    std::string tag, raw_value;
-    if (!try_get_tagged(preferences->file, key, tag, raw_value) || tag != "s") {
+    LedgerLock lock;
+    const Value* value = find_value(preferences->store, key, ValueType::String);
+    if (value == nullptr) {
         return ERROR_NOT_FOUND;
     }
-    std::string value = unescape(raw_value);
-    if (value.size() + 1 > out_value_size) {
+    if (value->text.size() + 1 > out_value_size) {
         return ERROR_BUFFER_OVERFLOW;
     }
-    std::memcpy(out_value, value.c_str(), value.size() + 1);
+    std::memcpy(out_value, value->text.c_str(), value->text.size() + 1);
     return ERROR_NONE;
 }
 
 void preferences_put_bool(Preferences* preferences, const char* key, bool value) {
-    properties_file_set(preferences->file, key, value ? "b:1" : "b:0");
+    put_value(preferences, key, { ValueType::Bool, value ? 1 : 0, {} });
 }
 
 void preferences_put_int32(Preferences* preferences, const char* key, int32_t value) {
-    char buffer[32];
-    std::snprintf(buffer, sizeof(buffer), "i32:%" PRId32, value);
-    properties_file_set(preferences->file, key, buffer);
+    put_value(preferences, key, { ValueType::Int32, value, {} });
 }
 
 void preferences_put_int64(Preferences* preferences, const char* key, int64_t value) {
-    char buffer[40];
-    std::snprintf(buffer, sizeof(buffer), "i64:%" PRId64, value);
-    properties_file_set(preferences->file, key, buffer);
+    put_value(preferences, key, { ValueType::Int64, value, {} });
 }
 
 void preferences_put_string(Preferences* preferences, const char* key, const char* value) {
-    std::string tagged = "s:" + escape(value);
-    properties_file_set(preferences->file, key, tagged.c_str());
+    put_value(preferences, key, { ValueType::String, 0, value });
 }
 
 } // extern "C"
@@ -15,10 +15,12 @@
 #include <tactility/drivers/bluetooth_serial.h>
 #include <tactility/drivers/camera.h>
 #include <tactility/drivers/display.h>
+#include <tactility/drivers/display_pixels.h>
 #include <tactility/drivers/gpio_controller.h>
 #include <tactility/drivers/grove.h>
 #include <tactility/drivers/haptic.h>
 #include <tactility/drivers/i2c_controller.h>
+#include <tactility/drivers/i2c_register_cache.h>
 #include <tactility/drivers/i2s_controller.h>
 #include <tactility/drivers/i8080_controller.h>
 #include <tactility/drivers/keyboard.h>
@@ -33,6 +35,7 @@
 #include <tactility/drivers/spi_controller.h>
 #include <tactility/drivers/trackball.h>
 #include <tactility/drivers/uart_controller.h>
+#include <tactility/drivers/uart_reader.h>
 #include <tactility/drivers/usb_device_controller.h>
 #include <tactility/drivers/usb_hid_device.h>
 #include <tactility/drivers/usb_host_hid.h>
@@ -152,6 +155,7 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     DEFINE_MODULE_SYMBOL(display_reset),
     DEFINE_MODULE_SYMBOL(display_init),
     DEFINE_MODULE_SYMBOL(display_draw_bitmap),
+    DEFINE_MODULE_SYMBOL(display_draw_bitmap_async),
     DEFINE_MODULE_SYMBOL(display_mirror),
     DEFINE_MODULE_SYMBOL(display_swap_xy),
     DEFINE_MODULE_SYMBOL(display_get_swap_xy),
@@ -168,6 +172,9 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     DEFINE_MODULE_SYMBOL(display_get_frame_buffer_count),
     DEFINE_MODULE_SYMBOL(display_get_backlight),
     DEFINE_MODULE_SYMBOL(DISPLAY_TYPE),
+    // drivers/display_pixels
+    DEFINE_MODULE_SYMBOL(display_pixels_swap_rgb565),
+    DEFINE_MODULE_SYMBOL(display_pixels_rotate),
     // file_mutex
     DEFINE_MODULE_SYMBOL(file_mutex_register),
     DEFINE_MODULE_SYMBOL(file_mutex_get),
@@ -186,7 +193,14 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     DEFINE_MODULE_SYMBOL(memory_alloc_with_policy),
     DEFINE_MODULE_SYMBOL(memory_realloc_with_policy),
     DEFINE_MODULE_SYMBOL(memory_calloc_with_policy),
+    DEFINE_MODULE_SYMBOL(memory_alloc_tagged),
+    DEFINE_MODULE_SYMBOL(memory_realloc_tagged),
+    DEFINE_MODULE_SYMBOL(memory_calloc_tagged),
     DEFINE_MODULE_SYMBOL(memory_free),
+    DEFINE_MODULE_SYMBOL(memory_tracking_is_enabled),
+    DEFINE_MODULE_SYMBOL(memory_tracking_set_thread_tag),
+    DEFINE_MODULE_SYMBOL(memory_tracking_get_stats),
+    DEFINE_MODULE_SYMBOL(memory_tracking_get_stats_by_tag),
     // drivers/gpio_controller
     DEFINE_MODULE_SYMBOL(gpio_descriptor_acquire),
     DEFINE_MODULE_SYMBOL(gpio_descriptor_release),
@@ -232,7 +246,21 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     DEFINE_MODULE_SYMBOL(i2c_controller_register16le_set),
     DEFINE_MODULE_SYMBOL(i2c_controller_register16be_get),
     DEFINE_MODULE_SYMBOL(i2c_controller_register16be_set),
+    DEFINE_MODULE_SYMBOL(i2c_batch_init),
+    DEFINE_MODULE_SYMBOL(i2c_batch_write_register),
+    DEFINE_MODULE_SYMBOL(i2c_batch_register8_set),
+    DEFINE_MODULE_SYMBOL(i2c_batch_read_register),
+    DEFINE_MODULE_SYMBOL(i2c_batch_submit),
     DEFINE_MODULE_SYMBOL(I2C_CONTROLLER_TYPE),
+    // drivers/i2c_register_cache
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_alloc),
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_free),
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_get),
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_set),
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_update_bits),
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_set_bits),
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_reset_bits),
+    DEFINE_MODULE_SYMBOL(i2c_register_cache_invalidate),
     // drivers/i2s_controller
     DEFINE_MODULE_SYMBOL(i2s_controller_read),
     DEFINE_MODULE_SYMBOL(i2s_controller_write),
@@ -321,6 +349,13 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     DEFINE_MODULE_SYMBOL(uart_controller_get_config),
     DEFINE_MODULE_SYMBOL(uart_controller_get_available),
     DEFINE_MODULE_SYMBOL(uart_controller_flush_input),
+    // drivers/uart_reader
+    DEFINE_MODULE_SYMBOL(uart_reader_alloc),
+    DEFINE_MODULE_SYMBOL(uart_reader_free),
+    DEFINE_MODULE_SYMBOL(uart_reader_read_line),
+    DEFINE_MODULE_SYMBOL(uart_reader_read),
+    DEFINE_MODULE_SYMBOL(uart_reader_get_buffered),
+    DEFINE_MODULE_SYMBOL(uart_reader_reset),
     DEFINE_MODULE_SYMBOL(UART_CONTROLLER_TYPE),
     // drivers/bluetooth
     DEFINE_MODULE_SYMBOL(bluetooth_find_first_ready_device),
@@ -462,8 +497,11 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     DEFINE_MODULE_SYMBOL(USB_MIDI_DEVICE_TYPE),
     // concurrent/dispatcher
     DEFINE_MODULE_SYMBOL(dispatcher_alloc),
+    DEFINE_MODULE_SYMBOL(dispatcher_alloc_with_config),
     DEFINE_MODULE_SYMBOL(dispatcher_free),
     DEFINE_MODULE_SYMBOL(dispatcher_dispatch_timed),
+    DEFINE_MODULE_SYMBOL(dispatcher_dispatch_priority_timed),
+    DEFINE_MODULE_SYMBOL(dispatcher_get_lane_stats),
     DEFINE_MODULE_SYMBOL(dispatcher_consume_timed),
     // concurrent/event_group
     DEFINE_MODULE_SYMBOL(event_group_set),
@@ -503,6 +541,10 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     // log
 #ifndef ESP_PLATFORM
     DEFINE_MODULE_SYMBOL(log_generic),
+    DEFINE_MODULE_SYMBOL(log_fast_generic),
+    DEFINE_MODULE_SYMBOL(log_set_level),
+    DEFINE_MODULE_SYMBOL(log_get_level),
+    DEFINE_MODULE_SYMBOL(log_flush),
 #endif
     // module
     DEFINE_MODULE_SYMBOL(module_construct),
@@ -537,7 +579,11 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     DEFINE_MODULE_SYMBOL(bundle_put_string),
     // preferences
     DEFINE_MODULE_SYMBOL(preferences_open),
+    DEFINE_MODULE_SYMBOL(preferences_open_with_options),
     DEFINE_MODULE_SYMBOL(preferences_close),
+    DEFINE_MODULE_SYMBOL(preferences_flush),
+    DEFINE_MODULE_SYMBOL(preferences_flush_all),
+    DEFINE_MODULE_SYMBOL(preferences_get_stats),
     DEFINE_MODULE_SYMBOL(preferences_has_bool),
     DEFINE_MODULE_SYMBOL(preferences_has_int32),
     DEFINE_MODULE_SYMBOL(preferences_has_int64),
@@ -553,6 +599,7 @@ const struct ModuleSymbol KERNEL_SYMBOLS[] = {
     // properties_file
     DEFINE_MODULE_SYMBOL(properties_file_open),
     DEFINE_MODULE_SYMBOL(properties_file_close),
+    DEFINE_MODULE_SYMBOL(properties_file_discard),
     DEFINE_MODULE_SYMBOL(properties_file_has),
     DEFINE_MODULE_SYMBOL(properties_file_get),
     DEFINE_MODULE_SYMBOL(properties_file_set),
@@ -1,22 +1,73 @@
 #include <tactility/system_event.h>
 
 #include <tactility/concurrent/mutex.h>
+#include <tactility/concurrent/timer.h>
 #include <tactility/delay.h>
 #include <tactility/error.h>
+#include <tactility/memory.h>
 #include <tactility/time.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
-#include <new>
-#include <vector>
+
+// Must be updated when a value is added to SystemEventType
+static constexpr size_t SYSTEM_EVENT_TYPE_COUNT = KERNEL_EVENT_TIME_CHANGED + 1;
+
+static bool is_valid_type(SystemEventType type) {
+    return static_cast<size_t>(type) < SYSTEM_EVENT_TYPE_COUNT;
+}
 
 struct KernelEventSubscription {
-    SystemEventType type;
     system_event_callback_t callback;
     void* callback_context;
 };
 
-static std::vector<KernelEventSubscription> subscriptions;
+// Immutable snapshot of the callbacks for one event type. Writers never modify a published
+// table: system_event_callback_add()/_remove() publish a fresh copy and retire the old one, so
+// system_event_emit() can iterate a table without holding any lock and without allocating.
+struct CallbackTable {
+    /** Links retired tables until they are reclaimed */
+    CallbackTable* retired_next;
+    size_t count;
+
+    KernelEventSubscription* entries() { return reinterpret_cast<KernelEventSubscription*>(this + 1); }
+};
+
+static_assert(sizeof(CallbackTable) % alignof(KernelEventSubscription) == 0);
+
+static size_t callback_table_size(size_t count) {
+    return sizeof(CallbackTable) + count * sizeof(KernelEventSubscription);
+}
+
+// Every add/remove replaces a table, so they come from the small block pools
+static CallbackTable* callback_table_alloc(size_t count) {
+    void* memory = memory_small_alloc(callback_table_size(count));
+    if (memory == nullptr) {
+        return nullptr;
+    }
+    auto* table = static_cast<CallbackTable*>(memory);
+    table->retired_next = nullptr;
+    table->count = count;
+    return table;
+}
+
+static void callback_table_free(CallbackTable* table) {
+    memory_small_free(table, callback_table_size(table->count));
+}
+
+static std::atomic<CallbackTable*> callback_tables[SYSTEM_EVENT_TYPE_COUNT];
+
+// Epoch-based reclamation of retired tables. Each emit registers itself in the reader counter
+// of the current epoch's parity for as long as it uses a table. The epoch only advances once
+// the readers of the previous epoch have all left, so at most two epochs have active readers.
+// A table retired during epoch E can only be held by readers of epoch E or older, so it's safe
+// to free once the epoch has advanced twice past E - i.e. when the retired list of E's parity
+// comes up for reuse.
+static std::atomic<uint32_t> epoch = 0;
+static std::atomic<uint32_t> epoch_readers[2];
+// Guarded by subscriptions_mutex
+static CallbackTable* retired_tables[2] = { nullptr, nullptr };
 
 // Mutex is constructed/destructed via a static-lifetime wrapper because struct Mutex
 // itself has no constructor: mutex_lock() on an unconstructed handle is undefined
@@ -27,15 +78,71 @@ struct KernelEventMutex {
     ~KernelEventMutex() { mutex_destruct(&handle); }
 };
 
+// Serializes writers (callback add/remove). Never taken by system_event_emit().
 static KernelEventMutex subscriptions_mutex;
 
-// Intrusive singly-linked list of poll subscriptions (system_event_subscribe()/_unsubscribe()/
-// _await()), separate from the callback-based `subscriptions` vector above. Guarded by its own
+// Per-type intrusive singly-linked lists of poll subscriptions (system_event_subscribe()/
+// _unsubscribe()/_await()), separate from the callback tables above. Guarded by its own
 // mutex since notifying a poll subscriber never invokes caller code (just a memcpy and an
 // xTaskNotifyGive), so there is no reentrancy concern requiring a snapshot-then-unlock dance.
-static SystemEventSubscription* poll_subscriptions = nullptr;
+static SystemEventSubscription* poll_subscriptions[SYSTEM_EVENT_TYPE_COUNT] = {};
 static KernelEventMutex poll_subscriptions_mutex;
 
+/** @return the epoch the caller registered in; pass it to epoch_leave() */
+static uint32_t epoch_enter() {
+    while (true) {
+        uint32_t current = epoch.load();
+        epoch_readers[current & 1U].fetch_add(1);
+        // If the epoch advanced in between, the writer may not have seen this registration
+        if (epoch.load() == current) {
+            return current;
+        }
+        epoch_readers[current & 1U].fetch_sub(1);
+    }
+}
+
+static void epoch_leave(uint32_t reader_epoch) {
+    epoch_readers[reader_epoch & 1U].fetch_sub(1);
+}
+
+/**
+ * Free the retired tables that no reader can still hold.
+ * @warning must hold subscriptions_mutex
+ */
+static void reclaim_retired_tables() {
+    // Two advances are needed before the tables retired in the current epoch are free-able.
+    // Stop early when readers of the previous epoch are still active: the next write retries.
+    for (int i = 0; i < 2; i++) {
+        uint32_t current = epoch.load();
+        if (epoch_readers[(current - 1U) & 1U].load() != 0) {
+            return;
+        }
+        epoch.store(current + 1U);
+        // The parity of the new epoch equals that of the previous one, which has no readers left
+        CallbackTable* table = retired_tables[(current + 1U) & 1U];
+        retired_tables[(current + 1U) & 1U] = nullptr;
+        while (table != nullptr) {
+            CallbackTable* next = table->retired_next;
+            callback_table_free(table);
+            table = next;
+        }
+    }
+}
+
+/**
+ * Publish a new table for a type and retire the old one.
+ * @warning must hold subscriptions_mutex
+ */
+static void publish_table(SystemEventType type, CallbackTable* table) {
+    CallbackTable* old_table = callback_tables[type].exchange(table);
+    if (old_table != nullptr) {
+        uint32_t current = epoch.load();
+        old_table->retired_next = retired_tables[current & 1U];
+        retired_tables[current & 1U] = old_table;
+    }
+    reclaim_retired_tables();
+}
+
 extern "C" {
 
 error_t system_event_callback_add(
@@ -43,8 +150,25 @@ error_t system_event_callback_add(
     system_event_callback_t callback,
     void* context
 ) {
+    if (!is_valid_type(type)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
     mutex_lock(&subscriptions_mutex.handle);
-    subscriptions.push_back(KernelEventSubscription { type, callback, context });
+
+    CallbackTable* old_table = callback_tables[type].load();
+    size_t old_count = (old_table != nullptr) ? old_table->count : 0;
+    CallbackTable* new_table = callback_table_alloc(old_count + 1);
+    if (new_table == nullptr) {
+        mutex_unlock(&subscriptions_mutex.handle);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    if (old_count > 0) {
+        std::memcpy(new_table->entries(), old_table->entries(), old_count * sizeof(KernelEventSubscription));
+    }
+    new_table->entries()[old_count] = KernelEventSubscription { callback, context };
+    publish_table(type, new_table);
+
     mutex_unlock(&subscriptions_mutex.handle);
 
     return ERROR_NONE;
@@ -54,118 +178,165 @@ error_t system_event_callback_remove(
     SystemEventType type,
     system_event_callback_t callback
 ) {
+    if (!is_valid_type(type)) {
+        return ERROR_NOT_FOUND;
+    }
+
     mutex_lock(&subscriptions_mutex.handle);
-    const auto iterator = std::ranges::find_if(subscriptions, [type, callback](const KernelEventSubscription& subscription) {
-        return subscription.type == type && subscription.callback == callback;
-    });
-    error_t result = ERROR_NOT_FOUND;
-    if (iterator != subscriptions.end()) {
-        subscriptions.erase(iterator);
-        result = ERROR_NONE;
+
+    CallbackTable* old_table = callback_tables[type].load();
+    size_t old_count = (old_table != nullptr) ? old_table->count : 0;
+    size_t remove_index = old_count;
+    for (size_t i = 0; i < old_count; i++) {
+        if (old_table->entries()[i].callback == callback) {
+            remove_index = i;
+            break;
+        }
     }
+
+    if (remove_index == old_count) {
+        mutex_unlock(&subscriptions_mutex.handle);
+        return ERROR_NOT_FOUND;
+    }
+
+    CallbackTable* new_table = nullptr;
+    if (old_count > 1) {
+        new_table = callback_table_alloc(old_count - 1);
+        if (new_table == nullptr) {
+            mutex_unlock(&subscriptions_mutex.handle);
+            return ERROR_OUT_OF_MEMORY;
+        }
+        auto* source = old_table->entries();
+        auto* target = new_table->entries();
+        std::memcpy(target, source, remove_index * sizeof(KernelEventSubscription));
+        std::memcpy(target + remove_index, source + remove_index + 1, (old_count - remove_index - 1) * sizeof(KernelEventSubscription));
+    }
+    publish_table(type, new_table);
+
     mutex_unlock(&subscriptions_mutex.handle);
 
-    return result;
+    return ERROR_NONE;
 }
 
 // Copies `data` into every current poll subscriber of `type` and signals its wakeup semaphore.
 // Held entirely under the lock: unlike the callback path, this never invokes caller code
 // (just a memcpy and a semaphore give), so there is nothing that could reenter and deadlock.
-static void notify_poll_subscribers(
-    SystemEventType type,
-    uint64_t timestamp,
-    const void* data,
-    size_t data_len
-) {
+static void notify_poll_subscribers(const SystemEvent& event) {
     mutex_lock(&poll_subscriptions_mutex.handle);
 
-    for (SystemEventSubscription* sub = poll_subscriptions; sub != nullptr; sub = sub->internal.next) {
-        if (sub->event.type == type) {
-            sub->event.timestamp = timestamp;
-            const size_t copied_len = std::min(data_len, SYSTEM_EVENT_MAX_DATA_SIZE);
-            if (copied_len > 0) {
-                std::memcpy(sub->event.data, data, copied_len);
-            }
-            sub->event.data_len = copied_len;
-            sub->internal.sequence++;
-            xSemaphoreGive(sub->internal.semaphore);
+    for (SystemEventSubscription* sub = poll_subscriptions[event.type]; sub != nullptr; sub = sub->internal.next) {
+        sub->event.timestamp = event.timestamp;
+        if (event.data_len > 0) {
+            std::memcpy(sub->event.data, event.data, event.data_len);
         }
+        sub->event.data_len = event.data_len;
+        sub->internal.sequence++;
+        xSemaphoreGive(sub->internal.semaphore);
     }
 
     mutex_unlock(&poll_subscriptions_mutex.handle);
 }
 
-static error_t notify_listeners(
-    SystemEvent& event
-) {
-    // Snapshot matching subscriptions under the lock, then invoke after unlocking: a
-    // callback calling system_event_callback_add(), system_event_callback_remove() or
-    // system_event_emit() would otherwise deadlock against this same (non-recursive)
-    // mutex, and a slow callback would block every other thread's subscribe/unsubscribe
-    // for the duration of this emit.
-    //
-    // Nothing between mutex_lock() and mutex_unlock() below may throw.
-    // Count first, then use new(std::nothrow) to allocate the exact size and report
-    // failure through the return value instead; the fill loop below is then a plain
-    // assignment of a trivially-copyable struct, which cannot throw or reallocate.
-
-    mutex_lock(&subscriptions_mutex.handle);
-
-    size_t match_count = 0;
-    for (const auto& subscription : subscriptions) {
-        if (subscription.type == event.type) {
-            match_count++;
+static void notify_listeners(SystemEvent& event) {
+    // No lock is held while the callbacks run: a callback may call system_event_callback_add(),
+    // system_event_callback_remove() or system_event_emit(). Those publish new tables, while
+    // this emit keeps iterating the snapshot it loaded. The epoch registration keeps that
+    // snapshot alive until we're done with it.
+    uint32_t reader_epoch = epoch_enter();
+    CallbackTable* table = callback_tables[event.type].load();
+    if (table != nullptr) {
+        auto* entries = table->entries();
+        for (size_t i = 0; i < table->count; i++) {
+            entries[i].callback(&event, entries[i].callback_context);
         }
     }
+    epoch_leave(reader_epoch);
+}
 
-    KernelEventSubscription* matching = (match_count > 0)
-        ? new (std::nothrow) KernelEventSubscription[match_count]
-        : nullptr;
-    if (match_count > 0 && matching == nullptr) {
-        mutex_unlock(&subscriptions_mutex.handle);
-        return ERROR_OUT_OF_MEMORY;
-    }
+static void emit_event(SystemEvent& event) {
+    notify_poll_subscribers(event);
+    notify_listeners(event);
+}
 
-    size_t matched_count = 0;
-    for (const auto& subscription : subscriptions) {
-        if (subscription.type == event.type) {
-            matching[matched_count++] = subscription;
-        }
+static void fill_event(SystemEvent& event, SystemEventType type, const void* data, size_t data_len) {
+    event.type = type;
+    event.timestamp = get_micros_since_boot();
+    const size_t copied_len = std::min(data_len, SYSTEM_EVENT_MAX_DATA_SIZE);
+    if (copied_len > 0) {
+        std::memcpy(event.data, data, copied_len);
     }
+    event.data_len = copied_len;
+}
 
-    mutex_unlock(&subscriptions_mutex.handle);
-
-    for (size_t i = 0; i < matched_count; i++) {
-        matching[i].callback(&event, matching[i].callback_context);
+error_t system_event_emit(
+    SystemEventType type,
+    const void* data,
+    size_t data_len
+) {
+    if (!is_valid_type(type)) {
+        return ERROR_INVALID_ARGUMENT;
     }
 
-    delete[] matching;
+    SystemEvent event {};
+    fill_event(event, type, data, data_len);
+    emit_event(event);
 
     return ERROR_NONE;
 }
 
-error_t system_event_emit(
+// Events emitted with system_event_emit_from_isr() wait in these slots until the timer
+// service task delivers them. A slot is claimed with a compare-and-swap, so no lock is needed.
+#define DEFERRED_EVENT_SLOT_COUNT 8
+
+struct DeferredEventSlot {
+    std::atomic<bool> in_use;
+    SystemEvent event;
+};
+
+static DeferredEventSlot deferred_event_slots[DEFERRED_EVENT_SLOT_COUNT];
+
+static void deliver_deferred_event(void* context, uint32_t arg) {
+    (void)arg;
+    auto* slot = static_cast<DeferredEventSlot*>(context);
+    emit_event(slot->event);
+    slot->in_use.store(false);
+}
+
+error_t system_event_emit_from_isr(
     SystemEventType type,
     const void* data,
     size_t data_len
 ) {
-    SystemEvent event {};
-    event.type = type;
-    event.timestamp = get_micros_since_boot();
-    const size_t copied_len = std::min(data_len, SYSTEM_EVENT_MAX_DATA_SIZE);
-    if (copied_len > 0) {
-        std::memcpy(event.data, data, copied_len);
+    if (!is_valid_type(type)) {
+        return ERROR_INVALID_ARGUMENT;
     }
-    event.data_len = copied_len;
 
-    notify_poll_subscribers(type, event.timestamp, data, data_len);
-    auto error = notify_listeners(event);
-    if (error != ERROR_NONE) { return error; }
+    DeferredEventSlot* slot = nullptr;
+    for (auto& candidate : deferred_event_slots) {
+        bool expected = false;
+        if (candidate.in_use.compare_exchange_strong(expected, true)) {
+            slot = &candidate;
+            break;
+        }
+    }
+    if (slot == nullptr) {
+        return ERROR_RESOURCE;
+    }
 
-    return ERROR_NONE;
+    fill_event(slot->event, type, data, data_len);
+    // No timer instance is needed: pending callbacks always run on the timer service task
+    error_t error = timer_set_pending_callback(nullptr, deliver_deferred_event, slot, 0, 0);
+    if (error != ERROR_NONE) {
+        slot->in_use.store(false);
+    }
+    return error;
 }
 
 error_t system_event_subscribe(SystemEventSubscription* sub) {
+    if (!is_valid_type(sub->event.type)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
     // Wait out any system_event_unsubscribe() call still draining old awaiters for this same
     // `sub` on another task (see internal.unsubscribe_in_progress). waiter_count/cancelled
     // belong to `sub` itself, not to a given registration - reusing `sub` before that call
@@ -192,12 +363,15 @@ error_t system_event_subscribe(SystemEventSubscription* sub) {
 
     // Check-and-insert in one critical section: registering the same `sub` twice would link
     // it into a list that already contains it, creating a cycle that notify_poll_subscribers()
-    // would then traverse forever while holding this same mutex.
-    for (SystemEventSubscription* existing = poll_subscriptions; existing != nullptr; existing = existing->internal.next) {
-        if (existing == sub) {
-            mutex_unlock(&poll_subscriptions_mutex.handle);
-            vSemaphoreDelete(semaphore);
-            return ERROR_INVALID_STATE;
+    // would then traverse forever while holding this same mutex. All lists are checked, in case
+    // the caller changed sub->event.type on a subscription that is still registered.
+    for (auto* list : poll_subscriptions) {
+        for (SystemEventSubscription* existing = list; existing != nullptr; existing = existing->internal.next) {
+            if (existing == sub) {
+                mutex_unlock(&poll_subscriptions_mutex.handle);
+                vSemaphoreDelete(semaphore);
+                return ERROR_INVALID_STATE;
+            }
         }
     }
 
@@ -207,8 +381,8 @@ error_t system_event_subscribe(SystemEventSubscription* sub) {
     sub->internal.waiter_count = 0;
     sub->internal.cancelled = false;
     sub->event.data_len = 0;
-    sub->internal.next = poll_subscriptions;
-    poll_subscriptions = sub;
+    sub->internal.next = poll_subscriptions[sub->event.type];
+    poll_subscriptions[sub->event.type] = sub;
 
     mutex_unlock(&poll_subscriptions_mutex.handle);
 
@@ -220,10 +394,15 @@ error_t system_event_unsubscribe(SystemEventSubscription* sub) {
     SemaphoreHandle_t semaphore_to_delete = nullptr;
 
     mutex_lock(&poll_subscriptions_mutex.handle);
-    for (SystemEventSubscription** link = &poll_subscriptions; *link != nullptr; link = &(*link)->internal.next) {
-        if (*link == sub) {
-            *link = sub->internal.next;
-            result = ERROR_NONE;
+    for (auto& list : poll_subscriptions) {
+        for (SystemEventSubscription** link = &list; *link != nullptr; link = &(*link)->internal.next) {
+            if (*link == sub) {
+                *link = sub->internal.next;
+                result = ERROR_NONE;
+                break;
+            }
+        }
+        if (result == ERROR_NONE) {
             break;
         }
     }
@@ -0,0 +1,265 @@
+#include "doctest.h"
+
+#include <atomic>
+#include <vector>
+
+#include <tactility/concurrent/mutex.h>
+#include <tactility/delay.h>
+#include <tactility/device.h>
+#include <tactility/device_boot.h>
+#include <tactility/driver.h>
+#include <tactility/module.h>
+#include <tactility/time.h>
+
+namespace {
+
+constexpr uint32_t SLOW_START_MS = 50;
+/** Only reached when the devices at the barrier don't run concurrently */
+constexpr uint32_t BARRIER_TIMEOUT_MS = 5000;
+
+Module module = {
+    .name = "device_boot_test_module",
+    .start = nullptr,
+    .stop = nullptr
+};
+
+std::atomic<int> running_count = 0;
+std::atomic<int> max_running_count = 0;
+/** The amount of devices that must start at the same time before any of them can finish starting */
+int barrier_count = 0;
+std::atomic<int> barrier_arrived = 0;
+Mutex start_order_mutex;
+std::vector<Device*> start_order;
+
+void record_start(Device* device) {
+    mutex_lock(&start_order_mutex);
+    start_order.push_back(device);
+    mutex_unlock(&start_order_mutex);
+}
+
+error_t start_slow(Device* device) {
+    int running = ++running_count;
+    int expected = max_running_count.load();
+    while (running > expected && !max_running_count.compare_exchange_weak(expected, running)) {}
+    record_start(device);
+    delay_millis(SLOW_START_MS);
+    running_count--;
+    return ERROR_NONE;
+}
+
+/** Finishes once barrier_count devices are starting at the same time, which only works when they run concurrently */
+error_t start_barrier(Device* device) {
+    record_start(device);
+    barrier_arrived++;
+    uint64_t deadline = get_millis() + BARRIER_TIMEOUT_MS;
+    while (barrier_arrived.load() < barrier_count) {
+        if (get_millis() >= deadline) {
+            return ERROR_TIMEOUT;
+        }
+        delay_millis(1);
+    }
+    return ERROR_NONE;
+}
+
+error_t start_failing(Device* device) {
+    record_start(device);
+    return ERROR_RESOURCE;
+}
+
+error_t stop(Device*) { return ERROR_NONE; }
+
+Driver slow_driver = {
+    .name = "device_boot_test_slow",
+    .compatible = (const char*[]) { "device_boot_test,slow", nullptr },
+    .start_device = start_slow,
+    .stop_device = stop,
+    .api = nullptr,
+    .device_type = nullptr,
+    .owner = &module,
+    .internal = nullptr,
+};
+
+Driver barrier_driver = {
+    .name = "device_boot_test_barrier",
+    .compatible = (const char*[]) { "device_boot_test,barrier", nullptr },
+    .start_device = start_barrier,
+    .stop_device = stop,
+    .api = nullptr,
+    .device_type = nullptr,
+    .owner = &module,
+    .internal = nullptr,
+};
+
+Driver failing_driver = {
+    .name = "device_boot_test_failing",
+    .compatible = (const char*[]) { "device_boot_test,failing", nullptr },
+    .start_device = start_failing,
+    .stop_device = stop,
+    .api = nullptr,
+    .device_type = nullptr,
+    .owner = &module,
+    .internal = nullptr,
+};
+
+void reset_counters() {
+    running_count = 0;
+    max_running_count = 0;
+    barrier_count = 0;
+    barrier_arrived = 0;
+    start_order.clear();
+}
+
+size_t index_of_start(Device* device) {
+    for (size_t i = 0; i < start_order.size(); i++) {
+        if (start_order[i] == device) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+void stop_remove_destruct(Device* device) {
+    if (device_is_constructed(device)) {
+        CHECK_EQ(device_stop(device), ERROR_NONE);
+        CHECK_EQ(device_remove(device), ERROR_NONE);
+        CHECK_EQ(device_destruct(device), ERROR_NONE);
+    }
+}
+
+struct BootFixture {
+    BootFixture() {
+        mutex_construct(&start_order_mutex);
+        REQUIRE_EQ(driver_construct_add(&slow_driver), ERROR_NONE);
+        REQUIRE_EQ(driver_construct_add(&barrier_driver), ERROR_NONE);
+        REQUIRE_EQ(driver_construct_add(&failing_driver), ERROR_NONE);
+        reset_counters();
+    }
+
+    ~BootFixture() {
+        CHECK_EQ(driver_remove_destruct(&failing_driver), ERROR_NONE);
+        CHECK_EQ(driver_remove_destruct(&barrier_driver), ERROR_NONE);
+        CHECK_EQ(driver_remove_destruct(&slow_driver), ERROR_NONE);
+        mutex_destruct(&start_order_mutex);
+    }
+};
+
+} // namespace
+
+TEST_CASE_FIXTURE(BootFixture, "device_boot should start independent devices concurrently") {
+    Device devices[4] = {
+        { .name = "boot_a" },
+        { .name = "boot_b" },
+        { .name = "boot_c" },
+        { .name = "boot_d" }
+    };
+    const DtsDevice dts_devices[] = {
+        { &devices[0], "device_boot_test,barrier", DTS_DEVICE_STATUS_OKAY },
+        { &devices[1], "device_boot_test,barrier", DTS_DEVICE_STATUS_OKAY },
+        { &devices[2], "device_boot_test,barrier", DTS_DEVICE_STATUS_OKAY },
+        { &devices[3], "device_boot_test,barrier", DTS_DEVICE_STATUS_OKAY },
+        DTS_DEVICE_TERMINATOR
+    };
+    DeviceBootRecord records[4];
+    const DeviceBootConfig config = { .worker_count = 4, .worker_stack_size = 4096 };
+    // Sequential starts would time out at the barrier
+    barrier_count = 4;
+
+    CHECK_EQ(device_boot(dts_devices, &config, records), ERROR_NONE);
+
+    for (size_t i = 0; i < 4; i++) {
+        CHECK_EQ(records[i].device, &devices[i]);
+        CHECK_EQ(records[i].result, ERROR_NONE);
+        CHECK_EQ(device_is_ready(&devices[i]), true);
+    }
+
+    for (auto& device : devices) {
+        stop_remove_destruct(&device);
+    }
+}
+
+TEST_CASE_FIXTURE(BootFixture, "device_boot should start a parent before its children") {
+    Device parent = { .name = "boot_parent" };
+    Device child_a = { .name = "boot_child_a", .parent = &parent };
+    Device child_b = { .name = "boot_child_b", .parent = &parent };
+    Device grandchild = { .name = "boot_grandchild", .parent = &child_a };
+    Device other = { .name = "boot_other" };
+    const DtsDevice dts_devices[] = {
+        { &parent, "device_boot_test,barrier", DTS_DEVICE_STATUS_OKAY },
+        { &child_a, "device_boot_test,slow", DTS_DEVICE_STATUS_OKAY },
+        { &child_b, "device_boot_test,slow", DTS_DEVICE_STATUS_OKAY },
+        { &grandchild, "device_boot_test,slow", DTS_DEVICE_STATUS_OKAY },
+        { &other, "device_boot_test,barrier", DTS_DEVICE_STATUS_OKAY },
+        DTS_DEVICE_TERMINATOR
+    };
+    DeviceBootRecord records[5];
+    const DeviceBootConfig config = { .worker_count = 4, .worker_stack_size = 4096 };
+    // Independent of the parent subtree, so other must start alongside the parent to get past the barrier
+    barrier_count = 2;
+
+    CHECK_EQ(device_boot(dts_devices, &config, records), ERROR_NONE);
+
+    for (const auto& record : records) {
+        CHECK_EQ(record.result, ERROR_NONE);
+    }
+    REQUIRE_EQ(start_order.size(), 5);
+    CHECK_LT(index_of_start(&parent), index_of_start(&child_a));
+    CHECK_LT(index_of_start(&parent), index_of_start(&child_b));
+    CHECK_LT(index_of_start(&child_a), index_of_start(&grandchild));
+
+    stop_remove_destruct(&grandchild);
+    stop_remove_destruct(&child_b);
+    stop_remove_destruct(&child_a);
+    stop_remove_destruct(&parent);
+    stop_remove_destruct(&other);
+}
+
+TEST_CASE_FIXTURE(BootFixture, "device_boot with a single worker should keep array order") {
+    Device devices[3] = {
+        { .name = "boot_first" },
+        { .name = "boot_second" },
+        { .name = "boot_third" }
+    };
+    const DtsDevice dts_devices[] = {
+        { &devices[0], "device_boot_test,slow", DTS_DEVICE_STATUS_OKAY },
+        { &devices[1], "device_boot_test,slow", DTS_DEVICE_STATUS_DISABLED },
+        { &devices[2], "device_boot_test,slow", DTS_DEVICE_STATUS_OKAY },
+        DTS_DEVICE_TERMINATOR
+    };
+    const DeviceBootConfig config = { .worker_count = 1, .worker_stack_size = 0 };
+
+    CHECK_EQ(device_boot(dts_devices, &config, nullptr), ERROR_NONE);
+
+    REQUIRE_EQ(start_order.size(), 2);
+    CHECK_EQ(start_order[0], &devices[0]);
+    CHECK_EQ(start_order[1], &devices[2]);
+    CHECK_EQ(max_running_count.load(), 1);
+    CHECK_EQ(device_is_added(&devices[1]), true);
+    CHECK_EQ(device_is_ready(&devices[1]), false);
+
+    stop_remove_destruct(&devices[0]);
+    stop_remove_destruct(&devices[1]);
+    stop_remove_destruct(&devices[2]);
+}
+
+TEST_CASE_FIXTURE(BootFixture, "device_boot should not start new devices after a failure") {
+    Device failing = { .name = "boot_failing" };
+    Device child = { .name = "boot_failing_child", .parent = &failing };
+    Device later = { .name = "boot_later" };
+    const DtsDevice dts_devices[] = {
+        { &failing, "device_boot_test,failing", DTS_DEVICE_STATUS_OKAY },
+        { &child, "device_boot_test,slow", DTS_DEVICE_STATUS_OKAY },
+        { &later, "device_boot_test,slow", DTS_DEVICE_STATUS_OKAY },
+        DTS_DEVICE_TERMINATOR
+    };
+    DeviceBootRecord records[3];
+    const DeviceBootConfig config = { .worker_count = 1, .worker_stack_size = 0 };
+
+    CHECK_EQ(device_boot(dts_devices, &config, records), ERROR_RESOURCE);
+
+    CHECK_EQ(records[0].result, ERROR_RESOURCE);
+    CHECK_EQ(records[1].result, ERROR_INVALID_STATE);
+    CHECK_EQ(records[2].result, ERROR_INVALID_STATE);
+    CHECK_EQ(device_is_constructed(&failing), false);
+    CHECK_EQ(device_is_constructed(&child), false);
+    CHECK_EQ(device_is_constructed(&later), false);
+}
@@ -0,0 +1,195 @@
+#include "doctest.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tactility/device.h>
+#include <tactility/driver.h>
+#include <tactility/module.h>
+
+namespace {
+
+Module module = {
+    .name = "device_index_test_module",
+    .start = nullptr,
+    .stop = nullptr
+};
+
+int start(Device*) { return ERROR_NONE; }
+int stop(Device*) { return ERROR_NONE; }
+
+DeviceType index_test_type = { .name = "device_index_test_type" };
+DeviceType unused_type = { .name = "device_index_unused_type" };
+
+Driver index_test_driver = {
+    .name = "device_index_test_driver",
+    .compatible = (const char*[]) { "device_index_test,a", "device_index_test,b", nullptr },
+    .start_device = start,
+    .stop_device = stop,
+    .api = nullptr,
+    .device_type = &index_test_type,
+    .owner = &module,
+    .internal = nullptr,
+};
+
+/** A set of dynamically named devices, added on construction and removed on destruction */
+class DeviceSet {
+
+    std::vector<std::string> names;
+    std::vector<std::unique_ptr<Device>> devices;
+
+public:
+
+    explicit DeviceSet(size_t count) {
+        names.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            names.push_back("device_index_" + std::to_string(i));
+        }
+        for (size_t i = 0; i < count; i++) {
+            auto device = std::make_unique<Device>();
+            device->name = names[i].c_str();
+            REQUIRE_EQ(device_construct(device.get()), ERROR_NONE);
+            device_set_driver(device.get(), &index_test_driver);
+            REQUIRE_EQ(device_add(device.get()), ERROR_NONE);
+            devices.push_back(std::move(device));
+        }
+    }
+
+    ~DeviceSet() {
+        for (auto& device : devices) {
+            CHECK_EQ(device_remove(device.get()), ERROR_NONE);
+            CHECK_EQ(device_destruct(device.get()), ERROR_NONE);
+        }
+    }
+
+    Device* get(size_t index) const { return devices[index].get(); }
+
+    const char* getName(size_t index) const { return names[index].c_str(); }
+};
+
+/** @return the average duration of a device_get_by_name() + device_put() round trip in nanoseconds */
+double measure_lookup_by_name(const DeviceSet& set, size_t count) {
+    constexpr int iterations = 20000;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        // Always look up the last-added device: the worst case for a linear scan
+        Device* device = nullptr;
+        if (device_get_by_name(set.getName(count - 1), &device) == ERROR_NONE) {
+            device_put(device);
+        }
+    }
+    auto duration = std::chrono::steady_clock::now() - start_time;
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / iterations;
+}
+
+} // namespace
+
+TEST_CASE("device lookups should find devices through the index") {
+    CHECK_EQ(driver_construct_add(&index_test_driver), ERROR_NONE);
+    {
+        DeviceSet set(3);
+
+        Device* device = nullptr;
+        CHECK_EQ(device_get_by_name(set.getName(1), &device), ERROR_NONE);
+        CHECK_EQ(device, set.get(1));
+        device_put(device);
+
+        CHECK_EQ(device_get_first_by_type(&index_test_type, &device), ERROR_NONE);
+        CHECK_EQ(device, set.get(0));
+        device_put(device);
+
+        CHECK_EQ(device_get_first_by_compatible("device_index_test,b", &device), ERROR_NONE);
+        CHECK_EQ(device, set.get(0));
+        device_put(device);
+
+        CHECK_EQ(device_exists_of_type(&index_test_type), true);
+        CHECK_EQ(device_exists_of_type(&unused_type), false);
+        CHECK_EQ(device_has_active_by_type(&index_test_type), false);
+        CHECK_EQ(device_get_first_active_by_type(&index_test_type, &device), ERROR_NOT_FOUND);
+
+        size_t type_count = 0;
+        device_for_each_of_type(&index_test_type, &type_count, [](auto*, auto* context) {
+            (*static_cast<size_t*>(context))++;
+            return true;
+        });
+        CHECK_EQ(type_count, 3);
+
+        CHECK_EQ(device_get_by_name("device_index_missing", &device), ERROR_NOT_FOUND);
+        CHECK_EQ(device_get_first_by_compatible("device_index_test,missing", &device), ERROR_NOT_FOUND);
+    }
+    CHECK_EQ(driver_remove_destruct(&index_test_driver), ERROR_NONE);
+}
+
+TEST_CASE("device lookups should not find devices after device_remove") {
+    CHECK_EQ(driver_construct_add(&index_test_driver), ERROR_NONE);
+    {
+        DeviceSet set(1);
+        CHECK_EQ(device_remove(set.get(0)), ERROR_NONE);
+
+        Device* device = nullptr;
+        CHECK_EQ(device_get_by_name(set.getName(0), &device), ERROR_NOT_FOUND);
+        CHECK_EQ(device_get_first_by_type(&index_test_type, &device), ERROR_NOT_FOUND);
+        CHECK_EQ(device_get_first_by_compatible("device_index_test,a", &device), ERROR_NOT_FOUND);
+        CHECK_EQ(device_exists_of_type(&index_test_type), false);
+
+        // Re-add so DeviceSet can clean up
+        CHECK_EQ(device_add(set.get(0)), ERROR_NONE);
+    }
+    CHECK_EQ(driver_remove_destruct(&index_test_driver), ERROR_NONE);
+}
+
+TEST_CASE("device_get_by_name should return the first added device when names collide") {
+    CHECK_EQ(driver_construct_add(&index_test_driver), ERROR_NONE);
+
+    Device first = { .name = "device_index_duplicate" };
+    Device second = { .name = "device_index_duplicate" };
+    CHECK_EQ(device_construct(&first), ERROR_NONE);
+    CHECK_EQ(device_construct(&second), ERROR_NONE);
+    CHECK_EQ(device_add(&first), ERROR_NONE);
+    CHECK_EQ(device_add(&second), ERROR_NONE);
+
+    Device* device = nullptr;
+    CHECK_EQ(device_get_by_name("device_index_duplicate", &device), ERROR_NONE);
+    CHECK_EQ(device, &first);
+    device_put(device);
+
+    CHECK_EQ(device_remove(&first), ERROR_NONE);
+    CHECK_EQ(device_get_by_name("device_index_duplicate", &device), ERROR_NONE);
+    CHECK_EQ(device, &second);
+    device_put(device);
+
+    CHECK_EQ(device_remove(&second), ERROR_NONE);
+    CHECK_EQ(device_destruct(&second), ERROR_NONE);
+    CHECK_EQ(device_destruct(&first), ERROR_NONE);
+    CHECK_EQ(driver_remove_destruct(&index_test_driver), ERROR_NONE);
+}
+
+TEST_CASE("device_get_by_name benchmark with a growing device count") {
+    CHECK_EQ(driver_construct_add(&index_test_driver), ERROR_NONE);
+
+    double small_ns;
+    double large_ns;
+    {
+        DeviceSet set(16);
+        small_ns = measure_lookup_by_name(set, 16);
+    }
+    {
+        DeviceSet set(1024);
+        large_ns = measure_lookup_by_name(set, 1024);
+
+        // Every device is found by its own name
+        for (size_t i = 0; i < 1024; i++) {
+            Device* device = nullptr;
+            CHECK_EQ(device_get_by_name(set.getName(i), &device), ERROR_NONE);
+            CHECK_EQ(device, set.get(i));
+            device_put(device);
+        }
+    }
+
+    // Timings are only reported: a linear scan would be ~64x slower with 1024 devices
+    MESSAGE("device_get_by_name: " << small_ns << " ns with 16 devices, " << large_ns << " ns with 1024 devices");
+
+    CHECK_EQ(driver_remove_destruct(&index_test_driver), ERROR_NONE);
+}
@@ -1,6 +1,135 @@
 #include "doctest.h"
 #include <tactility/freertos/task.h>
 #include <tactility/concurrent/dispatcher.h>
+#include <tactility/concurrent/thread.h>
+#include <tactility/delay.h>
+#include <tactility/time.h>
+
+#include <atomic>
+#include <vector>
+
+namespace {
+
+constexpr DispatcherConfig RING_CONFIG = { .backend = DISPATCHER_BACKEND_RING, .ring_capacity = 4096 };
+
+void increment(void* context) {
+    (*static_cast<int*>(context))++;
+}
+
+struct LoadContext {
+    DispatcherHandle_t dispatcher;
+    std::atomic<uint32_t> consumed { 0 };
+    uint32_t items_per_producer;
+    uint32_t expected;
+};
+
+void count_consumed(void* context) {
+    static_cast<LoadContext*>(context)->consumed.fetch_add(1U, std::memory_order_relaxed);
+}
+
+int32_t produce(void* context) {
+    auto* load = static_cast<LoadContext*>(context);
+    for (uint32_t i = 0; i < load->items_per_producer; i++) {
+        if (dispatcher_dispatch(load->dispatcher, load, count_consumed) != ERROR_NONE) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int32_t consume_all(void* context) {
+    auto* load = static_cast<LoadContext*>(context);
+    while (load->consumed.load(std::memory_order_relaxed) < load->expected) {
+        dispatcher_consume_timed(load->dispatcher, pdMS_TO_TICKS(10));
+    }
+    return 0;
+}
+
+/**
+ * Dispatch from several producer threads to a single consumer thread.
+ * @return the duration in microseconds, or 0 when not all items were consumed
+ */
+uint64_t run_throughput(DispatcherHandle_t dispatcher, uint32_t producer_count, uint32_t items_per_producer) {
+    LoadContext load;
+    load.dispatcher = dispatcher;
+    load.items_per_producer = items_per_producer;
+    load.expected = producer_count * items_per_producer;
+
+    uint64_t start_time = get_micros_since_boot();
+    auto* consumer = thread_alloc_full("dispatcher_consumer", 4096, consume_all, &load, -1);
+    CHECK_EQ(thread_start(consumer), ERROR_NONE);
+    std::vector<Thread*> producers;
+    for (uint32_t i = 0; i < producer_count; i++) {
+        auto* producer = thread_alloc_full("dispatcher_producer", 4096, produce, &load, -1);
+        CHECK_EQ(thread_start(producer), ERROR_NONE);
+        producers.push_back(producer);
+    }
+    for (auto* producer : producers) {
+        CHECK_EQ(thread_join(producer, MAX_TICKS, 1), ERROR_NONE);
+        CHECK_EQ(thread_get_return_code(producer), 0);
+        thread_free(producer);
+    }
+    CHECK_EQ(thread_join(consumer, pdMS_TO_TICKS(10000), 1), ERROR_NONE);
+    thread_free(consumer);
+    uint64_t duration = get_micros_since_boot() - start_time;
+
+    return (load.consumed.load() == load.expected) ? duration : 0U;
+}
+
+struct LatencyContext {
+    DispatcherHandle_t dispatcher;
+    std::atomic<bool> running { true };
+    std::atomic<uint64_t> dispatch_time { 0 };
+    std::atomic<uint64_t> total_latency { 0 };
+    std::atomic<uint32_t> samples { 0 };
+};
+
+void record_latency(void* context) {
+    auto* latency = static_cast<LatencyContext*>(context);
+    latency->total_latency.fetch_add(get_micros_since_boot() - latency->dispatch_time.load());
+    latency->samples.fetch_add(1U);
+}
+
+int32_t consume_until_stopped(void* context) {
+    auto* latency = static_cast<LatencyContext*>(context);
+    while (latency->running.load()) {
+        dispatcher_consume_timed(latency->dispatcher, pdMS_TO_TICKS(10));
+    }
+    return 0;
+}
+
+/** @return the average time between dispatching a function and its execution on a waiting consumer, in microseconds */
+uint64_t run_latency(DispatcherHandle_t dispatcher, uint32_t sample_count) {
+    LatencyContext latency;
+    latency.dispatcher = dispatcher;
+    auto* consumer = thread_alloc_full("dispatcher_consumer", 4096, consume_until_stopped, &latency, -1);
+    CHECK_EQ(thread_start(consumer), ERROR_NONE);
+    for (uint32_t i = 0; i < sample_count; i++) {
+        // Give the consumer time to block on the event group again
+        delay_ticks(1);
+        latency.dispatch_time = get_micros_since_boot();
+        CHECK_EQ(dispatcher_dispatch(dispatcher, &latency, record_latency), ERROR_NONE);
+        while (latency.samples.load() == i) {
+            taskYIELD();
+        }
+    }
+    latency.running = false;
+    CHECK_EQ(thread_join(consumer, pdMS_TO_TICKS(1000), 1), ERROR_NONE);
+    thread_free(consumer);
+    return latency.total_latency.load() / sample_count;
+}
+
+struct OrderEntry {
+    std::vector<int>* order;
+    int value;
+};
+
+void record_order(void* context) {
+    auto* entry = static_cast<OrderEntry*>(context);
+    entry->order->push_back(entry->value);
+}
+
+} // namespace
 
 TEST_CASE("dispatcher test") {
     DispatcherHandle_t dispatcher = dispatcher_alloc();
@@ -23,3 +152,170 @@ TEST_CASE("dispatcher test") {
     dispatcher_free(dispatcher);
 }
 
+TEST_CASE("dispatcher_alloc_with_config should reject invalid ring capacities") {
+    DispatcherConfig config = { .backend = DISPATCHER_BACKEND_RING, .ring_capacity = 100 };
+    CHECK_EQ(dispatcher_alloc_with_config(&config), nullptr);
+    config.ring_capacity = 1;
+    CHECK_EQ(dispatcher_alloc_with_config(&config), nullptr);
+
+    // The capacity doesn't apply to the queue backend
+    config.backend = DISPATCHER_BACKEND_QUEUE;
+    auto* dispatcher = dispatcher_alloc_with_config(&config);
+    CHECK_NE(dispatcher, nullptr);
+    dispatcher_free(dispatcher);
+}
+
+TEST_CASE("dispatcher ring backend should consume all pending functions in order in one call") {
+    auto* dispatcher = dispatcher_alloc_with_config(&RING_CONFIG);
+    REQUIRE_NE(dispatcher, nullptr);
+
+    std::vector<int> order;
+    OrderEntry entries[3] = { { &order, 1 }, { &order, 2 }, { &order, 3 } };
+    for (auto& entry : entries) {
+        CHECK_EQ(dispatcher_dispatch(dispatcher, &entry, record_order), ERROR_NONE);
+    }
+    CHECK(order.empty());
+
+    CHECK_EQ(dispatcher_consume_timed(dispatcher, 0), ERROR_NONE);
+    CHECK_EQ(order, std::vector<int> { 1, 2, 3 });
+
+    // Nothing left, and no stale wakeup either
+    CHECK_EQ(dispatcher_consume_timed(dispatcher, 0), ERROR_TIMEOUT);
+
+    dispatcher_free(dispatcher);
+}
+
+TEST_CASE("dispatcher ring backend should report a full ring") {
+    const DispatcherConfig config = { .backend = DISPATCHER_BACKEND_RING, .ring_capacity = 4 };
+    auto* dispatcher = dispatcher_alloc_with_config(&config);
+    REQUIRE_NE(dispatcher, nullptr);
+
+    int count = 0;
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQ(dispatcher_dispatch_timed(dispatcher, &count, increment, 0), ERROR_NONE);
+    }
+    CHECK_EQ(dispatcher_dispatch_timed(dispatcher, &count, increment, 0), ERROR_BUFFER_OVERFLOW);
+    CHECK_EQ(dispatcher_dispatch_timed(dispatcher, &count, increment, 2), ERROR_BUFFER_OVERFLOW);
+
+    CHECK_EQ(dispatcher_consume(dispatcher), ERROR_NONE);
+    CHECK_EQ(count, 4);
+
+    // The slots are reused after wrapping around
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQ(dispatcher_dispatch_timed(dispatcher, &count, increment, 0), ERROR_NONE);
+    }
+    CHECK_EQ(dispatcher_consume(dispatcher), ERROR_NONE);
+    CHECK_EQ(count, 8);
+
+    dispatcher_free(dispatcher);
+}
+
+TEST_CASE("dispatcher ring backend should not lose functions from concurrent producers") {
+    const DispatcherConfig config = { .backend = DISPATCHER_BACKEND_RING, .ring_capacity = 64 };
+    auto* dispatcher = dispatcher_alloc_with_config(&config);
+    REQUIRE_NE(dispatcher, nullptr);
+    // The small ring forces producers to wait for room
+    CHECK_NE(run_throughput(dispatcher, 4, 2000), 0U);
+    dispatcher_free(dispatcher);
+}
+
+TEST_CASE("dispatcher backends benchmark") {
+    constexpr uint32_t producer_count = 4;
+    constexpr uint32_t items_per_producer = 20000;
+    constexpr uint32_t item_count = producer_count * items_per_producer;
+    constexpr uint32_t latency_samples = 200;
+
+    auto* queue = dispatcher_alloc();
+    uint64_t queue_us = run_throughput(queue, producer_count, items_per_producer);
+    uint64_t queue_latency_us = run_latency(queue, latency_samples);
+    dispatcher_free(queue);
+
+    auto* ring = dispatcher_alloc_with_config(&RING_CONFIG);
+    uint64_t ring_us = run_throughput(ring, producer_count, items_per_producer);
+    uint64_t ring_latency_us = run_latency(ring, latency_samples);
+    dispatcher_free(ring);
+
+    CHECK_NE(queue_us, 0U);
+    CHECK_NE(ring_us, 0U);
+    MESSAGE("queue: " << (queue_us * 1000U) / item_count << " ns per function, " << queue_latency_us << " us latency");
+    MESSAGE("ring: " << (ring_us * 1000U) / item_count << " ns per function, " << ring_latency_us << " us latency");
+}
+
+TEST_CASE("dispatcher should call higher priority lanes first") {
+    auto* dispatcher = dispatcher_alloc();
+    std::vector<int> order;
+    OrderEntry low = { &order, 3 };
+    OrderEntry normal = { &order, 2 };
+    OrderEntry high = { &order, 1 };
+
+    CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &low, record_order, DISPATCHER_PRIORITY_LOW, DISPATCHER_NO_DEADLINE, portMAX_DELAY), ERROR_NONE);
+    CHECK_EQ(dispatcher_dispatch(dispatcher, &normal, record_order), ERROR_NONE);
+    CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &high, record_order, DISPATCHER_PRIORITY_HIGH, DISPATCHER_NO_DEADLINE, portMAX_DELAY), ERROR_NONE);
+    CHECK_EQ(dispatcher_consume(dispatcher), ERROR_NONE);
+    CHECK_EQ(order, std::vector<int> { 1, 2, 3 });
+
+    DispatcherLaneStats stats;
+    CHECK_EQ(dispatcher_get_lane_stats(dispatcher, DISPATCHER_PRIORITY_HIGH, &stats), ERROR_NONE);
+    CHECK_EQ(stats.executed, 1);
+    CHECK_EQ(stats.depth, 0);
+    CHECK_EQ(stats.depth_peak, 1);
+    CHECK_EQ(dispatcher_get_lane_stats(dispatcher, (DispatcherPriority)DISPATCHER_PRIORITY_COUNT, &stats), ERROR_INVALID_ARGUMENT);
+
+    dispatcher_free(dispatcher);
+}
+
+TEST_CASE("dispatcher should not starve lower priority lanes") {
+    auto* dispatcher = dispatcher_alloc();
+    std::vector<int> order;
+    OrderEntry high = { &order, 1 };
+    OrderEntry low = { &order, 3 };
+
+    CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &low, record_order, DISPATCHER_PRIORITY_LOW, DISPATCHER_NO_DEADLINE, portMAX_DELAY), ERROR_NONE);
+    for (int i = 0; i < 20; i++) {
+        CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &high, record_order, DISPATCHER_PRIORITY_HIGH, DISPATCHER_NO_DEADLINE, portMAX_DELAY), ERROR_NONE);
+    }
+    CHECK_EQ(dispatcher_consume(dispatcher), ERROR_NONE);
+
+    REQUIRE_EQ(order.size(), 21);
+    // The low lane was skipped 8 times
+    CHECK_EQ(order[8], 3);
+
+    dispatcher_free(dispatcher);
+}
+
+TEST_CASE("dispatcher should move a function ahead when its deadline has passed") {
+    auto* dispatcher = dispatcher_alloc();
+    std::vector<int> order;
+    OrderEntry high = { &order, 1 };
+    OrderEntry low = { &order, 3 };
+
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &high, record_order, DISPATCHER_PRIORITY_HIGH, DISPATCHER_NO_DEADLINE, portMAX_DELAY), ERROR_NONE);
+    }
+    CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &low, record_order, DISPATCHER_PRIORITY_LOW, 1, portMAX_DELAY), ERROR_NONE);
+    delay_ticks(3);
+    CHECK_EQ(dispatcher_consume(dispatcher), ERROR_NONE);
+    CHECK_EQ(order, std::vector<int> { 3, 1, 1, 1 });
+
+    DispatcherLaneStats stats;
+    CHECK_EQ(dispatcher_get_lane_stats(dispatcher, DISPATCHER_PRIORITY_LOW, &stats), ERROR_NONE);
+    CHECK_EQ(stats.executed, 1);
+    CHECK_EQ(stats.deadline_misses, 1);
+    CHECK_GE(stats.latency_max, 3);
+    CHECK_EQ(stats.latency_total, stats.latency_max);
+
+    dispatcher_free(dispatcher);
+}
+
+TEST_CASE("dispatcher ring backend should only support the normal lane without deadlines") {
+    auto* dispatcher = dispatcher_alloc_with_config(&RING_CONFIG);
+    int count = 0;
+    CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &count, increment, DISPATCHER_PRIORITY_HIGH, DISPATCHER_NO_DEADLINE, 0), ERROR_NOT_SUPPORTED);
+    CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &count, increment, DISPATCHER_PRIORITY_NORMAL, 10, 0), ERROR_NOT_SUPPORTED);
+    CHECK_EQ(dispatcher_dispatch_priority_timed(dispatcher, &count, increment, DISPATCHER_PRIORITY_NORMAL, DISPATCHER_NO_DEADLINE, 0), ERROR_NONE);
+    DispatcherLaneStats stats;
+    CHECK_EQ(dispatcher_get_lane_stats(dispatcher, DISPATCHER_PRIORITY_NORMAL, &stats), ERROR_NOT_SUPPORTED);
+    CHECK_EQ(dispatcher_consume(dispatcher), ERROR_NONE);
+    CHECK_EQ(count, 1);
+    dispatcher_free(dispatcher);
+}
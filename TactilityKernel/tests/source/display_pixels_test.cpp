@@ -0,0 +1,165 @@
+#include "doctest.h"
+
+#include <tactility/drivers/display_pixels.h>
+#include <tactility/time.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/** Byte-wise reference: maps every source pixel to its destination with the documented formulas */
+void reference_rotate(const uint8_t* source, uint8_t* destination, int32_t width, int32_t height, size_t source_stride, size_t destination_stride, uint8_t bytes_per_pixel, DisplayPixelRotation rotation, bool swap) {
+    for (int32_t y = 0; y < height; y++) {
+        for (int32_t x = 0; x < width; x++) {
+            int32_t out_x = x;
+            int32_t out_y = y;
+            switch (rotation) {
+                case DISPLAY_PIXEL_ROTATION_0:
+                    break;
+                case DISPLAY_PIXEL_ROTATION_90:
+                    out_x = y;
+                    out_y = width - 1 - x;
+                    break;
+                case DISPLAY_PIXEL_ROTATION_180:
+                    out_x = width - 1 - x;
+                    out_y = height - 1 - y;
+                    break;
+                case DISPLAY_PIXEL_ROTATION_270:
+                    out_x = height - 1 - y;
+                    out_y = x;
+                    break;
+            }
+            const uint8_t* in = source + y * source_stride + x * bytes_per_pixel;
+            uint8_t* out = destination + out_y * destination_stride + out_x * bytes_per_pixel;
+            for (uint8_t i = 0; i < bytes_per_pixel; i++) {
+                out[i] = in[swap ? bytes_per_pixel - 1 - i : i];
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> create_pattern(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<uint8_t>(i * 7U + (i >> 8));
+    }
+    return data;
+}
+
+/** The pre-existing flush path: rotate column by column like lv_draw_sw_rotate(), then swap in a second pass */
+void two_pass_rotate_90_swap(const uint16_t* source, uint16_t* destination, int32_t width, int32_t height) {
+    for (int32_t x = 0; x < width; x++) {
+        uint16_t* out = destination + (width - 1 - x) * height;
+        for (int32_t y = 0; y < height; y++) {
+            out[y] = source[y * width + x];
+        }
+    }
+    auto* words = reinterpret_cast<uint32_t*>(destination);
+    for (int32_t i = 0; i < (width * height) / 2; i++) {
+        words[i] = ((words[i] & 0xFF00FF00U) >> 8) | ((words[i] & 0x00FF00FFU) << 8);
+    }
+}
+
+} // namespace
+
+TEST_CASE("display_pixels_swap_rgb565 should swap every pixel regardless of alignment and count") {
+    std::vector<uint16_t> pixels(67);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = static_cast<uint16_t>(0x1234U + i * 0x0101U);
+    }
+    // Start at an odd pixel so the head and tail both need single pixel handling
+    display_pixels_swap_rgb565(pixels.data() + 1, 63);
+    CHECK_EQ(pixels[0], 0x1234);
+    for (size_t i = 1; i < 64; i++) {
+        auto expected = static_cast<uint16_t>(0x1234U + i * 0x0101U);
+        CHECK_EQ(pixels[i], static_cast<uint16_t>((expected << 8) | (expected >> 8)));
+    }
+    CHECK_EQ(pixels[64], static_cast<uint16_t>(0x1234U + 64U * 0x0101U));
+}
+
+TEST_CASE("display_pixels_rotate should match the reference for all rotations and pixel sizes") {
+    // Not a multiple of the block size, with padded source rows
+    constexpr int32_t WIDTH = 45;
+    constexpr int32_t HEIGHT = 37;
+    const DisplayPixelRotation rotations[] = {
+        DISPLAY_PIXEL_ROTATION_0,
+        DISPLAY_PIXEL_ROTATION_90,
+        DISPLAY_PIXEL_ROTATION_180,
+        DISPLAY_PIXEL_ROTATION_270
+    };
+
+    for (uint8_t bytes_per_pixel = 1; bytes_per_pixel <= 4; bytes_per_pixel++) {
+        for (auto rotation : rotations) {
+            for (bool swap : { false, true }) {
+                if (swap && bytes_per_pixel != 2) {
+                    continue;
+                }
+                CAPTURE(bytes_per_pixel);
+                CAPTURE(rotation);
+                CAPTURE(swap);
+                bool swapped_size = rotation == DISPLAY_PIXEL_ROTATION_90 || rotation == DISPLAY_PIXEL_ROTATION_270;
+                size_t source_stride = (WIDTH + 3) * bytes_per_pixel;
+                size_t destination_stride = (swapped_size ? HEIGHT : WIDTH) * bytes_per_pixel;
+                size_t destination_size = destination_stride * (swapped_size ? WIDTH : HEIGHT);
+                auto source = create_pattern(source_stride * HEIGHT);
+                std::vector<uint8_t> expected(destination_size);
+                std::vector<uint8_t> actual(destination_size);
+
+                reference_rotate(source.data(), expected.data(), WIDTH, HEIGHT, source_stride, destination_stride, bytes_per_pixel, rotation, swap);
+                REQUIRE_EQ(display_pixels_rotate(source.data(), actual.data(), WIDTH, HEIGHT, source_stride, destination_stride, bytes_per_pixel, rotation, swap), ERROR_NONE);
+                CHECK_EQ(std::memcmp(expected.data(), actual.data(), destination_size), 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("display_pixels_rotate should reject unsupported arguments") {
+    uint32_t source[16] = {};
+    uint32_t destination[16] = {};
+    CHECK_EQ(display_pixels_rotate(source, destination, 4, 4, 16, 16, 4, DISPLAY_PIXEL_ROTATION_90, true), ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(display_pixels_rotate(source, destination, 4, 4, 16, 16, 5, DISPLAY_PIXEL_ROTATION_90, false), ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(display_pixels_rotate(source, destination, 4, 4, 8, 16, 4, DISPLAY_PIXEL_ROTATION_90, false), ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(display_pixels_rotate(source, destination, 0, 4, 16, 16, 4, DISPLAY_PIXEL_ROTATION_90, false), ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(display_pixels_rotate(source, destination, 4, 4, 16, 16, 4, static_cast<DisplayPixelRotation>(4), false), ERROR_INVALID_ARGUMENT);
+    // Misaligned RGB565 rows
+    CHECK_EQ(display_pixels_rotate(source, destination, 4, 4, 9, 8, 2, DISPLAY_PIXEL_ROTATION_180, false), ERROR_INVALID_ARGUMENT);
+}
+
+TEST_CASE("display_pixels_rotate benchmark") {
+    constexpr int ITERATIONS = 20;
+    const int32_t sizes[][2] = { { 320, 240 }, { 480, 320 } };
+
+    for (const auto& size : sizes) {
+        int32_t width = size[0];
+        int32_t height = size[1];
+        auto pattern = create_pattern(static_cast<size_t>(width) * height * 2U);
+        std::vector<uint16_t> source(static_cast<size_t>(width) * height);
+        std::memcpy(source.data(), pattern.data(), pattern.size());
+        std::vector<uint16_t> two_pass(source.size());
+        std::vector<uint16_t> fused(source.size());
+
+        uint64_t start_time = get_micros_since_boot();
+        for (int i = 0; i < ITERATIONS; i++) {
+            two_pass_rotate_90_swap(source.data(), two_pass.data(), width, height);
+        }
+        uint64_t two_pass_us = (get_micros_since_boot() - start_time) / ITERATIONS;
+
+        start_time = get_micros_since_boot();
+        for (int i = 0; i < ITERATIONS; i++) {
+            display_pixels_rotate(source.data(), fused.data(), width, height, width * 2U, height * 2U, 2, DISPLAY_PIXEL_ROTATION_90, true);
+        }
+        uint64_t fused_us = (get_micros_since_boot() - start_time) / ITERATIONS;
+
+        start_time = get_micros_since_boot();
+        for (int i = 0; i < ITERATIONS; i++) {
+            display_pixels_swap_rgb565(fused.data(), fused.size());
+        }
+        uint64_t swap_us = (get_micros_since_boot() - start_time) / ITERATIONS;
+        // An even number of swaps leaves the pixels as they were
+        CHECK_EQ(std::memcmp(two_pass.data(), fused.data(), fused.size() * 2U), 0);
+
+        MESSAGE("RGB565 " << width << "x" << height << " rotate 90 + swap: " << two_pass_us << " us in 2 passes, "
+            << fused_us << " us fused; swap only: " << swap_us << " us");
+    }
+}
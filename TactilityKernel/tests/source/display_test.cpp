@@ -0,0 +1,147 @@
+#include "doctest.h"
+
+#include <tactility/device.h>
+#include <tactility/driver.h>
+#include <tactility/drivers/display.h>
+
+#include <cstdint>
+
+namespace {
+
+struct MockDisplay {
+    int draw_count = 0;
+    int32_t last_x_end = 0;
+    const void* last_color_data = nullptr;
+    // Set while an async draw is in flight, like a DMA transfer
+    DisplayDrawDoneCallback pending_callback = nullptr;
+    void* pending_context = nullptr;
+};
+
+MockDisplay mock;
+
+const char* compatible[] = { "display_test", nullptr };
+
+error_t mock_draw_bitmap(Device*, int32_t, int32_t, int32_t x_end, int32_t, const void* color_data) {
+    mock.draw_count++;
+    mock.last_x_end = x_end;
+    mock.last_color_data = color_data;
+    return ERROR_NONE;
+}
+
+error_t mock_draw_bitmap_async(Device* device, int32_t x_start, int32_t y_start, int32_t x_end, int32_t y_end, const void* color_data, DisplayDrawDoneCallback on_done, void* context) {
+    if (mock.pending_callback != nullptr) {
+        return ERROR_RESOURCE_BUSY;
+    }
+    mock_draw_bitmap(device, x_start, y_start, x_end, y_end, color_data);
+    mock.pending_callback = on_done;
+    mock.pending_context = context;
+    return ERROR_NONE;
+}
+
+/** Simulates the transfer-done interrupt */
+void mock_complete_transfer(Device* device) {
+    auto callback = mock.pending_callback;
+    mock.pending_callback = nullptr;
+    callback(device, mock.pending_context);
+}
+
+DisplayApi create_api(bool async) {
+    return {
+        .capabilities = async ? (uint32_t)DISPLAY_CAPABILITY_ASYNC_DRAW : 0U,
+        .reset = nullptr,
+        .init = nullptr,
+        .draw_bitmap = mock_draw_bitmap,
+        .mirror = nullptr,
+        .swap_xy = nullptr,
+        .get_swap_xy = nullptr,
+        .get_mirror_x = nullptr,
+        .get_mirror_y = nullptr,
+        .set_gap = nullptr,
+        .get_gap_x = nullptr,
+        .get_gap_y = nullptr,
+        .invert_color = nullptr,
+        .disp_on_off = nullptr,
+        .disp_sleep = nullptr,
+        .get_color_format = nullptr,
+        .get_resolution_x = nullptr,
+        .get_resolution_y = nullptr,
+        .get_frame_buffer = nullptr,
+        .get_frame_buffer_count = nullptr,
+        .get_backlight = nullptr,
+        .has_capability = nullptr,
+        .draw_bitmap_async = async ? mock_draw_bitmap_async : nullptr,
+    };
+}
+
+void on_draw_done(Device*, void* context) {
+    (*static_cast<int*>(context))++;
+}
+
+struct DisplayFixture {
+    DisplayApi api {};
+    Driver driver {};
+    Device device { .name = "display_test_device" };
+
+    explicit DisplayFixture(bool async) : api(create_api(async)) {
+        mock = {};
+        driver = {
+            .name = "display_test_driver",
+            .compatible = compatible,
+            .start_device = nullptr,
+            .stop_device = nullptr,
+            .api = &api,
+            .device_type = &DISPLAY_TYPE,
+            .owner = nullptr,
+            .internal = nullptr,
+        };
+        REQUIRE_EQ(device_construct(&device), ERROR_NONE);
+        device_set_driver(&device, &driver);
+    }
+
+    ~DisplayFixture() {
+        device_set_driver(&device, nullptr);
+        CHECK_EQ(device_destruct(&device), ERROR_NONE);
+    }
+};
+
+} // namespace
+
+TEST_CASE("display_draw_bitmap_async should draw synchronously for drivers without async support") {
+    DisplayFixture fixture(false);
+    uint16_t pixels[4] = {};
+    int done_count = 0;
+
+    CHECK_FALSE(display_has_capability(&fixture.device, DISPLAY_CAPABILITY_ASYNC_DRAW));
+    CHECK_EQ(display_draw_bitmap_async(&fixture.device, 0, 0, 2, 2, pixels, on_draw_done, &done_count), ERROR_NONE);
+    CHECK_EQ(mock.draw_count, 1);
+    CHECK_EQ(mock.last_x_end, 2);
+    CHECK_EQ(mock.last_color_data, pixels);
+    // Done before returning, so the caller can reuse the buffer right away
+    CHECK_EQ(done_count, 1);
+}
+
+TEST_CASE("display_draw_bitmap_async should call on_done when the driver finishes the transfer") {
+    DisplayFixture fixture(true);
+    uint16_t first[4] = {};
+    uint16_t second[4] = {};
+    int done_count = 0;
+
+    CHECK(display_has_capability(&fixture.device, DISPLAY_CAPABILITY_ASYNC_DRAW));
+    CHECK_EQ(display_draw_bitmap_async(&fixture.device, 0, 0, 2, 2, first, on_draw_done, &done_count), ERROR_NONE);
+    CHECK_EQ(mock.draw_count, 1);
+    // Still transferring: the caller can render into another buffer in the meantime
+    CHECK_EQ(done_count, 0);
+    CHECK_EQ(display_draw_bitmap_async(&fixture.device, 0, 2, 2, 4, second, on_draw_done, &done_count), ERROR_RESOURCE_BUSY);
+
+    mock_complete_transfer(&fixture.device);
+    CHECK_EQ(done_count, 1);
+
+    CHECK_EQ(display_draw_bitmap_async(&fixture.device, 0, 2, 2, 4, second, on_draw_done, &done_count), ERROR_NONE);
+    CHECK_EQ(mock.last_color_data, second);
+    mock_complete_transfer(&fixture.device);
+    CHECK_EQ(done_count, 2);
+
+    // The synchronous API keeps working for async drivers
+    CHECK_EQ(display_draw_bitmap(&fixture.device, 0, 0, 2, 2, first), ERROR_NONE);
+    CHECK_EQ(mock.draw_count, 3);
+}
@@ -0,0 +1,207 @@
+#include "doctest.h"
+
+#include <tactility/device.h>
+#include <tactility/drivers/i2c_controller.h>
+#include <tactility/drivers/i2c_register_cache.h>
+#include <tactility/drivers/posix_i2c.h>
+
+namespace {
+
+constexpr uint8_t TARGET_ADDRESS = 0x20;
+
+// A mock I2C bus from platform-posix with 1 slave device
+struct MockI2cBus {
+    Device device { .name = "i2c_controller_test" };
+
+    MockI2cBus() {
+        REQUIRE_EQ(device_construct_add_start(&device, "posix,mock-i2c"), ERROR_NONE);
+        REQUIRE_EQ(posix_i2c_add_target(&device, TARGET_ADDRESS), ERROR_NONE);
+    }
+
+    ~MockI2cBus() {
+        CHECK_EQ(device_stop(&device), ERROR_NONE);
+        CHECK_EQ(device_remove(&device), ERROR_NONE);
+        CHECK_EQ(device_destruct(&device), ERROR_NONE);
+    }
+
+    uint32_t get_transfer_count() {
+        return posix_i2c_get_transfer_count(&device);
+    }
+
+    uint8_t get_register(uint8_t reg) {
+        uint8_t value = 0;
+        REQUIRE_EQ(posix_i2c_get_register(&device, TARGET_ADDRESS, reg, &value), ERROR_NONE);
+        return value;
+    }
+};
+
+} // namespace
+
+TEST_CASE("i2c_batch_submit merges consecutive registers of auto-incrementing devices") {
+    MockI2cBus bus;
+    REQUIRE_EQ(posix_i2c_set_register(&bus.device, TARGET_ADDRESS, 0x10, 0xAA), ERROR_NONE);
+    REQUIRE_EQ(posix_i2c_set_register(&bus.device, TARGET_ADDRESS, 0x11, 0xBB), ERROR_NONE);
+
+    I2cBatch batch;
+    i2c_batch_init(&batch, &bus.device, TARGET_ADDRESS, I2C_BATCH_FLAG_AUTO_INCREMENT);
+    const uint8_t pair[] = { 3, 4 };
+    uint8_t first = 0;
+    uint8_t second = 0;
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x01, 1), ERROR_NONE);
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x02, 2), ERROR_NONE);
+    CHECK_EQ(i2c_batch_write_register(&batch, 0x03, pair, sizeof(pair)), ERROR_NONE);
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x08, 8), ERROR_NONE);
+    CHECK_EQ(i2c_batch_read_register(&batch, 0x10, &first, 1), ERROR_NONE);
+    CHECK_EQ(i2c_batch_read_register(&batch, 0x11, &second, 1), ERROR_NONE);
+
+    uint32_t transfers_before = bus.get_transfer_count();
+    REQUIRE_EQ(i2c_batch_submit(&batch, 0), ERROR_NONE);
+    // 0x01-0x04 in 1 write, 0x08 in another and 0x10-0x11 in 1 read
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 3);
+    CHECK_EQ(bus.get_register(0x01), 1);
+    CHECK_EQ(bus.get_register(0x02), 2);
+    CHECK_EQ(bus.get_register(0x03), 3);
+    CHECK_EQ(bus.get_register(0x04), 4);
+    CHECK_EQ(bus.get_register(0x08), 8);
+    CHECK_EQ(first, 0xAA);
+    CHECK_EQ(second, 0xBB);
+
+    // The batch is empty after submitting
+    transfers_before = bus.get_transfer_count();
+    CHECK_EQ(i2c_batch_submit(&batch, 0), ERROR_NONE);
+    CHECK_EQ(bus.get_transfer_count(), transfers_before);
+}
+
+TEST_CASE("i2c_batch_submit executes each operation without auto-increment") {
+    MockI2cBus bus;
+    I2cBatch batch;
+    i2c_batch_init(&batch, &bus.device, TARGET_ADDRESS, 0);
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x01, 1), ERROR_NONE);
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x02, 2), ERROR_NONE);
+    uint32_t transfers_before = bus.get_transfer_count();
+    REQUIRE_EQ(i2c_batch_submit(&batch, 0), ERROR_NONE);
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 2);
+    CHECK_EQ(bus.get_register(0x02), 2);
+}
+
+TEST_CASE("i2c_batch_submit reports errors from queueing and transfers") {
+    MockI2cBus bus;
+    I2cBatch batch;
+    i2c_batch_init(&batch, &bus.device, TARGET_ADDRESS, 0);
+    for (int i = 0; i < I2C_BATCH_OPERATIONS_MAX; i++) {
+        CHECK_EQ(i2c_batch_register8_set(&batch, static_cast<uint8_t>(i), 1), ERROR_NONE);
+    }
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x20, 1), ERROR_BUFFER_OVERFLOW);
+    uint32_t transfers_before = bus.get_transfer_count();
+    CHECK_EQ(i2c_batch_submit(&batch, 0), ERROR_BUFFER_OVERFLOW);
+    CHECK_EQ(bus.get_transfer_count(), transfers_before);
+    CHECK_EQ(bus.get_register(0x00), 0);
+
+    // Missing device: the first transfer fails and the rest is skipped
+    i2c_batch_init(&batch, &bus.device, 0x21, 0);
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x00, 1), ERROR_NONE);
+    CHECK_EQ(i2c_batch_register8_set(&batch, 0x01, 1), ERROR_NONE);
+    CHECK_EQ(i2c_batch_submit(&batch, 0), ERROR_NOT_FOUND);
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 1);
+}
+
+TEST_CASE("i2c_register_cache serves reads from the cache and writes through") {
+    MockI2cBus bus;
+    REQUIRE_EQ(posix_i2c_set_register(&bus.device, TARGET_ADDRESS, 0x06, 0xFF), ERROR_NONE);
+    I2cRegisterCache* cache = i2c_register_cache_alloc(&bus.device, TARGET_ADDRESS, nullptr, 0);
+    REQUIRE_NE(cache, nullptr);
+
+    uint32_t transfers_before = bus.get_transfer_count();
+    uint8_t value = 0;
+    CHECK_EQ(i2c_register_cache_get(cache, 0x06, &value, 0), ERROR_NONE);
+    CHECK_EQ(value, 0xFF);
+    CHECK_EQ(i2c_register_cache_get(cache, 0x06, &value, 0), ERROR_NONE);
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 1);
+
+    // Read-modify-write only writes, and nothing when the value doesn't change
+    CHECK_EQ(i2c_register_cache_reset_bits(cache, 0x06, 0x01, 0), ERROR_NONE);
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 2);
+    CHECK_EQ(bus.get_register(0x06), 0xFE);
+    CHECK_EQ(i2c_register_cache_reset_bits(cache, 0x06, 0x01, 0), ERROR_NONE);
+    CHECK_EQ(i2c_register_cache_update_bits(cache, 0x06, 0x0F, 0x0E, 0), ERROR_NONE);
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 2);
+
+    // Written values are cached
+    CHECK_EQ(i2c_register_cache_set(cache, 0x02, 0x55, 0), ERROR_NONE);
+    CHECK_EQ(i2c_register_cache_get(cache, 0x02, &value, 0), ERROR_NONE);
+    CHECK_EQ(value, 0x55);
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 3);
+
+    // After invalidating, the device is read again
+    REQUIRE_EQ(posix_i2c_set_register(&bus.device, TARGET_ADDRESS, 0x02, 0x66), ERROR_NONE);
+    i2c_register_cache_invalidate(cache);
+    CHECK_EQ(i2c_register_cache_get(cache, 0x02, &value, 0), ERROR_NONE);
+    CHECK_EQ(value, 0x66);
+
+    i2c_register_cache_free(cache);
+}
+
+TEST_CASE("i2c_register_cache always reads volatile registers from the device") {
+    MockI2cBus bus;
+    const uint8_t volatile_registers[] = { 0x00 };
+    I2cRegisterCache* cache = i2c_register_cache_alloc(&bus.device, TARGET_ADDRESS, volatile_registers, 1);
+    REQUIRE_NE(cache, nullptr);
+
+    uint8_t value = 0;
+    REQUIRE_EQ(posix_i2c_set_register(&bus.device, TARGET_ADDRESS, 0x00, 0x01), ERROR_NONE);
+    CHECK_EQ(i2c_register_cache_get(cache, 0x00, &value, 0), ERROR_NONE);
+    CHECK_EQ(value, 0x01);
+    REQUIRE_EQ(posix_i2c_set_register(&bus.device, TARGET_ADDRESS, 0x00, 0x02), ERROR_NONE);
+    CHECK_EQ(i2c_register_cache_get(cache, 0x00, &value, 0), ERROR_NONE);
+    CHECK_EQ(value, 0x02);
+
+    // Writing a volatile register happens even when the bits look unchanged, e.g. to clear interrupt flags
+    uint32_t transfers_before = bus.get_transfer_count();
+    CHECK_EQ(i2c_register_cache_set_bits(cache, 0x00, 0x02, 0), ERROR_NONE);
+    CHECK_EQ(bus.get_transfer_count() - transfers_before, 2);
+
+    i2c_register_cache_free(cache);
+}
+
+TEST_CASE("i2c_register_cache transfer count for IO expander pin updates") {
+    // Like an IO expander driver: configure 16 pins as outputs, then toggle each pin 4 times
+    constexpr uint8_t OUTPUT_PORT0 = 0x02;
+    constexpr uint8_t CONFIG_PORT0 = 0x06;
+    constexpr int TOGGLES = 4;
+    MockI2cBus bus;
+
+    auto run = [&](auto set_bits, auto reset_bits) {
+        uint32_t transfers_before = bus.get_transfer_count();
+        for (uint8_t pin = 0; pin < 16; pin++) {
+            auto port = static_cast<uint8_t>(pin >> 3);
+            auto bit = static_cast<uint8_t>(1 << (pin & 0x7));
+            reset_bits(static_cast<uint8_t>(CONFIG_PORT0 + port), bit);
+            for (int toggle = 0; toggle < TOGGLES; toggle++) {
+                set_bits(static_cast<uint8_t>(OUTPUT_PORT0 + port), bit);
+                reset_bits(static_cast<uint8_t>(OUTPUT_PORT0 + port), bit);
+                // A redundant update, like setting a level that didn't change
+                reset_bits(static_cast<uint8_t>(OUTPUT_PORT0 + port), bit);
+            }
+        }
+        return bus.get_transfer_count() - transfers_before;
+    };
+
+    uint32_t direct_transfers = run(
+        [&](uint8_t reg, uint8_t bits) { CHECK_EQ(i2c_controller_register8_set_bits(&bus.device, TARGET_ADDRESS, reg, bits, 0), ERROR_NONE); },
+        [&](uint8_t reg, uint8_t bits) { CHECK_EQ(i2c_controller_register8_reset_bits(&bus.device, TARGET_ADDRESS, reg, bits, 0), ERROR_NONE); }
+    );
+
+    I2cRegisterCache* cache = i2c_register_cache_alloc(&bus.device, TARGET_ADDRESS, nullptr, 0);
+    REQUIRE_NE(cache, nullptr);
+    uint32_t cached_transfers = run(
+        [&](uint8_t reg, uint8_t bits) { CHECK_EQ(i2c_register_cache_set_bits(cache, reg, bits, 0), ERROR_NONE); },
+        [&](uint8_t reg, uint8_t bits) { CHECK_EQ(i2c_register_cache_reset_bits(cache, reg, bits, 0), ERROR_NONE); }
+    );
+    i2c_register_cache_free(cache);
+
+    // Directly, every read-modify-write is 2 transfers. With the cache, only changes are written and each of
+    // the 4 registers is read once: the pins are outputs already, so the direction isn't written again.
+    CHECK_EQ(direct_transfers, 16 * (1 + TOGGLES * 3) * 2);
+    CHECK_EQ(cached_transfers, 16 * TOGGLES * 2 + 4);
+    MESSAGE("register8 helpers: " << direct_transfers << " transfers, register cache: " << cached_transfers << " transfers");
+}
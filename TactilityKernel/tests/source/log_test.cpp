@@ -0,0 +1,190 @@
+#include "doctest.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+#include <tactility/log.h>
+
+namespace {
+
+const char* TEST_PATH = "/tmp/tactility_kernel_log_test.log";
+
+std::string read_file(const char* path) {
+    std::string content;
+    FILE* file = std::fopen(path, "r");
+    if (file != nullptr) {
+        char buffer[256];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            content.append(buffer, read);
+        }
+        std::fclose(file);
+    }
+    return content;
+}
+
+LogAsyncConfig create_config(uint32_t record_count, uint32_t drain_interval_ms) {
+    return {
+        .record_count = record_count,
+        .drain_interval_ms = drain_interval_ms,
+        .drain_stack_size = 4096,
+        .file_path = TEST_PATH
+    };
+}
+
+} // namespace
+
+TEST_CASE("log_set_level should override the default level per tag") {
+    CHECK_EQ(log_get_level("log_test_level"), LOG_LEVEL_VERBOSE);
+
+    CHECK_EQ(log_set_level("log_test_level", LOG_LEVEL_WARNING), ERROR_NONE);
+    CHECK_EQ(log_get_level("log_test_level"), LOG_LEVEL_WARNING);
+    CHECK_EQ(log_get_level("log_test_other"), LOG_LEVEL_VERBOSE);
+
+    CHECK_EQ(log_set_level("log_test_level", LOG_LEVEL_VERBOSE), ERROR_NONE);
+    CHECK_EQ(log_get_level("log_test_level"), LOG_LEVEL_VERBOSE);
+
+    CHECK_EQ(log_set_level("log_test_tag_that_is_too_long", LOG_LEVEL_ERROR), ERROR_INVALID_ARGUMENT);
+}
+
+TEST_CASE("log_async_start should reject invalid configurations") {
+    auto config = create_config(100, 10);
+    CHECK_EQ(log_async_start(&config), ERROR_INVALID_ARGUMENT);
+    config = create_config(0, 10);
+    CHECK_EQ(log_async_start(&config), ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(log_async_stop(), ERROR_INVALID_STATE);
+}
+
+TEST_CASE("async logging should write filtered records to the output file") {
+    std::remove(TEST_PATH);
+    CHECK_EQ(log_set_level("log_test_async", LOG_LEVEL_WARNING), ERROR_NONE);
+
+    auto config = create_config(64, 10);
+    REQUIRE_EQ(log_async_start(&config), ERROR_NONE);
+    CHECK_EQ(log_async_start(&config), ERROR_INVALID_STATE);
+
+    LOG_W("log_test_async", "kept %d", 42);
+    LOG_I("log_test_async", "filtered %d", 43);
+    log_flush();
+
+    LogStats stats;
+    log_get_stats(&stats);
+    CHECK_GE(stats.written, 1U);
+    CHECK_EQ(stats.dropped, 0U);
+
+    CHECK_EQ(log_async_stop(), ERROR_NONE);
+    CHECK_EQ(log_set_level("log_test_async", LOG_LEVEL_VERBOSE), ERROR_NONE);
+
+    auto content = read_file(TEST_PATH);
+    CHECK_NE(content.find("W ("), std::string::npos);
+    CHECK_NE(content.find("log_test_async kept 42\n"), std::string::npos);
+    CHECK_EQ(content.find("filtered"), std::string::npos);
+    // No color codes in files
+    CHECK_EQ(content.find("\033["), std::string::npos);
+    std::remove(TEST_PATH);
+}
+
+TEST_CASE("async logging should count and report dropped records when the buffer is full") {
+    std::remove(TEST_PATH);
+
+    // The drain task sleeps for much longer than this test before its first pass, so only 4 records fit
+    auto config = create_config(4, 60000);
+    REQUIRE_EQ(log_async_start(&config), ERROR_NONE);
+
+    for (int i = 0; i < 20; i++) {
+        LOG_I("log_test_drop", "message %d", i);
+    }
+
+    LogStats stats;
+    log_get_stats(&stats);
+    // Other tasks could take up records too, but that only adds drops
+    CHECK_GE(stats.dropped, 16U);
+
+    // Stopping wakes up the drain task and writes out what was buffered
+    CHECK_EQ(log_async_stop(), ERROR_NONE);
+
+    auto content = read_file(TEST_PATH);
+    CHECK_NE(content.find("log_test_drop message 0\n"), std::string::npos);
+    CHECK_NE(content.find("log messages dropped"), std::string::npos);
+    std::remove(TEST_PATH);
+}
+
+TEST_CASE("log_flush_on_crash should write out buffered records and switch to synchronous output") {
+    std::remove(TEST_PATH);
+
+    auto config = create_config(16, 60000);
+    REQUIRE_EQ(log_async_start(&config), ERROR_NONE);
+
+    LOG_E("log_test_crash", "before crash");
+    log_flush_on_crash();
+    CHECK_NE(read_file(TEST_PATH).find("log_test_crash before crash\n"), std::string::npos);
+
+    // Written synchronously, so log_flush() isn't needed
+    LOG_E("log_test_crash", "after crash");
+    fflush(nullptr);
+    CHECK_NE(read_file(TEST_PATH).find("log_test_crash after crash\n"), std::string::npos);
+
+    // A real crash never returns from __crash(), but stopping must still release the drain task
+    CHECK_EQ(log_async_stop(), ERROR_NONE);
+    std::remove(TEST_PATH);
+}
+
+TEST_CASE("LOG_FAST should format deferred arguments like printf") {
+    std::remove(TEST_PATH);
+
+    auto config = create_config(64, 10);
+    REQUIRE_EQ(log_async_start(&config), ERROR_NONE);
+
+    LOG_FAST_I("log_test_fast", "no arguments");
+    LOG_FAST_I("log_test_fast", "int %d unsigned %u hex %04x char %c %%", -5, 7U, 0xab, 'x');
+    LOG_FAST_I("log_test_fast", "wide %lld %" PRIu64 " %zu", -1234567890123LL, (uint64_t)UINT64_MAX, sizeof(uint32_t));
+    LOG_FAST_I("log_test_fast", "float %.2f string %s pointer %p", 3.14159, "literal", (void*)nullptr);
+    log_flush();
+    CHECK_EQ(log_async_stop(), ERROR_NONE);
+
+    auto content = read_file(TEST_PATH);
+    CHECK_NE(content.find("log_test_fast no arguments\n"), std::string::npos);
+    CHECK_NE(content.find("log_test_fast int -5 unsigned 7 hex 00ab char x %\n"), std::string::npos);
+    CHECK_NE(content.find("log_test_fast wide -1234567890123 18446744073709551615 4\n"), std::string::npos);
+
+    char expected[64];
+    snprintf(expected, sizeof(expected), "log_test_fast float 3.14 string literal pointer %p\n", (void*)nullptr);
+    CHECK_NE(content.find(expected), std::string::npos);
+    std::remove(TEST_PATH);
+}
+
+TEST_CASE("LOG_FAST benchmark against LOG_I") {
+    constexpr int iterations = 1000;
+    auto config = create_config(4096, 60000);
+    config.file_path = "/dev/null";
+    LogStats stats;
+
+    REQUIRE_EQ(log_async_start(&config), ERROR_NONE);
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        LOG_I("log_test_bench", "value %d of %d at %p: %.3f", i, iterations, &config, 1.5);
+    }
+    auto formatted_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count() / iterations;
+    CHECK_EQ(log_async_stop(), ERROR_NONE);
+    log_get_stats(&stats);
+    CHECK_EQ(stats.dropped, 0U);
+    // Other tasks can log in the meantime
+    CHECK_GE(stats.written, iterations);
+
+    REQUIRE_EQ(log_async_start(&config), ERROR_NONE);
+    start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        LOG_FAST_I("log_test_bench", "value %d of %d at %p: %.3f", i, iterations, &config, 1.5);
+    }
+    auto deferred_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count() / iterations;
+    CHECK_EQ(log_async_stop(), ERROR_NONE);
+    log_get_stats(&stats);
+    CHECK_EQ(stats.dropped, 0U);
+    // Other tasks can log in the meantime
+    CHECK_GE(stats.written, iterations);
+
+    // Timings are only reported: LOG_FAST_I defers the formatting to the drain task, so it's usually the cheaper one
+    MESSAGE("LOG_I: " << formatted_ns << " ns, LOG_FAST_I: " << deferred_ns << " ns per call");
+}
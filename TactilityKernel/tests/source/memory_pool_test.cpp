@@ -0,0 +1,196 @@
+#include "doctest.h"
+#include <tactility/memory.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+
+/** Deterministic pseudo-random numbers (xorshift32) so the soak test is repeatable */
+struct Random {
+    uint32_t state = 0x12345678U;
+
+    uint32_t next() {
+        state ^= state << 13U;
+        state ^= state >> 17U;
+        state ^= state << 5U;
+        return state;
+    }
+};
+
+size_t get_small_capacity_bytes() {
+    MemoryPoolStats stats[16];
+    size_t count = memory_small_get_stats(stats, 16);
+    size_t bytes = 0;
+    for (size_t i = 0; i < count && i < 16; i++) {
+        bytes += stats[i].block_capacity * stats[i].block_size;
+    }
+    return bytes;
+}
+
+struct Slot {
+    void* ptr = nullptr;
+    size_t size = 0;
+};
+
+/**
+ * Randomly allocate and free small blocks in a fixed set of slots, like long-running kernel objects do.
+ * @return the duration in nanoseconds
+ */
+template<typename Alloc, typename Free>
+int64_t soak(std::vector<Slot>& slots, size_t operations, Random& random, Alloc alloc, Free free) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < operations; i++) {
+        auto& slot = slots[random.next() % slots.size()];
+        if (slot.ptr != nullptr) {
+            free(slot.ptr, slot.size);
+            slot.ptr = nullptr;
+        } else {
+            slot.size = 8U + (random.next() % (MEMORY_SMALL_SIZE_MAX - 8U));
+            slot.ptr = alloc(slot.size);
+            // Touch the memory like a real object would
+            std::memset(slot.ptr, 0xA5, slot.size);
+        }
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+template<typename Free>
+void release_all(std::vector<Slot>& slots, Free free) {
+    for (auto& slot : slots) {
+        if (slot.ptr != nullptr) {
+            free(slot.ptr, slot.size);
+            slot.ptr = nullptr;
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("memory_pool should hand out distinct aligned blocks and reuse freed ones") {
+    auto* pool = memory_pool_alloc(24, 4, &MEMORY_POLICY_DEFAULT);
+    REQUIRE_NE(pool, nullptr);
+
+    void* blocks[6];
+    for (auto& block : blocks) {
+        block = memory_pool_block_alloc(pool);
+        REQUIRE_NE(block, nullptr);
+        CHECK_EQ(reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t), 0);
+        std::memset(block, 0xFF, 24);
+    }
+    for (size_t i = 0; i < 6; i++) {
+        for (size_t j = i + 1; j < 6; j++) {
+            CHECK_NE(blocks[i], blocks[j]);
+        }
+    }
+
+    MemoryPoolStats stats;
+    memory_pool_get_stats(pool, &stats);
+    CHECK_GE(stats.block_size, 24);
+    CHECK_EQ(stats.blocks_in_use, 6);
+    CHECK_EQ(stats.chunk_count, 2);
+    CHECK_EQ(stats.block_capacity, 8);
+
+    memory_pool_block_free(pool, blocks[5]);
+    CHECK_EQ(memory_pool_block_alloc(pool), blocks[5]);
+
+    for (auto* block : blocks) {
+        memory_pool_block_free(pool, block);
+    }
+    memory_pool_get_stats(pool, &stats);
+    CHECK_EQ(stats.blocks_in_use, 0);
+    CHECK_EQ(stats.blocks_in_use_peak, 6);
+    // Chunks are kept for reuse
+    CHECK_EQ(stats.chunk_count, 2);
+
+    memory_pool_free(pool);
+}
+
+TEST_CASE("memory_pool should honor the policy alignment") {
+    MemoryPolicy policy = MEMORY_POLICY_DEFAULT;
+    policy.alignment = 64;
+    auto* pool = memory_pool_alloc(10, 3, &policy);
+    REQUIRE_NE(pool, nullptr);
+    void* first = memory_pool_block_alloc(pool);
+    void* second = memory_pool_block_alloc(pool);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(first) % 64, 0);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(second) % 64, 0);
+    memory_pool_block_free(pool, first);
+    memory_pool_block_free(pool, second);
+    memory_pool_free(pool);
+}
+
+TEST_CASE("memory_pool_alloc should reject empty blocks and chunks") {
+    CHECK_EQ(memory_pool_alloc(0, 4, &MEMORY_POLICY_DEFAULT), nullptr);
+    CHECK_EQ(memory_pool_alloc(16, 0, &MEMORY_POLICY_DEFAULT), nullptr);
+}
+
+TEST_CASE("memory_small_alloc should serve small sizes from pools and larger sizes from the heap") {
+    MemoryPoolStats before[16];
+    MemoryPoolStats after[16];
+    size_t class_count = memory_small_get_stats(before, 16);
+    REQUIRE_GT(class_count, 0);
+
+    void* small = memory_small_alloc(20);
+    void* large = memory_small_alloc(MEMORY_SMALL_SIZE_MAX + 1U);
+    REQUIRE_NE(small, nullptr);
+    REQUIRE_NE(large, nullptr);
+    std::memset(large, 0, MEMORY_SMALL_SIZE_MAX + 1U);
+
+    memory_small_get_stats(after, 16);
+    size_t in_use_before = 0;
+    size_t in_use_after = 0;
+    for (size_t i = 0; i < class_count; i++) {
+        in_use_before += before[i].blocks_in_use;
+        in_use_after += after[i].blocks_in_use;
+        if (i > 0) {
+            CHECK_LT(after[i - 1].block_size, after[i].block_size);
+        }
+    }
+    CHECK_EQ(in_use_after, in_use_before + 1);
+    CHECK_EQ(after[class_count - 1].block_size, MEMORY_SMALL_SIZE_MAX);
+
+    memory_small_free(small, 20);
+    memory_small_free(large, MEMORY_SMALL_SIZE_MAX + 1U);
+    memory_small_free(nullptr, 20);
+}
+
+TEST_CASE("memory_small_alloc soak: capacity should stop growing under steady churn") {
+    constexpr size_t slot_count = 4096;
+    constexpr size_t operations = 200000;
+    std::vector<Slot> slots(slot_count);
+
+    // Baseline: the same workload on malloc
+    Random malloc_random;
+    int64_t malloc_ns = soak(slots, operations, malloc_random,
+        [](size_t size) { return malloc(size); },
+        [](void* ptr, size_t) { free(ptr); }
+    );
+#ifdef __GLIBC__
+    struct mallinfo2 malloc_info = mallinfo2();
+    MESSAGE("malloc soak: " << malloc_ns / operations << " ns/op, " << malloc_info.fordblks << " free bytes in the arena");
+#else
+    MESSAGE("malloc soak: " << malloc_ns / operations << " ns/op");
+#endif
+    release_all(slots, [](void* ptr, size_t) { free(ptr); });
+
+    Random pool_random;
+    int64_t first_half_ns = soak(slots, operations / 2, pool_random, memory_small_alloc, memory_small_free);
+    size_t mid_capacity = get_small_capacity_bytes();
+    int64_t second_half_ns = soak(slots, operations / 2, pool_random, memory_small_alloc, memory_small_free);
+    size_t end_capacity = get_small_capacity_bytes();
+    release_all(slots, memory_small_free);
+
+    MESSAGE("memory_small soak: " << (first_half_ns + second_half_ns) / operations << " ns/op, capacity "
+        << mid_capacity << " bytes halfway, " << end_capacity << " bytes at the end");
+
+    // The live set is bounded by the slots, so the pools must settle instead of growing over time
+    CHECK_LE(end_capacity, mid_capacity + (mid_capacity / 10U));
+}
@@ -1,5 +1,6 @@
 #include "doctest.h"
 #include <tactility/memory.h>
+#include <tactility/memory_tracking_internal.h>
 
 #include <cstdint>
 #include <cstring>
@@ -81,3 +82,144 @@ TEST_CASE("memory_calloc_with_policy should honor alignment and zero-initialize"
 TEST_CASE("memory_print_stats should not crash") {
     memory_print_stats();
 }
+
+TEST_CASE("memory tracking should account allocations per tag") {
+    REQUIRE(memory_tracking_is_enabled());
+    const char* tag = "memory_test_tag";
+
+    void* first = memory_alloc_tagged(100, &MEMORY_POLICY_DEFAULT, tag);
+    void* second = memory_calloc_tagged(4, 50, &MEMORY_POLICY_DEFAULT, tag);
+    REQUIRE_NE(first, nullptr);
+    REQUIRE_NE(second, nullptr);
+
+    MemoryTagStats stats;
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_tag", &stats), ERROR_NONE);
+    CHECK_EQ(std::strcmp(stats.tag, "memory_test_tag"), 0);
+    CHECK_EQ(stats.current_bytes, 300);
+    CHECK_EQ(stats.allocation_count, 2);
+    CHECK_EQ(stats.largest_block, 200);
+
+    void* grown = memory_realloc_tagged(first, 400, &MEMORY_POLICY_DEFAULT, tag);
+    REQUIRE_NE(grown, nullptr);
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_tag", &stats), ERROR_NONE);
+    CHECK_EQ(stats.current_bytes, 600);
+    CHECK_EQ(stats.allocation_count, 2);
+    CHECK_EQ(stats.largest_block, 400);
+
+    memory_free(grown);
+    memory_free(second);
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_tag", &stats), ERROR_NONE);
+    CHECK_EQ(stats.current_bytes, 0);
+    CHECK_EQ(stats.allocation_count, 0);
+    CHECK_EQ(stats.total_allocation_count, 3);
+    CHECK_EQ(stats.peak_bytes, 600);
+
+    CHECK_EQ(memory_tracking_get_stats_by_tag("memory_test_unused_tag", &stats), ERROR_NOT_FOUND);
+}
+
+TEST_CASE("memory tracking should account allocations without a tag as untagged") {
+    REQUIRE(memory_tracking_is_enabled());
+    MemoryTagStats before;
+    MemoryTagStats after;
+    if (memory_tracking_get_stats_by_tag(MEMORY_TAG_UNTAGGED, &before) != ERROR_NONE) {
+        before = {};
+    }
+
+    void* ptr = memory_alloc(64);
+    REQUIRE_NE(ptr, nullptr);
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag(MEMORY_TAG_UNTAGGED, &after), ERROR_NONE);
+    CHECK_EQ(after.current_bytes, before.current_bytes + 64);
+    CHECK_EQ(after.total_allocation_count, before.total_allocation_count + 1);
+
+    size_t tag_count = memory_tracking_get_stats(nullptr, 0);
+    CHECK_GE(tag_count, 1);
+
+    memory_free(ptr);
+}
+
+TEST_CASE("memory tracking should account untagged allocations to the thread tag") {
+    REQUIRE(memory_tracking_is_enabled());
+    // The tag is copied by the tracker, so its statistics outlive the string
+    auto* tag = new char[32];
+    strcpy(tag, "memory_test_thread_tag");
+    const char* previous_tag = memory_tracking_set_thread_tag(tag);
+    void* untagged = memory_alloc(32);
+    void* tagged = memory_alloc_tagged(16, &MEMORY_POLICY_DEFAULT, "memory_test_own_tag");
+    CHECK_EQ(memory_tracking_set_thread_tag(previous_tag), tag);
+    delete[] tag;
+    REQUIRE_NE(untagged, nullptr);
+    REQUIRE_NE(tagged, nullptr);
+
+    MemoryTagStats stats;
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_thread_tag", &stats), ERROR_NONE);
+    CHECK_EQ(std::strcmp(stats.tag, "memory_test_thread_tag"), 0);
+    CHECK_EQ(stats.current_bytes, 32);
+    // The allocation's own tag takes precedence
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_own_tag", &stats), ERROR_NONE);
+    CHECK_EQ(stats.current_bytes, 16);
+
+    memory_free(untagged);
+    memory_free(tagged);
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_thread_tag", &stats), ERROR_NONE);
+    CHECK_EQ(stats.current_bytes, 0);
+}
+
+TEST_CASE("memory tracking should discard statistics when disabled") {
+    REQUIRE(memory_tracking_is_enabled());
+    // Keep the records of the test runner's leak check
+    memory_tracking_save();
+    void* ptr = memory_alloc_tagged(16, &MEMORY_POLICY_DEFAULT, "memory_test_disable");
+    REQUIRE_NE(ptr, nullptr);
+    MemoryTagStats stats;
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_disable", &stats), ERROR_NONE);
+    CHECK_EQ(stats.allocation_count, 1);
+
+    memory_tracking_set_enabled(false);
+    CHECK_EQ(memory_tracking_get_stats_by_tag("memory_test_disable", &stats), ERROR_INVALID_STATE);
+    CHECK_EQ(memory_tracking_get_stats(nullptr, 0), 0);
+
+    // Freeing an allocation from before tracking was (re-)enabled must be harmless
+    memory_tracking_set_enabled(true);
+    memory_free(ptr);
+    CHECK_EQ(memory_tracking_get_stats_by_tag("memory_test_disable", &stats), ERROR_NOT_FOUND);
+
+    memory_tracking_restore();
+}
+
+TEST_CASE("memory tracking statistics should outlive disabling the tracking") {
+    REQUIRE(memory_tracking_is_enabled());
+    memory_tracking_save();
+    void* ptr = memory_alloc_tagged(16, &MEMORY_POLICY_DEFAULT, "memory_test_copied_tag");
+    REQUIRE_NE(ptr, nullptr);
+    MemoryTagStats stats;
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_copied_tag", &stats), ERROR_NONE);
+
+    memory_tracking_set_enabled(false);
+    CHECK_EQ(std::strcmp(stats.tag, "memory_test_copied_tag"), 0);
+
+    memory_tracking_set_enabled(true);
+    memory_free(ptr);
+    memory_tracking_restore();
+}
+
+TEST_CASE("memory tracking should keep the records that were set aside") {
+    REQUIRE(memory_tracking_is_enabled());
+    void* ptr = memory_alloc_tagged(16, &MEMORY_POLICY_DEFAULT, "memory_test_saved");
+    REQUIRE_NE(ptr, nullptr);
+
+    memory_tracking_save();
+    memory_tracking_set_enabled(false);
+    memory_tracking_set_enabled(true);
+    memory_tracking_restore();
+
+    MemoryTagStats stats;
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_saved", &stats), ERROR_NONE);
+    CHECK_EQ(stats.allocation_count, 1);
+
+    // A free while the records are set aside is accounted to them
+    memory_tracking_save();
+    memory_free(ptr);
+    memory_tracking_restore();
+    REQUIRE_EQ(memory_tracking_get_stats_by_tag("memory_test_saved", &stats), ERROR_NONE);
+    CHECK_EQ(stats.allocation_count, 0);
+}
@@ -1,7 +1,16 @@
 #include "doctest.h"
+#include <tactility/concurrent/mutex.h>
 #include <tactility/module.h>
+#include <tactility/time.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" const struct ModuleSymbol KERNEL_SYMBOLS[];
 
 static void symbol_test_function() { /* NO-OP */ }
+static void symbol_test_function_other() { /* NO-OP */ }
 
 static error_t test_start_result = ERROR_NONE;
 static bool start_called = false;
@@ -234,3 +243,100 @@ TEST_CASE("module_ensure_destructed removes module from global ledger") {
     // Calling again on an already-destructed module should be a no-op
     CHECK_EQ(module_ensure_destructed(&module), ERROR_NONE);
 }
+
+TEST_CASE("Global symbol resolution prefers the module that was added first") {
+    static const struct ModuleSymbol first_symbols[] = {
+        DEFINE_MODULE_SYMBOL(symbol_test_function),
+        MODULE_SYMBOL_TERMINATOR
+    };
+    static const struct ModuleSymbol second_symbols[] = {
+        { "symbol_test_function", (void*)&symbol_test_function_other },
+        DEFINE_MODULE_SYMBOL(symbol_test_function_other),
+        MODULE_SYMBOL_TERMINATOR
+    };
+
+    struct Module first = { .name = "test_sym_first", .start = nullptr, .stop = nullptr, .symbols = first_symbols, .internal = nullptr };
+    struct Module second = { .name = "test_sym_second", .start = nullptr, .stop = nullptr, .symbols = second_symbols, .internal = nullptr };
+    REQUIRE_EQ(module_construct_add_start(&first), ERROR_NONE);
+    REQUIRE_EQ(module_construct_add_start(&second), ERROR_NONE);
+
+    uintptr_t addr = 0;
+    CHECK(module_resolve_symbol_global("symbol_test_function", &addr));
+    CHECK_EQ(addr, reinterpret_cast<uintptr_t>(&symbol_test_function));
+    CHECK(module_resolve_symbol_global("symbol_test_function_other", &addr));
+    CHECK_EQ(addr, reinterpret_cast<uintptr_t>(&symbol_test_function_other));
+    CHECK_FALSE(module_resolve_symbol_global("symbol_test_function_missing", &addr));
+
+    // The index must follow modules that stop
+    CHECK_EQ(module_stop(&first), ERROR_NONE);
+    CHECK(module_resolve_symbol_global("symbol_test_function", &addr));
+    CHECK_EQ(addr, reinterpret_cast<uintptr_t>(&symbol_test_function_other));
+
+    CHECK_EQ(module_ensure_destructed(&second), ERROR_NONE);
+    CHECK_FALSE(module_resolve_symbol_global("symbol_test_function", &addr));
+    CHECK_EQ(module_ensure_destructed(&first), ERROR_NONE);
+}
+
+TEST_CASE("Global symbol resolution benchmark") {
+    // On a device, the lvgl and other modules add about 1000 more symbols to the kernel's
+    constexpr size_t EXTRA_SYMBOL_COUNT = 1000;
+    std::vector<std::string> extra_names;
+    std::vector<ModuleSymbol> extra_symbols;
+    for (size_t i = 0; i < EXTRA_SYMBOL_COUNT; i++) {
+        extra_names.push_back("lv_benchmark_symbol_" + std::to_string(i));
+    }
+    for (size_t i = 0; i < EXTRA_SYMBOL_COUNT; i++) {
+        extra_symbols.push_back({ extra_names[i].c_str(), &extra_names[i] });
+    }
+    extra_symbols.push_back(MODULE_SYMBOL_TERMINATOR);
+    struct Module extra = { .name = "test_sym_benchmark", .start = nullptr, .stop = nullptr, .symbols = extra_symbols.data(), .internal = nullptr };
+    REQUIRE_EQ(module_construct_add_start(&extra), ERROR_NONE);
+
+    const ModuleSymbol* symbol_lists[] = { KERNEL_SYMBOLS, extra_symbols.data() };
+    std::vector<const char*> names;
+    for (auto* symbols : symbol_lists) {
+        for (auto* symbol = symbols; symbol->name != nullptr; symbol++) {
+            names.push_back(symbol->name);
+        }
+    }
+
+    // The previous implementation: a linear search through each module, with the ledger locked
+    Mutex mutex;
+    mutex_construct(&mutex);
+    uint64_t start_time = get_micros_since_boot();
+    uintptr_t checksum = 0;
+    for (auto* name : names) {
+        mutex_lock(&mutex);
+        bool found = false;
+        for (auto* symbols : symbol_lists) {
+            for (auto* symbol = symbols; symbol->name != nullptr && !found; symbol++) {
+                if (strcmp(symbol->name, name) == 0) {
+                    checksum += reinterpret_cast<uintptr_t>(symbol->symbol);
+                    found = true;
+                }
+            }
+        }
+        mutex_unlock(&mutex);
+    }
+    uint64_t linear_us = get_micros_since_boot() - start_time;
+    mutex_destruct(&mutex);
+
+    uintptr_t addr;
+    start_time = get_micros_since_boot();
+    // Includes building the index
+    CHECK(module_resolve_symbol_global(names[0], &addr));
+    uint64_t build_us = get_micros_since_boot() - start_time;
+    start_time = get_micros_since_boot();
+    uintptr_t indexed_checksum = 0;
+    for (auto* name : names) {
+        REQUIRE(module_resolve_symbol_global(name, &addr));
+        indexed_checksum += addr;
+    }
+    uint64_t indexed_us = get_micros_since_boot() - start_time;
+    CHECK_EQ(indexed_checksum, checksum);
+
+    MESSAGE("Resolving " << names.size() << " symbols: " << linear_us << " us with a linear search, "
+        << indexed_us << " us with the index (built in " << build_us << " us)");
+
+    CHECK_EQ(module_ensure_destructed(&extra), ERROR_NONE);
+}
@@ -1,8 +1,11 @@
 #include "doctest.h"
+#include <tactility/delay.h>
 #include <tactility/preferences.h>
+#include <tactility/time.h>
 
 #include <cstdio>
 #include <cstring>
+#include <string>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -38,6 +41,12 @@ void write_raw(const char* path, const char* content) {
     std::fclose(file);
 }
 
+uint32_t file_writes() {
+    PreferencesStats stats;
+    preferences_get_stats(&stats);
+    return stats.file_writes;
+}
+
 } // namespace
 
 TEST_CASE("preferences_open_path on a missing file starts out empty, without creating it") {
@@ -243,3 +252,236 @@ TEST_CASE("preferences_open creates missing parent directories (recursively) and
     rmdir(nested_dir_b);
     rmdir(nested_dir_a);
 }
+
+TEST_CASE("reopening a cached file doesn't read it again, unless it was changed externally") {
+    ScratchFile scratch;
+
+    Preferences* preferences = preferences_open(TEST_PATH);
+    preferences_put_int32(preferences, "count", 1);
+    preferences_close(preferences);
+
+    PreferencesStats before;
+    preferences_get_stats(&before);
+    preferences = preferences_open(TEST_PATH);
+    PreferencesStats after;
+    preferences_get_stats(&after);
+    CHECK_EQ(after.file_reads, before.file_reads);
+    preferences_close(preferences);
+
+    write_raw(TEST_PATH, "count=i32:1234\n");
+    preferences = preferences_open(TEST_PATH);
+    int32_t out = 0;
+    CHECK(preferences_opt_int32(preferences, "count", &out));
+    CHECK_EQ(out, 1234);
+    preferences_close(preferences);
+}
+
+TEST_CASE("an interrupted commit is recovered from the backup of the previous file") {
+    ScratchFile scratch;
+    std::string backup_path = std::string(TEST_PATH) + ".bak";
+    std::string temp_path = std::string(TEST_PATH) + ".tmp";
+
+    Preferences* preferences = preferences_open(TEST_PATH);
+    preferences_put_int32(preferences, "count", 1);
+    preferences_close(preferences);
+    CHECK(file_exists(TEST_PATH));
+    CHECK_FALSE(file_exists(backup_path.c_str()));
+
+    // A reset after the previous file was moved aside, but before the new one replaced it
+    REQUIRE_EQ(std::rename(TEST_PATH, backup_path.c_str()), 0);
+    write_raw(temp_path.c_str(), "count=i32:2");
+
+    preferences = preferences_open(TEST_PATH);
+    int32_t out = 0;
+    CHECK(preferences_opt_int32(preferences, "count", &out));
+    CHECK_EQ(out, 1);
+    preferences_put_int32(preferences, "count", 3);
+    preferences_close(preferences);
+    CHECK(file_exists(TEST_PATH));
+    CHECK_FALSE(file_exists(backup_path.c_str()));
+    CHECK_FALSE(file_exists(temp_path.c_str()));
+
+    preferences = preferences_open(TEST_PATH);
+    CHECK(preferences_opt_int32(preferences, "count", &out));
+    CHECK_EQ(out, 3);
+    preferences_close(preferences);
+}
+
+TEST_CASE("putting the current value again doesn't write the file") {
+    ScratchFile scratch;
+
+    Preferences* preferences = preferences_open(TEST_PATH);
+    preferences_put_string(preferences, "text", "same");
+    preferences_close(preferences);
+
+    uint32_t writes = file_writes();
+    preferences = preferences_open(TEST_PATH);
+    preferences_put_string(preferences, "text", "same");
+    preferences_close(preferences);
+    CHECK_EQ(file_writes(), writes);
+}
+
+TEST_CASE("a commit_delay_ms batches changes until preferences_flush()") {
+    ScratchFile scratch;
+    PreferencesOptions options = { .format = PREFERENCES_FORMAT_PROPERTIES, .commit_delay_ms = 60000 };
+
+    uint32_t writes = file_writes();
+    for (int32_t i = 0; i < 10; i++) {
+        Preferences* preferences = preferences_open_with_options(TEST_PATH, &options);
+        REQUIRE_NE(preferences, nullptr);
+        preferences_put_int32(preferences, "count", i);
+        preferences_close(preferences);
+    }
+    CHECK_FALSE(file_exists(TEST_PATH));
+    CHECK_EQ(file_writes(), writes);
+
+    Preferences* preferences = preferences_open_with_options(TEST_PATH, &options);
+    CHECK_EQ(preferences_flush(preferences), ERROR_NONE);
+    CHECK_EQ(file_writes(), writes + 1);
+    CHECK(file_exists(TEST_PATH));
+    // Nothing changed since
+    CHECK_EQ(preferences_flush_all(), ERROR_NONE);
+    CHECK_EQ(file_writes(), writes + 1);
+    preferences_close(preferences);
+}
+
+TEST_CASE("a commit_delay_ms commits after the last change") {
+    ScratchFile scratch;
+    PreferencesOptions options = { .format = PREFERENCES_FORMAT_PROPERTIES, .commit_delay_ms = 20 };
+
+    Preferences* preferences = preferences_open_with_options(TEST_PATH, &options);
+    preferences_put_bool(preferences, "flag", true);
+
+    // The commit thread can be late on a busy host, so only the upper bound is generous
+    TickType_t start_ticks = get_ticks();
+    while (!file_exists(TEST_PATH) && get_ticks() - start_ticks < millis_to_ticks(5000)) {
+        delay_millis(10);
+    }
+    CHECK(file_exists(TEST_PATH));
+    preferences_close(preferences);
+}
+
+TEST_CASE("closed files are dropped from the cache once they're committed") {
+    PreferencesStats stats;
+    std::string paths[20];
+    for (size_t i = 0; i < 20; i++) {
+        paths[i] = std::string("/tmp/tactility_kernel_preferences_test_cache_") + std::to_string(i) + ".properties";
+        std::remove(paths[i].c_str());
+        // Dirty when closed, so they're only evictable after the commit
+        Preferences* preferences = preferences_open(paths[i].c_str());
+        REQUIRE_NE(preferences, nullptr);
+        preferences_put_int32(preferences, "index", static_cast<int32_t>(i));
+        preferences_close(preferences);
+    }
+
+    preferences_get_stats(&stats);
+    CHECK_LE(stats.cached_files, 16);
+
+    for (const auto& path : paths) {
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("preferences_open_with_options() fails when the file is open with other options") {
+    ScratchFile scratch;
+    PreferencesOptions delayed = { .format = PREFERENCES_FORMAT_BINARY, .commit_delay_ms = 60000 };
+
+    Preferences* preferences = preferences_open_with_options(TEST_PATH, &delayed);
+    REQUIRE_NE(preferences, nullptr);
+    CHECK_EQ(preferences_open(TEST_PATH), nullptr);
+    Preferences* other = preferences_open_with_options(TEST_PATH, &delayed);
+    REQUIRE_NE(other, nullptr);
+    preferences_close(other);
+
+    // Closed, but the change isn't committed yet
+    preferences_put_int32(preferences, "count", 1);
+    preferences_close(preferences);
+    CHECK_EQ(preferences_open(TEST_PATH), nullptr);
+
+    // Committed and closed: the next open can choose again
+    CHECK_EQ(preferences_flush_all(), ERROR_NONE);
+    preferences = preferences_open(TEST_PATH);
+    REQUIRE_NE(preferences, nullptr);
+    int32_t count = 0;
+    CHECK(preferences_opt_int32(preferences, "count", &count));
+    CHECK_EQ(count, 1);
+    preferences_close(preferences);
+}
+
+TEST_CASE("the binary format round-trips all types and is recognized by preferences_open()") {
+    ScratchFile scratch;
+    const char* copy_path = "/tmp/tactility_kernel_preferences_test.bin";
+    PreferencesOptions options = { .format = PREFERENCES_FORMAT_BINARY, .commit_delay_ms = 0 };
+
+    Preferences* preferences = preferences_open_with_options(TEST_PATH, &options);
+    preferences_put_bool(preferences, "flag", true);
+    preferences_put_int32(preferences, "count", -42);
+    preferences_put_int64(preferences, "big", -123456789012345LL);
+    preferences_put_string(preferences, "text", "line1\nline2=value");
+    preferences_close(preferences);
+
+    // Copy the file to a path that isn't cached, so it has to be decoded
+    FILE* file = std::fopen(TEST_PATH, "rb");
+    REQUIRE(file != nullptr);
+    char content[256];
+    size_t size = std::fread(content, 1, sizeof(content), file);
+    std::fclose(file);
+    CHECK_EQ(std::memcmp(content, "TPRF", 4), 0);
+    std::remove(copy_path);
+    file = std::fopen(copy_path, "wb");
+    REQUIRE(file != nullptr);
+    std::fwrite(content, 1, size, file);
+    std::fclose(file);
+
+    preferences = preferences_open(copy_path);
+    REQUIRE_NE(preferences, nullptr);
+    bool bool_out = false;
+    CHECK(preferences_opt_bool(preferences, "flag", &bool_out));
+    CHECK(bool_out);
+    int32_t int32_out = 0;
+    CHECK(preferences_opt_int32(preferences, "count", &int32_out));
+    CHECK_EQ(int32_out, -42);
+    int64_t int64_out = 0;
+    CHECK(preferences_opt_int64(preferences, "big", &int64_out));
+    CHECK_EQ(int64_out, -123456789012345LL);
+    char buffer[32];
+    CHECK_EQ(preferences_opt_string(preferences, "text", buffer, sizeof(buffer)), ERROR_NONE);
+    CHECK_EQ(std::strcmp(buffer, "line1\nline2=value"), 0);
+    preferences_close(preferences);
+    std::remove(copy_path);
+}
+
+TEST_CASE("preferences benchmark") {
+    ScratchFile scratch;
+    constexpr int32_t SET_COUNT = 1000;
+    const PreferencesOptions variants[] = {
+        { .format = PREFERENCES_FORMAT_PROPERTIES, .commit_delay_ms = 0 },
+        { .format = PREFERENCES_FORMAT_PROPERTIES, .commit_delay_ms = 60000 },
+        { .format = PREFERENCES_FORMAT_BINARY, .commit_delay_ms = 60000 }
+    };
+
+    for (const auto& options : variants) {
+        std::remove(TEST_PATH);
+        uint32_t writes = file_writes();
+        uint64_t start_time = get_micros_since_boot();
+        // The typical settings app pattern: open, set a value and close again
+        for (int32_t i = 0; i < SET_COUNT; i++) {
+            Preferences* preferences = preferences_open_with_options(TEST_PATH, &options);
+            preferences_put_int32(preferences, "count", i);
+            preferences_close(preferences);
+        }
+        CHECK_EQ(preferences_flush_all(), ERROR_NONE);
+        uint64_t total_us = get_micros_since_boot() - start_time;
+        uint32_t set_writes = file_writes() - writes;
+        if (options.commit_delay_ms > 0) {
+            CHECK_EQ(set_writes, 1);
+        } else {
+            CHECK_EQ(set_writes, SET_COUNT);
+        }
+
+        std::string format = (options.format == PREFERENCES_FORMAT_BINARY) ? "binary" : "properties";
+        MESSAGE(SET_COUNT << " sets, " << format
+            << ", commit delay " << options.commit_delay_ms << " ms: " << set_writes << " file writes, "
+            << total_us / SET_COUNT << " us per set");
+    }
+}
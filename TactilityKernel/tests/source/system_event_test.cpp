@@ -5,6 +5,9 @@
 #include <tactility/system_event.h>
 #include <tactility/time.h>
 
+#include <atomic>
+#include <cstring>
+#include <chrono>
 #include <vector>
 
 // system_event_emit() snapshots matching subscriptions under the lock, then invokes them
@@ -437,3 +440,109 @@ TEST_CASE("a subscription node can be re-subscribed after system_event_unsubscri
 
     CHECK_EQ(system_event_unsubscribe(&sub), ERROR_NONE);
 }
+
+TEST_CASE("system_event_emit and system_event_callback_add reject unknown event types") {
+    auto unknown_type = static_cast<SystemEventType>(KERNEL_EVENT_TIME_CHANGED + 1);
+    int context_a = 1;
+    CHECK_EQ(system_event_callback_add(unknown_type, listener_a, &context_a), ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(system_event_emit(unknown_type, nullptr, 0), ERROR_INVALID_ARGUMENT);
+    CHECK_EQ(system_event_emit_from_isr(unknown_type, nullptr, 0), ERROR_INVALID_ARGUMENT);
+}
+
+static std::atomic<int> deferred_call_count = 0;
+static std::atomic<int> deferred_value = 0;
+
+static void deferred_listener(SystemEvent* event, void* context) {
+    (void)context;
+    int value = 0;
+    std::memcpy(&value, event->data, sizeof(value));
+    deferred_value = value;
+    deferred_call_count++;
+}
+
+TEST_CASE("system_event_emit_from_isr delivers the event from the timer task") {
+    deferred_call_count = 0;
+    CHECK_EQ(system_event_callback_add(KERNEL_EVENT_SERVICE_STARTED, deferred_listener, nullptr), ERROR_NONE);
+
+    int value = 1234;
+    CHECK_EQ(system_event_emit_from_isr(KERNEL_EVENT_SERVICE_STARTED, &value, sizeof(value)), ERROR_NONE);
+    // The copy was taken before returning
+    value = 0;
+
+    TickType_t start_ticks = get_ticks();
+    while (deferred_call_count.load() == 0 && get_ticks() - start_ticks < pdMS_TO_TICKS(1000)) {
+        delay_millis(1);
+    }
+    CHECK_EQ(deferred_call_count.load(), 1);
+    CHECK_EQ(deferred_value.load(), 1234);
+
+    system_event_callback_remove(KERNEL_EVENT_SERVICE_STARTED, deferred_listener);
+}
+
+static void counting_listener(SystemEvent* event, void* context) {
+    (void)event;
+    (*static_cast<size_t*>(context))++;
+}
+
+TEST_CASE("system_event_emit latency with 1, 10 and 100 subscribers") {
+    constexpr int iterations = 10000;
+    // Distinct function pointers aren't needed: removal takes the first match per call
+    for (size_t subscriber_count : { 1, 10, 100 }) {
+        size_t call_count = 0;
+        for (size_t i = 0; i < subscriber_count; i++) {
+            REQUIRE_EQ(system_event_callback_add(KERNEL_EVENT_BOOT_COMPLETED, counting_listener, &call_count), ERROR_NONE);
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            system_event_emit(KERNEL_EVENT_BOOT_COMPLETED, nullptr, 0);
+        }
+        auto duration = std::chrono::steady_clock::now() - start_time;
+        auto ns_per_emit = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / iterations;
+
+        MESSAGE("system_event_emit: " << ns_per_emit << " ns per emit with " << subscriber_count << " subscribers");
+        CHECK_EQ(call_count, subscriber_count * iterations);
+
+        for (size_t i = 0; i < subscriber_count; i++) {
+            CHECK_EQ(system_event_callback_remove(KERNEL_EVENT_BOOT_COMPLETED, counting_listener), ERROR_NONE);
+        }
+    }
+}
+
+static std::atomic<bool> churn_stop = false;
+
+TEST_CASE("system_event_emit is safe while another task adds and removes callbacks") {
+    churn_stop = false;
+    size_t call_count = 0;
+    CHECK_EQ(system_event_callback_add(KERNEL_EVENT_TIME_CHANGED, counting_listener, &call_count), ERROR_NONE);
+
+    auto* thread = thread_alloc_full(
+        "system-event-churn",
+        4096,
+        [](void*) {
+            static size_t churn_count = 0;
+            while (!churn_stop.load()) {
+                system_event_callback_add(KERNEL_EVENT_TIME_CHANGED, listener_b, &churn_count);
+                system_event_callback_remove(KERNEL_EVENT_TIME_CHANGED, listener_b);
+            }
+            return 0;
+        },
+        nullptr,
+        -1
+    );
+    CHECK_EQ(thread_start(thread), ERROR_NONE);
+
+    reset_calls();
+    for (int i = 0; i < 20000; i++) {
+        system_event_emit(KERNEL_EVENT_TIME_CHANGED, nullptr, 0);
+    }
+    churn_stop = true;
+    CHECK_EQ(thread_join(thread, pdMS_TO_TICKS(2000), pdMS_TO_TICKS(1)), ERROR_NONE);
+    thread_free(thread);
+
+    // The permanent subscriber saw every emit, regardless of the churn around it
+    CHECK_EQ(call_count, 20000);
+
+    CHECK_EQ(system_event_callback_remove(KERNEL_EVENT_TIME_CHANGED, counting_listener), ERROR_NONE);
+    reset_calls();
+}
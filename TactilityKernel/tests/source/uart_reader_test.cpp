@@ -0,0 +1,171 @@
+#include "doctest.h"
+
+#include <tactility/device.h>
+#include <tactility/drivers/uart_controller.h>
+#include <tactility/drivers/uart_reader.h>
+#include <tactility/time.h>
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+// A loopback UART from platform-posix: everything that is written can be read back
+struct LoopbackUart {
+    Device device { .name = "uart_reader_test" };
+
+    LoopbackUart() {
+        REQUIRE_EQ(device_construct_add_start(&device, "posix,mock-uart"), ERROR_NONE);
+        UartConfig config = {
+            .baud_rate = 115200,
+            .data_bits = UART_CONTROLLER_DATA_8_BITS,
+            .parity = UART_CONTROLLER_PARITY_DISABLE,
+            .stop_bits = UART_CONTROLLER_STOP_BITS_1
+        };
+        REQUIRE_EQ(uart_controller_set_config(&device, &config), ERROR_NONE);
+        REQUIRE_EQ(uart_controller_open(&device), ERROR_NONE);
+    }
+
+    ~LoopbackUart() {
+        CHECK_EQ(uart_controller_close(&device), ERROR_NONE);
+        CHECK_EQ(device_stop(&device), ERROR_NONE);
+        CHECK_EQ(device_remove(&device), ERROR_NONE);
+        CHECK_EQ(device_destruct(&device), ERROR_NONE);
+    }
+
+    void write(const char* text) {
+        REQUIRE_EQ(uart_controller_write_bytes(&device, reinterpret_cast<const uint8_t*>(text), strlen(text), 0), ERROR_NONE);
+    }
+};
+
+std::string to_string(const uint8_t* line, size_t length) {
+    return std::string(reinterpret_cast<const char*>(line), length);
+}
+
+} // namespace
+
+TEST_CASE("uart_reader_read_line returns each line including its delimiter") {
+    LoopbackUart uart;
+    UartReader* reader = uart_reader_alloc(&uart.device, 64);
+    REQUIRE_NE(reader, nullptr);
+
+    uart.write("$GPGGA,1\r\n$GPRMC,2\r\n$GP");
+    const uint8_t* line;
+    size_t length;
+    REQUIRE_EQ(uart_reader_read_line(reader, '\n', &line, &length, 0), ERROR_NONE);
+    CHECK_EQ(to_string(line, length), "$GPGGA,1\r\n");
+    REQUIRE_EQ(uart_reader_read_line(reader, '\n', &line, &length, 0), ERROR_NONE);
+    CHECK_EQ(to_string(line, length), "$GPRMC,2\r\n");
+
+    // The incomplete line is kept until the rest arrives
+    CHECK_EQ(uart_reader_read_line(reader, '\n', &line, &length, 1), ERROR_TIMEOUT);
+    CHECK_EQ(uart_reader_get_buffered(reader), 3);
+    uart.write("ZDA,3\r\n");
+    REQUIRE_EQ(uart_reader_read_line(reader, '\n', &line, &length, 0), ERROR_NONE);
+    CHECK_EQ(to_string(line, length), "$GPZDA,3\r\n");
+    CHECK_EQ(uart_reader_get_buffered(reader), 0);
+
+    uart_reader_free(reader);
+}
+
+TEST_CASE("uart_reader_read_line handles lines that wrap around and overflow the buffer") {
+    LoopbackUart uart;
+    UartReader* reader = uart_reader_alloc(&uart.device, 16);
+    REQUIRE_NE(reader, nullptr);
+
+    const uint8_t* line;
+    size_t length;
+    // Lines that don't fit the rest of the buffer move to the start
+    for (int i = 0; i < 10; i++) {
+        uart.write("0123456789\n");
+        REQUIRE_EQ(uart_reader_read_line(reader, '\n', &line, &length, 0), ERROR_NONE);
+        CHECK_EQ(to_string(line, length), "0123456789\n");
+    }
+
+    uart.write("0123456789abcdefXYZ\n");
+    CHECK_EQ(uart_reader_read_line(reader, '\n', &line, &length, 0), ERROR_BUFFER_OVERFLOW);
+    CHECK_EQ(to_string(line, length), "0123456789abcdef");
+    REQUIRE_EQ(uart_reader_read_line(reader, '\n', &line, &length, 0), ERROR_NONE);
+    CHECK_EQ(to_string(line, length), "XYZ\n");
+
+    uart_reader_free(reader);
+}
+
+TEST_CASE("uart_reader_read returns buffered bytes before reading from the driver") {
+    LoopbackUart uart;
+    UartReader* reader = uart_reader_alloc(&uart.device, 32);
+    REQUIRE_NE(reader, nullptr);
+
+    uart.write("line\nrest");
+    const uint8_t* line;
+    size_t length;
+    REQUIRE_EQ(uart_reader_read_line(reader, '\n', &line, &length, 0), ERROR_NONE);
+
+    uint8_t buffer[8];
+    REQUIRE_EQ(uart_reader_read(reader, buffer, 2, &length, 0), ERROR_NONE);
+    CHECK_EQ(to_string(buffer, length), "re");
+    REQUIRE_EQ(uart_reader_read(reader, buffer, sizeof(buffer), &length, 0), ERROR_NONE);
+    CHECK_EQ(to_string(buffer, length), "st");
+    CHECK_EQ(uart_reader_read(reader, buffer, sizeof(buffer), &length, 1), ERROR_TIMEOUT);
+    CHECK_EQ(length, 0);
+
+    uart.write("abc");
+    REQUIRE_EQ(uart_reader_read(reader, buffer, sizeof(buffer), &length, 0), ERROR_NONE);
+    CHECK_EQ(to_string(buffer, length), "abc");
+
+    uart.write("discarded\n");
+    REQUIRE_EQ(uart_reader_read(reader, buffer, 1, &length, 0), ERROR_NONE);
+    uart_reader_reset(reader);
+    CHECK_EQ(uart_reader_get_buffered(reader), 0);
+
+    uart_reader_free(reader);
+}
+
+TEST_CASE("uart_reader benchmark") {
+    constexpr int LINE_COUNT = 200;
+    constexpr int ITERATIONS = 10;
+    // Same as the GPS driver
+    const TickType_t timeout = pdMS_TO_TICKS(100);
+    const char* sentence = "$GNRMC,123519.00,A,4807.03812,N,01131.00012,E,0.022,,230394,,,A,V*1A\r\n";
+    size_t sentence_length = strlen(sentence);
+    std::string burst;
+    for (int i = 0; i < LINE_COUNT; i++) {
+        burst += sentence;
+    }
+
+    LoopbackUart uart;
+    uint64_t read_until_us = 0;
+    uint64_t reader_us = 0;
+    UartReader* reader = uart_reader_alloc(&uart.device, UART_READER_BUFFER_SIZE_DEFAULT);
+    REQUIRE_NE(reader, nullptr);
+
+    for (int iteration = 0; iteration < ITERATIONS; iteration++) {
+        uart.write(burst.c_str());
+        uint64_t start_time = get_micros_since_boot();
+        for (int i = 0; i < LINE_COUNT; i++) {
+            uint8_t buffer[UART_READER_BUFFER_SIZE_DEFAULT];
+            size_t bytes_read = 0;
+            REQUIRE_EQ(uart_controller_read_until(&uart.device, buffer, sizeof(buffer), '\n', true, &bytes_read, timeout), ERROR_NONE);
+            REQUIRE_EQ(bytes_read, sentence_length);
+        }
+        read_until_us += get_micros_since_boot() - start_time;
+
+        uart.write(burst.c_str());
+        start_time = get_micros_since_boot();
+        for (int i = 0; i < LINE_COUNT; i++) {
+            const uint8_t* line;
+            size_t length;
+            REQUIRE_EQ(uart_reader_read_line(reader, '\n', &line, &length, timeout), ERROR_NONE);
+            REQUIRE_EQ(length, sentence_length);
+        }
+        reader_us += get_micros_since_boot() - start_time;
+    }
+    uart_reader_free(reader);
+
+    uint64_t total_bytes = static_cast<uint64_t>(burst.size()) * ITERATIONS;
+    uint64_t total_lines = static_cast<uint64_t>(LINE_COUNT) * ITERATIONS;
+    MESSAGE("read_until: " << (read_until_us * 1000U / total_lines) << " ns per line, "
+        << (total_bytes * 1000000U / (read_until_us + 1)) / 1024U << " KiB/s");
+    MESSAGE("uart_reader: " << (reader_us * 1000U / total_lines) << " ns per line, "
+        << (total_bytes * 1000000U / (reader_us + 1)) / 1024U << " KiB/s");
+}